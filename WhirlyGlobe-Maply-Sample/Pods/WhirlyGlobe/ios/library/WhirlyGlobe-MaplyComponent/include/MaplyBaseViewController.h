@@ -836,6 +836,17 @@
  */
 - (CGPoint)screenPointFromGeo:(MaplyCoordinate)geoCoord;
 
+/**
+    Return the locations on screen for a batch of geographic (lon/lat radians) coordinates.
+    
+    The view matrices are set up once for the whole batch, so this is much faster than calling screenPointFromGeo: on each point.  Points that can't be seen (e.g. on the far side of the globe) come back as NAN.  Points off the edge of the screen are not clipped.
+    
+    @param geoCoords The coordinates to project.
+    @param numPts The number of coordinates.
+    @param screenPts Filled in with the screen points.  Must have room for numPts.
+ */
+- (void)screenPointsFromGeos:(const MaplyCoordinate *__nonnull)geoCoords numPoints:(int)numPts screenPoints:(CGPoint *__nonnull)screenPts;
+
 /** 
     Animate the given position to the screen position over time.
  
@@ -1265,6 +1276,35 @@
   */
 - (NSArray * _Nonnull)objectsAtCoord:(MaplyCoordinate)coord;
 
+/**
+    Find all the selectable objects overlapping a region of the screen.
+ 
+    The search runs on a background queue and the completion block is called on the main thread with the objects found.  These are the same objects passed to the selection delegate, such as markers, labels and shapes.  Vectors aren't included.  See objectsAtCoord: for those.
+ 
+    @param screenPts The region as a closed polygon in screen points.  These are CGPoints wrapped in NSValues.
+ 
+    @param completion Called on the main thread with an array of the objects found.
+  */
+- (void)findSelectablesInScreenPolygon:(NSArray<NSValue *> *__nonnull)screenPts completion:(void (^__nonnull)(NSArray *__nonnull selectedObjs))completion;
+
+/**
+    Find all the selectable objects overlapping a rectangle on the screen.
+ 
+    Just like findSelectablesInScreenPolygon:completion:, but with a rectangle.
+  */
+- (void)findSelectablesInScreenRect:(CGRect)rect completion:(void (^__nonnull)(NSArray *__nonnull selectedObjs))completion;
+
+/**
+    Find all the selectable objects overlapping a geographic bounding box.
+ 
+    The search runs on a background queue and the completion block is called on the main thread with the objects found.  Since this doesn't depend on the view, objects outside their visibility range are included.
+ 
+    @param bbox The bounding box in geographic (radians).
+ 
+    @param completion Called on the main thread with an array of the objects found.
+  */
+- (void)findSelectablesInBoundingBox:(MaplyBoundingBox)bbox completion:(void (^__nonnull)(NSArray *__nonnull selectedObjs))completion;
+
 /// Turn on/off performance output (goes to the log periodically).
 @property (nonatomic,assign) bool performanceOutput;
 
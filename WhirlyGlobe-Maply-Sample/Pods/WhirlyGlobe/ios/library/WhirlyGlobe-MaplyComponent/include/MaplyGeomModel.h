@@ -34,9 +34,18 @@
     Initialize with the full path to a Wavefront OBJ model file.
     
     This creates a model from a Wavefront OBJ file, a standard, simple file format for models.  You can then instance and place this model where you might like.
+ 
+    Duplicate vertices are merged and the triangles are reordered for the GPU's vertex cache as the model is loaded.
   */
 - (nullable instancetype)initWithObj:(NSString *__nonnull)fullPath;
 
+/** 
+    Initialize with a Wavefront OBJ model file and a binary cache of the converted model.
+    
+    If the cache file exists and is newer than the OBJ file and the material files it uses, the model is read from it instead.  Otherwise the OBJ file is parsed and the cache is written out for next time.  Put the cache somewhere writable, such as the caches directory.
+  */
+- (nullable instancetype)initWithObj:(NSString *__nonnull)fullPath cache:(NSString *__nullable)cachePath;
+
 /** 
     Initialize with a shape.
     
@@ -44,6 +53,20 @@
   */
 - (nonnull instancetype)initWithShape:(MaplyShape *__nonnull)shape;
 
+/** 
+    Number of detail levels to build for instances of this model.
+    
+    When this is more than 1, simplified versions of the model are built the first time it's instanced, each with about a quarter of the triangles of the one before.  Instances that are small on screen use the simpler versions.  Defaults to 1, which is just the model as given.
+  */
+@property (nonatomic,assign) int numLods;
+
+/** 
+    Size on screen (in pixels) below which instances switch to the first simplified version.
+    
+    Each level after that is used for every halving of the size below this.  Defaults to 128.
+  */
+@property (nonatomic,assign) float lodSize;
+
 @end
 
 
@@ -44,6 +44,24 @@
 
 @end
 
+/**
+    Loading status for a single frame of a MaplyQuadImageFrameLoader.
+ 
+    Use these to decide when there's enough data in to start (or keep) animating.
+  */
+@interface MaplyQuadImageFrameStatus : NSObject
+
+/// Number of tiles that can display this frame, either their own data or a parent's
+@property (nonatomic,readonly) int numTilesLoaded;
+
+/// Number of tiles we're currently displaying
+@property (nonatomic,readonly) int numTiles;
+
+/// Set if the lowest level tiles are all in, so the frame can be displayed
+@property (nonatomic,readonly) bool fullyLoaded;
+
+@end
+
 /**
  The Maply Quad Image Loader is for paging image pyramids local or remote.
  
@@ -72,6 +90,25 @@
   */
 - (void)setCurrentImage:(double)where;
 
+/**
+  Number of frames to keep loaded around the current image.
+ 
+  By default (0) every frame is loaded for every visible tile and kept until the tile goes away.
+  That's fine for a handful of frames, but memory goes up with the frame count.
+ 
+  Set this to stream instead.  We keep the current and next frames, plus the ones ahead in whichever
+  direction the animation is running, and let the rest go.  Frames closer to the current one are fetched first.
+  Set this before the loader starts up.
+  */
+@property (nonatomic,assign) int frameWindow;
+
+/**
+  Loading status for each frame, for deciding when to start or pause an animation.
+ 
+  Returns nil if nothing has loaded yet.  Call this on the main thread.
+  */
+- (nullable NSArray<MaplyQuadImageFrameStatus *> *)getFrameStatus;
+
 /** Turn off the image loader and shut things down.
  
     This unregisters us with the sampling layer and shuts down the various objects we created.
@@ -178,10 +178,26 @@ extern NSString * _Nonnull const MaplyQuadImageLoaderFetcherName;
  | MaplyImageUByteBlue | 8 bits, where we choose the B and ignore the rest. |
  | MaplyImageUByteAlpha | 8 bits, where we choose the A and ignore the rest. |
  | MaplyImageUByteRGB | 8 bits, where we average RGB for the value. |
+ | MaplyImageETC2RGB8 | 4 bits, compressed RGB.  PNG and JPEG tiles are encoded on the loader thread. |
+ | MaplyImageETC2RGBA8 | 8 bits, compressed RGBA.  PNG and JPEG tiles are encoded on the loader thread. |
  | MaplyImage4Layer8Bit | 32 bits, four channels of 8 bits each.  Just like MaplyImageIntRGBA, but a warning not to do anything too clever in sampling. |
  */
 @property (nonatomic) MaplyQuadImageFormat imageFormat;
 
+/**
+ How hard to work when encoding tiles to ETC2.
+ 
+ Only used if imageFormat is MaplyImageETC2RGB8 or MaplyImageETC2RGBA8 and the tiles come in as regular images.  Fast is the default and costs a few milliseconds per 256 pixel tile.  Normal looks a bit better and takes several times longer.  Best is really only for offline use.
+ */
+@property (nonatomic) MaplyETC2Quality etc2Quality;
+
+/**
+ Build mipmaps for the image tiles as they come in.
+ 
+ The levels are built on the loader thread, so the main thread just uploads them.  Box is a simple 2x2 average.  Kaiser is a bit slower and keeps the smaller levels sharper.  None, the default, skips mipmaps entirely.  This doesn't apply to the compressed image formats.
+ */
+@property (nonatomic) MaplyMipmapFilter mipmapFilter;
+
 /**
  Number of border texels to set up around image tiles.
  
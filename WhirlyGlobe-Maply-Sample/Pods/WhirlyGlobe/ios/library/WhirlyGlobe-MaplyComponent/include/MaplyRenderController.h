@@ -53,6 +53,20 @@ typedef NS_ENUM(NSInteger, MaplyQuadImageFormat) {
     MaplyImage4Layer8Bit
 };
 
+/// How hard to work when encoding images to ETC2 on the device.  Fast is the default.
+typedef NS_ENUM(NSInteger, MaplyETC2Quality) {
+    MaplyETC2QualityFast,
+    MaplyETC2QualityNormal,
+    MaplyETC2QualityBest
+};
+
+/// How to build mipmaps for image tiles on the loader thread.  None is the default.
+typedef NS_ENUM(NSInteger, MaplyMipmapFilter) {
+    MaplyMipmapNone,
+    MaplyMipmapBox,
+    MaplyMipmapKaiser
+};
+
 /// Wrap values for certain types of textures
 #define MaplyImageWrapNone (0)
 #define MaplyImageWrapX (1<<0)
@@ -82,6 +82,8 @@ extern NSString* const kMaplyRenderTarget;
 extern NSString* const kMaplyShader;
 /// An NSDictionary containing uniforms to apply to a shader before drawing
 extern NSString* const kMaplyShaderUniforms;
+/// If set, vertex attributes are stored in compact form (normalized shorts, oct normals).  Off by default.
+extern NSString* const kMaplyCompactVertices;
 
 /// Stars, moon, stars, atmosphere
 extern const int kMaplyStarsDrawPriorityDefault;
@@ -141,6 +143,8 @@ extern NSString* const kMaplyTextOutlineSize;
 extern NSString* const kMaplyTextLineSpacing;
 /// If outline is being used, we can control the stroke size
 extern NSString* const kMaplyTextOutlineColor;
+/// Render screen label glyphs as signed distance fields.  One copy of each glyph then serves every size, outline and color.
+extern NSString* const kMaplyTextSDF;
 /// When creating textures, we may pass in the size
 extern NSString* const kMaplyTexSizeX;
 /// When creating textures, we may pass in the size
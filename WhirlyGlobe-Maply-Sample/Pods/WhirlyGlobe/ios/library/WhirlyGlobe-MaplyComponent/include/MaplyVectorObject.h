@@ -282,6 +282,18 @@ typedef NS_ENUM(NSInteger, MaplyVectorObjectType) {
   */
 - (bool)pointInAreal:(MaplyCoordinate)coord;
 
+/**
+    Run point in polygon tests for a whole batch of points.
+ 
+    Each point is tested against the areal features in the given vector objects.  The areals are indexed first and the points are split up across the available CPUs, so this is much faster than calling pointInAreal: over and over.
+ 
+    @param coords The points to test, in geographic (radians).
+    @param numCoords The number of points.
+    @param vecObjs The vector objects to test against.  Only their areal features are considered.
+    @return An NSData full of ints, one per point.  Each is the index of the first vector object containing that point, or -1 if none do.
+  */
++ (NSData *__nonnull)arealIndicesForPoints:(const MaplyCoordinate *__nonnull)coords numPoints:(int)numCoords inVectors:(NSArray<MaplyVectorObject *> *__nonnull)vecObjs;
+
 /** 
     Test if any linear feature is within distance of coord
  */
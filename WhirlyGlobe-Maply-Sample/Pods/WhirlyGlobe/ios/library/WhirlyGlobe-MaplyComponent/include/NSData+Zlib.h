@@ -31,6 +31,9 @@
 /// Return an uncompressed verison of the given data
 - (NSData *) uncompressGZip;
 
+/// Return an uncompressed version of the data, given the size it's likely to be (or 0 if unknown)
+- (NSData *) uncompressGZipWithSizeHint:(NSUInteger)sizeHint;
+
 /// test if the data is zlib compressed
 - (BOOL)isCompressed;
 
@@ -195,6 +195,15 @@
 // Thread-safe
 - (NSObject *)getSelectableObject:(WhirlyKit::SimpleIdentity)objId;
 
+// Find the selectable Maply objects overlapping a region of the screen (in screen points)
+// The placement info is a snapshot of the view, taken on the main thread
+// Thread-safe
+- (NSArray *)findSelectablesInScreenPolygon:(const std::vector<WhirlyKit::Point2f> &)screenPoly placement:(const WhirlyKit::SelectionManager::PlacementInfo &)pInfo;
+
+// Find the selectable Maply objects overlapping a geographic bounding box
+// Thread-safe
+- (NSArray *)findSelectablesInGeoMbr:(const WhirlyKit::GeoMbr &)geoMbr;
+
 // Called right before asking us to do some work
 - (bool)startOfWork;
 
@@ -20,6 +20,17 @@
 #import "MaplyQuadImageLoader.h"
 #import "QuadTileBuilder.h"
 #import "MaplyQuadSampler_private.h"
+#import "TileBuildQueue.h"
+
+@interface MaplyLoaderReturn()
+{
+@public
+    // Generation of the tile when this was handed off.  If the tile has moved on, this is stale.
+    int generation;
+    // Textures built off of the layer thread, waiting to be merged
+    std::vector<WhirlyKit::Texture *> texs;
+}
+@end
 
 @interface MaplyQuadImageLoaderBase()
 {
@@ -36,6 +47,20 @@
     MaplyBaseViewController * __weak viewC;
     MaplyRenderTarget * __weak renderTarget;
     MaplyQuadSamplingLayer *samplingLayer;
+    
+    // Parsing and texture building happen here, most important tiles first
+    WhirlyKit::TileBuildQueueRef buildQueue;
+    // Loads the build queue dropped for lack of room, waiting to go back in.  Layer thread only.
+    NSMutableArray<MaplyLoaderReturn *> *droppedLoads;
 }
 
+// Hand fetched data over to the build queue.  Filled in by the subclasses.
+- (void)addBuildJob:(MaplyLoaderReturn *)loadReturn;
+
+// Hang on to data the build queue dropped so we don't have to fetch it again
+- (void)keepDroppedLoad:(MaplyLoaderReturn *)loadReturn;
+
+// Put dropped loads back in the build queue as long as there's room
+- (void)resubmitDroppedLoads;
+
 @end
@@ -57,6 +57,13 @@
 /// @brief Layers sorted by source layer name
 @property (nonatomic, strong, nullable) NSDictionary *layersBySource;
 
+/** @brief Deepest level the vector tiles go to.
+    @details Tiles at this level are displayed at deeper zooms too, so they get any layers that show up down there.
+    A maxzoom on the style's source takes precedence.  Defaults to -1, which means we don't know, and then
+    minzoom can't be used to skip layers at all.
+  */
+@property (nonatomic, assign) NSInteger tileMaxZoom;
+
 /// @brief Initialize with the style JSON and the view controller
 /// @details We'll parse the style JSON passed in and return nil on failure.
 /// @details The optional filter can be used to reject layers we won't use
@@ -118,6 +125,7 @@
 @property (nonatomic,nullable,strong) NSString *sourceLayer;
 
 /// @brief Min/max zoom levels
+/// @details These are -1 if the style sheet didn't set them
 @property (nonatomic) int minzoom,maxzoom;
 
 /// @brief Filter this layer uses to match up to data
@@ -129,6 +137,9 @@
 /// @brief Initialize with the style sheet and the entry for this layer
 + (id __nullable)VectorStyleLayer:(MapboxVectorStyleSet * __nonnull)styleSet JSON:(NSDictionary * __nonnull)layerDict drawPriority:(int)drawPriority;
 
+/// @brief True if the layer's min/max zoom allows it to display at the given zoom level
+- (bool)displaysAtZoom:(int)zoom;
+
 /// @brief Base class initialization.  Copies data out of the refLayer
 - (id __nullable)initWithStyleEntry:(NSDictionary * __nonnull)styleEntry parent:(MaplyMapboxVectorStyleLayer * __nonnull)refLayer styleSet:(MapboxVectorStyleSet * __nonnull)styleSet drawPriority:(int)drawPriority viewC:(NSObject<MaplyRenderControllerProtocol> * __nonnull)viewC;
 
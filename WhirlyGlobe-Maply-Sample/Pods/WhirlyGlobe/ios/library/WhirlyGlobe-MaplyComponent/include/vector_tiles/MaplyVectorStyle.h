@@ -21,6 +21,8 @@
 #import <UIKit/UIKit.h>
 #import "MaplyQuadPagingLayer.h"
 
+@class MaplyVectorObject;
+
 /** 
     Settings that control how vector tiles look in relation to their styles.
     
@@ -73,6 +75,13 @@
 /// If set, we'll make the areal features selectable.  If not, this saves memory.
 @property (nonatomic) bool selectable;
 
+/** 
+    Merge compatible areal features from different styles within this many draw priorities.
+ 
+    When set, fills and outlines from styles on the same tile are built together if they differ only in color and draw priority and fall in the same band of draw priorities.  Each merged group draws in style order at the lowest priority in the group.  Groups are split wherever geometry from another style on the same tile falls in between, so the tile itself draws in the same order.  That cuts down on draw calls considerably, but geometry from other tiles can no longer slip in between styles within a group.  Defaults to zero, which turns this off.
+  */
+@property (nonatomic) int batchDrawPriorityBand;
+
 /// If set, icons will be loaded from this directory
 @property (nonatomic, strong) NSString * _Nullable iconDirectory;
 
@@ -122,6 +131,51 @@
 /// Bounding box in geographic
 @property (nonatomic,assign) MaplyBoundingBoxD geoBBox;
 
+/**
+    Return a feature derived from the given one, computing it only once per tile.
+ 
+    Stacked styles tend to clip, subdivide or tessellate the same features in the same way.  The first style to ask runs the block and everyone else asking for the same feature and operation on this tile gets the same result back.  Treat the result as read only.
+ 
+    @param vecObj The feature the operation applies to.
+ 
+    @param operation Describes the operation and any parameters it takes, e.g. @"tesselate".
+ 
+    @param buildBlock Computes the derived feature.  It may return nil.
+  */
+- (MaplyVectorObject * __nullable)derivedVector:(MaplyVectorObject * __nonnull)vecObj operation:(NSString * __nonnull)operation build:(MaplyVectorObject * __nullable (^ __nonnull)(void))buildBlock;
+
+/// Set if the tile parser will call buildBatches:categories: after running the styles.
+@property (nonatomic) bool batching;
+
+/**
+    Hand over vectors to be merged with compatible vectors from other styles on this tile.
+ 
+    Only valid if batching is set.  Vectors are grouped by their description (less color and draw priority), band and category.  The color in the description is applied per feature.
+ 
+    @param vecObjs The vectors to add.
+ 
+    @param desc The description dictionary as it would be passed to addVectors:desc:
+ 
+    @param band Draw priority band these fall into.
+ 
+    @param category Category for the resulting component object, if any.
+  */
+- (void)batchVectors:(NSArray * __nonnull)vecObjs desc:(NSDictionary * __nonnull)desc band:(int)band category:(NSString * __nullable)category;
+
+/**
+    Note the draw priority of geometry a style added directly to this tile.
+ 
+    Only needed if batching is set.  Batched groups are split so they don't merge across this priority.
+  */
+- (void)noteDrawPriority:(int)drawPriority;
+
+/**
+    Add the batched vectors to the view controller, one component object per group.
+ 
+    Component objects with a category are also added to the categories dictionary under that category.
+  */
+- (NSArray * __nonnull)buildBatches:(NSObject<MaplyRenderControllerProtocol> * __nonnull)viewC categories:(NSMutableDictionary * __nonnull)categories;
+
 @end
 
 /** 
@@ -3784,6 +3784,47 @@ typedef std::set<GeomModelInstances *,struct GeomModelInstancesCmp> GeomModelIns
     return ret;
 }
 
+// Convert selection manager IDs back to the objects the user passed in
+- (NSArray *)selectableObjectsForIDs:(const SimpleIDSet &)selectIDs
+{
+    NSMutableArray *objs = [NSMutableArray array];
+    
+    pthread_mutex_lock(&selectLock);
+    for (SimpleIdentity selectID : selectIDs)
+    {
+        SelectObjectSet::iterator sit = selectObjectSet.find(SelectObject(selectID));
+        if (sit != selectObjectSet.end() && sit->obj)
+            [objs addObject:sit->obj];
+    }
+    pthread_mutex_unlock(&selectLock);
+    
+    return objs;
+}
+
+- (NSArray *)findSelectablesInScreenPolygon:(const std::vector<WhirlyKit::Point2f> &)screenPoly placement:(const WhirlyKit::SelectionManager::PlacementInfo &)pInfo
+{
+    if (isShuttingDown || !scene)
+        return @[];
+    
+    SelectionManager *selectManager = (SelectionManager *)scene->getManager(kWKSelectionManager);
+    SimpleIDSet selectIDs;
+    selectManager->findObjectsInScreenPolygon(screenPoly, pInfo, selectIDs);
+    
+    return [self selectableObjectsForIDs:selectIDs];
+}
+
+- (NSArray *)findSelectablesInGeoMbr:(const WhirlyKit::GeoMbr &)geoMbr
+{
+    if (isShuttingDown || !scene)
+        return @[];
+    
+    SelectionManager *selectManager = (SelectionManager *)scene->getManager(kWKSelectionManager);
+    SimpleIDSet selectIDs;
+    selectManager->findObjectsInGeoMbr(geoMbr, selectIDs);
+    
+    return [self selectableObjectsForIDs:selectIDs];
+}
+
 - (NSObject*)selectLabelsAndMarkerForScreenPoint:(CGPoint)screenPoint
 {
     return nil;
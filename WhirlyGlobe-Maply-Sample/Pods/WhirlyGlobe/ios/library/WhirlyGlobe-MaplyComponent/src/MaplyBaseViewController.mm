@@ -446,6 +446,7 @@ static const float PerfOutputDelay = 15.0;
         return;
     
     _performanceOutput = performanceOutput;
+    ChangeRequestPool::setStatsEnabled(_performanceOutput);
     if (_performanceOutput)
     {
         renderControl->sceneRenderer.perfInterval = 100;
@@ -908,6 +909,13 @@ static const float PerfOutputDelay = 15.0;
     return CGPointZero;
 }
 
+// Subclasses do this in one go
+- (void)screenPointsFromGeos:(const MaplyCoordinate *)geoCoords numPoints:(int)numPts screenPoints:(CGPoint *)screenPts
+{
+    for (int ii=0;ii<numPts;ii++)
+        screenPts[ii] = [self screenPointFromGeo:geoCoords[ii]];
+}
+
 // Overridden by the subclasses
 - (bool)animateToPosition:(MaplyCoordinate)newPos onScreen:(CGPoint)loc time:(NSTimeInterval)howLong
 {
@@ -1459,6 +1467,75 @@ static const float PerfOutputDelay = 15.0;
     return [renderControl->interactLayer findVectorsInPoint:Point2f(coord.x,coord.y)];
 }
 
+- (void)findSelectablesInScreenPolygon:(NSArray<NSValue *> *)screenPts completion:(void (^)(NSArray *selectedObjs))completion
+{
+    if (!renderControl)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(@[]);
+        });
+        return;
+    }
+    
+    // The view has to be looked at on the main thread
+    if (![NSThread isMainThread])
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self findSelectablesInScreenPolygon:screenPts completion:completion];
+        });
+        return;
+    }
+    
+    std::vector<Point2f> screenPoly;
+    for (NSValue *val in screenPts)
+    {
+        CGPoint pt = [val CGPointValue];
+        screenPoly.push_back(Point2f(pt.x,pt.y));
+    }
+    
+    // Snapshot the view here so the search doesn't see it change underneath
+    std::shared_ptr<SelectionManager::PlacementInfo> pInfo(new SelectionManager::PlacementInfo(visualView,renderControl->sceneRenderer));
+    
+    MaplyBaseInteractionLayer *interactLayer = renderControl->interactLayer;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                   ^{
+                       NSArray *objs = [interactLayer findSelectablesInScreenPolygon:screenPoly placement:*pInfo];
+                       dispatch_async(dispatch_get_main_queue(), ^{
+                           completion(objs);
+                       });
+                   });
+}
+
+- (void)findSelectablesInScreenRect:(CGRect)rect completion:(void (^)(NSArray *selectedObjs))completion
+{
+    NSArray *screenPts = @[[NSValue valueWithCGPoint:CGPointMake(CGRectGetMinX(rect), CGRectGetMinY(rect))],
+                           [NSValue valueWithCGPoint:CGPointMake(CGRectGetMaxX(rect), CGRectGetMinY(rect))],
+                           [NSValue valueWithCGPoint:CGPointMake(CGRectGetMaxX(rect), CGRectGetMaxY(rect))],
+                           [NSValue valueWithCGPoint:CGPointMake(CGRectGetMinX(rect), CGRectGetMaxY(rect))]];
+    [self findSelectablesInScreenPolygon:screenPts completion:completion];
+}
+
+- (void)findSelectablesInBoundingBox:(MaplyBoundingBox)bbox completion:(void (^)(NSArray *selectedObjs))completion
+{
+    if (!renderControl)
+    {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(@[]);
+        });
+        return;
+    }
+    
+    GeoMbr geoMbr(GeoCoord(bbox.ll.x,bbox.ll.y),GeoCoord(bbox.ur.x,bbox.ur.y));
+    MaplyBaseInteractionLayer *interactLayer = renderControl->interactLayer;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                   ^{
+                       NSArray *objs = [interactLayer findSelectablesInGeoMbr:geoMbr];
+                       dispatch_async(dispatch_get_main_queue(), ^{
+                           completion(objs);
+                       });
+                   });
+}
+
 #pragma mark - Properties
 
 - (UIColor *)clearColor
@@ -123,7 +123,7 @@
             data = [res dataForColumn:@"data"];
         }
         if (data && [data length] > 0)
-            uncompressedData = [data uncompressGZip];
+            uncompressedData = [data uncompressGZipWithSizeHint:_tileSizeX*_tileSizeY*sizeof(short)];
         [res close];
     }];
     
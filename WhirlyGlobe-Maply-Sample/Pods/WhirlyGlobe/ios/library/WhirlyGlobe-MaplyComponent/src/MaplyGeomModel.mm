@@ -34,9 +34,50 @@ using namespace Eigen;
     WhirlyKit::SimpleIdentity baseModelID;    
 }
 
-- (instancetype)initWithObj:(NSString *)fullPath
+- (instancetype)init
 {
     self = [super init];
+    _numLods = 1;
+    _lodSize = 128.0;
+    
+    return self;
+}
+
+- (instancetype)initWithObj:(NSString *)fullPath
+{
+    return [self initWithObj:fullPath cache:nil];
+}
+
+- (instancetype)initWithObj:(NSString *)fullPath cache:(NSString *)cachePath
+{
+    self = [self init];
+    
+    // Use the cache if it's at least as new as the model and its material files
+    if (cachePath)
+    {
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        NSDate *objDate = [[fileManager attributesOfItemAtPath:fullPath error:nil] fileModificationDate];
+        NSDate *cacheDate = [[fileManager attributesOfItemAtPath:cachePath error:nil] fileModificationDate];
+        std::vector<std::string> depFiles;
+        if (objDate && cacheDate && [cacheDate compare:objDate] != NSOrderedAscending &&
+            ReadGeometryRawCache([cachePath fileSystemRepresentation],depFiles,textures,rawGeom))
+        {
+            bool upToDate = true;
+            for (const std::string &depFile : depFiles)
+            {
+                NSDate *depDate = [[fileManager attributesOfItemAtPath:[NSString stringWithUTF8String:depFile.c_str()] error:nil] fileModificationDate];
+                if (!depDate || [cacheDate compare:depDate] == NSOrderedAscending)
+                {
+                    upToDate = false;
+                    break;
+                }
+            }
+            if (upToDate)
+                return self;
+        }
+        textures.clear();
+        rawGeom.clear();
+    }
     
     const char *str = [fullPath cStringUsingEncoding:NSASCIIStringEncoding];
     FILE *fp = fopen(str, "r");
@@ -45,17 +86,26 @@ using namespace Eigen;
     
     // Parse it out of the file
     GeometryModelOBJ objModel;
-    if (!objModel.parse(fp))
+    bool success = objModel.parse(fp);
+    fclose(fp);
+    if (!success)
         return nil;
     
     objModel.toRawGeometry(textures,rawGeom);
     
+    // Models get instanced a lot, so it's worth tidying up the meshes once here
+    for (auto &geom : rawGeom)
+        geom.optimize();
+    
+    if (cachePath && !WriteGeometryRawCache([cachePath fileSystemRepresentation],objModel.mtlFiles,textures,rawGeom))
+        NSLog(@"MaplyGeomModel: Failed to write model cache to %@",cachePath);
+    
     return self;
 }
 
 - (instancetype)initWithShape:(MaplyShape *)inShape;
 {
-    self = [super init];
+    self = [self init];
     
     shape = inShape;
     // Note: Not supporting the linears at the moment
@@ -203,7 +253,7 @@ using namespace Eigen;
             procGeom.push_back(it.second);
         
         GeometryManager *geomManager = (GeometryManager *)layer->scene->getManager(kWKGeometryManager);
-        baseModelID = geomManager->addBaseGeometry(procGeom, changes);
+        baseModelID = geomManager->addBaseGeometry(procGeom, _numLods, _lodSize, changes);
 
         // Need to flush these changes immediately
         layer->scene->addChangeRequests(changes);
@@ -33,6 +33,17 @@
 - (int)getNumFrames;
 @end
 
+@interface MaplyQuadImageFrameStatus()
+
+@property (nonatomic,readwrite) int numTilesLoaded;
+@property (nonatomic,readwrite) int numTiles;
+@property (nonatomic,readwrite) bool fullyLoaded;
+
+@end
+
+@implementation MaplyQuadImageFrameStatus
+@end
+
 namespace WhirlyKit
 {
 
@@ -172,36 +183,61 @@ public:
         return false;
     }
     
-    // Fetch the tile frames.  Just fetch them all for now.
-    void startFetching(MaplyQuadImageFrameLoader *loader,NSMutableArray *toStart,NSArray<NSObject<MaplyTileInfoNew> *> *frameInfos) {
+    // Fetch the tile frames we don't have yet.
+    // If we're streaming, only the frames with a priority (how soon we'll need them) are fetched.
+    void startFetching(MaplyQuadImageFrameLoader *loader,NSMutableArray *toStart,NSArray<NSObject<MaplyTileInfoNew> *> *frameInfos,const std::vector<int> &framePriorities) {
         state = Active;
         
         int frame = 0;
         for (MaplyRemoteTileInfoNew *frameInfo in frameInfos) {
-            MaplyTileID tileID;  tileID.level = ident.level;  tileID.x = ident.x;  tileID.y = ident.y;
-            id fetchInfo = [frameInfo fetchInfoForTile:tileID];
-            if (fetchInfo) {
-                MaplyTileFetchRequest *request = frames[frame]->setupFetch(fetchInfo,frameInfo,1,ident.importance * loader.importanceScale);
-                
-                // We need all the min levels to display a a frame, so bump this up a bit
-                if (tileID.level == loader->minLevel)
-                    request.priority = request.priority - 1;
-        
-                request.success = ^(MaplyTileFetchRequest *request, NSData *data) {
-                    [loader fetchRequestSuccess:request tileID:tileID frame:frame data:data];
-                };
-                request.failure = ^(MaplyTileFetchRequest *request, NSError *error) {
-                    [loader fetchRequestFail:request tileID:tileID frame:frame error:error];
-                };
-                [toStart addObject:request];
-            } else {
-                frames[frame]->loadSkipped();
+            bool wanted = framePriorities.empty() || (frame < framePriorities.size() && framePriorities[frame] >= 0);
+            if (wanted && frames[frame]->getState() == QIFFrameAsset::Empty) {
+                MaplyTileID tileID;  tileID.level = ident.level;  tileID.x = ident.x;  tileID.y = ident.y;
+                id fetchInfo = [frameInfo fetchInfoForTile:tileID];
+                if (fetchInfo) {
+                    int priority = framePriorities.empty() ? 1 : 1 + framePriorities[frame];
+                    MaplyTileFetchRequest *request = frames[frame]->setupFetch(fetchInfo,frameInfo,priority,ident.importance * loader.importanceScale);
+                    
+                    // We need all the min levels to display a a frame, so bump this up a bit
+                    if (tileID.level == loader->minLevel)
+                        request.priority = request.priority - 1;
+            
+                    request.success = ^(MaplyTileFetchRequest *request, NSData *data) {
+                        [loader fetchRequestSuccess:request tileID:tileID frame:frame data:data];
+                    };
+                    request.failure = ^(MaplyTileFetchRequest *request, NSError *error) {
+                        [loader fetchRequestFail:request tileID:tileID frame:frame error:error];
+                    };
+                    [toStart addObject:request];
+                } else {
+                    frames[frame]->loadSkipped();
+                }
             }
             frame++;
         }
         
     }
     
+    // Streaming window moved.  Let go of the frames outside it, fetch the new ones and reorder the ones in flight.
+    void updateFrameWindow(MaplyQuadImageFrameLoader *loader,NSObject<MaplyTileFetcher> *tileFetcher,NSMutableArray *toStart,NSMutableArray *toCancel,
+                           NSArray<NSObject<MaplyTileInfoNew> *> *frameInfos,const std::vector<int> &framePriorities,ChangeSet &changes) {
+        if (state != Active)
+            return;
+        
+        for (unsigned int ii=0;ii<frames.size() && ii<framePriorities.size();ii++) {
+            auto frame = frames[ii];
+            if (framePriorities[ii] < 0) {
+                if (frame->getState() != QIFFrameAsset::Empty)
+                    frame->clear(toCancel, changes);
+            } else if (frame->getState() == QIFFrameAsset::Loading) {
+                int priority = 1 + framePriorities[ii] - (ident.level == loader->minLevel ? 1 : 0);
+                frame->updateFetching(tileFetcher, priority, ident.importance * loader.importanceScale);
+            }
+        }
+        
+        startFetching(loader, toStart, frameInfos, framePriorities);
+    }
+    
     // True if the given frame is loading
     bool isFrameLoading(int which) {
         if (which < 0 || which >= frames.size())
@@ -619,6 +655,12 @@ using namespace WhirlyKit;
     MaplyQuadImageFrameLoaderUpdater *updater;
     
     bool changesSinceLastFlush;
+    
+    // Streaming only.  Where the playhead was last and which way it's going (main thread).
+    int lastWindowCenter,lastWindowDir;
+    
+    // Streaming only.  How soon we'll need each frame, or -1 if it's outside the window (layer thread).
+    std::vector<int> framePriorities;
 }
 
 - (nullable instancetype)initWithParams:(MaplySamplingParams *__nonnull)inParams tileInfos:(NSArray<NSObject<MaplyTileInfoNew> *> *__nonnull)inFrameInfos viewC:(MaplyBaseViewController * __nonnull)inViewC
@@ -648,9 +690,14 @@ using namespace WhirlyKit;
     self.importanceScale = 1.0;
     self.importanceCutoff = 0.0;
     self.imageFormat = MaplyImageIntRGBA;
+    self.etc2Quality = MaplyETC2QualityFast;
+    self.mipmapFilter = MaplyMipmapNone;
     self.borderTexel = 0;
     self.color = [UIColor whiteColor];
+    self.frameWindow = 0;
     self->texType = GL_UNSIGNED_BYTE;
+    lastWindowCenter = 0;
+    lastWindowDir = 1;
     changesSinceLastFlush = true;
     valid = true;
     
@@ -670,6 +717,10 @@ using namespace WhirlyKit;
             self->loadInterp = [[MaplyImageLoaderInterpreter alloc] init];
         }
         
+        // Set up the streaming window before any tiles show up
+        if (self.frameWindow > 0)
+            self->framePriorities = [self framePrioritiesForCenter:self->lastWindowCenter dir:self->lastWindowDir];
+        
         self->samplingLayer = [self->viewC findSamplingLayer:inParams forUser:self];
         
         // They changed it, so make sure the cutoff still works
@@ -705,6 +756,12 @@ using namespace WhirlyKit;
             case MaplyImageUByteRGB:
                 self->texType = GL_ALPHA;
                 break;
+            case MaplyImageETC2RGB8:
+                self->texType = GL_COMPRESSED_RGB8_ETC2;
+                break;
+            case MaplyImageETC2RGBA8:
+                self->texType = GL_COMPRESSED_RGBA8_ETC2_EAC;
+                break;
         }
 
         if (self->shaderID == EmptyIdentity) {
@@ -722,7 +779,91 @@ using namespace WhirlyKit;
 
 - (void)setCurrentImage:(double)where
 {
-    curFrame = std::min(std::max(where,0.0),(double)([frameInfos count]-1));
+    double newFrame = std::min(std::max(where,0.0),(double)([frameInfos count]-1));
+    
+    // If we're streaming, let the layer thread know when the playhead gets to a new frame
+    if (self.frameWindow > 0 && samplingLayer) {
+        int numFrames = [frameInfos count];
+        int center = floor(newFrame);
+        int dir = lastWindowDir;
+        // A big jump is the animation looping back around, not a change of direction
+        if (fabs(newFrame - curFrame) < numFrames/2.0) {
+            if (newFrame > curFrame)
+                dir = 1;
+            else if (newFrame < curFrame)
+                dir = -1;
+        }
+        if (center != lastWindowCenter || dir != lastWindowDir) {
+            lastWindowCenter = center;
+            lastWindowDir = dir;
+            [self performSelector:@selector(updateFrameWindow:) onThread:samplingLayer.layerThread withObject:@[@(center),@(dir)] waitUntilDone:NO];
+        }
+    }
+
+    curFrame = newFrame;
+}
+
+// Work out how soon we'll need each frame.  The current and next frames go first,
+//  then the ones ahead in the direction we're playing, wrapping around at the ends.
+- (std::vector<int>)framePrioritiesForCenter:(int)center dir:(int)dir
+{
+    int numFrames = [frameInfos count];
+    std::vector<int> priorities(numFrames,-1);
+    if (numFrames == 0)
+        return priorities;
+    
+    int windowSize = std::min(std::max(self.frameWindow,2),numFrames);
+    std::vector<int> order;
+    order.push_back(center);
+    order.push_back(center+1);
+    for (int ii=1;(int)order.size()<windowSize && ii<numFrames;ii++)
+        order.push_back(dir > 0 ? center+1+ii : center-ii);
+    
+    int priority = 0;
+    for (int frame : order) {
+        frame = ((frame % numFrames) + numFrames) % numFrames;
+        if (priorities[frame] < 0)
+            priorities[frame] = priority++;
+    }
+    
+    return priorities;
+}
+
+// Called on SamplingLayer.layerThread
+- (void)updateFrameWindow:(NSArray *)args
+{
+    if (!valid)
+        return;
+    
+    framePriorities = [self framePrioritiesForCenter:[args[0] intValue] dir:[args[1] intValue]];
+    
+    ChangeSet changes;
+    NSMutableArray *toCancel = [NSMutableArray array];
+    NSMutableArray *toStart = [NSMutableArray array];
+    for (auto it : tiles)
+        it.second->updateFrameWindow(self, tileFetcher, toStart, toCancel, frameInfos, framePriorities, changes);
+    [tileFetcher cancelTileFetches:toCancel];
+    [tileFetcher startTileFetches:toStart];
+    
+    [layer.layerThread addChangeRequests:changes];
+    changesSinceLastFlush = true;
+}
+
+- (nullable NSArray<MaplyQuadImageFrameStatus *> *)getFrameStatus
+{
+    if (renderState.tilesLoaded.empty())
+        return nil;
+    
+    NSMutableArray *status = [NSMutableArray array];
+    for (unsigned int ii=0;ii<renderState.tilesLoaded.size();ii++) {
+        MaplyQuadImageFrameStatus *frameStatus = [[MaplyQuadImageFrameStatus alloc] init];
+        frameStatus.numTiles = (int)renderState.tiles.size();
+        frameStatus.numTilesLoaded = renderState.tilesLoaded[ii];
+        frameStatus.fullyLoaded = renderState.topTilesLoaded[ii];
+        [status addObject:frameStatus];
+    }
+    
+    return status;
 }
 
 - (int)getNumFrames
@@ -762,7 +903,7 @@ using namespace WhirlyKit;
     if ([self shouldLoad:ident]) {
         if (self.debugMode)
             NSLog(@"Starting fetch for tile %d: (%d,%d)",ident.level,ident.x,ident.y);
-        newTile->startFetching(self, toStart, frameInfos);
+        newTile->startFetching(self, toStart, frameInfos, framePriorities);
     }
     
     return newTile;
@@ -820,17 +961,55 @@ using namespace WhirlyKit;
     if (!tile->isFrameLoading(loadReturn.frame))
         return;
     
-    // Do the parsing on another thread since it can be slow
-    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [self addBuildJob:loadReturn];
+}
+
+// Called on the SamplingLayer.LayerThread
+// Do the parsing on the build queue since it can be slow
+- (void)addBuildJob:(MaplyLoaderReturn *)loadReturn
+{
+    if (!valid)
+        return;
+    
+    QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
+    auto it = tiles.find(ident);
+    if (it == tiles.end() || !it->second->isFrameLoading(loadReturn.frame))
+        return;
+    auto tile = it->second;
+    
+    buildQueue->addJob(tile->getIdent().importance,TileGenerationRef(),0,
+    ^{
         [self->loadInterp parseData:loadReturn];
         
         [self performSelector:@selector(mergeLoadedTile:) onThread:self->samplingLayer.layerThread withObject:loadReturn waitUntilDone:NO];
+    },
+    ^{
+        [self performSelector:@selector(mergeDroppedTile:) onThread:self->samplingLayer.layerThread withObject:loadReturn waitUntilDone:NO];
     });
 }
 
+// Called on the SamplingLayer.LayerThread
+// Build queue was full, so hang on to the data and try again when there's room.
+// Nothing else would fetch this frame again outside of streaming mode, so we can't just fail it.
+- (void)mergeDroppedTile:(MaplyLoaderReturn *)loadReturn
+{
+    QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
+    auto it = tiles.find(ident);
+    if (it == tiles.end() || !it->second->isFrameLoading(loadReturn.frame))
+        return;
+    
+    if (self.debugMode)
+        NSLog(@"MaplyQuadImageLoader: Dropped frame %d for tile %d: (%d,%d) from the build queue",loadReturn.frame,ident.level,ident.x,ident.y);
+    
+    [self keepDroppedLoad:loadReturn];
+}
+
 // Called on the SamplingLayer.LayerThread
 - (void)mergeLoadedTile:(MaplyLoaderReturn *)loadReturn
 {
+    // That's one less in the build queue, so there may be room for something it dropped
+    [self resubmitDroppedLoads];
+    
     QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
     auto it = tiles.find(ident);
     // Tile disappeared in the mean time, so drop it
@@ -841,6 +1020,13 @@ using namespace WhirlyKit;
     }
     auto tile = it->second;
     
+    // Frame was dropped in the mean time, probably because it left the streaming window
+    if (!tile->isFrameLoading(loadReturn.frame)) {
+        if (self.debugMode)
+            NSLog(@"MaplyQuadImageLoader: Dropping frame %d for tile %d: (%d,%d)",loadReturn.frame,loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y);
+        return;
+    }
+    
     // Build the texture
     WhirlyKitLoadedTile *loadTile = [loadReturn.images count] > 0 ? [loadReturn.images objectAtIndex:0] : nil;
     Texture *tex = NULL;
@@ -852,6 +1038,12 @@ using namespace WhirlyKit;
                 // Build the image
                 tex = [loadedImage buildTexture:self.borderTexel destWidth:loadedImage.width destHeight:loadedImage.height];
                 tex->setFormat(texType);
+                // Mipmap levels are cheaper to build here than with glGenerateMipmap() on the main thread
+                if (self.mipmapFilter != MaplyMipmapNone && tex->buildMipmaps(self.mipmapFilter == MaplyMipmapKaiser ? WKMipFilterKaiser : WKMipFilterBox))
+                    tex->setUsesMipmaps(true);
+                // Encoding to ETC2 is slow, so do it here rather than on the main thread
+                tex->setETC2Quality((WKETC2Quality)self.etc2Quality);
+                tex->compressETC2();
             }
         }
     }
@@ -1070,7 +1262,7 @@ using namespace WhirlyKit;
             if (tile->getState() == QIFTileAsset::Waiting) {
                 if (self.debugMode)
                     NSLog(@"Tile switched from Wait to Fetch %d: (%d,%d) importance = %f",ident.level,ident.x,ident.y,ident.importance);
-                tile->startFetching(self, toStart, frameInfos);
+                tile->startFetching(self, toStart, frameInfos, framePriorities);
                 if (loadedTile)
                     tile->setShouldEnable(loadedTile->enabled);
                 somethingChanged = true;
@@ -1104,6 +1296,9 @@ using namespace WhirlyKit;
 
 - (void)quadBuilderPreSceneFlush:(WhirlyKitQuadTileBuilder * _Nonnull)builder
 {
+    // Jobs the build queue skipped as stale don't come back to us, so check for room here too
+    [self resubmitDroppedLoads];
+    
     if (!changesSinceLastFlush)
         return;
     
@@ -1123,6 +1318,9 @@ using namespace WhirlyKit;
 {
     ChangeSet changes;
     
+    buildQueue->cancelAll();
+    [droppedLoads removeAllObjects];
+    
     NSMutableArray *toCancel = [NSMutableArray array];
     for (auto tile : tiles) {
         tile.second->clear(toCancel, changes);
@@ -40,7 +40,7 @@ typedef std::shared_ptr<TileAsset> TileAssetRef;
 class TileAsset
 {
 public:
-    TileAsset() : drawPriority(0), compObjs(nil), ovlCompObjs(nil), enable(false), state(Waiting)
+    TileAsset() : drawPriority(0), compObjs(nil), ovlCompObjs(nil), enable(false), state(Waiting), importance(0.0), generation(new TileGeneration())
     { }
 
     // Tile is doing what?
@@ -49,6 +49,7 @@ public:
 
     // Completely clear out the tile geometry
     void clear(MaplyBaseInteractionLayer *interactLayer,ChangeSet &changes) {
+        generation->bump();
         clearToBlank(interactLayer, changes, Waiting);
         for (auto drawID : instanceDrawIDs)
             changes.push_back(new RemDrawableReq(drawID));
@@ -83,6 +84,7 @@ public:
     // Kick off the request and keep track of the handle for later
     void startFetch(NSObject<MaplyTileFetcher> *tileFetcher,NSArray<MaplyTileFetchRequest *> *requests) {
         state = Loading;
+        generation->bump();
         for (MaplyTileFetchRequest *request in requests)
             fetchHandles.push_back(request);
         [tileFetcher startTileFetches:requests];
@@ -98,8 +100,18 @@ public:
             }
         [tileFetcher cancelTileFetches:toCancel];
         state = Waiting;
+        // Anything already parsing for this tile is now stale
+        generation->bump();
     }
     
+    // Generation changes every time we start or stop a fetch
+    int getGeneration() { return generation->current(); }
+    TileGenerationRef getGenerationRef() { return generation; }
+    
+    // Importance as of the last fetch.  Decides the order we build in.
+    double getImportance() { return importance; }
+    void setImportance(double newImportance) { importance = newImportance; }
+    
     // Called after a completed load
     bool dataWasLoaded(MaplyTileFetchRequest *request,NSData *loadedData) {
         bool anyLoading = false;
@@ -322,6 +334,12 @@ protected:
     
     // Data returned by the fetcher, in case we have more than one tile info
     std::vector<NSData *> fetchedData;
+    
+    // Used to sort the build queue
+    double importance;
+    
+    // Shared with the build queue so it can skip work for tiles that have moved on
+    TileGenerationRef generation;
 };
 
 typedef std::map<QuadTreeNew::Node,TileAssetRef> TileAssetMap;
@@ -409,6 +427,9 @@ using namespace WhirlyKit;
 
 @end
 
+// Tiles waiting to be parsed beyond this get dropped, least important first
+static const int MaxBuildQueueSize = 128;
+
 @implementation MaplyQuadImageLoaderBase
 
 - (instancetype)init
@@ -417,10 +438,32 @@ using namespace WhirlyKit;
     
     _zBufferRead = false;
     _zBufferWrite = true;
+    buildQueue = TileBuildQueueRef(new TileBuildQueue(0,MaxBuildQueueSize));
+    droppedLoads = [NSMutableArray array];
     
     return self;
 }
 
+- (void)addBuildJob:(MaplyLoaderReturn *)loadReturn
+{
+}
+
+- (void)keepDroppedLoad:(MaplyLoaderReturn *)loadReturn
+{
+    [droppedLoads addObject:loadReturn];
+}
+
+- (void)resubmitDroppedLoads
+{
+    // The subclass sorts out whether they're still wanted and how important they are now
+    while ([droppedLoads count] > 0 && buildQueue->numQueued() < MaxBuildQueueSize)
+    {
+        MaplyLoaderReturn *loadReturn = [droppedLoads objectAtIndex:0];
+        [droppedLoads removeObjectAtIndex:0];
+        [self addBuildJob:loadReturn];
+    }
+}
+
 - (void)setTileFetcher:(NSObject<MaplyTileFetcher> * __nonnull)inTileFetcher
 {
     if (tileFetcher) {
@@ -568,6 +611,8 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     self.importanceScale = 1.0;
     self.importanceCutoff = 0.0;
     self.imageFormat = MaplyImageIntRGBA;
+    self.etc2Quality = MaplyETC2QualityFast;
+    self.mipmapFilter = MaplyMipmapNone;
     self.borderTexel = 0;
     self.color = [UIColor whiteColor];
     self->texType = GL_UNSIGNED_BYTE;
@@ -624,6 +669,12 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
             case MaplyImageUByteRGB:
                 self->texType = GL_ALPHA;
                 break;
+            case MaplyImageETC2RGB8:
+                self->texType = GL_COMPRESSED_RGB8_ETC2;
+                break;
+            case MaplyImageETC2RGBA8:
+                self->texType = GL_COMPRESSED_RGBA8_ETC2_EAC;
+                break;
         }
     });
 
@@ -687,6 +738,7 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
         }
     }
 
+    tile->setImportance(ident.importance * self.importanceScale);
     tile->startFetch(tileFetcher,requests);
 }
 
@@ -766,15 +818,38 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
             [(NSMutableArray *)multiLoadData.multiTileData addObject:allData[ii]];
         multiLoadData.tileData = [multiLoadData.multiTileData objectAtIndex:0];
         
-        // Hand over to another queue to do the parsing, since that can be slow
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-            [self->loadInterp parseData:multiLoadData];
-            
-            [self performSelector:@selector(mergeLoadedTile:) onThread:self->samplingLayer.layerThread withObject:multiLoadData waitUntilDone:NO];
-        });
+        multiLoadData->generation = tile->getGeneration();
+        
+        [self addBuildJob:multiLoadData];
     }
 }
 
+// Called on SamplingLayer.layerThread
+// Hand over to the build queue to do the parsing and texture setup, since that can be slow
+// Visible tiles jump ahead and anything cancelled in the mean time is skipped
+- (void)addBuildJob:(MaplyLoaderReturn *)loadReturn
+{
+    if (!valid)
+        return;
+    
+    QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
+    auto it = tiles.find(ident);
+    if (it == tiles.end() || it->second->getGeneration() != loadReturn->generation)
+        return;
+    auto tile = it->second;
+    
+    buildQueue->addJob(tile->getImportance(),tile->getGenerationRef(),loadReturn->generation,
+    ^{
+        [self->loadInterp parseData:loadReturn];
+        [self buildTextures:loadReturn];
+        
+        [self performSelector:@selector(mergeLoadedTile:) onThread:self->samplingLayer.layerThread withObject:loadReturn waitUntilDone:NO];
+    },
+    ^{
+        [self performSelector:@selector(mergeDroppedTile:) onThread:self->samplingLayer.layerThread withObject:loadReturn waitUntilDone:NO];
+    });
+}
+
 // Called on the SamplingLayer.LayerThread
 - (void)mergeFetchRequest:(NSArray *)retData
 {
@@ -800,11 +875,48 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     [self mergeFetchedData:loadReturn forTile:tile tileID:ident frame:loadReturn.frame request:request];
 }
 
+// Called on a build queue worker
+- (void)buildTextures:(MaplyLoaderReturn *)loadReturn
+{
+    if (loadReturn.error)
+        return;
+    
+    for (WhirlyKitLoadedTile *loadTile in loadReturn.images) {
+        if ([loadTile.images count] > 0) {
+            WhirlyKitLoadedImage *loadedImage = [loadTile.images objectAtIndex:0];
+            if ([loadedImage isKindOfClass:[WhirlyKitLoadedImage class]]) {
+                // Build the image
+                Texture *tex = [loadedImage buildTexture:self.borderTexel destWidth:loadedImage.width destHeight:loadedImage.height];
+                if (!tex)
+                    continue;
+                tex->setFormat(texType);
+                // Mipmap levels are cheaper to build here than with glGenerateMipmap() on the main thread
+                if (self.mipmapFilter != MaplyMipmapNone && tex->buildMipmaps(self.mipmapFilter == MaplyMipmapKaiser ? WKMipFilterKaiser : WKMipFilterBox))
+                    tex->setUsesMipmaps(true);
+                // Encoding to ETC2 is slow, so do it here rather than on the main thread
+                tex->setETC2Quality((WKETC2Quality)self.etc2Quality);
+                tex->compressETC2();
+                loadReturn->texs.push_back(tex);
+            }
+        }
+    }
+}
+
 // Called on SamplingLayer.layerThread
 - (void)mergeLoadedTile:(MaplyLoaderReturn *)loadReturn
 {
-    if (!valid)
+    // Textures we built, but can't use after all
+    std::vector<Texture *> texs = loadReturn->texs;
+    loadReturn->texs.clear();
+
+    if (!valid) {
+        for (auto tex : texs)
+            delete tex;
         return;
+    }
+    
+    // That's one less in the build queue, so there may be room for something it dropped
+    [self resubmitDroppedLoads];
     
     if (self.debugMode)
         NSLog(@"MaplyQuadImageLoader: Merging fetch for %d: (%d,%d)",loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y);
@@ -814,13 +926,15 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     
     QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
     auto it = tiles.find(ident);
-    // Failed, so clean up the objects that may have been created
-    if (it == tiles.end() || loadReturn.error)
+    // Failed or went stale, so clean up the objects that may have been created
+    if (it == tiles.end() || loadReturn.error || it->second->getGeneration() != loadReturn->generation)
     {
         if (loadReturn.compObjs || loadReturn.ovlCompObjs) {
             [viewC removeObjects:loadReturn.compObjs mode:MaplyThreadCurrent];
             [viewC removeObjects:loadReturn.ovlCompObjs mode:MaplyThreadCurrent];
         }
+        for (auto tex : texs)
+            delete tex;
         if (self.debugMode)
             NSLog(@"MaplyQuadImageLoader: Failed to load tile before it was erased %d: (%d,%d)",loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y);
         return;
@@ -831,32 +945,25 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     // Now put its data in place
 
     auto control = viewC.getRenderControl;
-    if (!control)
+    if (!control) {
+        for (auto tex : texs)
+            delete tex;
         return;
+    }
     auto interactLayer = control->interactLayer;
     
     ChangeSet changes;
 
-    // Might get more than one texture back
-    std::vector<Texture *> texs;
+    // Need geometry to put the textures on
     LoadedTileNewRef loadedTile = [builder getLoadedTile:ident];
-    for (WhirlyKitLoadedTile *loadTile in loadReturn.images) {
-        Texture *tex = NULL;
-        if ([loadTile.images count] > 0) {
-            WhirlyKitLoadedImage *loadedImage = [loadTile.images objectAtIndex:0];
-            if ([loadedImage isKindOfClass:[WhirlyKitLoadedImage class]]) {
-                if (loadedTile) {
-                    // Build the image
-                    tex = [loadedImage buildTexture:self.borderTexel destWidth:loadedImage.width destHeight:loadedImage.height];
-                    tex->setFormat(texType);
-                    texs.push_back(tex);
-
-                    if (self.debugMode)
-                        NSLog(@"Loaded %d: (%d,%d) texID = %d",loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y,(int)(tex ? tex->getId() : 0));
-                }
-            }
-        }
+    if (!loadedTile) {
+        for (auto tex : texs)
+            delete tex;
+        texs.clear();
     }
+    if (self.debugMode)
+        for (auto tex : texs)
+            NSLog(@"Loaded %d: (%d,%d) texID = %d",loadReturn.tileID.level,loadReturn.tileID.x,loadReturn.tileID.y,(int)tex->getId());
     
     if (!texs.empty()) {
         if ([loadReturn.ovlCompObjs count] > 0)
@@ -875,6 +982,26 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
     [layer.layerThread addChangeRequests:changes];
 }
 
+// Called on SamplingLayer.layerThread
+// The build queue overflowed and this one lost out.
+// We've already got the data, so hang on to it and try again when there's room.
+// The tile stays Loading, so if it's cancelled in the mean time the data goes stale and is skipped.
+- (void)mergeDroppedTile:(MaplyLoaderReturn *)loadReturn
+{
+    if (!valid)
+        return;
+    
+    QuadTreeNew::Node ident(loadReturn.tileID.x,loadReturn.tileID.y,loadReturn.tileID.level);
+    auto it = tiles.find(ident);
+    if (it == tiles.end() || it->second->getGeneration() != loadReturn->generation)
+        return;
+    
+    if (self.debugMode)
+        NSLog(@"MaplyQuadImageLoader: Dropped tile from the build queue %d: (%d,%d)",ident.level,ident.x,ident.y);
+    
+    [self keepDroppedLoad:loadReturn];
+}
+
 // Called on SamplingLayer.layerThread
 - (void)fetchRequestFail:(MaplyTileFetchRequest *)request tileID:(MaplyTileID)tileID frame:(int)frame error:(NSError *)error
 {
@@ -1080,6 +1207,9 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
 // Turns things on/off and find cover textures
 - (void)quadBuilderPreSceneFlush:(WhirlyKitQuadTileBuilder *)builder
 {
+    // Jobs the build queue skipped as stale don't come back to us, so check for room here too
+    [self resubmitDroppedLoads];
+    
     ChangeSet changes;
     auto control = viewC.getRenderControl;
     auto interactLayer = control->interactLayer;
@@ -1167,6 +1297,7 @@ NSString * const MaplyQuadImageLoaderFetcherName = @"QuadImageLoader";
 
 - (void)shutdown
 {
+    buildQueue->cancelAll();
     tileFetcher = nil;
     loadInterp = nil;
     [viewC releaseSamplingLayer:samplingLayer forUser:self];
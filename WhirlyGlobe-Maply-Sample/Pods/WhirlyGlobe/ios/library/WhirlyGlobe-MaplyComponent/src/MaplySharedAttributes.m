@@ -74,6 +74,7 @@ NSString* const kMaplyRenderTarget = @"rendertarget";
 NSString* const kMaplyShader = @"shader";
 /// An NSDictionary containing uniforms to apply to a shader before drawing
 NSString* const kMaplyShaderUniforms = @"shaderuniforms";
+NSString* const kMaplyCompactVertices = @"compactvertices";
 
 /// Stars, moon, stars, atmosphere
 const int kMaplyStarsDrawPriorityDefault = 0;
@@ -122,6 +123,7 @@ NSString* const kMaplyTextOutlineSize = @"outlineSize";
 NSString* const kMaplyTextLineSpacing = @"lineSpacing";
 /// If outline is being used, we can control the stroke size
 NSString* const kMaplyTextOutlineColor = @"outlineColor";
+NSString* const kMaplyTextSDF = @"sdf";
 NSString* const kMaplyTexSizeX = @"texsizex";
 NSString* const kMaplyTexSizeY = @"texsizey";
 NSString* const kMaplyTextJustify = @"textjustify";
@@ -382,7 +382,8 @@ public:
         VectorRing pts;
         for (unsigned int ii=0;ii<numCoords;ii++)
             pts.push_back(GeoCoord(coords[ii].x,coords[ii].y));
-        areal->loops.push_back(pts);        
+        areal->loops.push_back(pts);
+        areal->clearPrepared();
     }
 }
 
@@ -582,6 +583,7 @@ public:
                     pt.x() = outPt.x();  pt.y() = outPt.y();
                 }
                 lin->calcGeoMbr();
+                lin->clearSegmentIndex();
             } else {
                 VectorLinear3dRef lin3d = std::dynamic_pointer_cast<VectorLinear3d>(*it);
                 if (lin3d)
@@ -592,6 +594,7 @@ public:
                         pt = outPt;
                     }
                     lin3d->calcGeoMbr();
+                    lin3d->clearSegmentIndex();
                 } else {
                     VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
                     if (ar)
@@ -604,6 +607,7 @@ public:
                                 pt.x() = outPt.x() * 180 / M_PI;  pt.y() = outPt.y() * 180 / M_PI;
                             }
                         ar->calcGeoMbr();
+                        ar->clearPrepared();
                     } else {
                         VectorTrianglesRef tri = std::dynamic_pointer_cast<VectorTriangles>(*it);
                         if (tri)
@@ -629,7 +633,7 @@ public:
         VectorArealRef areal = std::dynamic_pointer_cast<VectorAreal>(*it);
         if (areal)
         {
-            if (areal->pointInside(GeoCoord(coord.x,coord.y)))
+            if (areal->pointInsidePrepared(GeoCoord(coord.x,coord.y)))
                 return true;
         } else {
             VectorTrianglesRef tris = std::dynamic_pointer_cast<VectorTriangles>(*it);
@@ -644,100 +648,156 @@ public:
     return false;
 }
 
++ (NSData *)arealIndicesForPoints:(const MaplyCoordinate *)coords numPoints:(int)numCoords inVectors:(NSArray<MaplyVectorObject *> *)vecObjs
+{
+    std::vector<int> which(std::max(numCoords,0),-1);
+    if (numCoords <= 0)
+        return [[NSData alloc] init];
+
+    // Flatten out the areals, remembering which vector object they came from
+    std::vector<VectorArealRef> areals;
+    std::vector<int> arealOwner;
+    int vecIdx = 0;
+    for (MaplyVectorObject *vecObj in vecObjs)
+    {
+        for (auto shape : vecObj.shapes)
+        {
+            VectorArealRef areal = std::dynamic_pointer_cast<VectorAreal>(shape);
+            if (areal)
+            {
+                areals.push_back(areal);
+                arealOwner.push_back(vecIdx);
+            }
+        }
+        vecIdx++;
+    }
+
+    if (!areals.empty())
+    {
+        std::vector<GeoCoord> pts(numCoords);
+        for (int ii=0;ii<numCoords;ii++)
+            pts[ii] = GeoCoord(coords[ii].x,coords[ii].y);
+        PointsInAreals(pts, areals, which);
+        for (int &idx : which)
+            if (idx >= 0)
+                idx = arealOwner[idx];
+    }
+
+    return [[NSData alloc] initWithBytes:&which[0] length:sizeof(int)*which.size()];
+}
+
+// Screen distance from p to the segment a-b
+static double ScreenDistToSegment(CGPoint p,CGPoint a,CGPoint b)
+{
+    CGPoint aToP = CGPointMake(a.x - p.x, a.y - p.y);
+    CGPoint aToB = CGPointMake(a.x - b.x, a.y - b.y);
+    double aToBMagitude = aToB.x * aToB.x + aToB.y * aToB.y;
+    if (aToBMagitude == 0.0)
+        return hypot(p.x - a.x, p.y - a.y);
+    double dot = aToP.x * aToB.x + aToP.y * aToB.y;
+    double d = dot/aToBMagitude;
+    
+    if(d < 0)
+        return hypot(p.x - a.x, p.y - a.y);
+    else if(d > 1)
+        return hypot(p.x - b.x, p.y - b.y);
+    
+    return hypot(p.x - a.x + (aToB.x * d),
+                 p.y - a.y + (aToB.y * d));
+}
+
 //Fuzzy matching for selecting Linear features
 - (bool)pointNearLinear:(MaplyCoordinate)coord distance:(float)maxDistance inViewController:(MaplyBaseViewController *)vc
 {
+    // Project the point and a couple of neighbors to see how far maxDistance reaches around it
+    const double ProbeEps = 1e-4;
+    MaplyCoordinate probes[3];
+    probes[0] = coord;
+    probes[1].x = coord.x + ProbeEps;  probes[1].y = coord.y;
+    probes[2].x = coord.x;  probes[2].y = coord.y + ProbeEps;
+    CGPoint probePts[3];
+    [vc screenPointsFromGeos:probes numPoints:3 screenPoints:probePts];
+    CGPoint p = probePts[0];
+    if (isnan(p.x) || isnan(p.y))
+        return false;
+
+    // The radius covers the worst direction through the local Jacobian, doubled for curvature
+    Point2f geoDist(MAXFLOAT,MAXFLOAT);
+    double jxx = (probePts[1].x - p.x)/ProbeEps, jyx = (probePts[1].y - p.y)/ProbeEps;
+    double jxy = (probePts[2].x - p.x)/ProbeEps, jyy = (probePts[2].y - p.y)/ProbeEps;
+    double det = std::abs(jxx*jyy - jxy*jyx);
+    if (!isnan(det) && det > 0.0)
+    {
+        double rad = 2.0 * maxDistance * sqrt(jxx*jxx + jyx*jyx + jxy*jxy + jyy*jyy) / det;
+        geoDist = Point2f(rad,rad);
+    }
+    GeoCoord geoCoord(coord.x,coord.y);
+
+    // Gather up the runs of segments that are close enough to matter
+    std::vector<MaplyCoordinate> coords;
+    std::vector<int> runEnds;
+    std::vector<int> starts;
     for (ShapeSet::iterator it = _shapes.begin();it != _shapes.end();++it)
     {
+        GeoMbr geoMbr;
+        LinearSegmentIndexRef segIndex;
         VectorLinearRef linear = std::dynamic_pointer_cast<VectorLinear>(*it);
+        VectorLinear3dRef linear3d;
+        int numPts = 0;
         if (linear)
         {
-            GeoMbr geoMbr = linear->calcGeoMbr();
-            if(geoMbr.inside(GeoCoord(coord.x,coord.y)))
-            {
-                CGPoint p = [vc screenPointFromGeo:coord];
-                VectorRing pts = linear->pts;
-                float distance;
-                for (int ii=0;ii<pts.size()-1;ii++)
-                {
-                    distance = MAXFLOAT;
-                    Point2f p0 = pts[ii];
-                    MaplyCoordinate pc;
-                    pc.x = p0.x();
-                    pc.y = p0.y();
-                    CGPoint a = [vc screenPointFromGeo:pc];
-
-                    Point2f p1 = pts[ii + 1];
-                    pc.x = p1.x();
-                    pc.y = p1.y();
-                    CGPoint b = [vc screenPointFromGeo:pc];
-                    
-                    CGPoint aToP = CGPointMake(a.x - p.x, a.y - p.y);
-                    CGPoint aToB = CGPointMake(a.x - b.x, a.y - b.y);
-                    double aToBMagitude = pow(hypot(aToB.x, aToB.y), 2);
-                    double dot = aToP.x * aToB.x + aToP.y * aToB.y;
-                    double d = dot/aToBMagitude;
-                    
-                    if(d < 0)
-                    {
-                        distance = hypot(p.x - a.x, p.y - a.y);
-                    } else if(d > 1) {
-                        distance = hypot(p.x - b.x, p.y - b.y);
-                    } else {
-                        distance = hypot(p.x - a.x + (aToB.x * d),
-                                         p.y - a.y + (aToB.y * d));
-                    }
-                    
-                    if (distance < maxDistance)
-                        return true;
-                }
-            }
+            geoMbr = linear->calcGeoMbr();
+            numPts = (int)linear->pts.size();
         } else {
-            VectorLinear3dRef linear3d = std::dynamic_pointer_cast<VectorLinear3d>(*it);
-            if (linear3d)
+            linear3d = std::dynamic_pointer_cast<VectorLinear3d>(*it);
+            if (!linear3d)
+                continue;
+            geoMbr = linear3d->calcGeoMbr();
+            numPts = (int)linear3d->pts.size();
+        }
+        if (numPts < 2 ||
+            geoCoord.x() < geoMbr.ll().x() - geoDist.x() || geoCoord.x() > geoMbr.ur().x() + geoDist.x() ||
+            geoCoord.y() < geoMbr.ll().y() - geoDist.y() || geoCoord.y() > geoMbr.ur().y() + geoDist.y())
+            continue;
+        
+        starts.clear();
+        segIndex = linear ? linear->getSegmentIndex() : linear3d->getSegmentIndex();
+        segIndex->findRuns(geoCoord, geoDist, starts);
+        for (int start : starts)
+        {
+            int end = std::min(start + LinearSegmentIndex::RunSize, numPts-1);
+            for (int ii=start;ii<=end;ii++)
             {
-                GeoMbr geoMbr = linear3d->calcGeoMbr();
-                if(geoMbr.inside(GeoCoord(coord.x,coord.y)))
+                MaplyCoordinate pc;
+                if (linear)
                 {
-                    CGPoint p = [vc screenPointFromGeo:coord];
-                    VectorRing3d pts = linear3d->pts;
-                    float distance;
-                    for (int ii=0;ii<pts.size()-1;ii++)
-                    {
-                        distance = MAXFLOAT;
-                        Point3d p0 = pts[ii];
-                        MaplyCoordinate pc;
-                        pc.x = p0.x();
-                        pc.y = p0.y();
-                        CGPoint a = [vc screenPointFromGeo:pc];
-                        
-                        Point3d p1 = pts[ii + 1];
-                        pc.x = p1.x();
-                        pc.y = p1.y();
-                        CGPoint b = [vc screenPointFromGeo:pc];
-                        
-                        CGPoint aToP = CGPointMake(a.x - p.x, a.y - p.y);
-                        CGPoint aToB = CGPointMake(a.x - b.x, a.y - b.y);
-                        double aToBMagitude = pow(hypot(aToB.x, aToB.y), 2);
-                        double dot = aToP.x * aToB.x + aToP.y * aToB.y;
-                        double d = dot/aToBMagitude;
-                        
-                        if(d < 0)
-                        {
-                            distance = hypot(p.x - a.x, p.y - a.y);
-                        } else if(d > 1) {
-                            distance = hypot(p.x - b.x, p.y - b.y);
-                        } else {
-                            distance = hypot(p.x - a.x + (aToB.x * d),
-                                             p.y - a.y + (aToB.y * d));
-                        }
-                        
-                        if (distance < maxDistance)
-                            return true;
-                    }
+                    pc.x = linear->pts[ii].x();  pc.y = linear->pts[ii].y();
+                } else {
+                    pc.x = linear3d->pts[ii].x();  pc.y = linear3d->pts[ii].y();
                 }
+                coords.push_back(pc);
             }
+            runEnds.push_back(coords.size());
+        }
+    }
+    if (coords.empty())
+        return false;
+    
+    // Project them all in one go and then check the segments
+    std::vector<CGPoint> screenPts(coords.size());
+    [vc screenPointsFromGeos:&coords[0] numPoints:(int)coords.size() screenPoints:&screenPts[0]];
+    int runStart = 0;
+    for (int runEnd : runEnds)
+    {
+        for (int ii=runStart;ii<runEnd-1;ii++)
+        {
+            const CGPoint &a = screenPts[ii], &b = screenPts[ii+1];
+            if (isnan(a.x) || isnan(a.y) || isnan(b.x) || isnan(b.y))
+                continue;
+            if (ScreenDistToSegment(p, a, b) < maxDistance)
+                return true;
         }
+        runStart = runEnd;
     }
     
     return false;
@@ -1329,6 +1389,7 @@ public:
             std::vector<Point2f> outPts;
             SubdivideEdgesToSurface(lin->pts, outPts, false, &adapter, epsilon);
             lin->pts = outPts;
+            lin->clearSegmentIndex();
         } else {
             VectorLinear3dRef lin3d = std::dynamic_pointer_cast<VectorLinear3d>(*it);
             if (lin3d)
@@ -1336,6 +1397,7 @@ public:
                 VectorRing3d outPts;
                 SubdivideEdgesToSurface(lin3d->pts, outPts, false, &adapter, epsilon);
                 lin3d->pts = outPts;
+                lin3d->clearSegmentIndex();
             } else {
                 VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
                 if (ar)
@@ -1346,6 +1408,7 @@ public:
                         SubdivideEdgesToSurface(ar->loops[ii], outPts, true, &adapter, epsilon);
                         ar->loops[ii] = outPts;
                     }
+                    ar->clearPrepared();
                 }
             }
         }
@@ -1395,6 +1458,7 @@ public:
                 lin->pts = offsetPts2D;
             } else
                 lin->pts = outPts2D;
+            lin->clearSegmentIndex();
         } else {
             VectorLinear3dRef lin3d = std::dynamic_pointer_cast<VectorLinear3d>(*it);
             if (lin3d)
@@ -1408,6 +1472,7 @@ public:
                     outPts[ii] = Point3d(outPt.x(),outPt.y(),0.0);
                 }
                 lin3d->pts = outPts;
+                lin3d->clearSegmentIndex();
             } else {
                 VectorArealRef ar = std::dynamic_pointer_cast<VectorAreal>(*it);
                 if (ar)
@@ -1422,6 +1487,7 @@ public:
                             outPts2D[ii] = coordSys->localToGeographic(adapter->displayToLocal(outPts[ii]));
                         ar->loops[ii] = outPts2D;
                     }
+                    ar->clearPrepared();
                 }
             }
         }
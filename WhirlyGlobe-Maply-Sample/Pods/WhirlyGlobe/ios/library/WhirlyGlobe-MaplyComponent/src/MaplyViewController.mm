@@ -1300,6 +1300,25 @@ using namespace Maply;
     return [theView pointOnScreenFromPlane:pt transform:&modelTrans frameSize:Point2f(renderControl->sceneRenderer.framebufferWidth/glView.contentScaleFactor,renderControl->sceneRenderer.framebufferHeight/glView.contentScaleFactor)];
 }
 
+- (void)screenPointsFromGeos:(const MaplyCoordinate *)geoCoords numPoints:(int)numPts screenPoints:(CGPoint *)screenPts
+{
+    if (!renderControl)
+    {
+        for (int ii=0;ii<numPts;ii++)
+            screenPts[ii] = CGPointMake(NAN, NAN);
+        return;
+    }
+    
+    CoordSystemDisplayAdapter *coordAdapter = mapView.coordAdapter;
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    std::vector<Point3d> dispPts(numPts);
+    for (int ii=0;ii<numPts;ii++)
+        dispPts[ii] = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(geoCoords[ii].x,geoCoords[ii].y)));
+    
+    Eigen::Matrix4d modelTrans = [mapView calcFullMatrix];
+    [mapView pointsOnScreen:&dispPts[0] numPoints:numPts transform:&modelTrans frameSize:Point2f(renderControl->sceneRenderer.framebufferWidth/glView.contentScaleFactor,renderControl->sceneRenderer.framebufferHeight/glView.contentScaleFactor) screenPts:screenPts];
+}
+
 // See if the given bounding box is all on screen
 - (bool)checkCoverage:(Mbr &)mbr mapView:(MaplyView *)theView height:(float)height margin:(const Point2d &)margin
 {
@@ -20,6 +20,8 @@
 
 #import <Foundation/Foundation.h>
 #import <zlib.h>
+#import "NSData+Zlib.h"
+#import "ZlibInflater.h"
 
 @implementation NSData(zlib)
 - (BOOL)isCompressed
@@ -92,51 +94,15 @@
 
 - (NSData *) uncompressGZip
 {
-    NSData *compressedData = self;
-    
-    if ([compressedData length] == 0) return compressedData;
-    
-    NSUInteger full_length = [compressedData length];
-    NSUInteger half_length = [compressedData length] / 2;
-    
-    NSMutableData *decompressed = [NSMutableData dataWithLength: full_length + half_length];
-    BOOL done = NO;
-    int status;
-    
-    z_stream strm;
-    strm.next_in = (Bytef *)[compressedData bytes];
-    strm.avail_in = (unsigned int)[compressedData length];
-    strm.total_out = 0;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    
-    if (inflateInit2(&strm, (15+32)) != Z_OK) return nil;
-    
-    while (!done) {
-        // Make sure we have enough room and reset the lengths.
-        if (strm.total_out >= [decompressed length]) {
-            [decompressed increaseLengthBy: half_length];
-        }
-        strm.next_out = [decompressed mutableBytes] + strm.total_out;
-        strm.avail_out = (unsigned int)([decompressed length] - strm.total_out);
-        
-        // Inflate another chunk.
-        status = inflate (&strm, Z_SYNC_FLUSH);
-        if (status == Z_STREAM_END) {
-            done = YES;
-        } else if (status != Z_OK) {
-            break;
-        }
-    }
-    if (inflateEnd (&strm) != Z_OK) return nil;
+    return [self uncompressGZipWithSizeHint:0];
+}
+
+- (NSData *) uncompressGZipWithSizeHint:(NSUInteger)sizeHint
+{
+    if ([self length] == 0) return self;
     
-    // Set real length.
-    if (done) {
-        [decompressed setLength: strm.total_out];
-        return [NSData dataWithData: decompressed];
-    } else {
-        return nil;
-    }
+    // Each thread keeps its own inflate state around
+    return WhirlyKit::ZlibInflater::threadInflater()->inflateToData([self bytes], [self length], sizeHint);
 }
 
 @end
@@ -1420,6 +1420,38 @@ using namespace WhirlyGlobe;
     return true;
 }
 
+- (void)screenPointsFromGeos:(const MaplyCoordinate *)geoCoords numPoints:(int)numPts screenPoints:(CGPoint *)screenPts
+{
+    if (!renderControl)
+    {
+        for (int ii=0;ii<numPts;ii++)
+            screenPts[ii] = CGPointMake(NAN, NAN);
+        return;
+    }
+    
+    CoordSystemDisplayAdapter *coordAdapter = visualView.coordAdapter;
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    std::vector<Point3d> dispPts(numPts);
+    for (int ii=0;ii<numPts;ii++)
+        dispPts[ii] = coordAdapter->localToDisplay(coordSys->geographicToLocal3d(GeoCoord(geoCoords[ii].x,geoCoords[ii].y)));
+    
+    Eigen::Matrix4d modelTrans4d = [visualView calcModelMatrix];
+    Eigen::Matrix4d viewTrans4d = [visualView calcViewMatrix];
+    Eigen::Matrix4d modelAndViewMat4d = viewTrans4d * modelTrans4d;
+    Eigen::Matrix4f modelAndViewMat = Matrix4dToMatrix4f(modelAndViewMat4d);
+    Eigen::Matrix4f modelAndViewNormalMat = modelAndViewMat.inverse().transpose();
+
+    [visualView pointsOnScreen:&dispPts[0] numPoints:numPts transform:&modelAndViewMat4d frameSize:Point2f(renderControl->sceneRenderer.framebufferWidth/glView.contentScaleFactor,renderControl->sceneRenderer.framebufferHeight/glView.contentScaleFactor) screenPts:screenPts];
+    
+    // Anything on the far side of the globe doesn't count
+    for (int ii=0;ii<numPts;ii++)
+    {
+        Point3f pt3f(dispPts[ii].x(),dispPts[ii].y(),dispPts[ii].z());
+        if (CheckPointAndNormFacing(pt3f,pt3f.normalized(),modelAndViewMat,modelAndViewNormalMat) < 0.0)
+            screenPts[ii] = CGPointMake(NAN, NAN);
+    }
+}
+
 - (bool)geoPointFromScreen:(CGPoint)screenPt geoCoord:(MaplyCoordinate *)retCoord
 {
     if (!renderControl)
@@ -123,13 +123,19 @@
     if (!_layout.visible)
         return compObjs;
 
+    // Merge with other styles on this tile if the parser is batching
+    int batchBand = tileInfo.batching ? self.styleSet.tileStyleSettings.batchDrawPriorityBand : 0;
+
     // Filled polygons
     if (fillDesc)
     {
         NSMutableArray *tessVecObjs = [NSMutableArray array];
         for (MaplyVectorObject *vecObj in vecObjs)
         {
-            MaplyVectorObject *tessVecObj = [vecObj tesselate];
+            // Tessellate once per tile, no matter how many fill styles share the feature
+            MaplyVectorObject *tessVecObj = [tileInfo derivedVector:vecObj operation:@"tesselate" build:^MaplyVectorObject *{
+                return [vecObj tesselate];
+            }];
             if (tessVecObj)
                 [tessVecObjs addObject:tessVecObj];
         }
@@ -151,9 +157,13 @@
         
         if (include)
         {
-            MaplyComponentObject *compObj = [viewC addVectors:tessVecObjs desc:desc mode:MaplyThreadCurrent];
-            if (compObj)
-                [compObjs addObject:compObj];
+            if (batchBand > 0)
+                [tileInfo batchVectors:tessVecObjs desc:desc band:[desc[kMaplyDrawPriority] intValue] / batchBand category:[self getCategory]];
+            else {
+                MaplyComponentObject *compObj = [viewC addVectors:tessVecObjs desc:desc mode:MaplyThreadCurrent];
+                if (compObj)
+                    [compObjs addObject:compObj];
+            }
         }
     }
     
@@ -178,9 +188,13 @@
 
         if (include)
         {
-            MaplyComponentObject *compObj = [viewC addVectors:vecObjs desc:desc mode:MaplyThreadCurrent];
-            if (compObj)
-                [compObjs addObject:compObj];
+            if (batchBand > 0)
+                [tileInfo batchVectors:vecObjs desc:desc band:[desc[kMaplyDrawPriority] intValue] / batchBand category:[self getCategory]];
+            else {
+                MaplyComponentObject *compObj = [viewC addVectors:vecObjs desc:desc mode:MaplyThreadCurrent];
+                if (compObj)
+                    [compObjs addObject:compObj];
+            }
         }
     }
     
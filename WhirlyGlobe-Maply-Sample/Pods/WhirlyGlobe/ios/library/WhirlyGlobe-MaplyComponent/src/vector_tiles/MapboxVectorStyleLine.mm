@@ -223,27 +223,43 @@ static unsigned int NextPowOf2(unsigned int val)
         return compObjs;
     
     // Turn into linears (if not already) and then clip to the bounds
+    // Other line styles on this tile are likely doing the same thing, so we share the results
     if (_linearClipToBounds) {
         MaplyCoordinate ll = MaplyCoordinateMake(tileInfo.geoBBox.ll.x, tileInfo.geoBBox.ll.y);
         MaplyCoordinate ur = MaplyCoordinateMake(tileInfo.geoBBox.ur.x, tileInfo.geoBBox.ur.y);
+        NSString *clipOp = _dropGridLines ? @"clipLinearDropGrid" : @"clipLinear";
+        bool dropGridLines = _dropGridLines;
         NSMutableArray *outVecObjs = [NSMutableArray array];
         for (MaplyVectorObject *vecObj in vecObjs) {
-            MaplyVectorObject *linVec = nil;
-            if (_dropGridLines)
-                linVec = [vecObj filterClippedEdges];
-            else
-                linVec = [vecObj arealsToLinears];
-            MaplyVectorObject *clipVec = [linVec clipToMbr:ll upperRight:ur];
-            [outVecObjs addObject:clipVec];
+            MaplyVectorObject *clipVec = [tileInfo derivedVector:vecObj operation:clipOp build:^MaplyVectorObject *{
+                MaplyVectorObject *linVec = nil;
+                if (dropGridLines)
+                    linVec = [vecObj filterClippedEdges];
+                else
+                    linVec = [vecObj arealsToLinears];
+                return [linVec clipToMbr:ll upperRight:ur];
+            }];
+            if (clipVec)
+                [outVecObjs addObject:clipVec];
         }
         vecObjs = outVecObjs;
     }
 
     // Subdivide long-ish lines to the globe, if set
+    // This works on a copy so the features (and anything derived from them) stay as they were
     if (_subdivToGlobe > 0.0) {
+        float subdivToGlobe = _subdivToGlobe;
+        NSString *subdivOp = [NSString stringWithFormat:@"subdivideToGlobe:%f",subdivToGlobe];
+        NSMutableArray *outVecObjs = [NSMutableArray array];
         for (MaplyVectorObject *vecObj in vecObjs) {
-            [vecObj subdivideToGlobe:_subdivToGlobe];
+            MaplyVectorObject *subdivVec = [tileInfo derivedVector:vecObj operation:subdivOp build:^MaplyVectorObject *{
+                MaplyVectorObject *newVecObj = [vecObj deepCopy2];
+                [newVecObj subdivideToGlobe:subdivToGlobe];
+                return newVecObj;
+            }];
+            [outVecObjs addObject:subdivVec];
         }
+        vecObjs = outVecObjs;
     }
     
     NSDictionary *desc = lineDesc;
@@ -289,6 +305,9 @@ static unsigned int NextPowOf2(unsigned int val)
     
     if (include)
     {
+        // Keep batched fills on this tile from merging across us
+        if (tileInfo.batching)
+            [tileInfo noteDrawPriority:[desc[kMaplyDrawPriority] intValue]];
         MaplyComponentObject *compObj = [viewC addWideVectors:vecObjs desc:desc mode:MaplyThreadCurrent];
         if (compObj)
             [compObjs addObject:compObj];
@@ -25,9 +25,16 @@
 #import "MapboxVectorStyleRaster.h"
 #import "MapboxVectorStyleSymbol.h"
 
+// We index the layers by zoom level up to this.  Deeper tiles use the last level.
+static const int MaxIndexedZoom = 24;
+
 @implementation MapboxVectorStyleSet
 {
     NSMutableDictionary *layersByUUID;
+    // Source layer name to an array (by zoom level) of the style layers that can display there
+    NSMutableDictionary<NSString *,NSArray<NSArray *> *> *layersBySourceAndZoom;
+    // Max zoom for the sources that specify it
+    NSMutableDictionary<NSString *,NSNumber *> *sourceMaxZooms;
 }
 
 - (id)initWithJSON:(NSData *)styleJSON settings:(MaplyVectorStyleSettings *)settings viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC filter:(bool (^)(NSMutableDictionary * __nonnull))filterBlock
@@ -49,6 +56,16 @@
     _version = [styleDict[@"version"] integerValue];
     _constants = styleDict[@"constants"];
     _spriteURL = styleDict[@"sprite"];
+    _tileMaxZoom = -1;
+    sourceMaxZooms = [NSMutableDictionary dictionary];
+    NSDictionary *sources = styleDict[@"sources"];
+    if ([sources isKindOfClass:[NSDictionary class]])
+        for (NSString *sourceName in sources)
+        {
+            NSDictionary *source = sources[sourceName];
+            if ([source isKindOfClass:[NSDictionary class]] && source[@"maxzoom"])
+                sourceMaxZooms[sourceName] = @([source[@"maxzoom"] intValue]);
+        }
     NSArray *layerStyles = styleDict[@"layers"];
     NSMutableArray *layers = [NSMutableArray array];
     NSMutableDictionary *sourceLayers = [NSMutableDictionary dictionary];
@@ -86,15 +103,66 @@
     _layersBySource = sourceLayers;
     _layersByName = layersByName;
     
+    [self buildZoomIndex];
+    
     return self;
 }
 
+- (void)setTileMaxZoom:(NSInteger)tileMaxZoom
+{
+    _tileMaxZoom = tileMaxZoom;
+    [self buildZoomIndex];
+}
+
+// Sort out which layers are active at each zoom level so we don't evaluate the rest
+- (void)buildZoomIndex
+{
+    NSMutableDictionary *newIndex = [NSMutableDictionary dictionary];
+    for (NSString *sourceLayer in _layersBySource)
+    {
+        NSArray *sourceEntry = _layersBySource[sourceLayer];
+        NSMutableArray *byZoom = [NSMutableArray arrayWithCapacity:MaxIndexedZoom+1];
+        for (int zoom=0;zoom<=MaxIndexedZoom;zoom++)
+        {
+            NSMutableArray *zoomEntry = [NSMutableArray array];
+            for (MaplyMapboxVectorStyleLayer *layer in sourceEntry)
+            {
+                // Tiles from the deepest level (or if we don't know it) get overzoomed,
+                //  so anything that displays at this level or below counts
+                NSNumber *sourceMaxZoom = layer.source ? sourceMaxZooms[layer.source] : nil;
+                int maxZoom = sourceMaxZoom ? [sourceMaxZoom intValue] : (int)_tileMaxZoom;
+                bool deepest = maxZoom < 0 || zoom >= maxZoom;
+                if ([layer displaysAtZoom:zoom] ||
+                    (deepest && (layer.maxzoom < 0 || layer.maxzoom >= zoom)))
+                    [zoomEntry addObject:layer];
+            }
+            [byZoom addObject:zoomEntry];
+        }
+        newIndex[sourceLayer] = byZoom;
+    }
+    layersBySourceAndZoom = newIndex;
+}
+
+/// Style layers for the given source layer that can display at the given zoom level
+/// A negative zoom means we're not building for a real tile level, so everything goes
+- (NSArray *)layersForSource:(NSString *)sourceLayer zoom:(int)zoom
+{
+    if (zoom < 0)
+        return _layersBySource[sourceLayer];
+    
+    NSArray *byZoom = layersBySourceAndZoom[sourceLayer];
+    if (!byZoom)
+        return nil;
+    
+    return byZoom[std::min(std::max(zoom,0),MaxIndexedZoom)];
+}
+
 - (NSArray*)stylesForFeatureWithAttributes:(NSDictionary*)attributes
                                     onTile:(MaplyTileID)tileID
                                    inLayer:(NSString*)sourceLayer
                                      viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
 {
-    NSArray *layersToRun = _layersBySource[sourceLayer];
+    NSArray *layersToRun = [self layersForSource:sourceLayer zoom:tileID.level];
     if (!layersToRun)
         return nil;
     NSMutableArray *passedLayers = [NSMutableArray array];
@@ -109,7 +177,7 @@
 
 - (BOOL)layerShouldDisplay:(NSString*)sourceLayer tile:(MaplyTileID)tileID
 {
-    NSArray *layersToRun = _layersBySource[sourceLayer];
+    NSArray *layersToRun = [self layersForSource:sourceLayer zoom:tileID.level];
     
     return (layersToRun.count != 0);
 }
@@ -495,8 +563,8 @@
     self.ident = layerDict[@"id"];
     self.source = [styleSet stringValue:@"source" dict:layerDict defVal:refLayer.source];
     self.sourceLayer = [styleSet stringValue:@"source-layer" dict:layerDict defVal:refLayer.sourceLayer];
-    self.minzoom = [styleSet intValue:@"minzoom" dict:layerDict defVal:refLayer.minzoom];
-    self.maxzoom = [styleSet intValue:@"maxzoom" dict:layerDict defVal:refLayer.maxzoom];
+    self.minzoom = [styleSet intValue:@"minzoom" dict:layerDict defVal:(refLayer ? refLayer.minzoom : _minzoom)];
+    self.maxzoom = [styleSet intValue:@"maxzoom" dict:layerDict defVal:(refLayer ? refLayer.maxzoom : _maxzoom)];
     category = [styleSet stringValue:@"wkcategory" dict:layerDict defVal:nil];
     
     return self;
@@ -507,6 +575,16 @@
     return category;
 }
 
+- (bool)displaysAtZoom:(int)zoom
+{
+    if (_minzoom >= 0 && zoom < _minzoom)
+        return false;
+    if (_maxzoom >= 0 && zoom > _maxzoom)
+        return false;
+    
+    return true;
+}
+
 - (NSArray *)buildObjects:(NSArray *)vecObjs forTile:(MaplyVectorTileInfo *)tileInfo viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
 {
     return nil;
@@ -250,9 +250,7 @@
     if (!_layout.visible)
         return compObjs;
     
-    if (self.minzoom > tileInfo.tileID.level)
-        return compObjs;
-    if (self.maxzoom < tileInfo.tileID.level)
+    if (![self displaysAtZoom:tileInfo.tileID.level])
         return compObjs;
     
     NSDictionary *desc = symbolDesc;
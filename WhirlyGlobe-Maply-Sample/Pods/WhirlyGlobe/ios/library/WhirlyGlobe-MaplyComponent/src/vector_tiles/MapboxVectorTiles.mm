@@ -84,6 +84,8 @@ static double MAX_EXTENT = 20037508.342789244;
     MaplyVectorTileInfo *tileInfo = [[MaplyVectorTileInfo alloc] init];
     tileInfo.tileID = tileID;
     tileInfo.geoBBox = {MaplyCoordinateDMake(geoBbox.ll.x, geoBbox.ll.y),MaplyCoordinateDMake(geoBbox.ur.x, geoBbox.ur.y)};
+    // Styles may hand us geometry to merge, which we build after they've all run
+    tileInfo.batching = true;
 
     double scale;
     double x;
@@ -388,6 +390,7 @@ static double MAX_EXTENT = 20037508.342789244;
         }
         [components addObjectsFromArray:theseCompObjs];
     }
+    [components addObjectsFromArray:[tileInfo buildBatches:_viewC categories:categories]];
     
     if(self.debugLabel || self.debugOutline) {
         MaplyCoordinate ne = geoBbox.ur;
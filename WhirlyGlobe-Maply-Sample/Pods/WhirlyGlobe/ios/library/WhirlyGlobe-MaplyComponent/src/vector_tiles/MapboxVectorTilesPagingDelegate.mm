@@ -58,6 +58,14 @@ static double MAX_EXTENT = 20037508.342789244;
     if(self) {
         self.tileSources = tileSources;
         _tileParser = [[MapboxVectorTileParser alloc] initWithStyle:style viewC:viewC];
+        
+        // Let the Mapbox style know how deep our tiles go so it can skip layers by zoom
+        if ([style isKindOfClass:[MapboxVectorStyleSet class]] && tileSources.count > 0)
+        {
+            MapboxVectorStyleSet *styleSet = (MapboxVectorStyleSet *)style;
+            if (styleSet.tileMaxZoom < 0)
+                styleSet.tileMaxZoom = [self maxZoom];
+        }
     }
     return self;
 }
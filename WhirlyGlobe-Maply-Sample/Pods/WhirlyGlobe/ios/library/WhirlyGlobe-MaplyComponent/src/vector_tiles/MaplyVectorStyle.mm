@@ -18,9 +18,12 @@
  *
  */
 
+#import <set>
+#import <map>
 #import "MapboxVectorTiles.h"
 #import "MaplyVectorStyle.h"
 #import "WhirlyGlobe.h"
+#import "MaplyVectorObject_private.h"
 
 using namespace WhirlyKit;
 
@@ -42,6 +45,7 @@ using namespace WhirlyKit;
     _selectable = false;
     _baseDrawPriority = kMaplyVectorDrawPriorityDefault;
     _drawPriorityPerLevel = 0;
+    _batchDrawPriorityBand = 0;
   
     return self;
 }
@@ -152,5 +156,194 @@ NSArray * _Nonnull AddMaplyVectorsUsingStyle(NSArray * _Nonnull vecObjs,NSObject
     return compObjs;
 }
 
+// Vectors from a single style waiting to be batched
+@interface MaplyVectorBatchEntry : NSObject
+@property (nonatomic) NSArray *vecObjs;
+@property (nonatomic) UIColor *color;
+@property (nonatomic) int drawPriority;
+@end
+
+@implementation MaplyVectorBatchEntry
+@end
+
+// Compatible vectors from one or more styles
+@interface MaplyVectorBatch : NSObject
+@property (nonatomic) NSDictionary *desc;
+@property (nonatomic) NSString *category;
+@property (nonatomic) NSMutableArray<MaplyVectorBatchEntry *> *entries;
+@end
+
+@implementation MaplyVectorBatch
+@end
+
 @implementation MaplyVectorTileInfo
+{
+    // Derived features, keyed by operation and then by the source feature
+    NSMutableDictionary<NSString *,NSMapTable *> *derivedVecs;
+    // Batches keyed by their description (minus color and priority), band and category
+    NSMutableDictionary<NSDictionary *,MaplyVectorBatch *> *batches;
+    // Priorities of geometry added outside the batches
+    std::set<int> unbatchedPriorities;
+}
+
+- (void)batchVectors:(NSArray *)vecObjs desc:(NSDictionary *)desc band:(int)band category:(NSString *)category
+{
+    if ([vecObjs count] == 0)
+        return;
+    
+    NSMutableDictionary *key = [NSMutableDictionary dictionaryWithDictionary:desc];
+    [key removeObjectForKey:kMaplyColor];
+    [key removeObjectForKey:kMaplyDrawPriority];
+    key[@"wkbatchband"] = @(band);
+    if (category)
+        key[@"wkcategory"] = category;
+    
+    if (!batches)
+        batches = [NSMutableDictionary dictionary];
+    MaplyVectorBatch *batch = batches[key];
+    if (!batch)
+    {
+        batch = [[MaplyVectorBatch alloc] init];
+        batch.desc = desc;
+        batch.category = category;
+        batch.entries = [NSMutableArray array];
+        batches[key] = batch;
+    }
+    
+    MaplyVectorBatchEntry *entry = [[MaplyVectorBatchEntry alloc] init];
+    entry.vecObjs = vecObjs;
+    entry.color = desc[kMaplyColor] ? desc[kMaplyColor] : [UIColor whiteColor];
+    entry.drawPriority = [desc[kMaplyDrawPriority] intValue];
+    [batch.entries addObject:entry];
+}
+
+- (void)noteDrawPriority:(int)drawPriority
+{
+    unbatchedPriorities.insert(drawPriority);
+}
+
+- (NSArray *)buildBatches:(NSObject<MaplyRenderControllerProtocol> *)viewC categories:(NSMutableDictionary *)categories
+{
+    NSMutableArray *compObjs = [NSMutableArray array];
+    
+    // Everything on the tile that draws at its own priority
+    std::map<int,int> batchedPriorities;
+    for (MaplyVectorBatch *batch in [batches allValues])
+    {
+        std::set<int> batchPriorities;
+        for (MaplyVectorBatchEntry *entry in batch.entries)
+            batchPriorities.insert(entry.drawPriority);
+        for (int drawPriority : batchPriorities)
+            batchedPriorities[drawPriority]++;
+    }
+    
+    for (MaplyVectorBatch *batch in [batches allValues])
+    {
+        // Styles draw in priority order within the batch
+        NSArray *entries = [batch.entries sortedArrayWithOptions:NSSortStable usingComparator:^NSComparisonResult(MaplyVectorBatchEntry *a, MaplyVectorBatchEntry *b) {
+            if (a.drawPriority == b.drawPriority)
+                return NSOrderedSame;
+            return a.drawPriority < b.drawPriority ? NSOrderedAscending : NSOrderedDescending;
+        }];
+        
+        // Anything else that draws in between our entries breaks up the batch, since it would otherwise end up on top
+        std::set<int> breaks = unbatchedPriorities;
+        std::set<int> ourPriorities;
+        for (MaplyVectorBatchEntry *entry in entries)
+            ourPriorities.insert(entry.drawPriority);
+        for (auto it : batchedPriorities)
+            if (it.second > 1 || ourPriorities.find(it.first) == ourPriorities.end())
+                breaks.insert(it.first);
+        NSMutableArray<NSArray *> *runs = [NSMutableArray array];
+        NSMutableArray *run = nil;
+        for (MaplyVectorBatchEntry *entry in entries)
+        {
+            if (run)
+            {
+                int runPriority = [run[0] drawPriority];
+                auto bit = breaks.upper_bound(runPriority);
+                if (bit != breaks.end() && *bit <= entry.drawPriority)
+                    run = nil;
+            }
+            if (!run)
+            {
+                run = [NSMutableArray array];
+                [runs addObject:run];
+            }
+            [run addObject:entry];
+        }
+        
+        for (NSArray *runEntries in runs)
+        {
+            MaplyComponentObject *compObj = [self buildBatch:batch entries:runEntries viewC:viewC];
+            if (!compObj)
+                continue;
+            [compObjs addObject:compObj];
+            
+            if (batch.category)
+            {
+                NSMutableArray *catArray = categories[batch.category];
+                if (!catArray)
+                    catArray = [NSMutableArray array];
+                [catArray addObject:compObj];
+                categories[batch.category] = catArray;
+            }
+        }
+    }
+    batches = nil;
+    unbatchedPriorities.clear();
+    
+    return compObjs;
+}
+
+// Add a sorted run of entries from a batch as a single component object
+- (MaplyComponentObject *)buildBatch:(MaplyVectorBatch *)batch entries:(NSArray *)entries viewC:(NSObject<MaplyRenderControllerProtocol> *)viewC
+{
+    // Features can show up in more than one style, so each gets its own copy with its color and order
+    NSMutableArray *vecObjs = [NSMutableArray array];
+    int order = 0;
+    for (MaplyVectorBatchEntry *entry in entries)
+    {
+        for (MaplyVectorObject *vecObj in entry.vecObjs)
+        {
+            MaplyVectorObject *newVecObj = [vecObj deepCopy2];
+            for (auto shape : newVecObj.shapes)
+            {
+                NSMutableDictionary *attrs = shape->getAttrDict();
+                attrs[@"color"] = entry.color;
+                attrs[@"batchorder"] = @(order);
+            }
+            [vecObjs addObject:newVecObj];
+        }
+        order++;
+    }
+    
+    NSMutableDictionary *desc = [NSMutableDictionary dictionaryWithDictionary:batch.desc];
+    desc[kMaplyDrawPriority] = @([entries[0] drawPriority]);
+    return [viewC addVectors:vecObjs desc:desc mode:MaplyThreadCurrent];
+}
+
+- (MaplyVectorObject *)derivedVector:(MaplyVectorObject *)vecObj operation:(NSString *)operation build:(MaplyVectorObject *(^)(void))buildBlock
+{
+    if (!derivedVecs)
+        derivedVecs = [NSMutableDictionary dictionary];
+    NSMapTable *forOperation = derivedVecs[operation];
+    if (!forOperation)
+    {
+        // Features are compared by identity, not by contents
+        forOperation = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+        derivedVecs[operation] = forOperation;
+    }
+    
+    id derivedVec = [forOperation objectForKey:vecObj];
+    if (!derivedVec)
+    {
+        derivedVec = buildBlock();
+        // Remember the misses too
+        [forOperation setObject:(derivedVec ? derivedVec : [NSNull null]) forKey:vecObj];
+    }
+    
+    return [derivedVec isKindOfClass:[NSNull class]] ? nil : derivedVec;
+}
+
 @end
@@ -48,6 +48,7 @@ namespace WhirlyKit
 @property (nonatomic) NSTimeInterval startEnable,endEnable;
 @property (nonatomic) WhirlyKit::SimpleIdentity programID;
 @property (nonatomic) WhirlyKit::SingleVertexAttributeSet &uniforms;
+@property (nonatomic) bool compactVertices;
 
 /// Initialize with an NSDictionary
 - (id)initWithDesc:(NSDictionary *)desc;
@@ -125,6 +125,18 @@ public:
     virtual void setDrawOffset(float newOffset);
     virtual float getDrawOffset();
     
+    /// Store vertex attributes in compact form when we build the buffers.
+    /// Floats in [-1,1] go to normalized shorts.  Triangle normals go to oct encoding,
+    /// but only if our program decodes them (u_octNormals), as the default triangle shaders do.
+    virtual void setCompactAttributes(bool compact);
+    virtual bool getCompactAttributes();
+    
+    /// Set the packing for a specific vertex attribute, overriding the compact logic
+    virtual bool setAttributePacking(int which,BDAttributePacking packing);
+    
+    /// True if the normals are oct-encoded in the vertex buffer
+    virtual bool hasOctNormals() const;
+    
     /// Set the geometry type.  Probably triangles.
     virtual void setType(GLenum inType);
     virtual GLenum getType() const;
@@ -327,8 +339,11 @@ public:
     /// Draw routine for OpenGL 2.0
     virtual void drawOGL2(WhirlyKitRendererFrameInfo *frameInfo,Scene *scene);
     /// Add a single point to the GL Buffer.
-    /// Override this to add your own data to interleaved vertex buffers.
     virtual void addPointToBuffer(unsigned char *basePtr,int which,const Point3d *center);
+    /// Add a run of points to an interleaved buffer laid out by singleVertexSize().
+    /// We copy attribute by attribute rather than vertex by vertex.
+    /// Override this to add your own data to interleaved vertex buffers.
+    virtual void addPointsToBuffer(unsigned char *basePtr,int start,int count,const Point3d *center);
     /// Called while a new VAO is bound.  Set up your VAO-related state here.
     virtual void setupAdditionalVAO(OpenGLES2Program *prog,GLuint vertArrayObj) { }
     
@@ -394,6 +409,9 @@ public:
     
     // If set the geometry is already in OpenGL clip coordinates, so no transform
     bool clipCoords;
+    
+    // If set, we'll pick compact packings for the vertex attributes
+    bool compactAttributes;
 };
 
 /** Drawable Tweaker that cycles through textures.
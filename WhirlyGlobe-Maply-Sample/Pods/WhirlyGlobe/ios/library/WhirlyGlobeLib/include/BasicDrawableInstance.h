@@ -160,6 +160,12 @@ public:
     /// Add a instance to the stack of instances this instance represents (mmm, noun overload)
     void addInstances(const std::vector<SingleInstance> &insts);
     
+    /** Only draw the instances whose projected size on screen (in pixels) is within [minSize,maxSize).
+        Used to spread instances out over simplified versions of a model.
+        The radius is that of the model around its origin, before the instance matrix.
+      */
+    void setInstanceLod(double radius,float minSize,float maxSize) { lodRadius = radius;  lodMinSize = minSize;  lodMaxSize = maxSize; }
+    
     // If set, we'll render this data where directed
     void setRenderTarget(SimpleIdentity newRenderTarget) { renderTargetID = newRenderTarget; }
     
@@ -225,6 +231,19 @@ protected:
 
     // If set, we'll instance this one multiple times
     std::vector<SingleInstance> instances;
+    
+    // Select instances by projected size
+    void updateLodInstances(WhirlyKitRendererFrameInfo *frameInfo);
+    
+    // If the radius is set, we're picking instances by size
+    double lodRadius;
+    float lodMinSize,lodMaxSize;
+    // Packed instance data and scaled radius for all the instances
+    std::vector<unsigned char> lodInstData;
+    std::vector<double> lodInstRadius;
+    // Instances we're currently drawing and their packed data
+    std::vector<int> lodInsts,lodNewInsts;
+    std::vector<unsigned char> lodUploadData;
     // While rendering, which instance we're rendering
 //    int whichInstance;
 };
@@ -0,0 +1,59 @@
+/*
+ *  ChangeRequestPool.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <stddef.h>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** Memory pool for change requests.
+    Change requests are small, short lived, allocated in bursts on the layer
+    threads and freed on the main thread.  Rather than hitting malloc for each
+    one, we keep free lists sorted by size and hand the blocks back in bulk
+    once the renderer has run a whole batch.
+    You don't call this directly.  ChangeRequest's new and delete use it.
+  */
+class ChangeRequestPool
+{
+public:
+    /// Allocate a block of at least the given size
+    static void *alloc(size_t size);
+
+    /// Return a single block to the pool
+    static void release(void *ptr);
+
+    /// Return a whole batch of blocks to the pool at once.
+    /// Clears the vector on the way out.
+    static void releaseBatch(std::vector<void *> &ptrs);
+
+    /// Turn on counting of change requests by type.  Off by default.
+    static void setStatsEnabled(bool enabled);
+
+    /// True if we're counting change requests by type
+    static bool getStatsEnabled();
+
+    /// Count a change request of the given type.  Only does anything if stats are on.
+    static void recordRequest(const char *typeName);
+
+    /// Print out the allocation counts and the per-type breakdown
+    static void dumpStats();
+};
+
+}
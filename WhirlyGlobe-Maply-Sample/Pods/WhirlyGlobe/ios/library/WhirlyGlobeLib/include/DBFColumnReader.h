@@ -0,0 +1,116 @@
+/*
+ *  DBFColumnReader.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <string>
+#import <vector>
+#import <unordered_map>
+
+namespace WhirlyKit
+{
+
+/// Field types we decode out of a DBF.  These follow shapelib's DBFGetFieldInfo().
+typedef enum {DBFColumnString,DBFColumnInteger,DBFColumnDouble,DBFColumnLogical} DBFColumnType;
+
+/** Columnar reader for the DBF attributes that go along with a shapefile.
+    The file is memory mapped and fields are sliced out of the fixed width
+    records directly, so you only pay for the fields you ask for.
+    Values are decoded the same way shapelib does it.
+    Nothing changes after construction, so it's safe to read from multiple threads.
+  */
+class DBFColumnReader
+{
+public:
+    /// Construct with the .dbf or .shp file name.  We'll swap in the extension.
+    DBFColumnReader(NSString *fileName);
+    ~DBFColumnReader();
+    
+    /// True if we mapped the file and made sense of the header
+    bool isValid() const;
+    
+    /// Number of records (rows)
+    int getNumRecords() const;
+    
+    /// Number of fields (columns)
+    int getNumFields() const;
+    
+    /// Look up a field by name.  Returns -1 if it's not there.
+    int getFieldIndex(const std::string &name) const;
+    
+    /// Name of the given field
+    const std::string &getFieldName(int field) const;
+    
+    /// Name of the given field as an attribute dictionary key
+    NSString *getFieldKey(int field) const;
+    
+    /// Data type of the given field
+    DBFColumnType getFieldType(int field) const;
+    
+    /// True if the given value is NULL
+    bool isNull(int record,int field) const;
+    
+    /// Decode a single integer value
+    int readInt(int record,int field) const;
+    
+    /// Decode a single double value
+    double readDouble(int record,int field) const;
+    
+    /// Decode a single string value, with the white space trimmed off
+    std::string readString(int record,int field) const;
+    
+    /// Decode a whole column of integers.  NULLs come back as 0 and are flagged in nulls, if passed in.
+    void readIntColumn(int field,std::vector<int> &vals,std::vector<bool> *nulls=NULL) const;
+    
+    /// Decode a whole column of doubles.  NULLs come back as 0.0 and are flagged in nulls, if passed in.
+    void readDoubleColumn(int field,std::vector<double> &vals,std::vector<bool> *nulls=NULL) const;
+    
+    /// Decode a whole column of strings.  NULLs come back empty and are flagged in nulls, if passed in.
+    void readStringColumn(int field,std::vector<std::string> &vals,std::vector<bool> *nulls=NULL) const;
+    
+    /// Fill in an attribute dictionary for one record with just the given fields.
+    /// NULL values are left out, as are strings that aren't ASCII.
+    void readAttributes(int record,const std::vector<int> &fields,NSMutableDictionary *attrDict) const;
+    
+protected:
+    class Field
+    {
+    public:
+        std::string name;
+        NSString *key;
+        DBFColumnType type;
+        char dbfType;
+        int offset,width;
+    };
+    
+    // Copy the raw field into buf, stopping at a NUL like strncpy.  Returns the length.
+    int copyField(int record,int field,char *buf) const;
+    // Same as copyField, but with the white space trimmed off.  Returns the start.
+    const char *trimField(int record,int field,char *buf,int &len) const;
+    bool isNullValue(const Field &theField,const char *str,int len) const;
+    
+    const unsigned char *data;
+    size_t dataLen;
+    bool mapped;
+    std::vector<unsigned char> dataBuf;
+    int numRecords,headerLen,recordLen;
+    std::vector<Field> fields;
+    std::unordered_map<std::string,int> fieldsByName;
+};
+
+}
@@ -49,6 +49,10 @@ namespace WhirlyKit
 #define kToolkitDefaultScreenSpaceProgram "Default Screenspace"
 /// Screen space shader w/ motion
 #define kToolkitDefaultScreenSpaceMotionProgram "Default Screenspace Motion"
+/// Screen space shader for distance field glyphs
+#define kToolkitDefaultScreenSpaceSDFProgram "Default Screenspace SDF"
+/// Screen space shader for distance field glyphs w/ motion
+#define kToolkitDefaultScreenSpaceSDFMotionProgram "Default Screenspace SDF Motion"
 /// Widened vector shader
 #define kToolkitDefaultWideVectorProgram "Default Wide Vector"
 /// Widened vector shader for globe
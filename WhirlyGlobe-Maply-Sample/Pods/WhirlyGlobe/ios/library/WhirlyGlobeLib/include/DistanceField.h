@@ -0,0 +1,35 @@
+/*
+ *  DistanceField.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <stdint.h>
+
+namespace WhirlyKit
+{
+
+/** Convert a rendered RGBA8888 glyph into a signed distance field.
+    Pixels with alpha at or above half are treated as inside.
+    The result is RGBA8888 with white color and the distance in alpha,
+    where 0.5 is the edge, higher values are inside and the field
+    reaches out spread pixels to either side.
+    Uses the Felzenszwalb & Huttenlocher exact Euclidean distance transform.
+  */
+NSData *SignedDistanceFieldFromRGBA(NSData *rgba,int width,int height,float spread);
+
+}
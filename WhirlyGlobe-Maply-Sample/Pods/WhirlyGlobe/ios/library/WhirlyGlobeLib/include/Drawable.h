@@ -32,6 +32,7 @@
 #import "StringIndexer.h"
 #import "WhirlyVector.h"
 #import "GlobeView.h"
+#import "ChangeRequestPool.h"
 
 
 @class WhirlyKitSceneRendererES;
@@ -123,6 +124,14 @@ class ChangeRequest
 public:
     ChangeRequest() : when(0.0) { }
 	virtual ~ChangeRequest() { }
+
+    /// Change requests come out of a pool rather than straight from the heap
+    static void *operator new(size_t size) { return ChangeRequestPool::alloc(size); }
+    static void operator delete(void *ptr) { ChangeRequestPool::release(ptr); }
+
+    /// Tear down a batch of change requests and hand the memory back in one go.
+    /// Null entries are skipped.  The change set is cleared.
+    static void deleteBatch(std::vector<ChangeRequest *> &changes);
 		
     /// Return true if this change requires a GL Flush in the thread it was executed in
     virtual bool needsFlush() { return false; }
@@ -138,6 +147,11 @@ public:
     
     /// If non-zero we'll execute this request after the given absolute time
     NSTimeInterval when;
+
+private:
+    // Requests are handed around by pointer, never copied
+    ChangeRequest(const ChangeRequest &) = delete;
+    ChangeRequest &operator = (const ChangeRequest &) = delete;
 };
     
 /// Representation of a list of changes.  Might get more complex in the future.
@@ -284,6 +298,11 @@ class SubTexture;
 
 /// Data types we'll accept for attributes
 typedef enum {BDFloat4Type,BDFloat3Type,BDChar4Type,BDFloat2Type,BDFloatType,BDIntType,BDDataTypeMax} BDAttributeDataType;
+
+/// How float attributes are stored in the vertex buffer.
+/// We always keep full floats on the CPU side and convert on the way into the buffer.
+/// Oct normals are two normalized shorts the shaders decode, only for 3D unit vectors.
+typedef enum {BDPackNone,BDPackHalfFloat,BDPackSNorm16,BDPackUNorm16,BDPackOctNormal} BDAttributePacking;
     
     
 /// Used to keep track of attributes (other than points)
@@ -299,6 +318,17 @@ public:
     
     /// Return the data type
     BDAttributeDataType getDataType() const;
+
+    /// Set how this attribute is stored in the vertex buffer.
+    /// Only float types can be packed and oct normals need a 3D vector.  Returns false if we can't do it.
+    bool setPacking(BDAttributePacking packing);
+
+    /// Return how this attribute is stored in the vertex buffer
+    BDAttributePacking getPacking() const;
+
+    /// Look through the data and pick the most compact packing that won't lose much.
+    /// That's snorm16/unorm16 for values in [-1,1]/[0,1] and full floats for the rest.
+    BDAttributePacking compactPacking() const;
     
     /// Set the default color (if the type matches)
     void setDefaultColor(const RGBAColor &color);
@@ -328,7 +358,7 @@ public:
     /// Number of elements in our array
     int numElements() const;
     
-    /// Return the size of a single element
+    /// Return the size of a single element in the vertex buffer
     int size() const;
     
     /// Clean out the data array
@@ -336,6 +366,11 @@ public:
     
     /// Return a pointer to the given element
     void *addressForElement(int which);
+
+    /// Copy a run of elements into an interleaved vertex buffer.
+    /// basePtr is the start of the first vertex, stride is the vertex size,
+    ///  and we write at our own buffer offset within each vertex.
+    void copyToBuffer(unsigned char *basePtr,int stride,int start,int count);
     
     /// Return the number of components as needed by glVertexAttribPointer
     GLuint glEntryComponents() const;
@@ -352,6 +387,8 @@ public:
 public:
     /// Data type for the attribute data
     BDAttributeDataType dataType;
+    /// How we store it in the vertex buffer
+    BDAttributePacking packing;
     /// Name used in the shader
     StringIdentity nameID;
     /// Default value to pass to OpenGL if there's no data array
@@ -0,0 +1,56 @@
+/*
+ *  ETC2Encoder.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <stdint.h>
+
+namespace WhirlyKit
+{
+
+/** How hard the ETC2 encoder works.
+    Fast picks the base colors from the block averages and searches the tables.
+    Normal also nudges the base colors around to find a better fit.
+    Best adds planar blocks (good for smooth gradients) and a wider alpha search.
+  */
+typedef enum {WKETC2Fast,WKETC2Normal,WKETC2Best} WKETC2Quality;
+
+/** Encode RGBA8888 pixels (R in the low byte) as ETC2.
+    If withAlpha is set we produce RGBA8 ETC2 + EAC (8 bits per pixel),
+    otherwise RGB8 ETC2 (4 bits per pixel) and alpha is ignored.
+    The data comes back with a PKM header, ready for Texture::ResolvePKM().
+    Width and height don't need to be multiples of 4, but the texture will be
+    rounded up to the next block and the edge pixels repeated.
+    This is slow enough that it belongs on a loader thread.
+  */
+NSData *ETC2EncodeRGBA(const uint8_t *pixels,int width,int height,bool withAlpha,WKETC2Quality quality);
+
+/** Decode ETC2 data with a PKM header back into RGBA8888.
+    Only handles what the encoder produces (individual, differential and planar
+    blocks, plus EAC alpha).  Returns nil for anything else.
+    This is for checking the encoder, not for display.
+  */
+NSData *ETC2DecodeRGBA(NSData *pkmData,int *retWidth,int *retHeight);
+
+/// PSNR in dB between two RGBA8888 images.  Only looks at alpha if asked.
+double ETC2ComputePSNR(const uint8_t *pixelsA,const uint8_t *pixelsB,int width,int height,bool withAlpha);
+
+/// Encode some synthetic 256 and 512 pixel tiles at each quality level and log PSNR and throughput
+void ETC2EncodeBenchmark();
+
+}
@@ -42,7 +42,7 @@ namespace WhirlyKit
 class DrawableString : public Identifiable
 {
 public:
-    DrawableString() { }
+    DrawableString() : sdfSpread(0.0) { }
     
     /// A rectangle describing the placement of a single glyph and
     ///  the texture piece used to represent it
@@ -57,6 +57,10 @@ public:
 
     /// Bounding box of the string in coordinates related to the font size
     Mbr mbr;
+    
+    /// For distance field glyphs, how far the field reaches past the edge (in the same coordinates).
+    /// Zero for regular glyphs.
+    float sdfSpread;
 };
 
 }
@@ -73,6 +77,11 @@ public:
 ///  the DrawableString
 - (WhirlyKit::DrawableString *)addString:(NSAttributedString *)str changes:(std::vector<WhirlyKit::ChangeRequest *> &)changes;
 
+/// Add the given string, optionally as signed distance field glyphs.
+/// Distance field glyphs are rendered once per font at a reference size and ignore the
+///  size, color and outline attributes, which are up to the shader instead.
+- (WhirlyKit::DrawableString *)addString:(NSAttributedString *)str sdf:(bool)sdf changes:(std::vector<WhirlyKit::ChangeRequest *> &)changes;
+
 /// Remove resources associated with the given string
 - (void)removeString:(WhirlyKit::SimpleIdentity)drawStringId changes:(std::vector<WhirlyKit::ChangeRequest *> &)changes when:(NSTimeInterval)when;
 
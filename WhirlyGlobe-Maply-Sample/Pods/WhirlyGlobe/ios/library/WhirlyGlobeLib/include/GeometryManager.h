@@ -36,12 +36,22 @@ namespace WhirlyKit
 class GeomSceneRep : public Identifiable
 {
 public:
-    GeomSceneRep() : fade(0.0) { }
-    GeomSceneRep(SimpleIdentity theID) : Identifiable(theID) { }
+    GeomSceneRep() : fade(0.0), lodSize(0.0), radius(0.0) { }
+    GeomSceneRep(SimpleIdentity theID) : Identifiable(theID), lodSize(0.0), radius(0.0) { }
     
     // Drawables created for this geometry
     SimpleIDSet drawIDs;
     
+    // If the base geometry has simplified versions, the drawables for each level (also in drawIDs)
+    std::vector<SimpleIDSet> lodDrawIDs;
+    
+    // Projected size (pixels) below which we switch from the first level to the second.
+    // Each level after that covers half the size of the one before.
+    float lodSize;
+    
+    // Radius of the base geometry around its origin
+    double radius;
+    
     // IDs kept with the selection manager
     SimpleIDSet selectIDs;
     
@@ -63,6 +73,20 @@ typedef std::set<GeomSceneRep *,IdentifiableSorter> GeomSceneRepSet;
 /// Types supported for raw geometry
 typedef enum {WhirlyKitGeometryNone,WhirlyKitGeometryLines,WhirlyKitGeometryTriangles} WhirlyKitGeometryRawType;
     
+/// Statistics from a GeometryRaw::optimize() pass
+class GeometryOptimizeStats
+{
+public:
+    GeometryOptimizeStats() : vertsBefore(0), vertsAfter(0), acmrBefore(0.0), acmrAfter(0.0), bytesBefore(0), bytesAfter(0) { }
+    
+    /// Unique vertices before and after welding
+    int vertsBefore,vertsAfter;
+    /// Average cache miss ratio (transformed vertices per triangle) before and after
+    double acmrBefore,acmrAfter;
+    /// Approximate vertex and index bytes in the resulting drawables, before and after
+    size_t bytesBefore,bytesAfter;
+};
+
 /// Raw Geometry object.  Fill it in and pass it to the layer.
 class GeometryRaw
 {
@@ -96,6 +120,22 @@ public:
     // Calculate bounding box
     void calcBounds(Point3d &ll,Point3d &ur);
     
+    /** Optimize the triangles for rendering.  Welds vertices with identical attributes,
+        reorders triangles for the post-transform vertex cache (Forsyth) and then
+        reorders the vertices in the order they're first used.
+        Meant to be done once for a model that will be instanced many times.
+      */
+    void optimize(GeometryOptimizeStats *stats = NULL);
+    
+    /** Build a simplified version of the triangles with roughly the given number of triangles.
+        Uses quadric error metrics to collapse edges onto existing vertices, so the other
+        attributes stay as they are.  Boundaries and vertices along texture or normal seams
+        are preserved, and no collapse may move the surface by more than about maxError.
+        Lines are just copied over.
+      */
+    void simplify(int targetTris,double maxError,GeometryRaw &outGeom) const;
+    
+    
     // Build geometry into a drawable, using the given transform
     void buildDrawables(std::vector<BasicDrawable *> &draws,const Eigen::Matrix4d &mat,const RGBAColor *colorOverride,WhirlyKitGeomInfo *geomInfo);
 
@@ -278,6 +318,13 @@ public:
     /// Add geometry we're planning to reuse (as a model, for example)
     SimpleIdentity addBaseGeometry(std::vector<GeometryRaw> &geom,ChangeSet &changes);
     
+    /** Add geometry we're planning to reuse, along with up to numLods-1 simplified versions.
+        Each level has about a quarter the triangles of the one before.  Instances use the
+        full geometry when their projected size is at least lodSize pixels and each following
+        level for every halving below that.
+      */
+    SimpleIdentity addBaseGeometry(std::vector<GeometryRaw> &geom,int numLods,float lodSize,ChangeSet &changes);
+    
     /// Add instances that reuse base geometry
     SimpleIdentity addGeometryInstances(SimpleIdentity baseGeomID,const std::vector<GeometryInstance> &instances,NSDictionary *desc,ChangeSet &changes);
     
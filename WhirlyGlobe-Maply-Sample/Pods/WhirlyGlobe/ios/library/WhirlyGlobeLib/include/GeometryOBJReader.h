@@ -27,8 +27,10 @@ namespace WhirlyKit
 class GeometryModelOBJ
 {
 public:
-    // Parse file
+    // Parse file.  The file is memory mapped and handed to the in-memory version.
     bool parse(FILE *fp);
+    // Parse an OBJ file that's already in memory.  Big files are parsed in chunks in parallel.
+    bool parse(const char *data,size_t len);
     // Parse material library
     bool parseMaterials(FILE *fp);
     
@@ -66,6 +68,7 @@ public:
     class Face
     {
     public:
+        Face() : mat(NULL), mtlID(-1) { }
         Material *mat;
         int mtlID;
         std::vector<Vertex> verts;
@@ -84,6 +87,22 @@ public:
     std::vector<Point2d> texCoords;
     std::vector<Point3d> norms;
     std::vector<Material> materials;
+    // Full paths of the material libraries we read
+    std::vector<std::string> mtlFiles;
+    
+protected:
+    class Chunk;
+    // Parse the lines in a chunk without touching the model
+    void parseChunk(const char *data,const char *end,Chunk &chunk);
+    // Apply a directive (mtllib, usemtl, g) in file order
+    bool applyDirective(int which,const std::string &arg,const std::string &fullLine,Group *&activeGroup,int &activeMtl);
 };
 
+/// Write the converted geometry (and texture names) to a compact binary file we can load in one read.
+/// The other files the geometry came from (e.g. material libraries) are recorded so the caller can check them for staleness.
+bool WriteGeometryRawCache(const std::string &fileName,const std::vector<std::string> &depFiles,const std::vector<std::string> &textures,const std::vector<GeometryRaw> &rawGeom);
+
+/// Read geometry written by WriteGeometryRawCache.  Returns false if the file is missing or doesn't match.
+bool ReadGeometryRawCache(const std::string &fileName,std::vector<std::string> &depFiles,std::vector<std::string> &textures,std::vector<GeometryRaw> &rawGeom);
+
 }
@@ -0,0 +1,50 @@
+/*
+ *  ImageResample.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <stdint.h>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** Filter used to build mipmap levels.
+    Box averages each 2x2 block and is the cheap one.
+    Kaiser is a windowed sinc that keeps more detail in the smaller levels.
+  */
+typedef enum {WKMipFilterBox,WKMipFilterKaiser} WKMipFilter;
+
+/** Resample RGBA8888 pixels into a new image with a border around it.
+    The source is scaled into the area inside the border and the edge pixels
+    are repeated out into the border, all in one pass.
+    Big reductions get box filtered down first, the rest is bilinear.
+  */
+NSData *ImageResampleWithBorder(const uint8_t *srcPixels,int srcWidth,int srcHeight,int destWidth,int destHeight,int border);
+
+/** Halve an RGBA8888 image in each direction (rounding down, but not below 1).
+    The edges are clamped, so any border texels carry down to the smaller image.
+  */
+void ImageDownsample(const uint8_t *srcPixels,int srcWidth,int srcHeight,uint8_t *destPixels,WKMipFilter filter);
+
+/** Build the whole mipmap chain for an RGBA8888 image, down to 1x1.
+    The levels come back smallest last and don't include the image itself.
+  */
+void ImageBuildMipChain(NSData *pixels,int width,int height,WKMipFilter filter,std::vector<NSData *> &levels);
+
+}
@@ -75,6 +75,8 @@ typedef enum {WhirlyKitTextCenter,WhirlyKitTextLeft,WhirlyKitTextRight} WhirlyKi
 @property (nonatomic,assign) float shadowSize;
 @property (nonatomic) UIColor *outlineColor;
 @property (nonatomic,assign) float outlineSize;
+/// Render screen label glyphs as signed distance fields
+@property (nonatomic,assign) bool sdf;
 
 - (id)initWithDesc:(NSDictionary *)desc;
 
@@ -57,6 +57,9 @@
 @property(nonatomic,assign) Eigen::Matrix4d &modelMatrix,&projMatrix;
 @property(nonatomic,assign) std::vector<Eigen::Matrix4d> &viewMatrices,&invViewMatrices,&fullMatrices,&fullNormalMatrices,&invFullMatrices;
 @property(nonatomic,assign) Eigen::Matrix4d &invModelMatrix,&invProjMatrix;
+/// Projection times full matrix (and its inverse) for each of the view matrices.
+/// Takes display space straight to clip space.
+@property(nonatomic,assign) std::vector<Eigen::Matrix4d> &fullProjMatrices,&invFullProjMatrices;
 @property(nonatomic,assign) double fieldOfView;
 @property(nonatomic,assign) double imagePlaneSize;
 @property(nonatomic,assign) double nearPlane;
@@ -20,6 +20,7 @@
 
 #import <Foundation/Foundation.h>
 #import <math.h>
+#import <tuple>
 #import "WhirlyVector.h"
 #import "TextureGroup.h"
 #import "Scene.h"
@@ -69,6 +70,24 @@ public:
 
 class TileGeomManager;
 
+/* Tile geometry that's the same for every tile with a given sampling.
+   The triangles, texture coordinates and skirt edges are built once and shared.
+  */
+class TileGeomGrid
+{
+public:
+    TileGeomGrid(int sampleX,int sampleY);
+    
+    int sampleX,sampleY;
+    // Two triangles per cell, indexed into the (sampleX+1)*(sampleY+1) grid
+    std::vector<BasicDrawable::Triangle> tris;
+    // Texture coordinates for a tile that isn't clipped
+    std::vector<TexCoord> texCoords;
+    // Grid vertex indices along the bottom, top, left and right edges, in the order the skirts want them
+    std::vector<int> skirtEdges[4];
+};
+typedef std::shared_ptr<TileGeomGrid> TileGeomGridRef;
+
 /* Wraps a single tile that we've loaded into memory.
   */
 class LoadedTileNew
@@ -150,6 +169,12 @@ public:
     // Remove all the various geometry
     void cleanup(ChangeSet &changes);
     
+    // Return the shared grid for the given sampling, building it if need be
+    TileGeomGridRef getGrid(int sampleX,int sampleY);
+    
+    // Calculate the display locations for a tile's grid, using the cached templates where we can
+    void buildTileLocs(const QuadTreeNew::Node &ident,const MbrD &theMbr,bool clipped,int sampleX,int sampleY,std::vector<Point3d> &locs);
+    
     TileGeomSettings settings;
     
     QuadTreeNew *quadTree;
@@ -172,6 +197,20 @@ public:
     MbrD mbr;
     
     std::map<QuadTreeNew::Node,LoadedTileNewRef> tileMap;
+    
+protected:
+    // Shared grids, by sampling
+    std::map<std::pair<int,int>,TileGeomGridRef> grids;
+    
+    // On a globe every tile in a row has the same shape, just rotated around the pole.
+    // We keep the locations for one tile per (level,row,sampleX,sampleY) and rotate them for the rest.
+    class RowTemplate
+    {
+    public:
+        double lon;
+        std::vector<Point3d> locs;
+    };
+    std::map<std::tuple<int,int,int,int>,RowTemplate> rowTemplates;
 };
 
 }
@@ -162,5 +162,9 @@ protected:
     // Attributes sorted for fast lookup
     std::unordered_map<StringIdentity,std::shared_ptr<OpenGLESAttribute>> attrs;
 };
+    
+/// True if the program with the given ID decodes oct encoded normals (u_octNormals).
+/// Drawables use this to decide if they can compact their normals.  Safe from any thread.
+bool ProgramDecodesOctNormals(SimpleIdentity progID);
 
 }
@@ -0,0 +1,69 @@
+/*
+ *  PixelConvert.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <stdint.h>
+#import <stddef.h>
+
+namespace WhirlyKit
+{
+
+/** Pixel conversion kernels.
+    These work on raw RGBA8888 pixels (R in the low byte) and use NEON on ARM
+    and SSE2 on x86, with a plain C version for everything else and for the
+    leftover pixels at the end of a run.
+    Input and output can't overlap unless noted.
+  */
+
+/// RGBA8888 to RGB565
+void PixelConvertRGBATo565(const uint32_t *inPixels,uint16_t *outPixels,size_t count);
+
+/// RGBA8888 to RGBA4444
+void PixelConvertRGBATo4444(const uint32_t *inPixels,uint16_t *outPixels,size_t count);
+
+/// RGBA8888 to RGBA5551
+void PixelConvertRGBATo5551(const uint32_t *inPixels,uint16_t *outPixels,size_t count);
+
+/// Pull a single channel (0-3 for R,G,B,A) out into a byte per pixel
+void PixelExtractChannel(const uint32_t *inPixels,uint8_t *outPixels,size_t count,int channel);
+
+/// Average R, G and B into a byte per pixel
+void PixelAverageRGB(const uint32_t *inPixels,uint8_t *outPixels,size_t count);
+
+/// Pull R and G out into two bytes per pixel
+void PixelExtractRG(const uint32_t *inPixels,uint8_t *outPixels,size_t count);
+
+/// Multiply R, G and B by alpha.  In place is fine.
+void PixelPremultiply(const uint32_t *inPixels,uint32_t *outPixels,size_t count);
+
+/// Reorder the channels.  Output channel i comes from input channel order[i].
+/// In place is fine.  {2,1,0,3} (BGRA <-> RGBA) is the fast case.
+void PixelSwizzle(const uint32_t *inPixels,uint32_t *outPixels,size_t count,const int order[4]);
+
+/** Allocate an NSData for pixel output out of a pool.
+    Texture conversion allocates the same few sizes over and over, so
+    rather than going to malloc each time we keep the buffers around and
+    hand them back out when the NSData goes away.
+  */
+NSData *PixelBufferPoolData(size_t length,void **retBytes);
+
+/// Run each of the kernels over 256, 512 and 1024 pixel square tiles and log the timings
+void PixelConvertBenchmark();
+
+}
@@ -20,6 +20,9 @@
 
 #import <Foundation/Foundation.h>
 #import <math.h>
+#import <list>
+#import <unordered_map>
+#import <mutex>
 #import "WhirlyVector.h"
 #import "TextureGroup.h"
 #import "Scene.h"
@@ -34,7 +37,84 @@
 namespace WhirlyKit
 {
 
-/// Check if any part of the given tile is on screen
+/** A solid volume used to describe the display space a tile takes up.
+    We use these for screen space calculations and share them between
+    layers through the DisplaySolidCache.
+  */
+class DisplaySolid
+{
+public:
+    /// Create a display solid, including height.
+    DisplaySolid(const Quadtree::Identifier &nodeIdent,const Mbr &nodeMbr,float minZ,float maxZ,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter);
+    
+    /// Calculate the importance for this display solid given the user's eye position
+    double importanceForViewState(WhirlyKitViewState *viewState,const Point2f &frameSize);
+    
+    /// See if this display solid is current in the viewing frustum
+    bool isOnScreenForViewState(WhirlyKitViewState *viewState,const Point2f &frameSize);
+
+    /// The area sampled into representative polygons
+    std::vector<std::vector<Point3d> > polys;
+    /// Normals for the polygons
+    std::vector<Eigen::Vector3d> normals;
+    /// Area of each polygon in display space
+    std::vector<double> areas;
+    
+protected:
+    bool isInside(const Point3d &pt);
+};
+typedef std::shared_ptr<DisplaySolid> DisplaySolidRef;
+
+/** Least recently used cache of display solids.
+    Every layer paging the same tiles in the same coordinate system and
+    display adapter winds up with the same solid, so we build them once here.
+  */
+class DisplaySolidCache
+{
+public:
+    DisplaySolidCache(int maxSolids);
+    
+    /// The cache the screen importance functions use
+    static DisplaySolidCache *sharedCache();
+    
+    /// Return the display solid for the given tile, building it if needed.
+    /// Returns an empty reference for degenerate tiles.
+    DisplaySolidRef getDisplaySolid(const Quadtree::Identifier &nodeIdent,const Mbr &nodeMbr,double minZ,double maxZ,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter);
+    
+    /// Clear out all the solids
+    void clear();
+    
+protected:
+    /// Tiles are identified by their bounds, heights and where they land in display space.
+    /// The latter keeps different source systems with the same bounds apart.
+    class Key
+    {
+    public:
+        bool operator == (const Key &that) const;
+        
+        CoordSystemDisplayAdapter *coordAdapter;
+        int x,y,level;
+        float llx,lly,urx,ury;
+        double minZ,maxZ;
+        Point3d dispOrigin;
+    };
+    class KeyHash
+    {
+    public:
+        size_t operator () (const Key &key) const;
+    };
+    typedef std::list<std::pair<Key,DisplaySolidRef> > SolidList;
+    typedef std::unordered_map<Key,SolidList::iterator,KeyHash> SolidMap;
+    
+    std::mutex mutex;
+    int maxSolids;
+    // Most recently used at the front
+    SolidList solids;
+    SolidMap solidMap;
+};
+
+/// Check if any part of the given tile is on screen.
+/// The attrs dictionary is no longer used.  Solids come from the shared DisplaySolidCache.
 bool TileIsOnScreen(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,WhirlyKit::Mbr nodeMbr,WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs);
     
 /// Utility function to calculate importance based on pixel screen size.
@@ -46,24 +126,3 @@ double ScreenImportance(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSi
 double ScreenImportance(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,int pixelsSquare,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,WhirlyKit::Mbr nodeMbr, double minZ,double maxZ, WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs);
 
 }
-
-/// A solid volume used to describe the display space a tile takes up.
-/// We use these for screen space calculations and cache them in the tile
-///  idents.
-@interface WhirlyKitDisplaySolid : NSObject
-
-/// The area sampled into representative polygons
-@property (nonatomic,assign) std::vector<std::vector<WhirlyKit::Point3d> > &polys;
-/// Normals for the polygons
-@property (nonatomic,assign) std::vector<Eigen::Vector3d> &normals;
-
-/// Create a display solid, including height.
-+ (WhirlyKitDisplaySolid *)displaySolidWithNodeIdent:(WhirlyKit::Quadtree::Identifier &)nodeIdent mbr:(WhirlyKit::Mbr)nodeMbr minZ:(float)minZ maxZ:(float)maxZ srcSystem:(WhirlyKit::CoordSystem *)srcSystem adapter:(WhirlyKit::CoordSystemDisplayAdapter *)coordAdapter;
-
-/// Calculate the importance for this display solid given the user's eye position
-- (double)importanceForViewState:(WhirlyKitViewState *)viewState frameSize:(WhirlyKit::Point2f)frameSize;
-
-/// See if this display solid is current in the viewing frustum
-- (bool)isOnScreenForViewState:(WhirlyKitViewState *)viewState frameSize:(WhirlyKit::Point2f)frameSize;
-
-@end
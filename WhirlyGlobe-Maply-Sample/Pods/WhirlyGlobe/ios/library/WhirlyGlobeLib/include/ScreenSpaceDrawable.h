@@ -26,10 +26,15 @@ namespace WhirlyKit
 // Shader name
 #define kScreenSpaceShaderName "Screen Space Shader"
 #define kScreenSpaceShaderMotionName "Screen Space Shader Motion"
+#define kScreenSpaceShaderSDFName "Screen Space Shader SDF"
+#define kScreenSpaceShaderSDFMotionName "Screen Space Shader SDF Motion"
     
 /// Construct and return the Screen Space shader program
 OpenGLES2Program *BuildScreenSpaceProgram();
 OpenGLES2Program *BuildScreenSpaceMotionProgram();
+/// Screen space shaders for signed distance field glyphs
+OpenGLES2Program *BuildScreenSpaceSDFProgram();
+OpenGLES2Program *BuildScreenSpaceSDFMotionProgram();
 
 /// Wrapper for building screen space drawables
 class ScreenSpaceDrawable : public BasicDrawable
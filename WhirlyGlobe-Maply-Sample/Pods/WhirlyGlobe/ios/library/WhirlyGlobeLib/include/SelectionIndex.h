@@ -0,0 +1,109 @@
+/*
+ *  SelectionIndex.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <vector>
+#import "WhirlyVector.h"
+#import "Identifiable.h"
+
+namespace WhirlyKit
+{
+
+/** A selection volume is the part of display space that projects into
+    a given region of the screen.  It's represented as one or more convex
+    hulls (one per wrapping offset matrix), each a set of planes.
+    Something is inside if it's on the positive side of all the planes
+    of any one hull.
+  */
+class SelectionVolume
+{
+public:
+    SelectionVolume() { }
+
+    /// Add a hull for the given screen rectangle.  The screen rectangle is in the same
+    ///  units as frameSize and the model/view and projection matrices are what we'd render with.
+    void addScreenRect(const Mbr &screenMbr,const Point2f &frameSize,const Eigen::Matrix4d &modelAndViewMat,const Eigen::Matrix4d &projMat);
+
+    /// Add a hull for an axis aligned box in display space
+    void addBBox(const BBox &bbox);
+
+    /// True if there's nothing in the volume
+    bool empty() const { return hulls.empty(); }
+
+    /// Conservative check against a bounding box.  May return true for a box that's actually outside.
+    bool overlaps(const BBox &bbox) const;
+
+protected:
+    std::vector<std::vector<Eigen::Vector4d> > hulls;
+};
+
+/** Bounding volume hierarchy over selectable objects in display space.
+    The selection manager keeps one of these for each type of selectable
+    and rebuilds it lazily when the objects change.
+  */
+class SelectableIndex
+{
+public:
+    SelectableIndex();
+
+    /// Clear out the entries and the tree
+    void clear();
+
+    /// Add an object's bounds.  Won't be considered until the next build()
+    void addEntry(SimpleIdentity selectID,const BBox &bbox);
+
+    /// Sort the entries into the tree
+    void build();
+
+    /// Number of entries in the index
+    int numEntries() const { return (int)entries.size(); }
+
+    /// Return the bounds of everything in the index.  False if it's empty or not built.
+    bool getBounds(BBox &bbox) const;
+
+    /// Return the IDs of all the objects whose bounds overlap the given volume
+    void findInVolume(const SelectionVolume &vol,std::vector<SimpleIdentity> &selectIDs) const;
+
+protected:
+    // Single selectable and its bounds
+    class Entry
+    {
+    public:
+        BBox bbox;
+        Point3d center;
+        SimpleIdentity selectID;
+    };
+
+    // A node in the tree.  Leaves point to a range of entries.
+    class Node
+    {
+    public:
+        Node() : left(-1), right(-1), start(0), count(0) { }
+        BBox bbox;
+        int left,right;
+        int start,count;
+    };
+
+    // Recursively build a node for the given range of entries
+    int buildNode(int start,int end);
+
+    std::vector<Entry> entries;
+    std::vector<Node> nodes;
+};
+
+}
@@ -27,6 +27,7 @@
 #import "MaplyView.h"
 #import "Scene.h"
 #import "ScreenSpaceBuilder.h"
+#import "SelectionIndex.h"
 
 @class WhirlyKitSceneRendererES;
 @class WhirlyGlobeViewState;
@@ -175,7 +176,9 @@ typedef std::set<WhirlyKit::BillboardSelectable> BillboardSelectableSet;
      when the caller uses pickObject.
  
     All objects are currently being projected to the 2D screen and
-     evaluated for distance there.
+     evaluated for distance there.  Only those objects whose bounds
+     fall near the touch are considered, using a spatial index per
+     type of selectable that's rebuilt when the objects change.
  
     The selection manager is entirely thread safe except for destruction.
  */
@@ -252,6 +255,10 @@ public:
     /// Find all the objects within a given distance and return them, sorted by distance
     void pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *theView,std::vector<SelectedObject> &selObjs);
     
+    /// Find all the objects that overlap the given geographic bounding box.
+    /// Visibility ranges aren't taken into account, since there's no view.
+    void findObjectsInGeoMbr(const GeoMbr &geoMbr,SimpleIDSet &selectIDs);
+    
     // Everything we need to project a world coordinate to one or more screen locations
     class PlacementInfo
     {
@@ -271,13 +278,24 @@ public:
         Point2f frameSizeScale;
         Mbr frameMbr;
     };
+    
+    /// Find all the objects that overlap a region of the screen.
+    /// The region is a closed polygon in screen points (so a rectangle is just four of them).
+    /// Build the placement info on the main thread.  This can then run on any thread.
+    void findObjectsInScreenPolygon(const std::vector<Point2f> &screenPoly,const PlacementInfo &pInfo,SimpleIDSet &selectIDs);
 
 protected:
     static Eigen::Matrix2d calcScreenRot(float &screenRot,WhirlyKitViewState *viewState,WhirlyGlobeViewState *globeViewState,ScreenSpaceObjectLocation *ssObj,const CGPoint &objPt,const Eigen::Matrix4d &modelTrans,const Eigen::Matrix4d &normalMat,const Point2f &frameBufferSize);
     // Projects a world coordinate to one or more points on the screen (wrapping)
     void projectWorldPointToScreen(const Point3d &worldLoc,const PlacementInfo &pInfo,std::vector<Point2d> &screenPts,float scale);
-    // Convert rect selectables into more generic screen space objects
-    void getScreenSpaceObjects(const PlacementInfo &pInfo,std::vector<ScreenSpaceObjectLocation> &screenObjs,NSTimeInterval now);
+    // Calculate the outline of a screen space object projected to the given location
+    static void screenSpaceObjectPoints(const PlacementInfo &pInfo,ScreenSpaceObjectLocation &screenObj,const Point2d &projPt,const Eigen::Matrix4d &modelTrans,const Eigen::Matrix4d &normalMat,const Point2f &frameBufferSize,std::vector<Point2f> &screenPts);
+    // Convert rect selectables into more generic screen space objects.  Only the static ones within the volume are considered.
+    void getScreenSpaceObjects(const PlacementInfo &pInfo,const SelectionVolume &vol,std::vector<ScreenSpaceObjectLocation> &screenObjs,NSTimeInterval now);
+    // Build a selection volume for a region of the screen, including any wrapping offsets
+    void buildSelectionVolume(const PlacementInfo &pInfo,const Mbr &screenMbr,SelectionVolume &vol);
+    // Rebuild any of the spatial indices that are out of date.  Call with the mutex locked.
+    void updateIndices();
     // Internal object picking method
     void pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *theView,bool multi,std::vector<SelectedObject> &selObjs);
 
@@ -292,6 +310,12 @@ protected:
     WhirlyKit::MovingPolytopeSelectableSet movingPolytopeSelectables;
     WhirlyKit::LinearSelectableSet linearSelectables;
     WhirlyKit::BillboardSelectableSet billboardSelectables;
+    
+    /// Spatial indices for the selectables that don't move
+    SelectableIndex rect3DIndex,rect2DIndex,polytopeIndex,linearIndex,billboardIndex;
+    bool rect3DIndexDirty,rect2DIndexDirty,polytopeIndexDirty,linearIndexDirty,billboardIndexDirty;
+    /// Largest distance from center to corner of the 2D rectangles
+    float rect2DMaxExtent;
 };
  
 }
@@ -22,6 +22,7 @@
 #import <math.h>
 #import "VectorData.h"
 #import "GlobeMath.h"
+#import "DBFColumnReader.h"
 
 namespace WhirlyKit
 {
@@ -51,9 +52,20 @@ public:
     /// Fetch an object by the index
     virtual VectorShapeRef getObjectByIndex(unsigned int vecIndex,const StringSet *filter);
     
+    /// Open the same shapefile again for reading on another thread
+    virtual VectorReader *clone();
+    
+    /** Columnar access to the attributes.
+        If you only need a few fields, or a whole column at once, this is much
+        cheaper than building the attribute dictionaries.  NULL if there's no DBF.
+      */
+    const DBFColumnReader *getAttrReader();
+    
 protected:
+    NSString *fileName;
 	void *shp;
-	void *dbf;
+	DBFColumnReader *attrReader;
+    std::vector<int> allFields;
 	int where,numEntity,shapeType;
 	double minBound[4], maxBound[4];
 };
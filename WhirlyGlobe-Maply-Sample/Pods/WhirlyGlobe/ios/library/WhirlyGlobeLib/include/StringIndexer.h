@@ -59,6 +59,7 @@ extern StringIdentity u_FadeNameID;
 extern StringIdentity u_pMatrixNameID;
 extern StringIdentity u_ScaleNameID;
 extern StringIdentity u_HasTextureNameID;
+extern StringIdentity u_OctNormalsNameID;
 extern StringIdentity a_SingleMatrixNameID;
 extern StringIdentity a_PositionNameID;
 extern StringIdentity u_EyeVecNameID;
@@ -69,6 +70,7 @@ extern StringIdentity u_lifetimeNameID;
 extern StringIdentity u_pixDispSizeNameID;
 extern StringIdentity u_frameLenID;
 extern StringIdentity a_offsetNameID;
+extern StringIdentity a_sdfParamsNameID;
 extern StringIdentity u_uprightNameID;
 extern StringIdentity u_activerotNameID;
 extern StringIdentity a_rotNameID;
@@ -29,6 +29,8 @@
 #import "Identifiable.h"
 #import "WhirlyVector.h"
 #import "BasicDrawable.h"
+#import "ETC2Encoder.h"
+#import "ImageResample.h"
 
 namespace WhirlyKit
 {
@@ -122,6 +124,18 @@ public:
     void setSingleByteSource(WKSingleByteSource source) { byteSource = source; }
     /// If set, this is a texture we're creating for output purposes
     void setIsEmptyTexture(bool inIsEmptyTexture) { isEmptyTexture = inIsEmptyTexture; }
+    /// If we're encoding raw data to ETC2, how hard to work at it
+    void setETC2Quality(WKETC2Quality quality) { etc2Quality = quality; }
+    
+    /// If the format is ETC2 (RGB8 or RGBA8) and we've got raw RGBA data, encode it now.
+    /// This is slow, so call it on a loader thread.  Otherwise it happens in processData().
+    /// If the data can't be encoded, we fall back to RGBA and return false.
+    bool compressETC2();
+
+    /// Build the mipmap levels from raw RGBA data with the given filter.
+    /// Call this on a loader thread and the levels are uploaded as is, rather than via glGenerateMipmap().
+    /// Returns false for compressed or non-RGBA textures, which are left alone.
+    bool buildMipmaps(WKMipFilter filter);
 
     /// Render side only.  Don't call this.  Create the openGL version
 	virtual bool createInGL(OpenGLMemManager *memManager);
@@ -150,6 +164,14 @@ protected:
     bool wrapU,wrapV;
     GLenum interpType;
     bool isEmptyTexture;
+    WKETC2Quality etc2Quality;
+    /// Mipmap levels we built ourselves, level 1 on down
+    std::vector<NSData *> mipData;
+    
+    /// Convert raw RGBA (or A or RG) data into what the format wants
+    NSData *convertData(NSData *data,int dataWidth,int dataHeight);
+    /// Hand one level of converted data over to OpenGL
+    void uploadLevel(int level,int levelWidth,int levelHeight,NSData *convertedData);
 };
 	
 }
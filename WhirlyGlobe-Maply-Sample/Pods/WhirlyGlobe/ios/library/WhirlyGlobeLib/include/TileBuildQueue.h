@@ -0,0 +1,106 @@
+/*
+ *  TileBuildQueue.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <atomic>
+#import <memory>
+#import <mutex>
+#import <vector>
+
+namespace WhirlyKit
+{
+
+/** Generation counter shared between a tile and the work queued up for it.
+    The tile bumps it whenever it's cancelled, refetched or removed.
+    Anything queued against an older generation is stale and gets skipped.
+  */
+class TileGeneration
+{
+public:
+    TileGeneration() : value(0) { }
+    
+    /// Current generation
+    int current() { return value.load(); }
+    
+    /// Move on to a new generation, invalidating the work for the old one
+    int bump() { return ++value; }
+    
+protected:
+    std::atomic<int> value;
+};
+typedef std::shared_ptr<TileGeneration> TileGenerationRef;
+
+/** The tile build queue runs the slow parts of loading a tile (parsing, decoding,
+    building textures) on a small pool of workers.
+    The most important tiles go first and work for tiles that have moved on is skipped.
+    The queue is bounded, so if it overflows the least important job is dropped.
+  */
+class TileBuildQueue : public std::enable_shared_from_this<TileBuildQueue>
+{
+public:
+    /// Pass in zero workers to size the pool from the number of CPUs
+    TileBuildQueue(int maxWorkers,int maxQueued);
+    ~TileBuildQueue();
+    
+    /** Add a piece of work for a tile.
+        The work block is skipped if the tile's generation has moved past genValue before it gets to run.
+        If the queue overflows and this is the least important job, the dropped block is called instead.
+        Either block is called on a worker or the caller's thread, so don't assume one or the other.
+      */
+    void addJob(double importance,TileGenerationRef gen,int genValue,dispatch_block_t work,dispatch_block_t dropped);
+    
+    /// Throw away everything that hasn't started yet.  No callbacks.
+    void cancelAll();
+    
+    /// Number of jobs waiting to run
+    int numQueued();
+    
+    /// Log the number of jobs run, skipped as stale and dropped for overflow
+    void dumpStats();
+    
+protected:
+    class Job
+    {
+    public:
+        // Most important goes first, then oldest
+        bool operator < (const Job &that) const;
+        
+        double importance;
+        unsigned long seq;
+        TileGenerationRef gen;
+        int genValue;
+        dispatch_block_t work;
+        dispatch_block_t dropped;
+    };
+    
+    // Worker loop.  Runs until the queue is empty.
+    void runJobs();
+    
+    std::mutex mutex;
+    std::vector<Job> jobs;
+    unsigned long seq;
+    int maxWorkers,activeWorkers;
+    int maxQueued;
+    dispatch_queue_t queue;
+    
+    std::atomic<int> numRun,numStale,numDropped;
+};
+typedef std::shared_ptr<TileBuildQueue> TileBuildQueueRef;
+
+}
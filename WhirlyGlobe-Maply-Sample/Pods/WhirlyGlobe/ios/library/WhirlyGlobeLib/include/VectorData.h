@@ -23,6 +23,7 @@
 #import <vector>
 #import <set>
 #import <map>
+#import <mutex>
 #import "Identifiable.h"
 #import "WhirlyVector.h"
 #import "WhirlyGeometry.h"
@@ -139,6 +140,59 @@ protected:
 /// Look for a triangle/ray intersection in the mesh
 bool VectorTrianglesRayIntersect(const Point3d &org,const Point3d &dir,const VectorTriangles &mesh,double *outT,Point3d *iPt);
 
+/** Point in polygon test for a set of loops, prepared ahead of time.
+    The edges are sorted into horizontal bands so a test only looks at the edges
+    that cross the point's latitude, rather than all of them.
+    The answer is the same as running PointInPolygon() against each loop.
+  */
+class PreparedPolygon
+{
+public:
+    PreparedPolygon(const std::vector<VectorRing> &loops);
+    
+    /// True if the point is inside any of the loops
+    bool pointInside(const Point2f &pt) const;
+    
+protected:
+    class Edge
+    {
+    public:
+        Point2f p0,p1;
+        int loop;
+    };
+    
+    float minY,maxY,bandScale;
+    int numBands;
+    // Edges for band i run from bandStart[i] to bandStart[i+1], sorted by loop
+    std::vector<int> bandStart;
+    std::vector<Edge> edges;
+};
+typedef std::shared_ptr<PreparedPolygon> PreparedPolygonRef;
+
+/** Bounding boxes around runs of segments in a linear feature.
+    Hit tests use this to go straight to the parts of a long line
+    that are near a point, rather than looking at every segment.
+  */
+class LinearSegmentIndex
+{
+public:
+    LinearSegmentIndex(const VectorRing &pts);
+    LinearSegmentIndex(const VectorRing3d &pts);
+    
+    /// Number of segments in each run
+    static const int RunSize = 16;
+    
+    /// Fill in the first point of each run that comes within dist (x and y, in radians) of the coordinate.
+    /// A run covers the segments from that point to RunSize points after it.
+    void findRuns(GeoCoord coord,const Point2f &dist,std::vector<int> &starts) const;
+    
+protected:
+    template<typename T> void build(const std::vector<T> &pts);
+
+    std::vector<Mbr> runMbrs;
+};
+typedef std::shared_ptr<LinearSegmentIndex> LinearSegmentIndexRef;
+
 /// Areal feature is a list of loops.  The first is an outer loop
 ///  and all the rest are inner loops
 class VectorAreal : public VectorShape
@@ -154,6 +208,17 @@ public:
     /// True if the given point is within one of the loops
     bool pointInside(GeoCoord coord);
     
+    /// Same as pointInside(), but builds a prepared index on the first call and uses it after.
+    /// Worth it if you're testing lots of points.  If you change the loops, call clearPrepared().
+    /// Safe to call from multiple threads.
+    bool pointInsidePrepared(GeoCoord coord);
+    
+    /// Build the prepared index now, if it isn't already.
+    void prepare();
+    
+    /// Throw away the prepared index.  Call this if the loops change.
+    void clearPrepared();
+    
     /// Sudivide to the given tolerance (in degrees)
     void subdivide(float tolerance);
         
@@ -163,8 +228,20 @@ public:
     
 protected:
     VectorAreal();
+    
+    /// Return the prepared index, building it if need be
+    PreparedPolygonRef getPrepared();
+    
+    std::mutex preparedLock;
+    PreparedPolygonRef prepared;
 };
 
+/** Test a whole batch of points against a batch of areals.
+    For each point, we return the index of the first areal that contains it, or -1.
+    The areals are prepared first and then the points are split up across the CPUs.
+  */
+void PointsInAreals(const std::vector<GeoCoord> &pts,const std::vector<VectorArealRef> &areals,std::vector<int> &which);
+
 /// Linear feature is just a list of points that form
 ///  a set of edges
 class VectorLinear : public VectorShape
@@ -180,11 +257,21 @@ public:
     /// Sudivide to the given tolerance (in degrees)
     void subdivide(float tolerance);
 
+    /// Return the segment index, building it if need be.  If you change the points, call clearSegmentIndex().
+    /// Safe to call from multiple threads.
+    LinearSegmentIndexRef getSegmentIndex();
+    
+    /// Throw away the segment index
+    void clearSegmentIndex();
+
 	GeoMbr geoMbr;
 	VectorRing pts;
     
 protected:
     VectorLinear();
+
+    std::mutex segIndexLock;
+    LinearSegmentIndexRef segIndex;
 };
 
 /// Linear feature is just a list of points that form
@@ -199,11 +286,21 @@ public:
     virtual GeoMbr calcGeoMbr();
     void initGeoMbr();
         
+    /// Return the segment index, building it if need be.  If you change the points, call clearSegmentIndex().
+    /// Safe to call from multiple threads.
+    LinearSegmentIndexRef getSegmentIndex();
+    
+    /// Throw away the segment index
+    void clearSegmentIndex();
+
     GeoMbr geoMbr;
     VectorRing3d pts;
     
 protected:
     VectorLinear3d();
+
+    std::mutex segIndexLock;
+    LinearSegmentIndexRef segIndex;
 };
 
 /// The Points feature is a list of points that share attributes
@@ -274,6 +371,10 @@ public:
     /// You need to be able to seek in your file format for this.
     /// The filter works the same as for getNextObect()
     virtual VectorShapeRef getObjectByIndex(unsigned int vecIndex,const StringSet *filter)  { return VectorShapeRef(); }
+    
+    /// Return a new reader on the same source so another thread can read by index.
+    /// The caller owns the result.  NULL if we can't do that.
+    virtual VectorReader *clone() { return NULL; }
 };
 
 /** Helper routine to parse geoJSON into a collection of vectors.
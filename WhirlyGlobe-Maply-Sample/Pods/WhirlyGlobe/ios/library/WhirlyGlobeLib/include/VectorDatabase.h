@@ -32,6 +32,7 @@ typedef std::set<unsigned int> UIntSet;
 /** The Vector Database is used to keep vector data out of memory until needed.
     It will initialize itself if its cache files aren't there.
     That can be slow, so ideally initialize it offline.
+    If the reader can be cloned, the shapes are read in parallel chunks.
     It builds both a file of MBRs and a sqlite database with the attributes
  */
 class VectorDatabase
@@ -88,7 +89,7 @@ public:
     sqlite3 *getSqliteDb();
     
 protected:
-    bool buildCaches(NSString *mbrCache,NSString *sqlDb);
+    bool buildCaches(NSString *mbrCache,NSString *sqlDb,const std::set<std::string> *indices);
     bool readCaches(NSString *mbrCache,NSString *sqlDb);
     
     VectorReader *reader;
@@ -100,6 +100,10 @@ typedef std::set<NSObject<WhirlyKitViewWatcherDelegate> * __weak> WhirlyKitViewW
 /// From a screen point calculate the corresponding point in 3-space
 - (WhirlyKit::Point3d)pointUnproject:(WhirlyKit::Point2f)screenPt width:(unsigned int)frameWidth height:(unsigned int)frameHeight clip:(bool)clip;
 
+/// Project a batch of display space points onto the screen, setting up the frustum just once.
+/// The transform is the model and view matrix.  Points that can't be projected come back as NAN.
+- (void)pointsOnScreen:(const WhirlyKit::Point3d *)worldLocs numPoints:(int)numPts transform:(const Eigen::Matrix4d *)transform frameSize:(const WhirlyKit::Point2f &)frameSize screenPts:(CGPoint *)screenPts;
+
 /// Return the ray running from eye through the given screen point in display space
 //- (WhirlyKit::Ray3f)displaySpaceRayFromScreenPt:(WhirlyKit::Point2f)screenPt width:(float)frameWidth height:(float)frameHeight;
 
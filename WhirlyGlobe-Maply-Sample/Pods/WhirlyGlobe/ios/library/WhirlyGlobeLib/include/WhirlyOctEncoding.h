@@ -33,4 +33,9 @@ namespace WhirlyKit
  */
 Point3f OctDecode(uint8_t x, uint8_t y);
 
+/** Oct-encodes a unit vector.  The result is in [-1,1] and undoes
+    the same way as OctDecode, just without the byte quantization.
+ */
+Point2f OctEncode(const Point3f &norm);
+
 }
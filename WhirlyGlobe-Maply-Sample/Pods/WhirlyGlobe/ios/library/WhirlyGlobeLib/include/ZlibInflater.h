@@ -0,0 +1,91 @@
+/*
+ *  ZlibInflater.h
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <zlib.h>
+#import <map>
+#import <mutex>
+
+namespace WhirlyKit
+{
+
+/** Output buffers for decompression, recycled between tiles.
+    Buffers handed back are kept around, up to a total size, and handed out
+    again for anything that fits in them without wasting too much.
+  */
+class InflateBufferPool
+{
+public:
+    InflateBufferPool();
+    ~InflateBufferPool();
+    
+    /// The pool everyone shares
+    static InflateBufferPool *sharedPool();
+    
+    /// Return a buffer of at least the given capacity.  The capacity is updated to the real size.
+    unsigned char *getBuffer(size_t &capacity);
+    
+    /// Hand a buffer back to the pool (or free it)
+    void releaseBuffer(unsigned char *buf,size_t capacity);
+    
+protected:
+    std::mutex lock;
+    std::multimap<size_t,unsigned char *> buffers;
+    size_t totalSize;
+};
+
+/** Reusable zlib and gzip decompression.
+    Keeps its inflate state between calls, so decompressing lots of small tiles
+    doesn't set up and tear down zlib every time.  Not thread safe, so use
+    threadInflater() to get the one for the current thread.
+ 
+    If WK_INFLATE_LIBCOMPRESSION is defined to 1 (and libcompression is linked),
+    gzip data with a usable size in its trailer is decoded with Apple's
+    libcompression instead and checked against the CRC.
+  */
+class ZlibInflater
+{
+public:
+    ZlibInflater();
+    ~ZlibInflater();
+    
+    /// The inflater for the current thread
+    static ZlibInflater *threadInflater();
+    
+    /// Uncompressed size from a gzip trailer, or 0 if this isn't gzip or the size looks wrong
+    static size_t gzipSizeHint(const void *data,size_t len);
+    
+    /** Decompress zlib or gzip data (detected from the header) into a buffer from the pool.
+        sizeHint is the expected uncompressed size, or 0 if not known, in which case we'll try the gzip trailer.
+        On success the caller owns outBuf and should return it to InflateBufferPool with its capacity.
+      */
+    bool inflate(const void *data,size_t len,size_t sizeHint,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity);
+    
+    /// Decompress into an NSData backed by a pooled buffer, or nil on failure
+    NSData *inflateToData(const void *data,size_t len,size_t sizeHint);
+    
+protected:
+    bool inflateZlib(const void *data,size_t len,size_t sizeHint,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity);
+    bool inflateCompression(const void *data,size_t len,size_t outSize,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity);
+    
+    z_stream strm;
+    bool strmValid;
+};
+
+}
@@ -55,6 +55,7 @@ using namespace Eigen;
     _endEnable = [desc doubleForKey:@"enableend" default:0.0];
     SimpleIdentity shaderID = [desc intForKey:@"shader" default:EmptyIdentity];
     _programID = [desc intForKey:@"program" default:(int)shaderID];
+    _compactVertices = [desc boolForKey:@"compactvertices" default:false];
     
     // Uniforms to be passed to shader
     // Note: Should add the rest of the types
@@ -103,6 +104,7 @@ using namespace Eigen;
     drawable->setViewerVisibility(_minViewerDist,_maxViewerDist,_viewerCenter);
     drawable->setProgram(_programID);
     drawable->setUniforms(_uniforms);
+    drawable->setCompactAttributes(_compactVertices);
 }
 
 - (void)setupBasicDrawableInstance:(WhirlyKit::BasicDrawableInstance *)drawInst
@@ -26,6 +26,7 @@
 #import "UIImage+Stuff.h"
 #import "SceneRendererES.h"
 #import "TextureAtlas.h"
+#import "OpenGLES2Program.h"
 
 using namespace Eigen;
 
@@ -70,6 +71,7 @@ void BasicDrawable::basicDrawableInit()
     renderTargetID = EmptyIdentity;
     
     clipCoords = false;
+    compactAttributes = false;
     
     hasMatrix = false;
 }
@@ -282,6 +284,33 @@ float BasicDrawable::getDrawOffset()
     return drawOffset;
 }
 
+void BasicDrawable::setCompactAttributes(bool compact)
+{
+    compactAttributes = compact;
+}
+
+bool BasicDrawable::getCompactAttributes()
+{
+    return compactAttributes;
+}
+
+bool BasicDrawable::setAttributePacking(int which,BDAttributePacking packing)
+{
+    if (which < 0 || which >= (int)vertexAttributes.size())
+        return false;
+    
+    return vertexAttributes[which]->setPacking(packing);
+}
+
+bool BasicDrawable::hasOctNormals() const
+{
+    for (const VertexAttribute *attr : vertexAttributes)
+        if (attr->nameID == a_normalNameID && attr->getPacking() == BDPackOctNormal)
+            return true;
+    
+    return false;
+}
+
 void BasicDrawable::setType(GLenum inType)
 {
     type = inType;
@@ -665,6 +694,18 @@ GLuint BasicDrawable::singleVertexSize()
         VertexAttribute *attr = vertexAttributes[ii];
         if (attr->numElements() != 0)
         {
+            // Pick a packing if we haven't been told one
+            if (compactAttributes && attr->getPacking() == BDPackNone)
+            {
+                // Only shaders with u_octNormals know how to decode oct normals.
+                // Billboards and wide vectors, among others, use the raw normal.
+                if (attr->nameID == a_normalNameID && attr->getDataType() == BDFloat3Type && type == GL_TRIANGLES &&
+                    ProgramDecodesOctNormals(programId))
+                    attr->setPacking(BDPackOctNormal);
+                else
+                    attr->setPacking(attr->compactPacking());
+            }
+
             attr->buffer = singleVertSize;
             singleVertSize += attr->size();
         }
@@ -675,32 +716,43 @@ GLuint BasicDrawable::singleVertexSize()
 
 // Adds the basic vertex data to an interleaved vertex buffer
 void BasicDrawable::addPointToBuffer(unsigned char *basePtr,int which,const Point3d *center)
+{
+    addPointsToBuffer(basePtr,which,1,center);
+}
+
+// Copy a run of vertices into an interleaved buffer, one attribute at a time
+void BasicDrawable::addPointsToBuffer(unsigned char *basePtr,int start,int count,const Point3d *center)
 {
     if (!points.empty())
     {
-        Point3f &pt = points[which];
+        unsigned char *ptPtr = basePtr+pointBuffer;
         
         // If there's a center, we have to offset everything first
         if (center)
         {
-            Vector4d pt3d;
-            if (hasMatrix)
-                pt3d = mat * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            else
-                pt3d = Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            Point3f newPt(pt3d.x()-center->x(),pt3d.y()-center->y(),pt3d.z()-center->z());
-            memcpy(basePtr+pointBuffer, &newPt.x(), 3*sizeof(GLfloat));
+            for (int ii=start;ii<start+count;ii++,ptPtr+=vertexSize)
+            {
+                const Point3f &pt = points[ii];
+                Vector4d pt3d;
+                if (hasMatrix)
+                    pt3d = mat * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+                else
+                    pt3d = Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+                Point3f newPt(pt3d.x()-center->x(),pt3d.y()-center->y(),pt3d.z()-center->z());
+                memcpy(ptPtr, &newPt.x(), 3*sizeof(GLfloat));
+            }
         } else {
             // Otherwise, copy it straight in
-            memcpy(basePtr+pointBuffer, &pt.x(), 3*sizeof(GLfloat));
+            if (vertexSize == 3*sizeof(GLfloat))
+                memcpy(ptPtr, &points[start].x(), count*3*sizeof(GLfloat));
+            else
+                for (int ii=start;ii<start+count;ii++,ptPtr+=vertexSize)
+                    memcpy(ptPtr, &points[ii].x(), 3*sizeof(GLfloat));
         }
     }
     
     for (VertexAttribute *attr : vertexAttributes)
-    {
-        if (attr->numElements() != 0)
-            memcpy(basePtr+attr->buffer, attr->addressForElement(which), attr->size());
-    }
+        attr->copyToBuffer(basePtr,vertexSize,start,count);
 }
 
 void BasicDrawable::setupGL(WhirlyKitGLSetupInfo *setupInfo,OpenGLMemManager *memManager)
@@ -771,16 +823,14 @@ void BasicDrawable::setupGL(WhirlyKitGLSetupInfo *setupInfo,OpenGLMemManager *me
     else
         glMem = glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, GL_MAP_WRITE_BIT);
     unsigned char *basePtr = (unsigned char *)glMem + sharedBufferOffset;
-    for (unsigned int ii=0;ii<numVerts;ii++,basePtr+=vertexSize)
-        addPointToBuffer(basePtr,ii,NULL);
+    addPointsToBuffer(basePtr,0,numVerts,NULL);
     
     // And copy in the element buffer
     if (tris.size())
     {
         triBuffer = vertexSize*numVerts;
         unsigned char *basePtr = (unsigned char *)glMem + triBuffer + sharedBufferOffset;
-        for (unsigned int ii=0;ii<tris.size();ii++,basePtr+=sizeof(Triangle))
-            memcpy(basePtr, &tris[ii], sizeof(Triangle));
+        memcpy(basePtr, &tris[0], tris.size()*sizeof(Triangle));
     }
     if (context.API < kEAGLRenderingAPIOpenGLES3)
         glUnmapBufferOES(GL_ARRAY_BUFFER);
@@ -833,8 +883,8 @@ NSData *BasicDrawable::asData(bool dupStart,bool dupEnd)
             addPointToBuffer(basePtr, 0, NULL);
             basePtr += vertexSize;
         }
-        for (unsigned int ii=0;ii<points.size();ii++,basePtr+=vertexSize)
-            addPointToBuffer(basePtr, ii, NULL);
+        addPointsToBuffer(basePtr, 0, (int)points.size(), NULL);
+        basePtr += vertexSize*points.size();
         if (dupEnd)
         {
             addPointToBuffer(basePtr, (int)(points.size()-1), NULL);
@@ -871,8 +921,7 @@ void BasicDrawable::asVertexAndElementData(NSMutableData **retVertData,NSMutable
     int numVerts = (int)points.size();
     NSMutableData *vertData = [[NSMutableData alloc] initWithBytesNoCopy:(malloc(vertexSize * numVerts)) length:vertexSize*numVerts freeWhenDone:YES];
     unsigned char *basePtr = (unsigned char *)[vertData mutableBytes];
-    for (unsigned int ii=0;ii<points.size();ii++,basePtr+=vertexSize)
-        addPointToBuffer(basePtr, ii, center);
+    addPointsToBuffer(basePtr, 0, numVerts, center);
     
     // Build up the triangles
     int triSize = singleElementSize * 3;
@@ -1237,6 +1286,9 @@ void BasicDrawable::drawOGL2(WhirlyKitRendererFrameInfo *frameInfo,Scene *scene)
     // Let the shaders know if we even have a texture
     prog->setUniform(u_HasTextureNameID, anyTextures);
     
+    // And whether the normals need decoding
+    prog->setUniform(u_OctNormalsNameID, hasOctNormals());
+    
     // If this is present, the drawable wants to do something based where the viewer is looking
     prog->setUniform(u_EyeVecNameID, frameInfo.fullEyeVec);
     
@@ -31,7 +31,7 @@ namespace WhirlyKit
 {
 
 BasicDrawableInstance::BasicDrawableInstance(const std::string &name,SimpleIdentity masterID,Style style)
-: Drawable(name), programID(EmptyIdentity), enable(true), masterID(masterID), requestZBuffer(false), writeZBuffer(true), startEnable(0.0), endEnable(0.0), instBuffer(0), numInstances(0), vertArrayObj(0), minVis(DrawVisibleInvalid), maxVis(DrawVisibleInvalid), minViewerDist(DrawVisibleInvalid), maxViewerDist(DrawVisibleInvalid), viewerCenter(DrawVisibleInvalid,DrawVisibleInvalid,DrawVisibleInvalid), startTime(0), moving(false), instanceStyle(style), renderTargetID(EmptyIdentity), hasColor(false), hasDrawPriority(false), hasLineWidth(false)
+: Drawable(name), programID(EmptyIdentity), enable(true), masterID(masterID), requestZBuffer(false), writeZBuffer(true), startEnable(0.0), endEnable(0.0), instBuffer(0), numInstances(0), vertArrayObj(0), minVis(DrawVisibleInvalid), maxVis(DrawVisibleInvalid), minViewerDist(DrawVisibleInvalid), maxViewerDist(DrawVisibleInvalid), viewerCenter(DrawVisibleInvalid,DrawVisibleInvalid,DrawVisibleInvalid), startTime(0), moving(false), instanceStyle(style), renderTargetID(EmptyIdentity), hasColor(false), hasDrawPriority(false), hasLineWidth(false), lodRadius(0.0), lodMinSize(0.0), lodMaxSize(0.0)
 {
 }
 
@@ -190,7 +190,10 @@ void BasicDrawableInstance::setupGL(WhirlyKitGLSetupInfo *setupInfo,OpenGLMemMan
     instSize = centerSize + matSize + colorSize + colorInstSize + modelDirSize;
     int bufferSize = (int)(instSize * instances.size());
     
-    instBuffer = memManager->getBufferID(bufferSize,GL_STATIC_DRAW);
+    // If we're picking instances by size, we'll be rewriting the buffer from a copy as we go
+    bool useLod = lodRadius > 0.0;
+    
+    instBuffer = memManager->getBufferID(bufferSize,useLod ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, instBuffer);
     void *glMem = NULL;
     EAGLContext *context = [EAGLContext currentContext];
@@ -198,7 +201,9 @@ void BasicDrawableInstance::setupGL(WhirlyKitGLSetupInfo *setupInfo,OpenGLMemMan
         glMem = glMapBufferOES(GL_ARRAY_BUFFER, GL_WRITE_ONLY_OES);
     else
         glMem = glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, GL_MAP_WRITE_BIT);
-    unsigned char *basePtr = (unsigned char *)glMem;
+    if (useLod)
+        lodInstData.resize(bufferSize);
+    unsigned char *basePtr = useLod ? &lodInstData[0] : (unsigned char *)glMem;
     for (unsigned int ii=0;ii<instances.size();ii++,basePtr+=instSize)
     {
         const SingleInstance &inst = instances[ii];
@@ -218,6 +223,24 @@ void BasicDrawableInstance::setupGL(WhirlyKitGLSetupInfo *setupInfo,OpenGLMemMan
         }
     }
     
+    if (useLod)
+    {
+        // Start out with all of them, the first frame will sort it out
+        memcpy(glMem, &lodInstData[0], bufferSize);
+        lodInsts.resize(instances.size());
+        for (unsigned int ii=0;ii<instances.size();ii++)
+            lodInsts[ii] = ii;
+        
+        // The instance matrix may scale the model
+        lodInstRadius.resize(instances.size());
+        for (unsigned int ii=0;ii<instances.size();ii++)
+        {
+            const Matrix4d &mat = instances[ii].mat;
+            double scale = std::max(mat.block<3,1>(0,0).norm(),std::max(mat.block<3,1>(0,1).norm(),mat.block<3,1>(0,2).norm()));
+            lodInstRadius[ii] = scale * lodRadius;
+        }
+    }
+    
     if (context.API < kEAGLRenderingAPIOpenGLES3)
         glUnmapBufferOES(GL_ARRAY_BUFFER);
     else
@@ -331,6 +354,45 @@ GLuint BasicDrawableInstance::setupVAO(OpenGLES2Program *prog)
     return vertArrayObj;
 }
     
+void BasicDrawableInstance::updateLodInstances(WhirlyKitRendererFrameInfo *frameInfo)
+{
+    // Projected diameter in pixels is the radius times this over the distance
+    float pixelScale = frameInfo.projMat(1,1) * frameInfo.sceneRenderer.framebufferHeight;
+    const Matrix4d &mvMat = frameInfo.viewAndModelMat4d;
+    NSTimeInterval elapsed = frameInfo.currentTime - startTime;
+    
+    lodNewInsts.clear();
+    for (unsigned int ii=0;ii<instances.size();ii++)
+    {
+        const SingleInstance &inst = instances[ii];
+        Point3d center = inst.center;
+        if (moving && inst.duration > 0.0)
+            center += (inst.endCenter - inst.center) * elapsed / inst.duration;
+        Vector4d viewPt = mvMat * Vector4d(center.x(),center.y(),center.z(),1.0);
+        double dist = Vector3d(viewPt.x(),viewPt.y(),viewPt.z()).norm();
+        float size = dist > 0.0 ? lodInstRadius[ii] * pixelScale / dist : MAXFLOAT;
+        if (lodMinSize <= size && size < lodMaxSize)
+            lodNewInsts.push_back(ii);
+    }
+    
+    // Only rewrite the buffer when the set changes
+    if (lodNewInsts != lodInsts)
+    {
+        lodInsts.swap(lodNewInsts);
+        if (!lodInsts.empty())
+        {
+            lodUploadData.resize(lodInsts.size() * instSize);
+            for (unsigned int ii=0;ii<lodInsts.size();ii++)
+                memcpy(&lodUploadData[ii*instSize], &lodInstData[lodInsts[ii]*instSize], instSize);
+            glBindBuffer(GL_ARRAY_BUFFER, instBuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, lodUploadData.size(), &lodUploadData[0]);
+            CheckGLError("BasicDrawableInstance::updateLodInstances glBufferSubData");
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    }
+    numInstances = (int)lodInsts.size();
+}
+
 // Used to pass in buffer offsets
 #define CALCBUFOFF(base,off) ((char *)((long)(base) + (off)))
 
@@ -439,6 +501,14 @@ void BasicDrawableInstance::draw(WhirlyKitRendererFrameInfo *frameInfo,Scene *sc
         basicDraw->setVisibleRange(oldMinVis, oldMaxVis);
         
     } else {
+        // Pick out the instances that are the right size for this level of detail
+        if (lodRadius > 0.0 && instBuffer)
+        {
+            updateLodInstances(frameInfo);
+            if (numInstances == 0)
+                return;
+        }
+        
         // New style makes use of OpenGL instancing and makes its own copy of the geometry
         EAGLContext *context = [EAGLContext currentContext];
         OpenGLES2Program *prog = frameInfo.program;
@@ -530,6 +600,9 @@ void BasicDrawableInstance::draw(WhirlyKitRendererFrameInfo *frameInfo,Scene *sc
         // Let the shaders know if we even have a texture
         prog->setUniform(u_HasTextureNameID, anyTextures);
         
+        // And whether the normals need decoding
+        prog->setUniform(u_OctNormalsNameID, basicDraw->hasOctNormals());
+        
         // If this is present, the drawable wants to do something based where the viewer is looking
         prog->setUniform(u_EyeVecNameID, frameInfo.fullEyeVec);
         
@@ -277,6 +277,13 @@ void BigDrawable::draw(WhirlyKitRendererFrameInfo *frameInfo,Scene *scene)
     
     // Let the shaders know if we even have a texture
     prog->setUniform(u_HasTextureNameID, anyTextures);
+    
+    // And whether the normals need decoding
+    bool octNormals = false;
+    for (const VertexAttribute &attr : vertexAttributes)
+        if (attr.nameID == a_normalNameID && attr.getPacking() == BDPackOctNormal)
+            octNormals = true;
+    prog->setUniform(u_OctNormalsNameID, octNormals);
 
     // The program itself may have some textures to bind
     bool hasTexture[WhirlyKitMaxTextures];
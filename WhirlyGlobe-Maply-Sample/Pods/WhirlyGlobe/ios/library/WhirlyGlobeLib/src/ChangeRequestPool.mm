@@ -0,0 +1,199 @@
+/*
+ *  ChangeRequestPool.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <Foundation/Foundation.h>
+#import <pthread.h>
+#import <stdlib.h>
+#import <cxxabi.h>
+#import <new>
+#import <map>
+#import "ChangeRequestPool.h"
+
+namespace WhirlyKit
+{
+
+// Blocks are sorted into size classes this far apart
+static const size_t PoolGranularity = 16;
+// Number of size classes.  Anything bigger goes straight to malloc.
+static const int PoolNumClasses = 32;
+// Largest number of free blocks we'll hang on to per size class
+static const size_t PoolMaxFreePerClass = 1024;
+
+// Sits in front of each block.  Sized to keep the block aligned.
+typedef union
+{
+    int sizeClass;
+    max_align_t align;
+} PoolBlockHeader;
+
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<void *> poolFreeLists[PoolNumClasses];
+
+// Stats, which we only keep if asked
+static bool poolStatsEnabled = false;
+static pthread_mutex_t poolStatsLock = PTHREAD_MUTEX_INITIALIZER;
+static long poolNumAllocs = 0,poolNumReused = 0,poolNumLarge = 0,poolNumBatches = 0;
+static std::map<const char *,long> poolTypeCounts;
+
+void *ChangeRequestPool::alloc(size_t size)
+{
+    int sizeClass = (int)((size + PoolGranularity - 1) / PoolGranularity) - 1;
+    if (sizeClass < 0)
+        sizeClass = 0;
+
+    void *block = NULL;
+    if (sizeClass < PoolNumClasses)
+    {
+        pthread_mutex_lock(&poolLock);
+        std::vector<void *> &freeList = poolFreeLists[sizeClass];
+        if (!freeList.empty())
+        {
+            block = freeList.back();
+            freeList.pop_back();
+        }
+        pthread_mutex_unlock(&poolLock);
+
+        if (poolStatsEnabled)
+        {
+            pthread_mutex_lock(&poolStatsLock);
+            poolNumAllocs++;
+            if (block)
+                poolNumReused++;
+            pthread_mutex_unlock(&poolStatsLock);
+        }
+
+        if (!block)
+            block = malloc(sizeof(PoolBlockHeader) + (sizeClass+1) * PoolGranularity);
+    } else {
+        sizeClass = -1;
+        block = malloc(sizeof(PoolBlockHeader) + size);
+
+        if (poolStatsEnabled)
+        {
+            pthread_mutex_lock(&poolStatsLock);
+            poolNumAllocs++;
+            poolNumLarge++;
+            pthread_mutex_unlock(&poolStatsLock);
+        }
+    }
+    if (!block)
+        throw std::bad_alloc();
+
+    ((PoolBlockHeader *)block)->sizeClass = sizeClass;
+
+    return (char *)block + sizeof(PoolBlockHeader);
+}
+
+void ChangeRequestPool::release(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    void *block = (char *)ptr - sizeof(PoolBlockHeader);
+    int sizeClass = ((PoolBlockHeader *)block)->sizeClass;
+    if (sizeClass >= 0)
+    {
+        pthread_mutex_lock(&poolLock);
+        std::vector<void *> &freeList = poolFreeLists[sizeClass];
+        if (freeList.size() < PoolMaxFreePerClass)
+        {
+            freeList.push_back(block);
+            block = NULL;
+        }
+        pthread_mutex_unlock(&poolLock);
+    }
+
+    if (block)
+        free(block);
+}
+
+void ChangeRequestPool::releaseBatch(std::vector<void *> &ptrs)
+{
+    if (ptrs.empty())
+        return;
+
+    std::vector<void *> toFree;
+
+    // One trip through the lock for the whole batch
+    pthread_mutex_lock(&poolLock);
+    for (void *ptr : ptrs)
+    {
+        if (!ptr)
+            continue;
+        void *block = (char *)ptr - sizeof(PoolBlockHeader);
+        int sizeClass = ((PoolBlockHeader *)block)->sizeClass;
+        if (sizeClass >= 0 && poolFreeLists[sizeClass].size() < PoolMaxFreePerClass)
+            poolFreeLists[sizeClass].push_back(block);
+        else
+            toFree.push_back(block);
+    }
+    pthread_mutex_unlock(&poolLock);
+
+    for (void *block : toFree)
+        free(block);
+
+    if (poolStatsEnabled)
+    {
+        pthread_mutex_lock(&poolStatsLock);
+        poolNumBatches++;
+        pthread_mutex_unlock(&poolStatsLock);
+    }
+
+    ptrs.clear();
+}
+
+void ChangeRequestPool::setStatsEnabled(bool enabled)
+{
+    poolStatsEnabled = enabled;
+}
+
+bool ChangeRequestPool::getStatsEnabled()
+{
+    return poolStatsEnabled;
+}
+
+void ChangeRequestPool::recordRequest(const char *typeName)
+{
+    if (!poolStatsEnabled)
+        return;
+
+    pthread_mutex_lock(&poolStatsLock);
+    poolTypeCounts[typeName]++;
+    pthread_mutex_unlock(&poolStatsLock);
+}
+
+void ChangeRequestPool::dumpStats()
+{
+    if (!poolStatsEnabled)
+        return;
+
+    pthread_mutex_lock(&poolStatsLock);
+    NSLog(@"ChangeRequestPool: %ld allocations, %ld reused, %ld too large for the pool, %ld batches released",
+          poolNumAllocs,poolNumReused,poolNumLarge,poolNumBatches);
+    for (auto it : poolTypeCounts)
+    {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(it.first,NULL,NULL,&status);
+        NSLog(@"ChangeRequestPool:   %s: %ld requests",(demangled && status == 0) ? demangled : it.first,it.second);
+        free(demangled);
+    }
+    pthread_mutex_unlock(&poolStatsLock);
+}
+
+}
@@ -0,0 +1,353 @@
+/*
+ *  DBFColumnReader.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <stdio.h>
+#import <string.h>
+#import <stdint.h>
+#import <limits.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <algorithm>
+#import "DBFColumnReader.h"
+
+namespace WhirlyKit
+{
+    
+// Fields are at most 255 wide, since the width is a byte
+static const int MaxDBFFieldWidth = 256;
+
+DBFColumnReader::DBFColumnReader(NSString *fileName)
+    : data(NULL), dataLen(0), mapped(false), numRecords(0), headerLen(0), recordLen(0)
+{
+    // Swap the extension for .dbf, like shapelib does
+    NSString *baseName = fileName;
+    if ([[fileName pathExtension] length] > 0)
+        baseName = [fileName stringByDeletingPathExtension];
+    FILE *fp = fopen([[baseName stringByAppendingPathExtension:@"dbf"] cStringUsingEncoding:NSASCIIStringEncoding],"rb");
+    if (!fp)
+        fp = fopen([[baseName stringByAppendingPathExtension:@"DBF"] cStringUsingEncoding:NSASCIIStringEncoding],"rb");
+    if (!fp)
+        return;
+    
+    int fd = fileno(fp);
+    struct stat statBuf;
+    if (fd < 0 || fstat(fd, &statBuf) != 0 || statBuf.st_size < 32)
+    {
+        fclose(fp);
+        return;
+    }
+    size_t len = statBuf.st_size;
+    
+    // Map the whole thing in and let the VM system worry about it
+    void *mapData = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapData != MAP_FAILED)
+    {
+        data = (const unsigned char *)mapData;
+        mapped = true;
+    } else {
+        // Fall back to reading it
+        dataBuf.resize(len);
+        if (fread(&dataBuf[0], 1, len, fp) != len)
+        {
+            fclose(fp);
+            dataBuf.clear();
+            return;
+        }
+        data = &dataBuf[0];
+    }
+    dataLen = len;
+    fclose(fp);
+    
+    // Table header
+    uint32_t headerRecords = (uint32_t)data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+    headerLen = data[8] + data[9]*256;
+    recordLen = data[10] + data[11]*256;
+    if (headerLen < 32 || headerLen > dataLen || recordLen < 1)
+        return;
+    // Don't trust the record count past the end of the file
+    size_t fileRecords = std::min((size_t)headerRecords,(dataLen - headerLen) / recordLen);
+    numRecords = (int)std::min(fileRecords,(size_t)INT_MAX);
+    
+    // Field definitions, laid out end to end in each record after the deleted flag
+    int numFields = (headerLen - 32) / 32;
+    fields.resize(numFields);
+    int offset = 1;
+    for (int ii=0;ii<numFields;ii++)
+    {
+        const unsigned char *fieldInfo = data + 32 + ii*32;
+        Field &field = fields[ii];
+        
+        char name[12];
+        strncpy(name, (const char *)fieldInfo, 11);
+        name[11] = '\0';
+        for (int ci = 10; ci > 0 && name[ci] == ' '; ci--)
+            name[ci] = '\0';
+        field.name = name;
+        field.key = [NSString stringWithFormat:@"%s",name];
+        
+        field.dbfType = (char)fieldInfo[11];
+        field.width = fieldInfo[16];
+        field.offset = offset;
+        offset += field.width;
+        // Clip anything that hangs off the end of the record
+        if (field.offset + field.width > recordLen)
+            field.width = std::max(recordLen - field.offset,0);
+        
+        if (field.dbfType == 'L')
+            field.type = DBFColumnLogical;
+        else if (field.dbfType == 'N' || field.dbfType == 'F')
+            field.type = (fieldInfo[17] > 0 || field.width > 10) ? DBFColumnDouble : DBFColumnInteger;
+        else
+            field.type = DBFColumnString;
+        
+        // First one wins, same as a linear search would
+        if (fieldsByName.find(field.name) == fieldsByName.end())
+            fieldsByName[field.name] = ii;
+    }
+}
+    
+DBFColumnReader::~DBFColumnReader()
+{
+    if (mapped)
+        munmap((void *)data, dataLen);
+}
+    
+bool DBFColumnReader::isValid() const
+{
+    return data != NULL && headerLen >= 32 && headerLen <= dataLen && recordLen >= 1;
+}
+    
+int DBFColumnReader::getNumRecords() const
+{
+    return numRecords;
+}
+    
+int DBFColumnReader::getNumFields() const
+{
+    return (int)fields.size();
+}
+    
+int DBFColumnReader::getFieldIndex(const std::string &name) const
+{
+    auto it = fieldsByName.find(name);
+    if (it == fieldsByName.end())
+        return -1;
+    return it->second;
+}
+    
+const std::string &DBFColumnReader::getFieldName(int field) const
+{
+    return fields[field].name;
+}
+    
+NSString *DBFColumnReader::getFieldKey(int field) const
+{
+    return fields[field].key;
+}
+
+DBFColumnType DBFColumnReader::getFieldType(int field) const
+{
+    return fields[field].type;
+}
+    
+int DBFColumnReader::copyField(int record,int field,char *buf) const
+{
+    const Field &theField = fields[field];
+    const char *src = (const char *)data + headerLen + (size_t)record * recordLen + theField.offset;
+    int len = 0;
+    while (len < theField.width && src[len] != '\0')
+    {
+        buf[len] = src[len];
+        len++;
+    }
+    buf[len] = '\0';
+    
+    return len;
+}
+    
+const char *DBFColumnReader::trimField(int record,int field,char *buf,int &len) const
+{
+    len = copyField(record, field, buf);
+    const char *start = buf;
+    while (*start == ' ')
+    {
+        start++;
+        len--;
+    }
+    while (len > 0 && start[len-1] == ' ')
+        len--;
+    buf[(start-buf)+len] = '\0';
+    
+    return start;
+}
+    
+// Same rules as shapelib's DBFIsValueNULL(), applied to the trimmed value
+bool DBFColumnReader::isNullValue(const Field &theField,const char *str,int len) const
+{
+    switch (theField.dbfType)
+    {
+        case 'N':
+        case 'F':
+            // Trimming leaves nothing if it was all blanks
+            return len == 0 || str[0] == '*';
+        case 'D':
+            return strncmp(str,"00000000",8) == 0;
+        case 'L':
+            return str[0] == '?';
+        default:
+            return len == 0;
+    }
+}
+    
+bool DBFColumnReader::isNull(int record,int field) const
+{
+    if (record < 0 || record >= numRecords || field < 0 || field >= fields.size())
+        return true;
+    
+    char buf[MaxDBFFieldWidth];
+    int len;
+    const char *str = trimField(record, field, buf, len);
+    return isNullValue(fields[field], str, len);
+}
+    
+int DBFColumnReader::readInt(int record,int field) const
+{
+    return (int)readDouble(record, field);
+}
+
+double DBFColumnReader::readDouble(int record,int field) const
+{
+    if (record < 0 || record >= numRecords || field < 0 || field >= fields.size())
+        return 0.0;
+    
+    char buf[MaxDBFFieldWidth];
+    copyField(record, field, buf);
+    return atof(buf);
+}
+    
+std::string DBFColumnReader::readString(int record,int field) const
+{
+    if (record < 0 || record >= numRecords || field < 0 || field >= fields.size())
+        return std::string();
+    
+    char buf[MaxDBFFieldWidth];
+    int len;
+    const char *str = trimField(record, field, buf, len);
+    return std::string(str,len);
+}
+    
+void DBFColumnReader::readIntColumn(int field,std::vector<int> &vals,std::vector<bool> *nulls) const
+{
+    std::vector<double> dVals;
+    readDoubleColumn(field, dVals, nulls);
+    vals.resize(dVals.size());
+    for (unsigned int ii=0;ii<dVals.size();ii++)
+        vals[ii] = (int)dVals[ii];
+}
+
+void DBFColumnReader::readDoubleColumn(int field,std::vector<double> &vals,std::vector<bool> *nulls) const
+{
+    vals.clear();
+    if (nulls)
+        nulls->clear();
+    if (field < 0 || field >= fields.size())
+        return;
+    
+    const Field &theField = fields[field];
+    vals.resize(numRecords,0.0);
+    if (nulls)
+        nulls->resize(numRecords,false);
+    char buf[MaxDBFFieldWidth];
+    for (int ii=0;ii<numRecords;ii++)
+    {
+        int len;
+        const char *str = trimField(ii, field, buf, len);
+        if (isNullValue(theField, str, len))
+        {
+            if (nulls)
+                (*nulls)[ii] = true;
+        } else
+            vals[ii] = atof(str);
+    }
+}
+
+void DBFColumnReader::readStringColumn(int field,std::vector<std::string> &vals,std::vector<bool> *nulls) const
+{
+    vals.clear();
+    if (nulls)
+        nulls->clear();
+    if (field < 0 || field >= fields.size())
+        return;
+    
+    const Field &theField = fields[field];
+    vals.resize(numRecords);
+    if (nulls)
+        nulls->resize(numRecords,false);
+    char buf[MaxDBFFieldWidth];
+    for (int ii=0;ii<numRecords;ii++)
+    {
+        int len;
+        const char *str = trimField(ii, field, buf, len);
+        if (isNullValue(theField, str, len))
+        {
+            if (nulls)
+                (*nulls)[ii] = true;
+        } else
+            vals[ii].assign(str,len);
+    }
+}
+    
+void DBFColumnReader::readAttributes(int record,const std::vector<int> &whichFields,NSMutableDictionary *attrDict) const
+{
+    if (record < 0 || record >= numRecords)
+        return;
+    
+    char buf[MaxDBFFieldWidth];
+    for (int field : whichFields)
+    {
+        if (field < 0 || field >= fields.size())
+            continue;
+        const Field &theField = fields[field];
+        int len;
+        const char *str = trimField(record, field, buf, len);
+        if (isNullValue(theField, str, len))
+            continue;
+        
+        switch (theField.type)
+        {
+            case DBFColumnString:
+            {
+                NSString *newStr = [[NSString alloc] initWithBytes:str length:len encoding:NSASCIIStringEncoding];
+                if (newStr)
+                    [attrDict setObject:newStr forKey:theField.key];
+            }
+                break;
+            case DBFColumnInteger:
+                [attrDict setObject:[NSNumber numberWithInt:(int)atof(str)] forKey:theField.key];
+                break;
+            case DBFColumnDouble:
+                [attrDict setObject:[NSNumber numberWithDouble:atof(str)] forKey:theField.key];
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+}
@@ -62,11 +62,22 @@ static const char *vertexShaderTri =
 "attribute vec4 a_color;"
 "attribute vec3 a_normal;"
 ""
+"uniform bool u_octNormals;"
+""
+"vec3 octDecode(vec2 enc)"
+"{"
+"   vec3 norm = vec3(enc.xy, 1.0 - abs(enc.x) - abs(enc.y));"
+"   if (norm.z < 0.0)"
+"     norm.xy = (1.0 - abs(norm.yx)) * vec2(norm.x < 0.0 ? -1.0 : 1.0, norm.y < 0.0 ? -1.0 : 1.0);"
+"   return normalize(norm);"
+"}"
+""
 "varying vec2 v_texCoord;"
 "varying vec4 v_color;"
 ""
 "void main()"
 "{"
+"   vec3 norm = u_octNormals ? octDecode(a_normal.xy) : a_normal;"
 "   if (u_texScale0.x != 0.0)"
 "     v_texCoord = vec2(a_texCoord0.x*u_texScale0.x,a_texCoord0.y*u_texScale0.y) + u_texOffset0;"
 "   else"
@@ -80,7 +91,7 @@ static const char *vertexShaderTri =
 "     {"
 "        if (ii>=u_numLights)"
 "           break;"
-"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;"
+"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(norm, 0.0)).xyz) : norm.xzy;"
 "        float ndotl;"
 //"        float ndoth;\n"
 "        ndotl = max(0.0, dot(adjNorm, light[ii].direction));"
@@ -171,11 +182,22 @@ static const char *vertexShaderModelTri =
 "attribute vec3 a_modelCenter;"
 "attribute vec3 a_modelDir;"
 ""
+"uniform bool u_octNormals;"
+""
+"vec3 octDecode(vec2 enc)"
+"{"
+"   vec3 norm = vec3(enc.xy, 1.0 - abs(enc.x) - abs(enc.y));"
+"   if (norm.z < 0.0)"
+"     norm.xy = (1.0 - abs(norm.yx)) * vec2(norm.x < 0.0 ? -1.0 : 1.0, norm.y < 0.0 ? -1.0 : 1.0);"
+"   return normalize(norm);"
+"}"
+""
 "varying vec2 v_texCoord;"
 "varying vec4 v_color;"
 ""
 "void main()"
 "{"
+"   vec3 norm = u_octNormals ? octDecode(a_normal.xy) : a_normal;"
 "   v_texCoord = a_texCoord0;"
 "   v_color = vec4(0.0,0.0,0.0,0.0);"
 "   vec4 inColor = a_useInstanceColor > 0.0 ? a_instanceColor : a_color;"
@@ -187,7 +209,7 @@ static const char *vertexShaderModelTri =
 "     {"
 "        if (ii>=u_numLights)"
 "           break;"
-"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;"
+"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(norm, 0.0)).xyz) : norm.xzy;"
 "        float ndotl;"
 //"        float ndoth;\n"
 "        ndotl = max(0.0, dot(adjNorm, light[ii].direction));"
@@ -244,12 +266,23 @@ static const char *vertexShaderTriMultiTex =
 "attribute vec4 a_color;                     \n"
 "attribute vec3 a_normal;                    \n"
 "\n"
+"uniform bool u_octNormals;\n"
+"\n"
+"vec3 octDecode(vec2 enc)\n"
+"{\n"
+"   vec3 norm = vec3(enc.xy, 1.0 - abs(enc.x) - abs(enc.y));\n"
+"   if (norm.z < 0.0)\n"
+"     norm.xy = (1.0 - abs(norm.yx)) * vec2(norm.x < 0.0 ? -1.0 : 1.0, norm.y < 0.0 ? -1.0 : 1.0);\n"
+"   return normalize(norm);\n"
+"}\n"
+"\n"
 "varying vec2 v_texCoord0;                    \n"
 "varying vec2 v_texCoord1;                    \n"
 "varying vec4 v_color;                       \n"
 "\n"
 "void main()                                 \n"
 "{                                           \n"
+"   vec3 norm = u_octNormals ? octDecode(a_normal.xy) : a_normal;\n"
 "   if (u_texScale0.x != 0.0)"
 "     v_texCoord0 = vec2(a_texCoord0.x*u_texScale0.x,a_texCoord0.y*u_texScale0.y) + u_texOffset0;"
 "   else"
@@ -269,7 +302,7 @@ static const char *vertexShaderTriMultiTex =
 "     {\n"
 "        if (ii>=u_numLights)                  \n"
 "           break;                             \n"
-"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;\n"
+"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(norm, 0.0)).xyz) : norm.xzy;\n"
 "        float ndotl;\n"
 //"        float ndoth;\n"
 "        ndotl = max(0.0, dot(adjNorm, light[ii].direction));\n"
@@ -361,11 +394,22 @@ static const char *vertexShaderScreenTexTri =
 "attribute vec3 a_normal;"
 "attribute mat4 a_singleMatrix;"
 ""
+"uniform bool u_octNormals;"
+""
+"vec3 octDecode(vec2 enc)"
+"{"
+"   vec3 norm = vec3(enc.xy, 1.0 - abs(enc.x) - abs(enc.y));"
+"   if (norm.z < 0.0)"
+"     norm.xy = (1.0 - abs(norm.yx)) * vec2(norm.x < 0.0 ? -1.0 : 1.0, norm.y < 0.0 ? -1.0 : 1.0);"
+"   return normalize(norm);"
+"}"
+""
 "varying vec2 v_texCoord;"
 "varying vec4 v_color;"
 ""
 "void main()"
 "{"
+"   vec3 norm = u_octNormals ? octDecode(a_normal.xy) : a_normal;"
 "   v_texCoord = a_texCoord0;"
 "   v_color = vec4(0.0,0.0,0.0,0.0);"
 "   if (u_numLights > 0)"
@@ -376,7 +420,7 @@ static const char *vertexShaderScreenTexTri =
 "     {"
 "        if (ii>=u_numLights)"
 "           break;"
-"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;"
+"        vec3 adjNorm = light[ii].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(norm, 0.0)).xyz) : norm.xzy;"
 "        float ndotl;"
 //"        float ndoth;\n"
 "        ndotl = max(0.0, dot(adjNorm, light[ii].direction));"
@@ -431,6 +475,16 @@ static const char *vertexShaderTriNightDay =
 "attribute vec4 a_color;                     \n"
 "attribute vec3 a_normal;                    \n"
 "\n"
+"uniform bool u_octNormals;\n"
+"\n"
+"vec3 octDecode(vec2 enc)\n"
+"{\n"
+"   vec3 norm = vec3(enc.xy, 1.0 - abs(enc.x) - abs(enc.y));\n"
+"   if (norm.z < 0.0)\n"
+"     norm.xy = (1.0 - abs(norm.yx)) * vec2(norm.x < 0.0 ? -1.0 : 1.0, norm.y < 0.0 ? -1.0 : 1.0);\n"
+"   return normalize(norm);\n"
+"}\n"
+"\n"
 "varying mediump vec2 v_texCoord0;                    \n"
 "varying mediump vec2 v_texCoord1;                    \n"
 "varying mediump vec4 v_color;\n"
@@ -439,10 +493,11 @@ static const char *vertexShaderTriNightDay =
 "\n"
 "void main()                                 \n"
 "{                                           \n"
+"   vec3 norm = u_octNormals ? octDecode(a_normal.xy) : a_normal;\n"
 "   v_texCoord0 = a_texCoord0;                 \n"
 "   v_texCoord1 = a_texCoord1;                 \n"
 "   v_color = a_color;\n"
-"   v_adjNorm = light[0].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(a_normal.xyz, 0.0)).xyz) : a_normal.xzy;\n"
+"   v_adjNorm = light[0].viewdepend > 0.0 ? normalize((u_mvpMatrix * vec4(norm, 0.0)).xyz) : norm.xzy;\n"
 "   v_lightDir = (u_numLights > 0) ? light[0].direction : vec3(1,0,0);\n"
 "   v_color = vec4(light[0].ambient.xyz * material.ambient.xyz * a_color.xyz + light[0].diffuse.xyz * a_color.xyz,a_color.a) * u_fade;\n"
 "\n"
@@ -742,6 +797,24 @@ void SetupDefaultShaders(Scene *scene)
         scene->addProgram(kToolkitDefaultScreenSpaceMotionProgram, screenSpaceMotionShader);
     }
     
+    // Screen space shader for distance field glyphs
+    OpenGLES2Program *screenSpaceSDFShader = BuildScreenSpaceSDFProgram();
+    if (!screenSpaceSDFShader)
+    {
+        NSLog(@"SetupDefaultShaders: Screen Space SDF shader didn't compile.");
+    } else {
+        scene->addProgram(kToolkitDefaultScreenSpaceSDFProgram, screenSpaceSDFShader);
+    }
+    
+    // Screen space shader for distance field glyphs w/ Motion
+    OpenGLES2Program *screenSpaceSDFMotionShader = BuildScreenSpaceSDFMotionProgram();
+    if (!screenSpaceSDFMotionShader)
+    {
+        NSLog(@"SetupDefaultShaders: Screen Space SDF Motion shader didn't compile.");
+    } else {
+        scene->addProgram(kToolkitDefaultScreenSpaceSDFMotionProgram, screenSpaceSDFMotionShader);
+    }
+    
     // Particle System program
     OpenGLES2Program *particleSystemShader = BuildParticleSystemProgram();
     if (!particleSystemShader)
@@ -0,0 +1,121 @@
+/*
+ *  DistanceField.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <math.h>
+#import <vector>
+#import <algorithm>
+#import "DistanceField.h"
+
+namespace WhirlyKit
+{
+
+// Stands in for infinity, but still behaves in the parabola intersections
+static const double EDTInf = 1e20;
+
+// 1D squared distance transform of f into d.  v and z are scratch space of size n and n+1.
+static void DistanceTransform1D(const double *f,int n,double *d,int *v,double *z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -EDTInf;
+    z[1] = EDTInf;
+    for (int q=1;q<n;q++)
+    {
+        double s = ((f[q]+(double)q*q) - (f[v[k]]+(double)v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+        while (s <= z[k])
+        {
+            k--;
+            s = ((f[q]+(double)q*q) - (f[v[k]]+(double)v[k]*v[k])) / (2.0*q - 2.0*v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = EDTInf;
+    }
+    
+    k = 0;
+    for (int q=0;q<n;q++)
+    {
+        while (z[k+1] < q)
+            k++;
+        double dq = q - v[k];
+        d[q] = dq*dq + f[v[k]];
+    }
+}
+
+// 2D squared distance transform in place, columns and then rows
+static void DistanceTransform2D(std::vector<double> &grid,int width,int height)
+{
+    int maxDim = std::max(width,height);
+    std::vector<double> f(maxDim),d(maxDim),z(maxDim+1);
+    std::vector<int> v(maxDim);
+
+    for (int x=0;x<width;x++)
+    {
+        for (int y=0;y<height;y++)
+            f[y] = grid[y*width+x];
+        DistanceTransform1D(&f[0], height, &d[0], &v[0], &z[0]);
+        for (int y=0;y<height;y++)
+            grid[y*width+x] = d[y];
+    }
+    
+    for (int y=0;y<height;y++)
+    {
+        double *row = &grid[y*width];
+        std::copy(row, row+width, f.begin());
+        DistanceTransform1D(&f[0], width, row, &v[0], &z[0]);
+    }
+}
+
+NSData *SignedDistanceFieldFromRGBA(NSData *rgba,int width,int height,float spread)
+{
+    if (width <= 0 || height <= 0 || [rgba length] < (size_t)width*height*4)
+        return nil;
+    
+    const uint8_t *src = (const uint8_t *)[rgba bytes];
+    size_t numPix = (size_t)width*height;
+    
+    // Distance to the nearest inside pixel and to the nearest outside pixel
+    std::vector<double> toInside(numPix),toOutside(numPix);
+    for (size_t ii=0;ii<numPix;ii++)
+    {
+        bool inside = src[ii*4+3] >= 128;
+        toInside[ii] = inside ? 0.0 : EDTInf;
+        toOutside[ii] = inside ? EDTInf : 0.0;
+    }
+    DistanceTransform2D(toInside, width, height);
+    DistanceTransform2D(toOutside, width, height);
+    
+    NSMutableData *retData = [NSMutableData dataWithLength:numPix*4];
+    uint8_t *dest = (uint8_t *)[retData mutableBytes];
+    double scale = 1.0 / (2.0*spread);
+    for (size_t ii=0;ii<numPix;ii++)
+    {
+        // Positive outside, negative inside, zero right between the two
+        double dist = sqrt(toInside[ii]) - sqrt(toOutside[ii]);
+        double val = 0.5 - dist * scale;
+        val = std::min(1.0,std::max(0.0,val));
+        dest[ii*4] = dest[ii*4+1] = dest[ii*4+2] = 255;
+        dest[ii*4+3] = (uint8_t)lround(val * 255.0);
+    }
+    
+    return retData;
+}
+
+}
@@ -24,6 +24,7 @@
 #import "UIImage+Stuff.h"
 #import "SceneRendererES.h"
 #import "TextureAtlas.h"
+#import "WhirlyOctEncoding.h"
 
 using namespace Eigen;
 
@@ -228,6 +229,24 @@ void Drawable::runTweakers(WhirlyKitRendererFrameInfo *frame)
         (*it)->tweakForFrame(this,frame);
 }
 	
+void ChangeRequest::deleteBatch(std::vector<ChangeRequest *> &changes)
+{
+    std::vector<void *> blocks;
+    blocks.reserve(changes.size());
+    for (ChangeRequest *req : changes)
+    {
+        if (!req)
+            continue;
+        // The pool wants the start of the whole object
+        void *block = dynamic_cast<void *>(req);
+        req->~ChangeRequest();
+        blocks.push_back(block);
+    }
+    changes.clear();
+
+    ChangeRequestPool::releaseBatch(blocks);
+}
+	
 void DrawableChangeRequest::execute(Scene *scene,WhirlyKitSceneRendererES *renderer,WhirlyKitView *view)
 {
 	DrawableRef theDrawable = scene->getDrawable(drawId);
@@ -236,7 +255,7 @@ void DrawableChangeRequest::execute(Scene *scene,WhirlyKitSceneRendererES *rende
 }
     
 VertexAttribute::VertexAttribute(BDAttributeDataType dataType,StringIdentity nameID)
-    : dataType(dataType), nameID(nameID), data(NULL), buffer(0)
+    : dataType(dataType), packing(BDPackNone), nameID(nameID), data(NULL), buffer(0)
 {
     defaultData.vec3[0] = 0.0;
     defaultData.vec3[1] = 0.0;
@@ -250,7 +269,7 @@ VertexAttribute::~VertexAttribute()
 }
     
 VertexAttribute::VertexAttribute(const VertexAttribute &that)
-    : dataType(that.dataType), nameID(that.nameID), data(NULL), buffer(that.buffer), defaultData(that.defaultData)
+    : dataType(that.dataType), packing(that.packing), nameID(that.nameID), data(NULL), buffer(that.buffer), defaultData(that.defaultData)
 {
 }
     
@@ -264,6 +283,63 @@ BDAttributeDataType VertexAttribute::getDataType() const
 {
     return dataType;
 }
+
+// Number of floats in a single element, if it's a float type
+static int FloatComponents(BDAttributeDataType dataType)
+{
+    switch (dataType)
+    {
+        case BDFloat4Type:
+            return 4;
+        case BDFloat3Type:
+            return 3;
+        case BDFloat2Type:
+            return 2;
+        case BDFloatType:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+bool VertexAttribute::setPacking(BDAttributePacking newPacking)
+{
+    if (newPacking != BDPackNone && FloatComponents(dataType) == 0)
+        return false;
+    if (newPacking == BDPackOctNormal && dataType != BDFloat3Type)
+        return false;
+
+    packing = newPacking;
+    return true;
+}
+
+BDAttributePacking VertexAttribute::getPacking() const
+{
+    return packing;
+}
+
+BDAttributePacking VertexAttribute::compactPacking() const
+{
+    int numComps = FloatComponents(dataType);
+    int numEls = numElements();
+    if (numComps == 0 || numEls == 0)
+        return BDPackNone;
+
+    const float *vals = (const float *)((VertexAttribute *)this)->addressForElement(0);
+    float minVal = vals[0], maxVal = vals[0];
+    for (int ii=1;ii<numEls*numComps;ii++)
+    {
+        minVal = std::min(minVal,vals[ii]);
+        maxVal = std::max(maxVal,vals[ii]);
+    }
+
+    if (minVal >= 0.0 && maxVal <= 1.0)
+        return BDPackUNorm16;
+    if (minVal >= -1.0 && maxVal <= 1.0)
+        return BDPackSNorm16;
+
+    return BDPackNone;
+}
     
 void VertexAttribute::setDefaultColor(const RGBAColor &color)
 {
@@ -467,6 +543,21 @@ int VertexAttribute::numElements() const
 /// Return the size of a single element
 int VertexAttribute::size() const
 {
+    // Packed values are 16 bits each, rounded up to keep vertices 4 byte aligned
+    switch (packing)
+    {
+        case BDPackNone:
+            break;
+        case BDPackOctNormal:
+            return 2*sizeof(GLshort);
+            break;
+        case BDPackHalfFloat:
+        case BDPackSNorm16:
+        case BDPackUNorm16:
+            return (FloatComponents(dataType)*sizeof(GLshort) + 3) & ~3;
+            break;
+    }
+
     switch (dataType)
     {
         case BDFloat4Type:
@@ -677,9 +768,143 @@ void *VertexAttribute::addressForElement(int which)
     return NULL;
 }
 
+// Copy fixed size elements from a packed array to a strided one.
+// The constant size lets the compiler turn the memcpy into a couple of moves.
+template<int ElementSize>
+static void CopyStridedElements(unsigned char *dest,int stride,const unsigned char *src,int count)
+{
+    for (int ii=0;ii<count;ii++,dest+=stride,src+=ElementSize)
+        memcpy(dest, src, ElementSize);
+}
+
+// Convert a float to IEEE half precision, rounding to nearest
+static GLushort FloatToHalf(float val)
+{
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exp = (int)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = bits & 0x7fffff;
+
+    // NaN and Inf
+    if (((bits >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    // Too big, so clamp to Inf
+    if (exp >= 31)
+        return sign | 0x7c00;
+    // Too small for a normal half, so denormalize or flush to zero
+    if (exp <= 0)
+    {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        if ((mant >> (shift-1)) & 1)
+            half++;
+        return sign | half;
+    }
+
+    uint32_t half = sign | (exp << 10) | (mant >> 13);
+    // Round, which may carry into the exponent.  That's fine.
+    if (mant & 0x1000)
+        half++;
+    return half;
+}
+
+// Convert to a normalized short in [-1,1]
+static GLshort FloatToSNorm16(float val)
+{
+    val = std::max(-1.0f,std::min(1.0f,val));
+    return (GLshort)lrintf(val * 32767.0f);
+}
+
+// Convert to a normalized unsigned short in [0,1]
+static GLushort FloatToUNorm16(float val)
+{
+    val = std::max(0.0f,std::min(1.0f,val));
+    return (GLushort)lrintf(val * 65535.0f);
+}
+
+void VertexAttribute::copyToBuffer(unsigned char *basePtr,int stride,int start,int count)
+{
+    if (count <= 0 || numElements() == 0)
+        return;
+
+    const unsigned char *src = (const unsigned char *)addressForElement(start);
+    unsigned char *dest = basePtr + buffer;
+    int elSize = size();
+
+    // Packed data gets converted on the way in
+    if (packing != BDPackNone)
+    {
+        int numComps = FloatComponents(dataType);
+        const float *vals = (const float *)src;
+        for (int ii=0;ii<count;ii++,dest+=stride,vals+=numComps)
+        {
+            GLushort *out = (GLushort *)dest;
+            switch (packing)
+            {
+                case BDPackHalfFloat:
+                    for (int jj=0;jj<numComps;jj++)
+                        out[jj] = FloatToHalf(vals[jj]);
+                    break;
+                case BDPackSNorm16:
+                    for (int jj=0;jj<numComps;jj++)
+                        ((GLshort *)out)[jj] = FloatToSNorm16(vals[jj]);
+                    break;
+                case BDPackUNorm16:
+                    for (int jj=0;jj<numComps;jj++)
+                        out[jj] = FloatToUNorm16(vals[jj]);
+                    break;
+                case BDPackOctNormal:
+                {
+                    Point2f enc = OctEncode(Point3f(vals[0],vals[1],vals[2]));
+                    ((GLshort *)out)[0] = FloatToSNorm16(enc.x());
+                    ((GLshort *)out)[1] = FloatToSNorm16(enc.y());
+                }
+                    break;
+                case BDPackNone:
+                    break;
+            }
+        }
+        return;
+    }
+
+    // Only thing in the vertex, so it's one big copy
+    if (elSize == stride)
+    {
+        memcpy(dest, src, elSize*count);
+        return;
+    }
+
+    switch (elSize)
+    {
+        case 4:
+            CopyStridedElements<4>(dest,stride,src,count);
+            break;
+        case 8:
+            CopyStridedElements<8>(dest,stride,src,count);
+            break;
+        case 12:
+            CopyStridedElements<12>(dest,stride,src,count);
+            break;
+        case 16:
+            CopyStridedElements<16>(dest,stride,src,count);
+            break;
+        default:
+            for (int ii=0;ii<count;ii++,dest+=stride,src+=elSize)
+                memcpy(dest, src, elSize);
+            break;
+    }
+}
+
 /// Return the number of components as needed by glVertexAttribPointer
 GLuint VertexAttribute::glEntryComponents() const
 {
+    if (packing == BDPackOctNormal)
+        return 2;
+    
     switch (dataType)
     {
         case BDFloat4Type:
@@ -741,6 +966,26 @@ GLuint SingleVertexAttributeInfo::glEntryComponents() const
 /// Return the data type as required by glVertexAttribPointer
 GLenum VertexAttribute::glType() const
 {
+    switch (packing)
+    {
+        case BDPackNone:
+            break;
+        case BDPackHalfFloat:
+            // Same format, but ES3 contexts want the core enum
+            if ([EAGLContext currentContext].API < kEAGLRenderingAPIOpenGLES3)
+                return GL_HALF_FLOAT_OES;
+            else
+                return GL_HALF_FLOAT;
+            break;
+        case BDPackSNorm16:
+        case BDPackOctNormal:
+            return GL_SHORT;
+            break;
+        case BDPackUNorm16:
+            return GL_UNSIGNED_SHORT;
+            break;
+    }
+    
     switch (dataType)
     {
         case BDFloat4Type:
@@ -789,6 +1034,9 @@ GLenum SingleVertexAttributeInfo::glType() const
 /// Whether or not glVertexAttribPointer will normalize the data
 GLboolean VertexAttribute::glNormalize() const
 {
+    if (packing == BDPackSNorm16 || packing == BDPackUNorm16 || packing == BDPackOctNormal)
+        return GL_TRUE;
+    
     switch (dataType)
     {
         case BDFloat4Type:
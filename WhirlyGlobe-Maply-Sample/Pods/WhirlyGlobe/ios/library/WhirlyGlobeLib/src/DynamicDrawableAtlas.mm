@@ -76,7 +76,8 @@ bool DynamicDrawableAtlas::addDrawable(BasicDrawable *draw,ChangeSet &changes,bo
     }
     for (unsigned int ii=0;ii<drawVertexAttributes.size();ii++)
         // Note: Comparison could be more comprehensive
-        if (vertexAttributes[ii].getDataType() != drawVertexAttributes[ii]->getDataType())
+        if (vertexAttributes[ii].getDataType() != drawVertexAttributes[ii]->getDataType() ||
+            vertexAttributes[ii].getPacking() != drawVertexAttributes[ii]->getPacking())
         {
             NSLog(@"DynamicDrawableAtlas::addDrawable(): Drawable mismatch.  Punting drawable.");
             return false;
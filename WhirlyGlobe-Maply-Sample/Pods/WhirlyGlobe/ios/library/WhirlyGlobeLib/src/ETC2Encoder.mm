@@ -0,0 +1,780 @@
+/*
+ *  ETC2Encoder.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string.h>
+#import <math.h>
+#import <limits.h>
+#import <limits>
+#import <algorithm>
+#import <vector>
+#import "ETC2Encoder.h"
+
+namespace WhirlyKit
+{
+
+// Intensity modifiers for individual and differential blocks
+static const int ETC2ModifierTable[8][2] = {{2,8},{5,17},{9,29},{13,42},{18,60},{24,80},{33,106},{47,183}};
+
+// Alpha modifiers for EAC
+static const int EACModifierTable[16][8] = {
+    {-3,-6,-9,-15,2,5,8,14},
+    {-3,-7,-10,-13,2,6,9,12},
+    {-2,-5,-8,-13,1,4,7,12},
+    {-2,-4,-6,-13,1,3,5,12},
+    {-3,-6,-8,-12,2,5,7,11},
+    {-3,-7,-9,-11,2,6,8,10},
+    {-4,-7,-8,-11,3,6,7,10},
+    {-3,-5,-8,-11,2,4,7,10},
+    {-2,-6,-8,-10,1,5,7,9},
+    {-2,-5,-8,-10,1,4,7,9},
+    {-2,-4,-8,-10,1,3,7,9},
+    {-2,-5,-7,-10,1,4,6,9},
+    {-3,-4,-7,-10,2,3,6,9},
+    {-1,-2,-3,-10,0,1,2,9},
+    {-4,-6,-8,-9,3,5,7,8},
+    {-3,-5,-7,-9,2,4,6,8}
+};
+
+// PKM header types
+static const int PKMTypeETC2RGB = 1;
+static const int PKMTypeETC2RGBA = 3;
+
+static inline int ETC2Clamp(int val,int minVal,int maxVal)
+{
+    return val < minVal ? minVal : (val > maxVal ? maxVal : val);
+}
+
+static inline int ETC2Quantize(float val,int bits)
+{
+    int maxVal = (1<<bits)-1;
+    return ETC2Clamp((int)(val * maxVal / 255.f + 0.5f),0,maxVal);
+}
+
+static inline int ETC2Expand(int val,int bits)
+{
+    switch (bits)
+    {
+        case 4:
+            return (val << 4) | val;
+        case 5:
+            return (val << 3) | (val >> 2);
+        case 6:
+            return (val << 2) | (val >> 4);
+        case 7:
+        default:
+            return (val << 1) | (val >> 6);
+    }
+}
+
+// Pixels in a block are numbered down the columns, which is how the index bits are laid out
+typedef uint8_t ETC2Block[16][4];
+
+static void ETC2LoadBlock(const uint8_t *pixels,int width,int height,int bx,int by,ETC2Block block)
+{
+    for (int x=0;x<4;x++)
+    {
+        int px = std::min(bx*4+x,width-1);
+        for (int y=0;y<4;y++)
+        {
+            int py = std::min(by*4+y,height-1);
+            memcpy(block[x*4+y],&pixels[4*(py*width+px)],4);
+        }
+    }
+}
+
+static void ETC2StoreBlock(uint8_t *pixels,int width,int height,int bx,int by,const ETC2Block block)
+{
+    for (int x=0;x<4;x++)
+        for (int y=0;y<4;y++)
+        {
+            int px = bx*4+x, py = by*4+y;
+            if (px < width && py < height)
+                memcpy(&pixels[4*(py*width+px)],block[x*4+y],4);
+        }
+}
+
+static inline void ETC2WriteBits(uint8_t *out,uint64_t bits)
+{
+    for (int ii=0;ii<8;ii++)
+        out[ii] = (uint8_t)(bits >> (56-8*ii));
+}
+
+static inline uint64_t ETC2ReadBits(const uint8_t *in)
+{
+    uint64_t bits = 0;
+    for (int ii=0;ii<8;ii++)
+        bits = (bits << 8) | in[ii];
+    return bits;
+}
+
+// The 8 pixels in one half of the block
+static void ETC2SubBlockPixels(bool flip,int sub,int pixList[8])
+{
+    int which = 0;
+    for (int k=0;k<16;k++)
+        if ((flip ? ((k & 3) >= 2) : (k >= 8)) == (sub == 1))
+            pixList[which++] = k;
+}
+
+// Fit of one half block to a given base color
+typedef struct
+{
+    int quant[3];
+    int err;
+    int table;
+    int indices[16];
+} ETC2SubBlockFit;
+
+// Pick the best table and indices for half a block with the given base color
+static void ETC2FitSubBlock(const ETC2Block block,const int pixList[8],const int base[3],ETC2SubBlockFit &fit)
+{
+    // Without clamping, the error for modifier m is |p-base|^2 - 2m*sum(p-base) + 3m^2
+    int distSq[8],distSum[8];
+    for (int ii=0;ii<8;ii++)
+    {
+        const uint8_t *pix = block[pixList[ii]];
+        int dr = pix[0]-base[0], dg = pix[1]-base[1], db = pix[2]-base[2];
+        distSq[ii] = dr*dr + dg*dg + db*db;
+        distSum[ii] = dr + dg + db;
+    }
+    int minBase = std::min(base[0],std::min(base[1],base[2]));
+    int maxBase = std::max(base[0],std::max(base[1],base[2]));
+
+    fit.err = INT_MAX;
+    for (int table=0;table<8;table++)
+    {
+        const int mods[4] = {ETC2ModifierTable[table][0],ETC2ModifierTable[table][1],-ETC2ModifierTable[table][0],-ETC2ModifierTable[table][1]};
+        bool clamps = minBase - ETC2ModifierTable[table][1] < 0 || maxBase + ETC2ModifierTable[table][1] > 255;
+        int colors[4][3];
+        if (clamps)
+            for (int mm=0;mm<4;mm++)
+                for (int c=0;c<3;c++)
+                    colors[mm][c] = ETC2Clamp(base[c]+mods[mm],0,255);
+
+        int err = 0;
+        int indices[8];
+        for (int ii=0;ii<8 && err < fit.err;ii++)
+        {
+            int bestErr = INT_MAX, bestIdx = 0;
+            if (clamps)
+            {
+                const uint8_t *pix = block[pixList[ii]];
+                for (int mm=0;mm<4;mm++)
+                {
+                    int dr = colors[mm][0]-pix[0], dg = colors[mm][1]-pix[1], db = colors[mm][2]-pix[2];
+                    int thisErr = dr*dr + dg*dg + db*db;
+                    if (thisErr < bestErr)
+                    {
+                        bestErr = thisErr;
+                        bestIdx = mm;
+                    }
+                }
+            } else {
+                for (int mm=0;mm<4;mm++)
+                {
+                    int thisErr = distSq[ii] - 2*mods[mm]*distSum[ii] + 3*mods[mm]*mods[mm];
+                    if (thisErr < bestErr)
+                    {
+                        bestErr = thisErr;
+                        bestIdx = mm;
+                    }
+                }
+            }
+            err += bestErr;
+            indices[ii] = bestIdx;
+        }
+
+        if (err < fit.err)
+        {
+            fit.err = err;
+            fit.table = table;
+            for (int ii=0;ii<8;ii++)
+                fit.indices[pixList[ii]] = indices[ii];
+        }
+    }
+}
+
+// Candidate base colors near the quantized average.  Fast only looks at the average itself.
+static int ETC2CandidateOffsets(WKETC2Quality quality,int offsets[27][3])
+{
+    int num = 0;
+    offsets[num][0] = 0;  offsets[num][1] = 0;  offsets[num][2] = 0;  num++;
+    if (quality == WKETC2Fast)
+        return num;
+
+    for (int dr=-1;dr<=1;dr++)
+        for (int dg=-1;dg<=1;dg++)
+            for (int db=-1;db<=1;db++)
+            {
+                int numNonZero = (dr != 0) + (dg != 0) + (db != 0);
+                if (numNonZero == 0 || (quality == WKETC2Normal && numNonZero > 1))
+                    continue;
+                offsets[num][0] = dr;  offsets[num][1] = dg;  offsets[num][2] = db;  num++;
+            }
+
+    return num;
+}
+
+// Fit each candidate base color for half a block
+static int ETC2FitCandidates(const ETC2Block block,const int pixList[8],const float avg[3],int bits,int numOffsets,const int offsets[27][3],ETC2SubBlockFit fits[27])
+{
+    int maxVal = (1<<bits)-1;
+    int center[3];
+    for (int c=0;c<3;c++)
+        center[c] = ETC2Quantize(avg[c],bits);
+
+    int numFits = 0;
+    for (int oo=0;oo<numOffsets;oo++)
+    {
+        ETC2SubBlockFit &fit = fits[numFits];
+        bool valid = true;
+        int base[3];
+        for (int c=0;c<3;c++)
+        {
+            fit.quant[c] = center[c] + offsets[oo][c];
+            if (fit.quant[c] < 0 || fit.quant[c] > maxVal)
+                valid = false;
+            base[c] = ETC2Expand(fit.quant[c],bits);
+        }
+        if (!valid)
+            continue;
+        ETC2FitSubBlock(block,pixList,base,fit);
+        numFits++;
+    }
+
+    return numFits;
+}
+
+static uint64_t ETC2PackIndividualOrDiff(bool diff,bool flip,const ETC2SubBlockFit &fit0,const ETC2SubBlockFit &fit1,const int pixList0[8],const int pixList1[8])
+{
+    uint64_t bits = 0;
+    if (diff)
+    {
+        for (int c=0;c<3;c++)
+        {
+            int delta = fit1.quant[c] - fit0.quant[c];
+            bits |= (uint64_t)fit0.quant[c] << (59-8*c);
+            bits |= (uint64_t)(delta & 0x7) << (56-8*c);
+        }
+    } else {
+        for (int c=0;c<3;c++)
+        {
+            bits |= (uint64_t)fit0.quant[c] << (60-8*c);
+            bits |= (uint64_t)fit1.quant[c] << (56-8*c);
+        }
+    }
+    bits |= (uint64_t)fit0.table << 37;
+    bits |= (uint64_t)fit1.table << 34;
+    bits |= (uint64_t)(diff ? 1 : 0) << 33;
+    bits |= (uint64_t)(flip ? 1 : 0) << 32;
+
+    for (int ii=0;ii<8;ii++)
+    {
+        int k0 = pixList0[ii], k1 = pixList1[ii];
+        int idx0 = fit0.indices[k0], idx1 = fit1.indices[k1];
+        bits |= (uint64_t)(idx0 >> 1) << (16+k0) | (uint64_t)(idx0 & 1) << k0;
+        bits |= (uint64_t)(idx1 >> 1) << (16+k1) | (uint64_t)(idx1 & 1) << k1;
+    }
+
+    return bits;
+}
+
+// Planar block colors from the quantized corner values
+static void ETC2PlanarColors(const int orig[3],const int horiz[3],const int vert[3],ETC2Block block)
+{
+    const int bits[3] = {6,7,6};
+    for (int c=0;c<3;c++)
+    {
+        int o = ETC2Expand(orig[c],bits[c]), h = ETC2Expand(horiz[c],bits[c]), v = ETC2Expand(vert[c],bits[c]);
+        for (int x=0;x<4;x++)
+            for (int y=0;y<4;y++)
+                block[x*4+y][c] = (uint8_t)ETC2Clamp((x*(h-o) + y*(v-o) + 4*o + 2) >> 2,0,255);
+    }
+}
+
+// Fit a plane to each channel and pack it as a planar block
+static uint64_t ETC2EncodePlanar(const ETC2Block block,int &retErr)
+{
+    const int bits[3] = {6,7,6};
+    int orig[3],horiz[3],vert[3];
+    for (int c=0;c<3;c++)
+    {
+        // Least squares for v = a + b*x + c*y over the 4x4 grid
+        float sum = 0.0, sumX = 0.0, sumY = 0.0;
+        for (int x=0;x<4;x++)
+            for (int y=0;y<4;y++)
+            {
+                float val = block[x*4+y][c];
+                sum += val;
+                sumX += (x-1.5f) * val;
+                sumY += (y-1.5f) * val;
+            }
+        float slopeX = sumX / 20.f, slopeY = sumY / 20.f;
+        float o = sum / 16.f - 1.5f*slopeX - 1.5f*slopeY;
+        orig[c] = ETC2Quantize(o,bits[c]);
+        horiz[c] = ETC2Quantize(o + 4.f*slopeX,bits[c]);
+        vert[c] = ETC2Quantize(o + 4.f*slopeY,bits[c]);
+    }
+
+    ETC2Block decoded;
+    ETC2PlanarColors(orig,horiz,vert,decoded);
+    retErr = 0;
+    for (int k=0;k<16;k++)
+        for (int c=0;c<3;c++)
+        {
+            int diff = (int)decoded[k][c] - (int)block[k][c];
+            retErr += diff*diff;
+        }
+
+    uint64_t packed = 0;
+    packed |= (uint64_t)orig[0] << 57;
+    packed |= (uint64_t)(orig[1] >> 6) << 56;
+    packed |= (uint64_t)(orig[1] & 0x3f) << 49;
+    packed |= (uint64_t)(orig[2] >> 5) << 48;
+    packed |= (uint64_t)((orig[2] >> 3) & 0x3) << 43;
+    packed |= (uint64_t)(orig[2] & 0x7) << 39;
+    packed |= (uint64_t)(horiz[0] >> 1) << 34;
+    packed |= (uint64_t)1 << 33;
+    packed |= (uint64_t)(horiz[0] & 1) << 32;
+    packed |= (uint64_t)horiz[1] << 25;
+    packed |= (uint64_t)horiz[2] << 19;
+    packed |= (uint64_t)vert[0] << 13;
+    packed |= (uint64_t)vert[1] << 6;
+    packed |= (uint64_t)vert[2];
+
+    // Planar is signaled by the blue in a differential block overflowing while red and green don't.
+    // Bits 63, 55, 47-45 and 42 are free, so pick them to make that happen.  There's always a way.
+    const int freeBits[6] = {63,55,47,46,45,42};
+    for (int combo=0;combo<64;combo++)
+    {
+        uint64_t bits = packed;
+        for (int ii=0;ii<6;ii++)
+            if (combo & (1<<ii))
+                bits |= (uint64_t)1 << freeBits[ii];
+        bool overflow[3];
+        for (int c=0;c<3;c++)
+        {
+            int base = (int)((bits >> (59-8*c)) & 0x1f);
+            int delta = (int)((bits >> (56-8*c)) & 0x7);
+            if (delta >= 4)
+                delta -= 8;
+            overflow[c] = base + delta < 0 || base + delta > 31;
+        }
+        if (!overflow[0] && !overflow[1] && overflow[2])
+            return bits;
+    }
+
+    retErr = INT_MAX;
+    return 0;
+}
+
+// Try one orientation in differential or individual mode with the given candidate base colors.
+// Updates the best error and bits if it does better.
+static void ETC2TryMode(const ETC2Block block,bool flip,bool diff,int numOffsets,const int offsets[27][3],int &bestErr,uint64_t &bestBits)
+{
+    int pixLists[2][8];
+    float avg[2][3];
+    for (int sub=0;sub<2;sub++)
+    {
+        ETC2SubBlockPixels(flip,sub,pixLists[sub]);
+        for (int c=0;c<3;c++)
+        {
+            int sum = 0;
+            for (int ii=0;ii<8;ii++)
+                sum += block[pixLists[sub][ii]][c];
+            avg[sub][c] = sum / 8.f;
+        }
+    }
+
+    // Differential mode has 5 bits per base color, but the second has to be close to the first.
+    // Individual mode has 4 bits and no restriction.
+    ETC2SubBlockFit fits[2][27];
+    int numFits[2];
+    for (int sub=0;sub<2;sub++)
+        numFits[sub] = ETC2FitCandidates(block,pixLists[sub],avg[sub],diff ? 5 : 4,numOffsets,offsets,fits[sub]);
+    int best0 = -1, best1 = -1, err = INT_MAX;
+    for (int f0=0;f0<numFits[0];f0++)
+        for (int f1=0;f1<numFits[1];f1++)
+        {
+            bool valid = true;
+            if (diff)
+                for (int c=0;c<3;c++)
+                {
+                    int delta = fits[1][f1].quant[c] - fits[0][f0].quant[c];
+                    if (delta < -4 || delta > 3)
+                        valid = false;
+                }
+            if (valid && fits[0][f0].err + fits[1][f1].err < err)
+            {
+                err = fits[0][f0].err + fits[1][f1].err;
+                best0 = f0;  best1 = f1;
+            }
+        }
+
+    if (best0 >= 0 && err < bestErr)
+    {
+        bestErr = err;
+        bestBits = ETC2PackIndividualOrDiff(diff,flip,fits[0][best0],fits[1][best1],pixLists[0],pixLists[1]);
+    }
+}
+
+static uint64_t ETC2EncodeRGBBlock(const ETC2Block block,WKETC2Quality quality)
+{
+    int offsets[27][3];
+    int numOffsets = ETC2CandidateOffsets(quality,offsets);
+
+    // Start with the block averages for both orientations
+    uint64_t bestBits = 0;
+    int bestErr = INT_MAX;
+    bool bestFlip = false, bestDiff = true;
+    for (int flip=0;flip<2;flip++)
+        for (int diff=1;diff>=0;diff--)
+        {
+            // Fast only bothers with individual mode when differential doesn't fit
+            if (!diff && quality == WKETC2Fast && bestErr < INT_MAX)
+                continue;
+            int lastErr = bestErr;
+            ETC2TryMode(block,flip,diff,1,offsets,bestErr,bestBits);
+            if (bestErr < lastErr)
+            {
+                bestFlip = flip;  bestDiff = diff;
+            }
+        }
+    if (bestErr == 0 || quality == WKETC2Fast)
+        return bestBits;
+
+    // Normal refines the winner.  Best refines everything.
+    if (quality == WKETC2Normal)
+        ETC2TryMode(block,bestFlip,bestDiff,numOffsets,offsets,bestErr,bestBits);
+    else
+        for (int flip=0;flip<2;flip++)
+            for (int diff=1;diff>=0;diff--)
+                ETC2TryMode(block,flip,diff,numOffsets,offsets,bestErr,bestBits);
+
+    if (quality == WKETC2Best && bestErr > 0)
+    {
+        int planarErr;
+        uint64_t planarBits = ETC2EncodePlanar(block,planarErr);
+        if (planarErr < bestErr)
+            bestBits = planarBits;
+    }
+
+    return bestBits;
+}
+
+// Error for an alpha block with the given settings
+static int EACFitAlpha(const ETC2Block block,int base,int mult,int table,int maxErr,int indices[16])
+{
+    int vals[8];
+    for (int mm=0;mm<8;mm++)
+        vals[mm] = ETC2Clamp(base + EACModifierTable[table][mm]*mult,0,255);
+
+    int err = 0;
+    for (int k=0;k<16 && err < maxErr;k++)
+    {
+        int alpha = block[k][3];
+        int bestErr = INT_MAX, bestIdx = 0;
+        for (int mm=0;mm<8;mm++)
+        {
+            int diff = vals[mm] - alpha;
+            if (diff*diff < bestErr)
+            {
+                bestErr = diff*diff;
+                bestIdx = mm;
+            }
+        }
+        err += bestErr;
+        indices[k] = bestIdx;
+    }
+
+    return err;
+}
+
+static uint64_t EACEncodeAlphaBlock(const ETC2Block block,WKETC2Quality quality)
+{
+    int minAlpha = 255, maxAlpha = 0;
+    for (int k=0;k<16;k++)
+    {
+        minAlpha = std::min(minAlpha,(int)block[k][3]);
+        maxAlpha = std::max(maxAlpha,(int)block[k][3]);
+    }
+
+    // Constant alpha is the usual case.  Table 13 has a zero modifier at index 4.
+    if (minAlpha == maxAlpha)
+    {
+        uint64_t bits = (uint64_t)minAlpha << 56 | (uint64_t)1 << 52 | (uint64_t)13 << 48;
+        for (int k=0;k<16;k++)
+            bits |= (uint64_t)4 << (45-3*k);
+        return bits;
+    }
+
+    int multRange = quality == WKETC2Fast ? 0 : (quality == WKETC2Normal ? 1 : 2);
+    int baseRange = quality == WKETC2Fast ? 0 : (quality == WKETC2Normal ? 1 : 3);
+
+    int bestErr = INT_MAX, bestBase = 0, bestMult = 1, bestTable = 0;
+    int bestIndices[16],indices[16];
+    memset(bestIndices,0,sizeof(bestIndices));
+    for (int table=0;table<16 && bestErr > 0;table++)
+    {
+        int tableMin = EACModifierTable[table][3], tableMax = EACModifierTable[table][7];
+        int estMult = ETC2Clamp((int)((maxAlpha-minAlpha) / (float)(tableMax-tableMin) + 0.5f),1,15);
+        for (int mult=std::max(1,estMult-multRange);mult<=std::min(15,estMult+multRange);mult++)
+        {
+            int estBase = (int)((minAlpha+maxAlpha)/2.f - (tableMin+tableMax)*mult/2.f + 0.5f);
+            for (int base=estBase-baseRange;base<=estBase+baseRange;base++)
+            {
+                if (base < 0 || base > 255)
+                    continue;
+                int err = EACFitAlpha(block,base,mult,table,bestErr,indices);
+                if (err < bestErr)
+                {
+                    bestErr = err;
+                    bestBase = base;  bestMult = mult;  bestTable = table;
+                    memcpy(bestIndices,indices,sizeof(indices));
+                }
+            }
+        }
+    }
+
+    uint64_t bits = (uint64_t)bestBase << 56 | (uint64_t)bestMult << 52 | (uint64_t)bestTable << 48;
+    for (int k=0;k<16;k++)
+        bits |= (uint64_t)bestIndices[k] << (45-3*k);
+    return bits;
+}
+
+NSData *ETC2EncodeRGBA(const uint8_t *pixels,int width,int height,bool withAlpha,WKETC2Quality quality)
+{
+    if (!pixels || width <= 0 || height <= 0 || width > 0xffff || height > 0xffff)
+        return nil;
+
+    int blocksX = (width+3)/4, blocksY = (height+3)/4;
+    size_t blockSize = withAlpha ? 16 : 8;
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:16 + blocksX*blocksY*blockSize];
+    uint8_t *out = (uint8_t *)[data mutableBytes];
+
+    // PKM header.  The size is rounded up to the block, followed by the original size.
+    int type = withAlpha ? PKMTypeETC2RGBA : PKMTypeETC2RGB;
+    memcpy(out,"PKM 20",6);
+    out[6] = (uint8_t)(type >> 8);  out[7] = (uint8_t)type;
+    out[8] = (uint8_t)((blocksX*4) >> 8);  out[9] = (uint8_t)(blocksX*4);
+    out[10] = (uint8_t)((blocksY*4) >> 8);  out[11] = (uint8_t)(blocksY*4);
+    out[12] = (uint8_t)(width >> 8);  out[13] = (uint8_t)width;
+    out[14] = (uint8_t)(height >> 8);  out[15] = (uint8_t)height;
+    out += 16;
+
+    ETC2Block block;
+    for (int by=0;by<blocksY;by++)
+        for (int bx=0;bx<blocksX;bx++)
+        {
+            ETC2LoadBlock(pixels,width,height,bx,by,block);
+            if (withAlpha)
+            {
+                ETC2WriteBits(out,EACEncodeAlphaBlock(block,quality));
+                out += 8;
+            }
+            ETC2WriteBits(out,ETC2EncodeRGBBlock(block,quality));
+            out += 8;
+        }
+
+    return data;
+}
+
+// Decode the color part of a block.  Returns false for the modes we don't produce.
+static bool ETC2DecodeRGBBlock(uint64_t bits,ETC2Block block)
+{
+    bool diff = (bits >> 33) & 1;
+    bool flip = (bits >> 32) & 1;
+    int base[2][3];
+    if (diff)
+    {
+        bool overflow[3];
+        for (int c=0;c<3;c++)
+        {
+            int col = (int)((bits >> (59-8*c)) & 0x1f);
+            int delta = (int)((bits >> (56-8*c)) & 0x7);
+            if (delta >= 4)
+                delta -= 8;
+            overflow[c] = col + delta < 0 || col + delta > 31;
+            if (!overflow[c])
+            {
+                base[0][c] = ETC2Expand(col,5);
+                base[1][c] = ETC2Expand(col+delta,5);
+            }
+        }
+        // T and H modes
+        if (overflow[0] || overflow[1])
+            return false;
+        if (overflow[2])
+        {
+            int orig[3],horiz[3],vert[3];
+            orig[0] = (int)((bits >> 57) & 0x3f);
+            orig[1] = (int)(((bits >> 56) & 0x1) << 6 | ((bits >> 49) & 0x3f));
+            orig[2] = (int)(((bits >> 48) & 0x1) << 5 | ((bits >> 43) & 0x3) << 3 | ((bits >> 39) & 0x7));
+            horiz[0] = (int)(((bits >> 34) & 0x1f) << 1 | ((bits >> 32) & 0x1));
+            horiz[1] = (int)((bits >> 25) & 0x7f);
+            horiz[2] = (int)((bits >> 19) & 0x3f);
+            vert[0] = (int)((bits >> 13) & 0x3f);
+            vert[1] = (int)((bits >> 6) & 0x7f);
+            vert[2] = (int)(bits & 0x3f);
+            ETC2PlanarColors(orig,horiz,vert,block);
+            return true;
+        }
+    } else {
+        for (int c=0;c<3;c++)
+        {
+            base[0][c] = ETC2Expand((int)((bits >> (60-8*c)) & 0xf),4);
+            base[1][c] = ETC2Expand((int)((bits >> (56-8*c)) & 0xf),4);
+        }
+    }
+
+    int tables[2] = {(int)((bits >> 37) & 0x7),(int)((bits >> 34) & 0x7)};
+    for (int k=0;k<16;k++)
+    {
+        int sub = (flip ? ((k & 3) >= 2) : (k >= 8)) ? 1 : 0;
+        int idx = (int)(((bits >> (16+k)) & 1) << 1 | ((bits >> k) & 1));
+        int mod = ETC2ModifierTable[tables[sub]][idx & 1];
+        if (idx & 2)
+            mod = -mod;
+        for (int c=0;c<3;c++)
+            block[k][c] = (uint8_t)ETC2Clamp(base[sub][c] + mod,0,255);
+    }
+
+    return true;
+}
+
+static void EACDecodeAlphaBlock(uint64_t bits,ETC2Block block)
+{
+    int base = (int)((bits >> 56) & 0xff);
+    int mult = (int)((bits >> 52) & 0xf);
+    int table = (int)((bits >> 48) & 0xf);
+    for (int k=0;k<16;k++)
+    {
+        int idx = (int)((bits >> (45-3*k)) & 0x7);
+        block[k][3] = (uint8_t)ETC2Clamp(base + EACModifierTable[table][idx]*mult,0,255);
+    }
+}
+
+NSData *ETC2DecodeRGBA(NSData *pkmData,int *retWidth,int *retHeight)
+{
+    if ([pkmData length] < 16)
+        return nil;
+    const uint8_t *header = (const uint8_t *)[pkmData bytes];
+    if (strncmp((const char *)header,"PKM ",4))
+        return nil;
+    int type = header[7];
+    if (type != PKMTypeETC2RGB && type != PKMTypeETC2RGBA)
+        return nil;
+    bool withAlpha = type == PKMTypeETC2RGBA;
+    int extWidth = header[8] << 8 | header[9], extHeight = header[10] << 8 | header[11];
+    int width = header[12] << 8 | header[13], height = header[14] << 8 | header[15];
+    int blocksX = extWidth/4, blocksY = extHeight/4;
+    size_t blockSize = withAlpha ? 16 : 8;
+    if ([pkmData length] < 16 + blocksX*blocksY*blockSize || width > extWidth || height > extHeight)
+        return nil;
+
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:width*height*4];
+    uint8_t *pixels = (uint8_t *)[data mutableBytes];
+    const uint8_t *in = header + 16;
+    ETC2Block block;
+    for (int by=0;by<blocksY;by++)
+        for (int bx=0;bx<blocksX;bx++)
+        {
+            for (int k=0;k<16;k++)
+                block[k][3] = 255;
+            if (withAlpha)
+            {
+                EACDecodeAlphaBlock(ETC2ReadBits(in),block);
+                in += 8;
+            }
+            if (!ETC2DecodeRGBBlock(ETC2ReadBits(in),block))
+                return nil;
+            in += 8;
+            ETC2StoreBlock(pixels,width,height,bx,by,block);
+        }
+
+    if (retWidth)
+        *retWidth = width;
+    if (retHeight)
+        *retHeight = height;
+
+    return data;
+}
+
+double ETC2ComputePSNR(const uint8_t *pixelsA,const uint8_t *pixelsB,int width,int height,bool withAlpha)
+{
+    int numChannels = withAlpha ? 4 : 3;
+    double sumSq = 0.0;
+    for (int ii=0;ii<width*height;ii++)
+        for (int c=0;c<numChannels;c++)
+        {
+            double diff = (double)pixelsA[4*ii+c] - (double)pixelsB[4*ii+c];
+            sumSq += diff*diff;
+        }
+    double mse = sumSq / ((double)width*height*numChannels);
+    if (mse == 0.0)
+        return std::numeric_limits<double>::infinity();
+
+    return 10.0 * log10(255.0*255.0 / mse);
+}
+
+// Something that looks a bit like imagery: smooth gradients, some texture and a little noise.
+// The alpha fades out in one corner.
+static void ETC2BenchmarkImage(int size,std::vector<uint8_t> &pixels)
+{
+    pixels.resize(size*size*4);
+    srand(size);
+    for (int y=0;y<size;y++)
+        for (int x=0;x<size;x++)
+        {
+            float fx = x / (float)size, fy = y / (float)size;
+            float detail = 24.f * sinf(fx * 40.f) * cosf(fy * 27.f);
+            int noise = rand() % 13 - 6;
+            uint8_t *pix = &pixels[4*(y*size+x)];
+            pix[0] = (uint8_t)ETC2Clamp((int)(60 + 120*fx + detail) + noise,0,255);
+            pix[1] = (uint8_t)ETC2Clamp((int)(90 + 80*fy + detail/2) + noise,0,255);
+            pix[2] = (uint8_t)ETC2Clamp((int)(40 + 60*fx*fy) + noise,0,255);
+            pix[3] = (uint8_t)ETC2Clamp((int)(255 * (2.f - fx - fy)),0,255);
+        }
+}
+
+void ETC2EncodeBenchmark()
+{
+    const int sizes[2] = {256,512};
+    const WKETC2Quality qualities[3] = {WKETC2Fast,WKETC2Normal,WKETC2Best};
+    const char *qualityNames[3] = {"fast","normal","best"};
+    for (int size : sizes)
+    {
+        std::vector<uint8_t> pixels;
+        ETC2BenchmarkImage(size,pixels);
+        for (int alpha=0;alpha<2;alpha++)
+            for (int qq=0;qq<3;qq++)
+            {
+                CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+                NSData *encoded = ETC2EncodeRGBA(&pixels[0],size,size,alpha,qualities[qq]);
+                double secs = CFAbsoluteTimeGetCurrent() - start;
+                int width,height;
+                NSData *decoded = ETC2DecodeRGBA(encoded,&width,&height);
+                double psnr = decoded ? ETC2ComputePSNR(&pixels[0],(const uint8_t *)[decoded bytes],size,size,alpha) : 0.0;
+                NSLog(@"ETC2Encoder: %dx%d %s %s: %.1f ms, %.2f Mpix/s, PSNR %.2f dB",size,size,alpha ? "RGBA" : "RGB",qualityNames[qq],
+                      secs * 1000.0,size*size / (secs * 1e6),psnr);
+            }
+    }
+}
+
+}
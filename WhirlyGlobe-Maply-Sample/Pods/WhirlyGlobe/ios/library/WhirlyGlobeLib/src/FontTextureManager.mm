@@ -22,6 +22,9 @@
 #import "UIImage+Stuff.h"
 #import "UIColor+Stuff.h"
 #import "WhirlyVector.h"
+#import "DistanceField.h"
+#import <unordered_map>
+#import <list>
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -33,19 +36,24 @@ typedef std::set<CGGlyph> GlyphSet;
 
 // We scale the fonts up so they look better sampled down.
 static const float BogusFontScale = 2.0;
+
+// Distance field glyphs are rendered once at this size
+static const float SDFReferenceSize = 64.0;
+// And the field reaches this many pixels to either side of the edge
+static const float SDFSpread = 12.0;
     
 /// Manages the glyphs for a single font
 class FontManager
 {
 public:
-    FontManager(CTFontRef theFont) : font(theFont),refCount(0),color(nil),backColor(nil),outlineColor(nil),outlineSize(0.0) { CFRetain(font); }
+    FontManager(CTFontRef theFont) : font(theFont),refCount(0),color(nil),backColor(nil),outlineColor(nil),outlineSize(0.0),sdf(false) { CFRetain(font); }
     ~FontManager()
     {
         CFRelease(font);
-        for (std::set<GlyphInfo *,GlyphInfoSorter>::iterator it = glyphs.begin();
+        for (GlyphInfoMap::iterator it = glyphs.begin();
              it != glyphs.end(); ++it)
         {
-            delete *it;
+            delete it->second;
         }
         glyphs.clear();
     }
@@ -68,21 +76,15 @@ public:
         int refCount;
     };
 
-    typedef struct
-    {
-        bool operator () (const GlyphInfo *a,const GlyphInfo *b) const { return a->glyph < b->glyph; }
-    } GlyphInfoSorter;
-
     bool empty() { return glyphs.empty(); }
 
     // Look for an existing glyph and return it if it's there
     GlyphInfo *findGlyph(CGGlyph glyph)
     {
-        GlyphInfo dummyGlyph(glyph);
-        GlyphInfoSet::iterator it = glyphs.find(&dummyGlyph);
+        GlyphInfoMap::iterator it = glyphs.find(glyph);
         if (it != glyphs.end())
         {
-            return *it;
+            return it->second;
         }
         
         return nil;
@@ -96,7 +98,7 @@ public:
         info->offset = offset;
         info->textureOffset = textureOffset;
         info->subTex = subTex;
-        glyphs.insert(info);
+        glyphs[glyph] = info;
         
         return info;
     }
@@ -108,14 +110,9 @@ public:
         for (GlyphSet::iterator it = usedGlyphs.begin();
              it != usedGlyphs.end(); ++it)
         {
-            CGGlyph theGlyph = *it;
-            GlyphInfo dummy(theGlyph);
-            GlyphInfoSet::iterator git = glyphs.find(&dummy);
+            GlyphInfoMap::iterator git = glyphs.find(*it);
             if (git != glyphs.end())
-            {
-                GlyphInfo *glyphInfo = *git;
-                glyphInfo->refCount++;
-            }
+                git->second->refCount++;
         }
     }
             
@@ -126,12 +123,10 @@ public:
         for (GlyphSet::iterator it = usedGlyphs.begin();
              it != usedGlyphs.end(); ++it)
         {
-            CGGlyph theGlyph = *it;
-            GlyphInfo dummy(theGlyph);
-            GlyphInfoSet::iterator git = glyphs.find(&dummy);
+            GlyphInfoMap::iterator git = glyphs.find(*it);
             if (git != glyphs.end())
             {
-                GlyphInfo *glyphInfo = *git;
+                GlyphInfo *glyphInfo = git->second;
                 glyphInfo->refCount--;
                 if (glyphInfo->refCount <= 0)
                 {
@@ -150,11 +145,13 @@ public:
     UIColor *outlineColor;
     float outlineSize;
     float pointSize;
+    // Glyphs are distance fields rather than bitmaps
+    bool sdf;
             
 protected:
     // Maps Glyphs (shorts) to texture and region
-    typedef std::set<GlyphInfo *,GlyphInfoSorter> GlyphInfoSet;
-    GlyphInfoSet glyphs;
+    typedef std::unordered_map<CGGlyph,GlyphInfo *> GlyphInfoMap;
+    GlyphInfoMap glyphs;
 };
 
 // Used to order a set of these
@@ -194,6 +191,37 @@ public:
 };
             
 typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
+
+// Fonts and glyphs used by a shaped string
+typedef std::map<FontManager *,GlyphSet> FontManagerGlyphMap;
+
+// A string we've already run through CoreText, with its glyph quads ready to go.
+// The cache holds its own references on the glyphs so they stay in the atlas.
+class ShapedString
+{
+public:
+    NSAttributedString *str;
+    bool sdf;
+    std::vector<DrawableString::Rect> glyphPolys;
+    Mbr mbr;
+    float sdfSpread;
+    FontManagerGlyphMap fontGlyphs;
+};
+typedef std::list<ShapedString> ShapedStringList;
+
+// Attributed strings compare on their text and all the attributes (font, size, colors, outline)
+struct AttrStringHash
+{
+    size_t operator () (NSAttributedString *str) const { return [str hash]; }
+};
+struct AttrStringEqual
+{
+    bool operator () (NSAttributedString *a,NSAttributedString *b) const { return [a isEqualToAttributedString:b]; }
+};
+typedef std::unordered_map<NSAttributedString *,ShapedStringList::iterator,AttrStringHash,AttrStringEqual> ShapedStringMap;
+
+// Number of shaped strings we'll keep around
+static const unsigned int MaxShapedStrings = 4096;
             
 @implementation WhirlyKitFontTextureManager
 {
@@ -201,6 +229,9 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     DynamicTextureAtlas *texAtlas;
     FontManagerSet fontManagers;
     DrawStringRepSet drawStringReps;
+    // Most recently used at the front
+    ShapedStringList shapedStrings;
+    ShapedStringMap shapedStringMap,sdfShapedStringMap;
     pthread_mutex_t lock;
 }
 
@@ -224,6 +255,9 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     for (DrawStringRepSet::iterator it = drawStringReps.begin();
          it != drawStringReps.end(); ++it)
         delete *it;
+    shapedStringMap.clear();
+    sdfShapedStringMap.clear();
+    shapedStrings.clear();
     for (FontManagerSet::iterator it = fontManagers.begin();
          it != fontManagers.end(); ++it)
         delete *it;
@@ -245,6 +279,9 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
          it != drawStringReps.end(); ++it)
         delete *it;
     drawStringReps.clear();
+    shapedStringMap.clear();
+    sdfShapedStringMap.clear();
+    shapedStrings.clear();
     for (FontManagerSet::iterator it = fontManagers.begin();
          it != fontManagers.end(); ++it)
         delete *it;
@@ -260,7 +297,11 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     int width,height;
     
     // Boundary around the image to capture the full data
-    if (fm->outlineSize > 0.0)
+    if (fm->sdf)
+    {
+        int spreadUp = ceilf(SDFSpread);
+        textureOffset = CGPointMake(1+spreadUp, 1+spreadUp);
+    } else if (fm->outlineSize > 0.0)
     {
         int outlineUp = ceilf(fm->outlineSize);
         textureOffset = CGPointMake(1+outlineUp, 1+outlineUp);
@@ -339,21 +380,39 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     
     CGColorSpaceRelease(colorSpace);
     
+    if (fm->sdf)
+        return SignedDistanceFieldFromRGBA(retData, width, height, SDFSpread);
+    
     return retData;
 }
             
 // Look for an existing font that will match the UIFont given
-- (FontManager *)findFontManagerForFont:(UIFont *)uiFont color:(UIColor *)color backColor:(UIColor *)backColor outlineColor:(UIColor *)outlineColor outlineSize:(NSNumber *)outlineSize
+- (FontManager *)findFontManagerForFont:(UIFont *)uiFont color:(UIColor *)color backColor:(UIColor *)backColor outlineColor:(UIColor *)outlineColor outlineSize:(NSNumber *)outlineSize sdf:(bool)sdf
 {
     NSString *fontName = uiFont.fontName;
     float pointSize = uiFont.pointSize;
     
     pointSize *= BogusFontScale;
     
+    // Distance field glyphs only care about the font itself
+    if (sdf)
+    {
+        pointSize = SDFReferenceSize;
+        color = nil;  backColor = nil;  outlineColor = nil;  outlineSize = nil;
+    }
+    
     for (FontManagerSet::iterator it = fontManagers.begin();
          it != fontManagers.end(); ++it)
     {
         FontManager *fm = *it;
+        if (fm->sdf != sdf)
+            continue;
+        if (sdf)
+        {
+            if (![fontName compare:fm->fontName])
+                return fm;
+            continue;
+        }
         if (![fontName compare:fm->fontName] && pointSize == fm->pointSize &&
             ((!fm->color && !color) ||
              ([fm->color asRGBAColor] == [color asRGBAColor])) &&
@@ -374,6 +433,7 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     fm->pointSize = pointSize;
     fm->outlineColor = outlineColor;
     fm->outlineSize = [outlineSize floatValue];
+    fm->sdf = sdf;
 //    fm->outlineSize *= BogusFontScale;
     fontManagers.insert(fm);
     if (font)
@@ -383,6 +443,11 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
 }
 
 - (WhirlyKit::DrawableString *)addString:(NSAttributedString *)str changes:(ChangeSet &)changes
+{
+    return [self addString:str sdf:false changes:changes];
+}
+
+- (WhirlyKit::DrawableString *)addString:(NSAttributedString *)str sdf:(bool)sdf changes:(ChangeSet &)changes
 {
     // We could make this more granular
     pthread_mutex_lock(&lock);
@@ -393,7 +458,34 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
         texAtlas = new DynamicTextureAtlas(2048,16,GL_UNSIGNED_BYTE);
     }
     
+    // If we've shaped this one before, just reuse the glyph quads
+    ShapedStringMap &stringMap = sdf ? sdfShapedStringMap : shapedStringMap;
+    ShapedStringMap::iterator sit = stringMap.find(str);
+    if (sit != stringMap.end())
+    {
+        shapedStrings.splice(shapedStrings.begin(), shapedStrings, sit->second);
+        const ShapedString &shaped = *(sit->second);
+        
+        DrawableString *drawString = new DrawableString();
+        drawString->glyphPolys = shaped.glyphPolys;
+        drawString->mbr = shaped.mbr;
+        drawString->sdfSpread = shaped.sdfSpread;
+        DrawStringRep *drawStringRep = new DrawStringRep(drawString->getId());
+        for (FontManagerGlyphMap::const_iterator fit = shaped.fontGlyphs.begin();
+             fit != shaped.fontGlyphs.end(); ++fit)
+        {
+            drawStringRep->addGlyphs(fit->first->font, fit->second);
+            fit->first->addGlyphRefs(fit->second);
+        }
+        drawStringReps.insert(drawStringRep);
+        
+        pthread_mutex_unlock(&lock);
+        
+        return drawString;
+    }
+    
     DrawableString *drawString = new DrawableString();
+    FontManagerGlyphMap fontGlyphs;
     
     // Convert to runs of glyphs
     CTLineRef line = CTLineCreateWithAttributedString((__bridge CFAttributedStringRef)str);
@@ -438,7 +530,7 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
 
             FontManager *fm = nil;
             if ([uiFont isKindOfClass:[UIFont class]])
-                fm = [self findFontManagerForFont:uiFont color:foregroundColor backColor:backgroundColor outlineColor:outlineColor outlineSize:outlineSize];
+                fm = [self findFontManagerForFont:uiFont color:foregroundColor backColor:backgroundColor outlineColor:outlineColor outlineSize:outlineSize sdf:sdf];
             if (!fm)
                 continue;
             
@@ -477,7 +569,10 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
                     DrawableString::Rect rect;
                     CGPoint &offset = offsets[jj];
                     
-                    float scale = 1.0/BogusFontScale;
+                    // Distance field glyphs get scaled down from the reference size to the one we want
+                    float scale = fm->sdf ? uiFont.pointSize / fm->pointSize : 1.0/BogusFontScale;
+                    if (fm->sdf)
+                        drawString->sdfSpread = std::max(drawString->sdfSpread,SDFSpread * scale);
 
                     // Note: was -1,-1
                     rect.pts[0] = Point2f(glyphInfo->offset.x*scale-glyphInfo->textureOffset.x*scale,glyphInfo->offset.y*scale-glyphInfo->textureOffset.y*scale)+Point2f(offset.x,offset.y);
@@ -497,7 +592,7 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
 
             // Keep track of the glyphs we're using
             drawStringRep->addGlyphs(fm->font,glyphsUsed);
-            fm->addGlyphRefs(glyphsUsed);
+            fontGlyphs[fm].insert(glyphsUsed.begin(),glyphsUsed.end());
             
             free(glyphs);
             free(offsets);
@@ -521,13 +616,64 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
     
     // We need to track the glyphs we're using
     if (drawStringRep != NULL)
+    {
         drawStringReps.insert(drawStringRep);
+        
+        // One reference per font, to match what removeString: takes away
+        for (FontManagerGlyphMap::iterator fit = fontGlyphs.begin();
+             fit != fontGlyphs.end(); ++fit)
+            fit->first->addGlyphRefs(fit->second);
+
+        // Keep the shaped version for the next time we see this string
+        shapedStrings.push_front(ShapedString());
+        ShapedString &shaped = shapedStrings.front();
+        shaped.str = [str copy];
+        shaped.sdf = sdf;
+        shaped.glyphPolys = drawString->glyphPolys;
+        shaped.mbr = drawString->mbr;
+        shaped.sdfSpread = drawString->sdfSpread;
+        shaped.fontGlyphs = fontGlyphs;
+        for (FontManagerGlyphMap::iterator fit = fontGlyphs.begin();
+             fit != fontGlyphs.end(); ++fit)
+            fit->first->addGlyphRefs(fit->second);
+        stringMap[shaped.str] = shapedStrings.begin();
+        
+        // Toss the least recently used one
+        if (shapedStrings.size() > MaxShapedStrings)
+        {
+            ShapedString &oldShaped = shapedStrings.back();
+            (oldShaped.sdf ? sdfShapedStringMap : shapedStringMap).erase(oldShaped.str);
+            for (FontManagerGlyphMap::iterator fit = oldShaped.fontGlyphs.begin();
+                 fit != oldShaped.fontGlyphs.end(); ++fit)
+                [self releaseGlyphs:fit->second font:fit->first changes:changes when:0.0];
+            shapedStrings.pop_back();
+        }
+    }
 
     pthread_mutex_unlock(&lock);
 
     return drawString;
 }
             
+// Decrement the glyph references, removing anything that's no longer used.  Lock must be held.
+- (void)releaseGlyphs:(const GlyphSet &)glyphs font:(FontManager *)fm changes:(ChangeSet &)changes when:(NSTimeInterval)when
+{
+    std::vector<SubTexture> texRemove;
+    fm->removeGlyphRefs(glyphs,texRemove);
+
+    // And possibly remove some sub textures
+    if (!texRemove.empty())
+        for (unsigned int ii=0;ii<texRemove.size();ii++)
+            texAtlas->removeTexture(texRemove[ii], changes, when);
+    
+    // Also see if we're done with the font
+    if (fm->refCount <= 0)
+    {
+        fontManagers.erase(fm);
+        delete fm;
+    }
+}
+
 - (void)removeString:(SimpleIdentity)drawStringId changes:(ChangeSet &)changes when:(NSTimeInterval)when
 {
     pthread_mutex_lock(&lock);
@@ -550,24 +696,7 @@ typedef std::set<DrawStringRep *,IdentifiableSorter> DrawStringRepSet;
         FontManager dummyFm(fit->first);
         FontManagerSet::iterator fmIt = fontManagers.find(&dummyFm);
         if (fmIt != fontManagers.end())
-        {
-            // Decrement the glyph references
-            FontManager *fm = *fmIt;
-            std::vector<SubTexture> texRemove;
-            fm->removeGlyphRefs(fit->second,texRemove);
-
-            // And possibly remove some sub textures
-            if (!texRemove.empty())
-                for (unsigned int ii=0;ii<texRemove.size();ii++)
-                    texAtlas->removeTexture(texRemove[ii], changes, when);
-            
-            // Also see if we're done with the font
-            if (fm->refCount <= 0)
-            {
-                fontManagers.erase(fmIt);
-                delete fm;
-            }
-        }
+            [self releaseGlyphs:fit->second font:*fmIt changes:changes when:when];
     }
     
     pthread_mutex_unlock(&lock);
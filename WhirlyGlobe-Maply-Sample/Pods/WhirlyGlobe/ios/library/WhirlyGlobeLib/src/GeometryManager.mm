@@ -24,6 +24,8 @@
 #import "NSDictionary+Stuff.h"
 #import "UIColor+Stuff.h"
 #import "BasicDrawableInstance.h"
+#import <queue>
+#import <set>
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -175,17 +177,603 @@ void GeometryRaw::calcBounds(Point3d &ll,Point3d &ur)
     }
 }
 
+// Size of the vertex cache the triangle ordering is tuned for
+static const int ForsythCacheSize = 32;
+// Size of the FIFO cache we measure ACMR against (typical for the hardware)
+static const int MeasureCacheSize = 16;
+
+// Mix the bits in well, since whole number coordinates leave the low bits empty
+static inline void HashCombine(size_t &hash,uint64_t val)
+{
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+    hash ^= (size_t)val + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+}
+
+static inline uint64_t HashBits(double val)
+{
+    uint64_t bits;
+    memcpy(&bits,&val,sizeof(bits));
+    return bits;
+}
+
+static inline uint64_t HashBits(float val)
+{
+    uint32_t bits;
+    memcpy(&bits,&val,sizeof(bits));
+    return bits;
+}
+
+// Average cache miss ratio for the triangles on a simple FIFO cache
+static double CalcACMR(const std::vector<GeometryRaw::RawTriangle> &tris,int numVerts)
+{
+    if (tris.empty())
+        return 0.0;
+    
+    // A vertex is in the cache if it went in fewer than MeasureCacheSize misses ago
+    std::vector<int> insertedAt(numVerts,-1);
+    int misses = 0;
+    for (const auto &tri : tris)
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            int vert = tri.verts[jj];
+            if (insertedAt[vert] < 0 || misses - insertedAt[vert] >= MeasureCacheSize)
+            {
+                insertedAt[vert] = misses;
+                misses++;
+            }
+        }
+    
+    return misses / (double)tris.size();
+}
+
+// Vertex score from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static float ForsythVertexScore(int cachePos,int remainingTris)
+{
+    if (remainingTris == 0)
+        return -1.0;
+    
+    float score = 0.0;
+    if (cachePos >= 0)
+    {
+        // The last triangle's vertices get a fixed score so we don't favor strips
+        if (cachePos < 3)
+            score = 0.75;
+        else
+            score = powf(1.0 - (cachePos - 3) / (float)(ForsythCacheSize - 3),1.5);
+    }
+    // Favor vertices with few triangles left so we don't strand them
+    score += 2.0 / sqrtf(remainingTris);
+    
+    return score;
+}
+
+// Reorder the triangles for the post-transform vertex cache
+static void ForsythReorder(std::vector<GeometryRaw::RawTriangle> &tris,int numVerts)
+{
+    int numTris = (int)tris.size();
+    if (numTris == 0)
+        return;
+    
+    // Triangles for each vertex.  The ones not yet added are kept at the front.
+    std::vector<int> vertTrisStart(numVerts+1,0),remaining(numVerts,0);
+    for (const auto &tri : tris)
+        for (unsigned int jj=0;jj<3;jj++)
+            remaining[tri.verts[jj]]++;
+    for (int ii=0;ii<numVerts;ii++)
+        vertTrisStart[ii+1] = vertTrisStart[ii] + remaining[ii];
+    std::vector<int> vertTris(vertTrisStart[numVerts]);
+    {
+        std::vector<int> fill(vertTrisStart.begin(),vertTrisStart.end()-1);
+        for (int ti=0;ti<numTris;ti++)
+            for (unsigned int jj=0;jj<3;jj++)
+                vertTris[fill[tris[ti].verts[jj]]++] = ti;
+    }
+    
+    std::vector<int> cachePos(numVerts,-1);
+    std::vector<float> vertScore(numVerts);
+    for (int ii=0;ii<numVerts;ii++)
+        vertScore[ii] = ForsythVertexScore(-1,remaining[ii]);
+    std::vector<float> triScore(numTris);
+    std::vector<bool> triAdded(numTris,false);
+    int bestTri = -1;
+    for (int ti=0;ti<numTris;ti++)
+    {
+        const auto &tri = tris[ti];
+        triScore[ti] = vertScore[tri.verts[0]] + vertScore[tri.verts[1]] + vertScore[tri.verts[2]];
+        if (bestTri < 0 || triScore[ti] > triScore[bestTri])
+            bestTri = ti;
+    }
+    
+    std::vector<GeometryRaw::RawTriangle> newTris;
+    newTris.reserve(numTris);
+    std::vector<int> cache,newCache;
+    int scanPos = 0;
+    while (newTris.size() < numTris)
+    {
+        // Nothing useful in the cache, so start over with the next unused triangle
+        if (bestTri < 0)
+        {
+            while (triAdded[scanPos])
+                scanPos++;
+            bestTri = scanPos;
+        }
+        
+        const GeometryRaw::RawTriangle tri = tris[bestTri];
+        triAdded[bestTri] = true;
+        newTris.push_back(tri);
+        
+        // Take the triangle out of its vertices' remaining lists
+        newCache.clear();
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            int vert = tri.verts[jj];
+            if (std::find(newCache.begin(),newCache.end(),vert) != newCache.end())
+                continue;
+            newCache.push_back(vert);
+            int start = vertTrisStart[vert];
+            int end = start + remaining[vert];
+            for (int ii=start;ii<end;ii++)
+                if (vertTris[ii] == bestTri)
+                {
+                    std::swap(vertTris[ii],vertTris[end-1]);
+                    break;
+                }
+            remaining[vert]--;
+        }
+        
+        // The triangle's vertices go to the front of the cache
+        int numTriVerts = (int)newCache.size();
+        for (int vert : cache)
+            if (std::find(newCache.begin(),newCache.begin()+numTriVerts,vert) == newCache.begin()+numTriVerts)
+                newCache.push_back(vert);
+        
+        // Rescore everything that was or is in the cache and pick the next best triangle
+        bestTri = -1;
+        for (unsigned int ii=0;ii<newCache.size();ii++)
+        {
+            int vert = newCache[ii];
+            cachePos[vert] = ii < ForsythCacheSize ? ii : -1;
+            vertScore[vert] = ForsythVertexScore(cachePos[vert],remaining[vert]);
+        }
+        for (int vert : newCache)
+        {
+            int start = vertTrisStart[vert];
+            for (int ii=start;ii<start+remaining[vert];ii++)
+            {
+                int ti = vertTris[ii];
+                const auto &otherTri = tris[ti];
+                triScore[ti] = vertScore[otherTri.verts[0]] + vertScore[otherTri.verts[1]] + vertScore[otherTri.verts[2]];
+                if (bestTri < 0 || triScore[ti] > triScore[bestTri])
+                    bestTri = ti;
+            }
+        }
+        
+        if (newCache.size() > ForsythCacheSize)
+            newCache.resize(ForsythCacheSize);
+        cache.swap(newCache);
+    }
+    
+    tris.swap(newTris);
+}
+
+void GeometryRaw::optimize(GeometryOptimizeStats *stats)
+{
+    if (type != WhirlyKitGeometryTriangles || !isValid())
+        return;
+    
+    int numVerts = (int)pts.size();
+    if (stats)
+    {
+        stats->vertsBefore = numVerts;
+        stats->acmrBefore = CalcACMR(triangles,numVerts);
+    }
+    
+    // Weld vertices with the exact same attributes
+    std::vector<int> remap(numVerts);
+    {
+        size_t tableSize = 1;
+        while (tableSize < 2*numVerts)
+            tableSize <<= 1;
+        size_t tableMask = tableSize-1;
+        std::vector<int> table(tableSize,-1);
+        
+        for (int ii=0;ii<numVerts;ii++)
+        {
+            size_t hash = 0;
+            for (unsigned int jj=0;jj<3;jj++)
+                HashCombine(hash,HashBits(pts[ii][jj]));
+            if (!norms.empty())
+                for (unsigned int jj=0;jj<3;jj++)
+                    HashCombine(hash,HashBits(norms[ii][jj]));
+            if (!texCoords.empty())
+                for (unsigned int jj=0;jj<2;jj++)
+                    HashCombine(hash,HashBits(texCoords[ii][jj]));
+            if (!colors.empty())
+            {
+                const RGBAColor &color = colors[ii];
+                HashCombine(hash,((uint64_t)color.r << 24) | ((uint64_t)color.g << 16) | ((uint64_t)color.b << 8) | color.a);
+            }
+            
+            size_t slot = hash & tableMask;
+            for (;table[slot] >= 0;slot = (slot+1) & tableMask)
+            {
+                int other = table[slot];
+                if (pts[other] != pts[ii])
+                    continue;
+                if (!norms.empty() && norms[other] != norms[ii])
+                    continue;
+                if (!texCoords.empty() && texCoords[other] != texCoords[ii])
+                    continue;
+                if (!colors.empty())
+                {
+                    const RGBAColor &color = colors[ii], &otherColor = colors[other];
+                    if (color.r != otherColor.r || color.g != otherColor.g || color.b != otherColor.b || color.a != otherColor.a)
+                        continue;
+                }
+                break;
+            }
+            if (table[slot] < 0)
+                table[slot] = ii;
+            remap[ii] = table[slot];
+        }
+    }
+    
+    // Welding can collapse triangles, which draw nothing anyway
+    std::vector<RawTriangle> newTris;
+    newTris.reserve(triangles.size());
+    for (const auto &tri : triangles)
+    {
+        RawTriangle newTri(remap[tri.verts[0]],remap[tri.verts[1]],remap[tri.verts[2]]);
+        if (newTri.verts[0] != newTri.verts[1] && newTri.verts[1] != newTri.verts[2] && newTri.verts[0] != newTri.verts[2])
+            newTris.push_back(newTri);
+    }
+    
+    ForsythReorder(newTris,numVerts);
+    
+    // Lay the vertices out in the order they're first used
+    std::vector<int> newIndex(numVerts,-1);
+    int numNewVerts = 0;
+    for (auto &tri : newTris)
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            int &vert = tri.verts[jj];
+            if (newIndex[vert] < 0)
+                newIndex[vert] = numNewVerts++;
+            vert = newIndex[vert];
+        }
+    std::vector<Point3d> newPts(numNewVerts),newNorms(norms.empty() ? 0 : numNewVerts);
+    std::vector<TexCoord> newTexCoords(texCoords.empty() ? 0 : numNewVerts);
+    std::vector<RGBAColor> newColors(colors.empty() ? 0 : numNewVerts);
+    for (int ii=0;ii<numVerts;ii++)
+    {
+        int which = newIndex[ii];
+        if (which < 0)
+            continue;
+        newPts[which] = pts[ii];
+        if (!norms.empty())
+            newNorms[which] = norms[ii];
+        if (!texCoords.empty())
+            newTexCoords[which] = texCoords[ii];
+        if (!colors.empty())
+            newColors[which] = colors[ii];
+    }
+    
+    if (stats)
+    {
+        // What the drawables will hold: float positions, normals and texture coordinates,
+        //  byte colors and 16 bit indices
+        size_t vertSize = 3*sizeof(float) + (norms.empty() ? 0 : 3*sizeof(float)) +
+                          (texCoords.empty() ? 0 : 2*sizeof(float)) + (colors.empty() ? 0 : 4);
+        stats->bytesBefore = numVerts * vertSize + triangles.size() * 3 * sizeof(GLushort);
+        stats->vertsAfter = numNewVerts;
+        stats->acmrAfter = CalcACMR(newTris,numNewVerts);
+        stats->bytesAfter = numNewVerts * vertSize + newTris.size() * 3 * sizeof(GLushort);
+    }
+    
+    pts.swap(newPts);
+    norms.swap(newNorms);
+    texCoords.swap(newTexCoords);
+    colors.swap(newColors);
+    triangles.swap(newTris);
+}
+
+// Boundary edges get a plane of their own, weighted heavily so the outline stays put
+static const double QuadricBoundaryWeight = 100.0;
+// Collapses that turn a triangle further than this (cosine) are rejected
+static const double QuadricMinFlipCos = 0.2;
+
+// Edge between two vertices, with a triangle using it
+typedef struct
+{
+    int v0,v1;
+    int tri;
+} QuadricEdge;
+
+// Potential collapse of one vertex onto another
+typedef struct
+{
+    double cost,error;
+    int from,to;
+    int fromStamp,toStamp;
+} QuadricCollapse;
+
+struct QuadricCollapseCmp
+{
+    bool operator () (const QuadricCollapse &a,const QuadricCollapse &b) const
+    {
+        return a.cost > b.cost;
+    }
+};
+
+void GeometryRaw::simplify(int targetTris,double maxError,GeometryRaw &outGeom) const
+{
+    outGeom = *this;
+    if (type != WhirlyKitGeometryTriangles || !isValid() || triangles.size() <= targetTris)
+        return;
+    
+    int numVerts = (int)pts.size();
+    int numTris = (int)triangles.size();
+    std::vector<RawTriangle> tris = triangles;
+    std::vector<bool> triDead(numTris,false),vertDead(numVerts,false);
+    std::vector<std::vector<int>> vertTris(numVerts);
+    int liveTris = 0;
+    for (int ti=0;ti<numTris;ti++)
+    {
+        const RawTriangle &tri = tris[ti];
+        if (tri.verts[0] == tri.verts[1] || tri.verts[1] == tri.verts[2] || tri.verts[0] == tri.verts[2])
+        {
+            triDead[ti] = true;
+            continue;
+        }
+        for (unsigned int jj=0;jj<3;jj++)
+            vertTris[tri.verts[jj]].push_back(ti);
+        liveTris++;
+    }
+    
+    // Vertices sharing a position with another are on a seam, so we leave them alone
+    std::vector<bool> locked(numVerts,false);
+    {
+        std::vector<int> sorted(numVerts);
+        for (int ii=0;ii<numVerts;ii++)
+            sorted[ii] = ii;
+        std::sort(sorted.begin(),sorted.end(),
+                  [this](int a,int b)
+                  {
+                      const Point3d &pa = pts[a], &pb = pts[b];
+                      return std::lexicographical_compare(pa.data(),pa.data()+3,pb.data(),pb.data()+3);
+                  });
+        for (int ii=1;ii<numVerts;ii++)
+            if (pts[sorted[ii]] == pts[sorted[ii-1]])
+                locked[sorted[ii]] = locked[sorted[ii-1]] = true;
+    }
+    
+    // Sort out the edges.  The ones with only one triangle are on a boundary.
+    std::vector<QuadricEdge> edges;
+    edges.reserve(3*numTris);
+    for (int ti=0;ti<numTris;ti++)
+    {
+        if (triDead[ti])
+            continue;
+        const RawTriangle &tri = tris[ti];
+        for (unsigned int jj=0;jj<3;jj++)
+        {
+            int v0 = tri.verts[jj], v1 = tri.verts[(jj+1)%3];
+            edges.push_back({std::min(v0,v1),std::max(v0,v1),ti});
+        }
+    }
+    std::sort(edges.begin(),edges.end(),
+              [](const QuadricEdge &a,const QuadricEdge &b)
+              {
+                  return a.v0 < b.v0 || (a.v0 == b.v0 && a.v1 < b.v1);
+              });
+    std::vector<bool> onBoundary(numVerts,false);
+    std::set<std::pair<int,int>> boundaryEdges;
+    std::vector<std::pair<int,int>> uniqueEdges;
+    std::vector<Matrix4d> quadrics(numVerts,Matrix4d::Zero());
+    for (unsigned int ii=0;ii<edges.size();)
+    {
+        unsigned int jj = ii+1;
+        while (jj < edges.size() && edges[jj].v0 == edges[ii].v0 && edges[jj].v1 == edges[ii].v1)
+            jj++;
+        const QuadricEdge &edge = edges[ii];
+        uniqueEdges.push_back(std::make_pair(edge.v0,edge.v1));
+        if (jj-ii == 1)
+        {
+            onBoundary[edge.v0] = onBoundary[edge.v1] = true;
+            boundaryEdges.insert(std::make_pair(edge.v0,edge.v1));
+            
+            // Plane through the edge, perpendicular to its triangle
+            const RawTriangle &tri = tris[edge.tri];
+            Point3d triNorm = (pts[tri.verts[1]]-pts[tri.verts[0]]).cross(pts[tri.verts[2]]-pts[tri.verts[0]]);
+            Point3d edgeDir = pts[edge.v1] - pts[edge.v0];
+            Point3d planeNorm = edgeDir.cross(triNorm);
+            if (planeNorm.norm() > 0.0)
+            {
+                planeNorm.normalize();
+                Vector4d plane(planeNorm.x(),planeNorm.y(),planeNorm.z(),-planeNorm.dot(pts[edge.v0]));
+                Matrix4d quad = QuadricBoundaryWeight * edgeDir.squaredNorm() * plane * plane.transpose();
+                quadrics[edge.v0] += quad;
+                quadrics[edge.v1] += quad;
+            }
+        }
+        ii = jj;
+    }
+    
+    // Each triangle's plane, weighted by area
+    for (int ti=0;ti<numTris;ti++)
+    {
+        if (triDead[ti])
+            continue;
+        const RawTriangle &tri = tris[ti];
+        Point3d triNorm = (pts[tri.verts[1]]-pts[tri.verts[0]]).cross(pts[tri.verts[2]]-pts[tri.verts[0]]);
+        double len = triNorm.norm();
+        if (len == 0.0)
+            continue;
+        triNorm /= len;
+        Vector4d plane(triNorm.x(),triNorm.y(),triNorm.z(),-triNorm.dot(pts[tri.verts[0]]));
+        Matrix4d quad = len/2.0 * plane * plane.transpose();
+        for (unsigned int jj=0;jj<3;jj++)
+            quadrics[tri.verts[jj]] += quad;
+    }
+    
+    // Live vertices connected to the given one
+    auto findNeighbors = [&](int vert,std::vector<int> &neighbors)
+    {
+        neighbors.clear();
+        for (int ti : vertTris[vert])
+        {
+            if (triDead[ti])
+                continue;
+            for (unsigned int jj=0;jj<3;jj++)
+                if (tris[ti].verts[jj] != vert)
+                    neighbors.push_back(tris[ti].verts[jj]);
+        }
+        std::sort(neighbors.begin(),neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(),neighbors.end()),neighbors.end());
+    };
+    
+    // Collapsing from onto to is fine if it doesn't move a seam or boundary, pinch the surface or flip anything over
+    std::vector<int> fromNeighbors,toNeighbors,common;
+    auto canCollapse = [&](int from,int to) -> bool
+    {
+        if (locked[from])
+            return false;
+        if (onBoundary[from] && boundaryEdges.find(std::make_pair(std::min(from,to),std::max(from,to))) == boundaryEdges.end())
+            return false;
+        
+        // The two ends can only share the vertices across the triangles on the edge
+        int edgeTris = 0;
+        for (int ti : vertTris[from])
+        {
+            const RawTriangle &tri = tris[ti];
+            if (!triDead[ti] && (tri.verts[0] == to || tri.verts[1] == to || tri.verts[2] == to))
+                edgeTris++;
+        }
+        findNeighbors(from,fromNeighbors);
+        findNeighbors(to,toNeighbors);
+        common.clear();
+        std::set_intersection(fromNeighbors.begin(),fromNeighbors.end(),toNeighbors.begin(),toNeighbors.end(),std::back_inserter(common));
+        if (common.size() > edgeTris)
+            return false;
+        
+        for (int ti : vertTris[from])
+        {
+            if (triDead[ti])
+                continue;
+            const RawTriangle &tri = tris[ti];
+            if (tri.verts[0] == to || tri.verts[1] == to || tri.verts[2] == to)
+                continue;
+            Point3d triPts[3],newPts[3];
+            for (unsigned int jj=0;jj<3;jj++)
+            {
+                triPts[jj] = pts[tri.verts[jj]];
+                newPts[jj] = tri.verts[jj] == from ? pts[to] : triPts[jj];
+            }
+            Point3d oldNorm = (triPts[1]-triPts[0]).cross(triPts[2]-triPts[0]);
+            Point3d newNorm = (newPts[1]-newPts[0]).cross(newPts[2]-newPts[0]);
+            double oldLen = oldNorm.norm(), newLen = newNorm.norm();
+            if (newLen == 0.0 || (oldLen > 0.0 && oldNorm.dot(newNorm) < QuadricMinFlipCos * oldLen * newLen))
+                return false;
+        }
+        return true;
+    };
+    
+    std::vector<int> stamps(numVerts,0);
+    std::priority_queue<QuadricCollapse,std::vector<QuadricCollapse>,QuadricCollapseCmp> collapses;
+    auto addCollapse = [&](int from,int to)
+    {
+        if (locked[from] || (onBoundary[from] && !onBoundary[to]))
+            return;
+        Vector4d pos(pts[to].x(),pts[to].y(),pts[to].z(),1.0);
+        Matrix4d quad = quadrics[from] + quadrics[to];
+        double cost = pos.dot(quad * pos);
+        // The quadrics are weighted by area, so this is about the mean squared distance from the old surface
+        double weight = quad(0,0) + quad(1,1) + quad(2,2);
+        double error = weight > 0.0 ? cost / weight : 0.0;
+        collapses.push({cost,error,from,to,stamps[from],stamps[to]});
+    };
+    for (const auto &edge : uniqueEdges)
+    {
+        addCollapse(edge.first,edge.second);
+        addCollapse(edge.second,edge.first);
+    }
+    
+    // Collapse the cheapest edges until we're down to size
+    std::vector<int> neighbors;
+    while (liveTris > targetTris && !collapses.empty())
+    {
+        QuadricCollapse collapse = collapses.top();
+        collapses.pop();
+        int from = collapse.from, to = collapse.to;
+        if (vertDead[from] || vertDead[to] || stamps[from] != collapse.fromStamp || stamps[to] != collapse.toStamp)
+            continue;
+        if (collapse.error > maxError*maxError)
+            continue;
+        if (!canCollapse(from,to))
+            continue;
+        
+        for (int ti : vertTris[from])
+        {
+            if (triDead[ti])
+                continue;
+            RawTriangle &tri = tris[ti];
+            if (tri.verts[0] == to || tri.verts[1] == to || tri.verts[2] == to)
+            {
+                triDead[ti] = true;
+                liveTris--;
+                continue;
+            }
+            for (unsigned int jj=0;jj<3;jj++)
+                if (tri.verts[jj] == from)
+                    tri.verts[jj] = to;
+            vertTris[to].push_back(ti);
+        }
+        vertTris[from].clear();
+        vertDead[from] = true;
+        quadrics[to] += quadrics[from];
+        stamps[to]++;
+        
+        // Anything involving the surviving vertex has a new cost
+        findNeighbors(to,neighbors);
+        for (int other : neighbors)
+        {
+            addCollapse(other,to);
+            addCollapse(to,other);
+        }
+    }
+    
+    outGeom.triangles.clear();
+    outGeom.triangles.reserve(liveTris);
+    for (int ti=0;ti<numTris;ti++)
+        if (!triDead[ti])
+            outGeom.triangles.push_back(tris[ti]);
+    
+    // Drops the unused vertices and puts the rest in a good order
+    outGeom.optimize();
+}
+
 void GeometryRaw::buildDrawables(std::vector<BasicDrawable *> &draws,const Eigen::Matrix4d &mat,const RGBAColor *colorOverride,WhirlyKitGeomInfo *geomInfo)
 {
     if (!isValid())
         return;
     
+    // Where each of our vertices landed in the current drawable, if it's there yet
+    std::vector<int> drawVert(pts.size(),-1),drawVertGen(pts.size(),-1);
+    int gen = -1;
+    
     BasicDrawable *draw = NULL;
     for (unsigned int ii=0;ii<triangles.size();ii++)
     {
         RawTriangle tri = triangles[ii];
-        // See if we need a new drawable
-        if (!draw || draw->getNumPoints() + 3 > MaxDrawablePoints || draw->getNumTris() + 1 > MaxDrawableTriangles)
+        int newVerts = 0;
+        for (unsigned int jj=0;jj<3;jj++)
+            if (drawVertGen[tri.verts[jj]] != gen)
+                newVerts++;
+
+        // See if we need a new drawable.  Indices are 16 bits, so we start over before running out.
+        if (!draw || draw->getNumPoints() + newVerts > MaxDrawablePoints || draw->getNumTris() + 1 > MaxDrawableTriangles)
         {
             draw = new BasicDrawable("Raw Geometry");
             if (geomInfo)
@@ -196,32 +784,41 @@ void GeometryRaw::buildDrawables(std::vector<BasicDrawable *> &draws,const Eigen
             if (texId > 0)
                 draw->setTexId(0,texId);
             draws.push_back(draw);
+            gen++;
         }
         
-        // Add the triangle by copying its vertices (meh)
-        int baseVert = draw->getNumPoints();
+        // Add each vertex the first time it's used in this drawable
+        BasicDrawable::Triangle drawTri;
         for (unsigned int jj=0;jj<3;jj++)
         {
-            const Point3d &pt = pts[tri.verts[jj]];
-            Vector4d outPt = mat * Eigen::Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            Point3d newPt(outPt.x()/outPt.w(),outPt.y()/outPt.w(),outPt.z()/outPt.w());
-            draw->addPoint(newPt);
-            if (!norms.empty())
+            int vert = tri.verts[jj];
+            if (drawVertGen[vert] != gen)
             {
-                const Point3d &norm = norms[tri.verts[jj]];
-                // Note: Not the right way to transform normals
-                Vector4d projNorm = mat * Eigen::Vector4d(norm.x(),norm.y(),norm.z(),0.0);
-                Point3d newNorm(projNorm.x(),projNorm.y(),projNorm.z());
-                newNorm.normalize();
-                draw->addNormal(newNorm);
+                drawVertGen[vert] = gen;
+                drawVert[vert] = draw->getNumPoints();
+                
+                const Point3d &pt = pts[vert];
+                Vector4d outPt = mat * Eigen::Vector4d(pt.x(),pt.y(),pt.z(),1.0);
+                Point3d newPt(outPt.x()/outPt.w(),outPt.y()/outPt.w(),outPt.z()/outPt.w());
+                draw->addPoint(newPt);
+                if (!norms.empty())
+                {
+                    const Point3d &norm = norms[vert];
+                    // Note: Not the right way to transform normals
+                    Vector4d projNorm = mat * Eigen::Vector4d(norm.x(),norm.y(),norm.z(),0.0);
+                    Point3d newNorm(projNorm.x(),projNorm.y(),projNorm.z());
+                    newNorm.normalize();
+                    draw->addNormal(newNorm);
+                }
+                if (texId > 0)
+                    draw->addTexCoord(0,texCoords[vert]);
+                if (!colors.empty() && !colorOverride)
+                    draw->addColor(colors[vert]);
             }
-            if (texId > 0)
-                draw->addTexCoord(0,texCoords[tri.verts[jj]]);
-            if (!colors.empty() && !colorOverride)
-                draw->addColor(colors[tri.verts[jj]]);
+            drawTri.verts[jj] = drawVert[vert];
         }
         
-        draw->addTriangle(BasicDrawable::Triangle(baseVert,baseVert+1,baseVert+2));
+        draw->addTriangle(drawTri);
     }
 }
     
@@ -662,6 +1259,12 @@ SimpleIdentity GeometryManager::addGeometry(std::vector<GeometryRaw> &geom,const
     
 /// Add geometry we're planning to reuse (as a model, for example)
 SimpleIdentity GeometryManager::addBaseGeometry(std::vector<GeometryRaw> &geom,ChangeSet &changes)
+{
+    return addBaseGeometry(geom,1,0.0,changes);
+}
+    
+/// Add geometry we're planning to reuse, along with simplified versions for instances that are far away
+SimpleIdentity GeometryManager::addBaseGeometry(std::vector<GeometryRaw> &geom,int numLods,float lodSize,ChangeSet &changes)
 {
     GeomSceneRep *sceneRep = new GeomSceneRep();
     
@@ -692,29 +1295,83 @@ SimpleIdentity GeometryManager::addBaseGeometry(std::vector<GeometryRaw> &geom,C
         }
     }
 
+    // Instances are placed by their origin, so that's what the radius is around
+    Point3d extent(0.0,0.0,0.0);
+    for (GeometryRaw &raw : geom)
+    {
+        if (raw.pts.empty())
+            continue;
+        Point3d rawLL,rawUR;
+        raw.calcBounds(rawLL, rawUR);
+        for (unsigned int ii=0;ii<3;ii++)
+            extent[ii] = std::max(extent[ii],std::max(std::abs(rawLL[ii]),std::abs(rawUR[ii])));
+    }
+    sceneRep->radius = extent.norm();
+    
+    // Simplified versions of the geometry, each with about a quarter the triangles of the last
+    std::vector<std::vector<GeometryRaw>> lodGeom;
+    if (numLods > 1 && lodSize > 0.0 && sceneRep->radius > 0.0)
+    {
+        lodGeom.reserve(numLods-1);
+        const std::vector<GeometryRaw> *prevGeom = &geom;
+        for (int lod=1;lod<numLods;lod++)
+        {
+            // Level n is used below lodSize/2^(n-1) pixels, so keep the error to about a pixel there
+            double maxError = sceneRep->radius * (1<<lod) / lodSize;
+            std::vector<GeometryRaw> newGeom(prevGeom->size());
+            int prevTris = 0, newTris = 0;
+            for (unsigned int ii=0;ii<prevGeom->size();ii++)
+            {
+                const GeometryRaw &raw = (*prevGeom)[ii];
+                raw.simplify((int)raw.triangles.size()/4,maxError,newGeom[ii]);
+                prevTris += raw.triangles.size();
+                newTris += newGeom[ii].triangles.size();
+            }
+            
+            // Not worth another level if it didn't get much simpler
+            if (newTris > 0.75*prevTris)
+                break;
+            lodGeom.push_back(newGeom);
+            prevGeom = &lodGeom.back();
+        }
+    }
+    int numLevels = 1 + (int)lodGeom.size();
+    if (numLevels > 1)
+    {
+        sceneRep->lodDrawIDs.resize(numLevels);
+        sceneRep->lodSize = lodSize;
+    }
+
     // Instance the geometry once for now
     Matrix4d instMat = Matrix4d::Identity();
     
-    // Convert the sorted lists of geometry into drawables
-    for (unsigned int jj=0;jj<sortedGeom.size();jj++)
+    // Convert the sorted lists of geometry into drawables, for each level
+    for (int lod=0;lod<numLevels;lod++)
     {
-        std::vector<GeometryRaw *> &sg = sortedGeom[jj];
-        for (unsigned int kk=0;kk<sg.size();kk++)
+        for (unsigned int jj=0;jj<sortedGeom.size();jj++)
         {
-            std::vector<BasicDrawable *> draws;
-            GeometryRaw *raw = sg[kk];
-            raw->buildDrawables(draws,instMat,NULL,nil);
-            
-            // Set the various parameters and store the drawables created
-            for (unsigned int ll=0;ll<draws.size();ll++)
+            std::vector<GeometryRaw *> &sg = sortedGeom[jj];
+            for (unsigned int kk=0;kk<sg.size();kk++)
             {
-                BasicDrawable *draw = draws[ll];
-                draw->setType((raw->type == WhirlyKitGeometryLines ? GL_LINES : GL_TRIANGLES));
-                draw->setOnOff(false);
-                draw->setRequestZBuffer(true);
-                draw->setWriteZBuffer(true);
-                sceneRep->drawIDs.insert(draw->getId());
-                changes.push_back(new AddDrawableReq(draw));
+                std::vector<BasicDrawable *> draws;
+                GeometryRaw *raw = sg[kk];
+                if (lod > 0)
+                    raw = &lodGeom[lod-1][raw - &geom[0]];
+                raw->buildDrawables(draws,instMat,NULL,nil);
+                
+                // Set the various parameters and store the drawables created
+                for (unsigned int ll=0;ll<draws.size();ll++)
+                {
+                    BasicDrawable *draw = draws[ll];
+                    draw->setType((raw->type == WhirlyKitGeometryLines ? GL_LINES : GL_TRIANGLES));
+                    draw->setOnOff(false);
+                    draw->setRequestZBuffer(true);
+                    draw->setWriteZBuffer(true);
+                    sceneRep->drawIDs.insert(draw->getId());
+                    if (numLevels > 1)
+                        sceneRep->lodDrawIDs[lod].insert(draw->getId());
+                    changes.push_back(new AddDrawableReq(draw));
+                }
             }
         }
     }
@@ -793,25 +1450,37 @@ SimpleIdentity GeometryManager::addGeometryInstances(SimpleIdentity baseGeomID,c
         }
     }
 
-    // Instance each of the drawables in the base
-    for (SimpleIdentity baseDrawID : baseSceneRep->drawIDs)
+    // Instance each of the drawables in the base.  With simplified versions, each level
+    //  gets all the instances and picks out the ones that are the right size as it draws.
+    int numLevels = std::max((int)baseSceneRep->lodDrawIDs.size(),1);
+    for (int lod=0;lod<numLevels;lod++)
     {
-        BasicDrawableInstance *drawInst = new BasicDrawableInstance("GeometryManager",baseDrawID,BasicDrawableInstance::LocalStyle);
-        [geomInfo setupBasicDrawableInstance:drawInst];
-        //                    draw->setColor([geomInfo.color asRGBAColor]);
-        drawInst->setRequestZBuffer(true);
-        drawInst->setWriteZBuffer(true);
-        drawInst->addInstances(singleInsts);
-        if (geomInfo.programID != EmptyIdentity)
-            drawInst->setProgram(geomInfo.programID);
-        if (hasMotion)
+        const SimpleIDSet &baseDrawIDs = baseSceneRep->lodDrawIDs.empty() ? baseSceneRep->drawIDs : baseSceneRep->lodDrawIDs[lod];
+        for (SimpleIdentity baseDrawID : baseDrawIDs)
         {
-            drawInst->setStartTime(startTime);
-            drawInst->setIsMoving(true);
+            BasicDrawableInstance *drawInst = new BasicDrawableInstance("GeometryManager",baseDrawID,BasicDrawableInstance::LocalStyle);
+            [geomInfo setupBasicDrawableInstance:drawInst];
+            //                    draw->setColor([geomInfo.color asRGBAColor]);
+            drawInst->setRequestZBuffer(true);
+            drawInst->setWriteZBuffer(true);
+            drawInst->addInstances(singleInsts);
+            if (geomInfo.programID != EmptyIdentity)
+                drawInst->setProgram(geomInfo.programID);
+            if (hasMotion)
+            {
+                drawInst->setStartTime(startTime);
+                drawInst->setIsMoving(true);
+            }
+            if (numLevels > 1)
+            {
+                float maxSize = lod == 0 ? MAXFLOAT : baseSceneRep->lodSize / (1<<(lod-1));
+                float minSize = lod == numLevels-1 ? 0.0 : baseSceneRep->lodSize / (1<<lod);
+                drawInst->setInstanceLod(baseSceneRep->radius, minSize, maxSize);
+            }
+            
+            sceneRep->drawIDs.insert(drawInst->getId());
+            changes.push_back(new AddDrawableReq(drawInst));
         }
-        
-        sceneRep->drawIDs.insert(drawInst->getId());
-        changes.push_back(new AddDrawableReq(drawInst));
     }
 
     SimpleIdentity geomID = sceneRep->getId();
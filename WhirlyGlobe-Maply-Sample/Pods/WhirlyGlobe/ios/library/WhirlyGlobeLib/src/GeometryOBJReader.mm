@@ -19,6 +19,8 @@
  */
 
 #import <stdio.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
 #import "GeometryOBJReader.h"
 
 namespace WhirlyKit
@@ -162,219 +164,463 @@ bool GeometryModelOBJ::parseMaterials(FILE *fp)
     return success;
 }
 
-bool GeometryModelOBJ::parse(FILE *fp)
+// Chunks smaller than this aren't worth a thread
+static const size_t MinOBJChunkSize = 1024*1024;
+static const int MaxOBJChunks = 16;
+
+// Powers of ten that are exact as doubles
+static const double ExactPowersOf10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+// Copy the token out and let strtod sort it out
+static double SlowParseDouble(const char *tok,const char *end)
 {
-    bool success = true;
-    Group *activeGroup = NULL;
-    int activeMtl = -1;
+    char buf[128];
+    size_t len = std::min((size_t)(end-tok),sizeof(buf)-1);
+    memcpy(buf,tok,len);
+    buf[len] = 0;
     
-    char line[2048],origLine[2048],tmpTok[2048];
-    int lineNo = 0;
+    return strtod(buf,NULL);
+}
+
+// Parse a number in the common formats directly.  Anything odd goes through strtod.
+// The fast path is only exact when the mantissa and the power of 10 are both exact doubles,
+//  so more than 15 significant digits or a big exponent go the slow way too.
+static double ParseDouble(const char *tok,const char *end)
+{
+    const char *p = tok;
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
     
-    while (fgets(origLine, 2047, fp))
+    uint64_t mant = 0;
+    int exp10 = 0, numDigits = 0;
+    bool anyDigits = false;
+    for (;p < end && *p >= '0' && *p <= '9';p++)
     {
-        lineNo++;
-        strcpy(line,origLine);
-        int lineLen = (int)strlen(line);
-
-        // Empty line
-        if (lineLen == 0 || line[0] == '\n')
-            continue;
-        // Comment
-        if (line[0] == '#')
-            continue;
-        // Chop off a \r
-        if (line[lineLen-1]  == '\r')
+        anyDigits = true;
+        if (numDigits < 18)
         {
-            line[lineLen-1] = 0;
-            lineLen--;
+            mant = mant*10 + (*p-'0');
+            if (mant)
+                numDigits++;
+        } else
+            exp10++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++;p < end && *p >= '0' && *p <= '9';p++)
+        {
+            anyDigits = true;
+            if (numDigits < 18)
+            {
+                mant = mant*10 + (*p-'0');
+                if (mant)
+                    numDigits++;
+                exp10--;
+            }
         }
-        
-        std::vector<char *> toks;
-        // Parse the various tokens into an array
-        char *tok = NULL;
-        char *ptr = line;
-        char *next = NULL;
-        while ( (tok = strtok_r(ptr, " \t\n\r", &next)) )
+    }
+    if (!anyDigits)
+        return SlowParseDouble(tok,end);
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool expNeg = false;
+        if (p < end && (*p == '-' || *p == '+'))
         {
-            toks.push_back(tok);
-            ptr = next;
+            expNeg = (*p == '-');
+            p++;
+        }
+        int expVal = 0;
+        bool anyExp = false;
+        for (;p < end && *p >= '0' && *p <= '9';p++)
+        {
+            anyExp = true;
+            if (expVal < 10000)
+                expVal = expVal*10 + (*p-'0');
         }
+        if (!anyExp)
+            return SlowParseDouble(tok,end);
+        exp10 += expNeg ? -expVal : expVal;
+    }
+    if (p != end || numDigits > 15 || exp10 < -22 || exp10 > 22)
+        return SlowParseDouble(tok,end);
+    
+    double val = (double)mant;
+    if (exp10 < 0)
+        val /= ExactPowersOf10[-exp10];
+    else if (exp10 > 0)
+        val *= ExactPowersOf10[exp10];
+    
+    return neg ? -val : val;
+}
+
+// Same as atoi, but bounded
+static int ParseInt(const char *p,const char *end)
+{
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
+    int val = 0;
+    for (;p < end && *p >= '0' && *p <= '9';p++)
+        val = val*10 + (*p-'0');
+    
+    return neg ? -val : val;
+}
+
+static inline bool IsOBJSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Split a line into whitespace separated tokens
+static int TokenizeOBJLine(const char *p,const char *end,const char **tokStarts,const char **tokEnds,int maxToks)
+{
+    int numToks = 0;
+    while (p < end && numToks < maxToks)
+    {
+        while (p < end && IsOBJSpace(*p))
+            p++;
+        if (p >= end)
+            break;
+        tokStarts[numToks] = p;
+        while (p < end && !IsOBJSpace(*p))
+            p++;
+        tokEnds[numToks++] = p;
+    }
+    
+    return numToks;
+}
+
+static inline bool OBJKeyIs(const char *tok,const char *tokEnd,const char *key)
+{
+    size_t len = strlen(key);
+    return (size_t)(tokEnd-tok) == len && !strncmp(tok,key,len);
+}
+
+typedef enum {OBJMtlLib,OBJUseMtl,OBJGroup} OBJDirectiveType;
+
+// Results of parsing a range of lines.  Anything order dependent is recorded for later.
+class GeometryModelOBJ::Chunk
+{
+public:
+    Chunk() : success(true) { }
+    
+    // Directives that change state, and which face they come before
+    class Directive
+    {
+    public:
+        OBJDirectiveType type;
+        size_t beforeFace;
+        std::string arg;
+        std::string fullLine;
+    };
+    
+    std::vector<Point3d> verts;
+    std::vector<Point2d> texCoords;
+    std::vector<Point3d> norms;
+    std::vector<Face> faces;
+    std::vector<Directive> directives;
+    bool success;
+};
+
+void GeometryModelOBJ::parseChunk(const char *data,const char *end,Chunk &chunk)
+{
+    // Faces can be long, but the other lines are short
+    static const int MaxToks = 1024;
+    const char *tokStarts[MaxToks],*tokEnds[MaxToks];
+    
+    const char *ptr = data;
+    while (ptr < end)
+    {
+        const char *lineEnd = (const char *)memchr(ptr, '\n', end-ptr);
+        if (!lineEnd)
+            lineEnd = end;
+        const char *line = ptr;
+        ptr = lineEnd+1;
         
-        if (toks.empty())
+        // Empty line or comment
+        if (line == lineEnd || line[0] == '#')
             continue;
         
-        char *key = toks[0];
-        if (!strcmp(key,"mtllib"))
+        int numToks = TokenizeOBJLine(line, lineEnd, tokStarts, tokEnds, MaxToks);
+        if (numToks == 0)
+            continue;
+        const char *key = tokStarts[0], *keyEnd = tokEnds[0];
+        
+        if (OBJKeyIs(key,keyEnd,"v"))
         {
-            if (toks.size() < 2)
+            // Regular vertex
+            if (numToks < 4)
             {
-                success = false;
+                chunk.success = false;
                 break;
             }
-
-            // The full name of the material file might contain spaces
-            strcpy(line,origLine);
-            strtok_r(line," \t\n\r", &next);
-            char *mtlFile = strtok_r(next,"\n\r", &next);
-            
-            if (!mtlFile)
+            chunk.verts.push_back(Point3d(ParseDouble(tokStarts[1],tokEnds[1]),ParseDouble(tokStarts[2],tokEnds[2]),ParseDouble(tokStarts[3],tokEnds[3])));
+        } else if (OBJKeyIs(key,keyEnd,"vn"))
+        {
+            // Normal
+            if (numToks < 4)
             {
-                success = false;
+                chunk.success = false;
                 break;
             }
-            
-            // Load the model
-            NSString *fullPath = [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:[NSString stringWithFormat:@"%s",mtlFile]];
-            FILE *mtlFP = fopen([fullPath cStringUsingEncoding:NSASCIIStringEncoding],"r");
-            if (!mtlFP)
+            chunk.norms.push_back(Point3d(ParseDouble(tokStarts[1],tokEnds[1]),ParseDouble(tokStarts[2],tokEnds[2]),ParseDouble(tokStarts[3],tokEnds[3])));
+        } else if (OBJKeyIs(key,keyEnd,"vt"))
+        {
+            // Texture coordinate
+            if (numToks < 3)
             {
-                success = false;
+                chunk.success = false;
                 break;
             }
-            if (!parseMaterials(mtlFP))
+            chunk.texCoords.push_back(Point2d(ParseDouble(tokStarts[1],tokEnds[1]),ParseDouble(tokStarts[2],tokEnds[2])));
+        } else if (OBJKeyIs(key,keyEnd,"f"))
+        {
+            // Face
+            if (numToks < 2)
             {
-                success = false;
+                chunk.success = false;
                 break;
             }
+            chunk.faces.resize(chunk.faces.size()+1);
+            Face &face = chunk.faces.back();
+            face.verts.resize(numToks-1);
+            
+            // We've either got numbers or collections of numbers separated by /
+            for (int ii=1;ii<numToks;ii++)
+            {
+                Vertex &vert = face.verts[ii-1];
+                const char *vertToks[3],*vertToksEnd[3];
+                int numVertToks = 0;
+                bool emptyTexCoord = false;
+                const char *tp = tokStarts[ii];
+                while (tp < tokEnds[ii] && numVertToks < 3)
+                {
+                    if (*tp == '/')
+                    {
+                        if (tp+1 < tokEnds[ii] && tp[1] == '/')
+                            emptyTexCoord = true;
+                        tp++;
+                        continue;
+                    }
+                    vertToks[numVertToks] = tp;
+                    while (tp < tokEnds[ii] && *tp != '/')
+                        tp++;
+                    vertToksEnd[numVertToks++] = tp;
+                }
+                if (numVertToks == 0)
+                {
+                    chunk.success = false;
+                    break;
+                }
+
+                vert.vert = ParseInt(vertToks[0],vertToksEnd[0]);
+                if (emptyTexCoord)
+                {
+                    if (numVertToks >= 2)
+                        vert.norm = ParseInt(vertToks[1],vertToksEnd[1]);
+                } else {
+                    if (numVertToks >= 2)
+                        vert.texCoord = ParseInt(vertToks[1],vertToksEnd[1]);
+                    if (numVertToks >= 3)
+                        vert.norm = ParseInt(vertToks[2],vertToksEnd[2]);
+                }
+            }
+            if (!chunk.success)
+                break;
+        } else if (OBJKeyIs(key,keyEnd,"mtllib") || OBJKeyIs(key,keyEnd,"usemtl") || OBJKeyIs(key,keyEnd,"g"))
+        {
+            // These depend on what came before, so they're sorted out in order later
+            Chunk::Directive directive;
+            directive.type = OBJKeyIs(key,keyEnd,"mtllib") ? OBJMtlLib : (OBJKeyIs(key,keyEnd,"usemtl") ? OBJUseMtl : OBJGroup);
+            directive.beforeFace = chunk.faces.size();
+            if (numToks > 1)
+                directive.arg = std::string(tokStarts[1],tokEnds[1]-tokStarts[1]);
+            directive.fullLine = std::string(line,lineEnd-line);
+            chunk.directives.push_back(directive);
+        }
+    }
+}
+
+bool GeometryModelOBJ::applyDirective(int which,const std::string &arg,const std::string &fullLine,Group *&activeGroup,int &activeMtl)
+{
+    switch (which)
+    {
+        case OBJMtlLib:
+        {
+            if (arg.empty())
+                return false;
+            
+            // The full name of the material file might contain spaces
+            size_t nameStart = fullLine.find_first_of(" \t");
+            if (nameStart == std::string::npos)
+                return false;
+            nameStart = fullLine.find_first_not_of(" \t",nameStart);
+            size_t nameEnd = fullLine.find_last_not_of(" \t\r\n");
+            if (nameStart == std::string::npos || nameEnd < nameStart)
+                return false;
+            std::string mtlFile = fullLine.substr(nameStart,nameEnd-nameStart+1);
+            
+            // Load the model
+            NSString *fullPath = [[[NSBundle mainBundle] resourcePath] stringByAppendingPathComponent:[NSString stringWithFormat:@"%s",mtlFile.c_str()]];
+            FILE *mtlFP = fopen([fullPath cStringUsingEncoding:NSASCIIStringEncoding],"r");
+            if (!mtlFP)
+                return false;
+            mtlFiles.push_back([fullPath fileSystemRepresentation]);
+            bool mtlSuccess = parseMaterials(mtlFP);
             fclose(mtlFP);
-        } else if (!strcmp(key,"usemtl"))
+            return mtlSuccess;
+        }
+            break;
+        case OBJUseMtl:
         {
             // Use a pre-defined material
-            if (toks.size() < 1 || !activeGroup)
-            {
-                success = false;
-                break;
-            }
+            if (arg.empty() || !activeGroup)
+                return false;
             
             // Look for the material
-            std::string mtlName = toks[1];
             int whichMtl = -1;
             for (unsigned int ii=0;ii<materials.size();ii++)
             {
-                if (mtlName == materials[ii].name)
+                if (arg == materials[ii].name)
                 {
                     whichMtl = ii;
                     break;
                 }
             }
-
-            // Note: Allowing materials we don't recognize
+            
+            // Note: Not allowing materials we don't recognize
             if (whichMtl < 0)
-            {
-                success = false;
-                break;
-            }
+                return false;
             activeMtl = whichMtl;
-        } else if (!strcmp(key,"g"))
-        {
+        }
+            break;
+        case OBJGroup:
             groups.resize(groups.size()+1);
             activeGroup = &groups.back();
-            
-            if (toks.size() > 1)
-            {
-                activeGroup->name = toks[1];
-            } else {
-                activeGroup->name = "";
-            }
-        } else if (!strcmp(key,"f"))
+            activeGroup->name = arg;
+            break;
+    }
+    
+    return true;
+}
+
+bool GeometryModelOBJ::parse(FILE *fp)
+{
+    int fd = fileno(fp);
+    struct stat statBuf;
+    if (fd < 0 || fstat(fd, &statBuf) != 0)
+        return false;
+    size_t len = statBuf.st_size;
+    if (len == 0)
+        return true;
+    
+    // Map the whole thing in and let the VM system worry about it
+    void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        // Fall back to reading it
+        std::vector<char> buf(len);
+        fseek(fp, 0, SEEK_SET);
+        if (fread(&buf[0], 1, len, fp) != len)
+            return false;
+        return parse(&buf[0],len);
+    }
+    madvise(data, len, MADV_SEQUENTIAL);
+    
+    bool success = parse((const char *)data,len);
+    munmap(data, len);
+    
+    return success;
+}
+
+bool GeometryModelOBJ::parse(const char *data,size_t len)
+{
+    // Split on line boundaries
+    int numChunks = (int)std::min(std::max(len / MinOBJChunkSize,(size_t)1),(size_t)MaxOBJChunks);
+    std::vector<const char *> chunkStarts;
+    chunkStarts.push_back(data);
+    for (int ii=1;ii<numChunks;ii++)
+    {
+        const char *split = std::max(data + (len * ii) / numChunks,chunkStarts.back());
+        const char *lineEnd = (const char *)memchr(split, '\n', data+len-split);
+        if (!lineEnd)
+            break;
+        chunkStarts.push_back(lineEnd+1);
+    }
+    chunkStarts.push_back(data+len);
+    numChunks = (int)chunkStarts.size()-1;
+    
+    // The numeric work happens in parallel
+    std::vector<Chunk> chunks(numChunks);
+    if (numChunks == 1)
+        parseChunk(chunkStarts[0], chunkStarts[1], chunks[0]);
+    else {
+        Chunk *chunksPtr = &chunks[0];
+        const char **chunkStartsPtr = &chunkStarts[0];
+        dispatch_apply(numChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t which){
+            parseChunk(chunkStartsPtr[which], chunkStartsPtr[which+1], chunksPtr[which]);
+        });
+    }
+    
+    // Then we stitch it together in file order
+    size_t numVerts = verts.size(), numTexCoords = texCoords.size(), numNorms = norms.size();
+    for (const Chunk &chunk : chunks)
+    {
+        numVerts += chunk.verts.size();
+        numTexCoords += chunk.texCoords.size();
+        numNorms += chunk.norms.size();
+    }
+    verts.reserve(numVerts);
+    texCoords.reserve(numTexCoords);
+    norms.reserve(numNorms);
+    
+    bool success = true;
+    Group *activeGroup = NULL;
+    int activeMtl = -1;
+    for (Chunk &chunk : chunks)
+    {
+        verts.insert(verts.end(),chunk.verts.begin(),chunk.verts.end());
+        texCoords.insert(texCoords.end(),chunk.texCoords.begin(),chunk.texCoords.end());
+        norms.insert(norms.end(),chunk.norms.begin(),chunk.norms.end());
+        
+        unsigned int di = 0;
+        for (size_t fi=0;fi<=chunk.faces.size() && success;fi++)
         {
-            // Face
-            if (toks.size() < 2)
+            for (;di < chunk.directives.size() && chunk.directives[di].beforeFace <= fi;di++)
             {
-                success = false;
-                break;
-            }
-            activeGroup->faces.resize(activeGroup->faces.size()+1);
-            Face &face = activeGroup->faces.back();
-            face.mtlID = activeMtl;
-            
-            // We've either got numbers of collections of numbers separated by /
-            for (unsigned int ii=1;ii<toks.size();ii++)
-            {
-                strcpy(tmpTok, toks[ii]);
-                bool emptyTexCoord = false;
-                if (strstr(tmpTok,"//"))
-                    emptyTexCoord = true;
-                
-                std::vector<char *> vertToks;
-                char *vertTok = NULL;
-                char *vertPtr = tmpTok;
-                char *vertNext = NULL;
-                while ( (vertTok = strtok_r(vertPtr, "/", &vertNext)) )
-                {
-                    vertToks.push_back(vertTok);
-                    vertPtr = vertNext;
-                }
-                
-                face.verts.resize(face.verts.size()+1);
-                Vertex &vert = face.verts.back();
-                if (vertToks.size() == 0)
+                const Chunk::Directive &directive = chunk.directives[di];
+                if (!applyDirective(directive.type, directive.arg, directive.fullLine, activeGroup, activeMtl))
                 {
                     success = false;
                     break;
                 }
-                if (vertToks.size() >= 1)
-                {
-                    vert.vert = atoi(vertToks[0]);
-                }
-                if (emptyTexCoord)
-                {
-                    if (vertToks.size() >= 2)
-                        vert.norm = atoi(vertToks[1]);
-                } else {
-                    if (vertToks.size() >= 2)
-                    {
-                        vert.texCoord = atoi(vertToks[1]);
-                    }
-                    if (vertToks.size() >= 3)
-                    {
-                        vert.norm = atoi(vertToks[2]);
-                    }
-                }
             }
-        } else if (!strcmp(key,"v"))
-        {
-            // Regular vertex
-            if (toks.size() < 4)
-            {
-                success = false;
+            if (!success || fi == chunk.faces.size())
                 break;
-            }
             
-            verts.resize(verts.size()+1);
-            Point3d &vert = verts.back();
-            vert.x() = atof(toks[1]);
-            vert.y() = atof(toks[2]);
-            vert.z() = atof(toks[3]);
-        } else if (!strcmp(key,"vn"))
-        {
-            // Normal
-            if (toks.size() < 4)
+            // Faces before any group go in an unnamed one
+            if (!activeGroup)
             {
-                success = false;
-                break;
-            }
-            
-            norms.resize(norms.size()+1);
-            Point3d &norm = norms.back();
-            norm.x() = atof(toks[1]);
-            norm.y() = atof(toks[2]);
-            norm.z() = atof(toks[3]);
-        } else if (!strcmp(key,"vt"))
-        {
-            // Texture coordinate
-            if (toks.size() < 3)
-            {
-                success = false;
-                break;
+                groups.resize(groups.size()+1);
+                activeGroup = &groups.back();
             }
-            
-            texCoords.resize(texCoords.size()+1);
-            Point2d &texCoord = texCoords.back();
-            texCoord.x() = atof(toks[1]);
-            texCoord.y() = atof(toks[2]);
+            Face &face = chunk.faces[fi];
+            face.mtlID = activeMtl;
+            activeGroup->faces.push_back(std::move(face));
         }
+        
+        if (!chunk.success)
+            success = false;
+        if (!success)
+            break;
     }
     
     // Link up the materials
@@ -545,4 +791,245 @@ void GeometryModelOBJ::toRawGeometry(std::vector<std::string> &textures,std::vec
     }
 }
 
+// Identifies a geometry cache file and its version
+static const uint32_t GeometryCacheMagic = 0x52474b57;  // "WKGR"
+// Version 2: models are run through GeometryRaw::optimize() before they're written
+// Version 3: the files the model depends on are listed up front
+static const uint32_t GeometryCacheVersion = 3;
+
+// Append plain data to the cache buffer
+template<typename T> static void CacheWrite(std::vector<unsigned char> &buf,const T *vals,size_t num)
+{
+    if (num == 0)
+        return;
+    size_t pos = buf.size();
+    buf.resize(pos + sizeof(T)*num);
+    memcpy(&buf[pos], vals, sizeof(T)*num);
+}
+
+template<typename T> static void CacheWrite(std::vector<unsigned char> &buf,T val)
+{
+    CacheWrite(buf,&val,1);
+}
+
+static void CacheWriteStrings(std::vector<unsigned char> &buf,const std::vector<std::string> &strs)
+{
+    CacheWrite(buf,(uint32_t)strs.size());
+    for (const std::string &str : strs)
+    {
+        CacheWrite(buf,(uint32_t)str.size());
+        CacheWrite(buf,str.c_str(),str.size());
+    }
+}
+
+bool WriteGeometryRawCache(const std::string &fileName,const std::vector<std::string> &depFiles,const std::vector<std::string> &textures,const std::vector<GeometryRaw> &rawGeom)
+{
+    std::vector<unsigned char> buf;
+    CacheWrite(buf,GeometryCacheMagic);
+    CacheWrite(buf,GeometryCacheVersion);
+    
+    CacheWriteStrings(buf,depFiles);
+    CacheWriteStrings(buf,textures);
+    
+    CacheWrite(buf,(uint32_t)rawGeom.size());
+    for (const GeometryRaw &geom : rawGeom)
+    {
+        CacheWrite(buf,(int32_t)geom.type);
+        CacheWrite(buf,(int64_t)geom.texId);
+        CacheWrite(buf,(uint32_t)geom.pts.size());
+        CacheWrite(buf,(uint32_t)geom.norms.size());
+        CacheWrite(buf,(uint32_t)geom.texCoords.size());
+        CacheWrite(buf,(uint32_t)geom.colors.size());
+        CacheWrite(buf,(uint32_t)geom.triangles.size());
+        
+        // Positions stay as doubles, but normals and such don't need it
+        for (const Point3d &pt : geom.pts)
+        {
+            double vals[3] = {pt.x(),pt.y(),pt.z()};
+            CacheWrite(buf,vals,3);
+        }
+        for (const Point3d &norm : geom.norms)
+        {
+            float vals[3] = {(float)norm.x(),(float)norm.y(),(float)norm.z()};
+            CacheWrite(buf,vals,3);
+        }
+        for (const TexCoord &texCoord : geom.texCoords)
+        {
+            float vals[2] = {texCoord.u(),texCoord.v()};
+            CacheWrite(buf,vals,2);
+        }
+        for (const RGBAColor &color : geom.colors)
+        {
+            unsigned char vals[4] = {color.r,color.g,color.b,color.a};
+            CacheWrite(buf,vals,4);
+        }
+        for (const GeometryRaw::RawTriangle &tri : geom.triangles)
+        {
+            int32_t vals[3] = {tri.verts[0],tri.verts[1],tri.verts[2]};
+            CacheWrite(buf,vals,3);
+        }
+    }
+    
+    // Write to the side and move it into place so a reader never sees half a file
+    std::string tmpName = fileName + ".tmp";
+    FILE *fp = fopen(tmpName.c_str(),"wb");
+    if (!fp)
+        return false;
+    bool success = fwrite(&buf[0], 1, buf.size(), fp) == buf.size();
+    success = (fclose(fp) == 0) && success;
+    if (success)
+        success = rename(tmpName.c_str(),fileName.c_str()) == 0;
+    if (!success)
+        unlink(tmpName.c_str());
+    
+    return success;
+}
+
+// Reads plain data out of the cache buffer, keeping track of overruns
+class GeometryCacheReader
+{
+public:
+    GeometryCacheReader(const unsigned char *data,size_t len) : ptr(data), end(data+len), valid(true) { }
+    
+    template<typename T> bool read(T *vals,size_t num)
+    {
+        size_t size = sizeof(T)*num;
+        if (!valid || (size_t)(end-ptr) < size)
+        {
+            valid = false;
+            return false;
+        }
+        memcpy(vals, ptr, size);
+        ptr += size;
+        return true;
+    }
+    
+    template<typename T> T read()
+    {
+        T val = 0;
+        read(&val,1);
+        return val;
+    }
+    
+    bool readStrings(std::vector<std::string> &strs)
+    {
+        uint32_t num = read<uint32_t>();
+        if (!valid || (size_t)num*sizeof(uint32_t) > (size_t)(end-ptr))
+        {
+            valid = false;
+            return false;
+        }
+        strs.resize(num);
+        for (std::string &str : strs)
+        {
+            uint32_t len = read<uint32_t>();
+            if (!valid || len > (size_t)(end-ptr))
+            {
+                valid = false;
+                return false;
+            }
+            str.assign((const char *)ptr,len);
+            ptr += len;
+        }
+        return true;
+    }
+    
+    const unsigned char *ptr,*end;
+    bool valid;
+};
+
+bool ReadGeometryRawCache(const std::string &fileName,std::vector<std::string> &depFiles,std::vector<std::string> &textures,std::vector<GeometryRaw> &rawGeom)
+{
+    FILE *fp = fopen(fileName.c_str(),"rb");
+    if (!fp)
+        return false;
+    
+    // Pull the whole thing in at once
+    struct stat statBuf;
+    if (fstat(fileno(fp), &statBuf) != 0 || statBuf.st_size < 2*sizeof(uint32_t))
+    {
+        fclose(fp);
+        return false;
+    }
+    std::vector<unsigned char> buf(statBuf.st_size);
+    bool readOk = fread(&buf[0], 1, buf.size(), fp) == buf.size();
+    fclose(fp);
+    if (!readOk)
+        return false;
+    
+    GeometryCacheReader reader(&buf[0],buf.size());
+    if (reader.read<uint32_t>() != GeometryCacheMagic || reader.read<uint32_t>() != GeometryCacheVersion)
+        return false;
+    
+    std::vector<std::string> newDepFiles,newTextures;
+    if (!reader.readStrings(newDepFiles) || !reader.readStrings(newTextures))
+        return false;
+    
+    uint32_t numGeom = reader.read<uint32_t>();
+    if (!reader.valid || (size_t)numGeom*(sizeof(int32_t)+sizeof(int64_t)+5*sizeof(uint32_t)) > (size_t)(reader.end-reader.ptr))
+        return false;
+    std::vector<GeometryRaw> newGeom;
+    newGeom.reserve(numGeom);
+    for (unsigned int gi=0;gi<numGeom;gi++)
+    {
+        newGeom.resize(newGeom.size()+1);
+        GeometryRaw &geom = newGeom.back();
+        geom.type = (WhirlyKitGeometryRawType)reader.read<int32_t>();
+        geom.texId = reader.read<int64_t>();
+        uint32_t numPts = reader.read<uint32_t>();
+        uint32_t numNorms = reader.read<uint32_t>();
+        uint32_t numTexCoords = reader.read<uint32_t>();
+        uint32_t numColors = reader.read<uint32_t>();
+        uint32_t numTris = reader.read<uint32_t>();
+        // Make sure the counts are sane before we allocate anything
+        size_t needed = (size_t)numPts*3*sizeof(double) + (size_t)numNorms*3*sizeof(float) + (size_t)numTexCoords*2*sizeof(float) + (size_t)numColors*4 + (size_t)numTris*3*sizeof(int32_t);
+        if (!reader.valid || needed > (size_t)(reader.end-reader.ptr))
+            return false;
+        
+        geom.pts.resize(numPts);
+        for (Point3d &pt : geom.pts)
+        {
+            double vals[3];
+            reader.read(vals,3);
+            pt = Point3d(vals[0],vals[1],vals[2]);
+        }
+        geom.norms.resize(numNorms);
+        for (Point3d &norm : geom.norms)
+        {
+            float vals[3];
+            reader.read(vals,3);
+            norm = Point3d(vals[0],vals[1],vals[2]);
+        }
+        geom.texCoords.resize(numTexCoords);
+        for (TexCoord &texCoord : geom.texCoords)
+        {
+            float vals[2];
+            reader.read(vals,2);
+            texCoord = TexCoord(vals[0],vals[1]);
+        }
+        geom.colors.resize(numColors);
+        for (RGBAColor &color : geom.colors)
+        {
+            unsigned char vals[4];
+            reader.read(vals,4);
+            color = RGBAColor(vals[0],vals[1],vals[2],vals[3]);
+        }
+        geom.triangles.resize(numTris);
+        for (GeometryRaw::RawTriangle &tri : geom.triangles)
+        {
+            int32_t vals[3];
+            reader.read(vals,3);
+            tri = GeometryRaw::RawTriangle(vals[0],vals[1],vals[2]);
+        }
+    }
+    if (!reader.valid)
+        return false;
+    
+    depFiles = newDepFiles;
+    textures = newTextures;
+    rawGeom.insert(rawGeom.end(),newGeom.begin(),newGeom.end());
+    
+    return true;
+}
+
 }
@@ -0,0 +1,293 @@
+/*
+ *  ImageResample.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <math.h>
+#import <string.h>
+#import <algorithm>
+#import "ImageResample.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#define WK_RESAMPLE_NEON 1
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#define WK_RESAMPLE_SSE2 1
+#endif
+
+namespace WhirlyKit
+{
+
+static inline int ResampleClamp(int val,int minVal,int maxVal)
+{
+    return val < minVal ? minVal : (val > maxVal ? maxVal : val);
+}
+
+// Average each 2x2 block.  Works for any size, clamping at the edges.
+static void ImageDownsampleBoxScalar(const uint8_t *src,int srcWidth,int srcHeight,uint8_t *dest,int destWidth,int startX,int endX,int destY)
+{
+    int sy0 = std::min(2*destY,srcHeight-1), sy1 = std::min(2*destY+1,srcHeight-1);
+    const uint8_t *row0 = src + 4*sy0*srcWidth, *row1 = src + 4*sy1*srcWidth;
+    uint8_t *out = dest + 4*destY*destWidth;
+    for (int x=startX;x<endX;x++)
+    {
+        int sx0 = std::min(2*x,srcWidth-1), sx1 = std::min(2*x+1,srcWidth-1);
+        for (int c=0;c<4;c++)
+            out[4*x+c] = (uint8_t)((row0[4*sx0+c] + row0[4*sx1+c] + row1[4*sx0+c] + row1[4*sx1+c] + 2) >> 2);
+    }
+}
+
+static void ImageDownsampleBox(const uint8_t *src,int srcWidth,int srcHeight,uint8_t *dest,int destWidth,int destHeight)
+{
+    for (int y=0;y<destHeight;y++)
+    {
+        int x = 0;
+        // The vector versions want two full source rows
+        if (2*y+1 < srcHeight)
+        {
+            const uint8_t *row0 = src + 4*(2*y)*srcWidth, *row1 = row0 + 4*srcWidth;
+            uint8_t *out = dest + 4*y*destWidth;
+#if WK_RESAMPLE_NEON
+            for (;x+4<=destWidth && 2*x+8<=srcWidth;x+=4)
+            {
+                // Split even and odd pixels apart, then widen and add
+                uint32x4x2_t top = vld2q_u32((const uint32_t *)(row0+8*x));
+                uint32x4x2_t bot = vld2q_u32((const uint32_t *)(row1+8*x));
+                uint8x16_t topEven = vreinterpretq_u8_u32(top.val[0]), topOdd = vreinterpretq_u8_u32(top.val[1]);
+                uint8x16_t botEven = vreinterpretq_u8_u32(bot.val[0]), botOdd = vreinterpretq_u8_u32(bot.val[1]);
+                uint16x8_t sumLo = vaddq_u16(vaddl_u8(vget_low_u8(topEven),vget_low_u8(topOdd)),
+                                             vaddl_u8(vget_low_u8(botEven),vget_low_u8(botOdd)));
+                uint16x8_t sumHi = vaddq_u16(vaddl_u8(vget_high_u8(topEven),vget_high_u8(topOdd)),
+                                             vaddl_u8(vget_high_u8(botEven),vget_high_u8(botOdd)));
+                vst1q_u8(out+4*x,vcombine_u8(vrshrn_n_u16(sumLo,2),vrshrn_n_u16(sumHi,2)));
+            }
+#elif WK_RESAMPLE_SSE2
+            const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(2);
+            for (;x+2<=destWidth && 2*x+4<=srcWidth;x+=2)
+            {
+                __m128i top = _mm_loadu_si128((const __m128i *)(row0+8*x));
+                __m128i bot = _mm_loadu_si128((const __m128i *)(row1+8*x));
+                // Each of these is two pixels from the top plus two from the bottom
+                __m128i sumLo = _mm_add_epi16(_mm_unpacklo_epi8(top,zero),_mm_unpacklo_epi8(bot,zero));
+                __m128i sumHi = _mm_add_epi16(_mm_unpackhi_epi8(top,zero),_mm_unpackhi_epi8(bot,zero));
+                // Fold the neighboring pixels together
+                sumLo = _mm_add_epi16(sumLo,_mm_srli_si128(sumLo,8));
+                sumHi = _mm_add_epi16(sumHi,_mm_srli_si128(sumHi,8));
+                __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLo,sumHi),round),2);
+                _mm_storel_epi64((__m128i *)(out+4*x),_mm_packus_epi16(sum,sum));
+            }
+#endif
+        }
+        ImageDownsampleBoxScalar(src,srcWidth,srcHeight,dest,destWidth,x,destWidth,y);
+    }
+}
+
+// Kaiser windowed sinc for 2:1 reduction.  Six taps, centered between source pixels.
+static const int KaiserTaps = 6;
+
+// Zeroth order modified Bessel function, which the Kaiser window needs
+static double KaiserBessel0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k=1;k<20;k++)
+    {
+        term *= (x / (2.0*k)) * (x / (2.0*k));
+        sum += term;
+    }
+    return sum;
+}
+
+static std::vector<float> KaiserMakeWeights()
+{
+    const double alpha = 4.0, halfWidth = 3.0;
+    double total = 0.0;
+    double weights[KaiserTaps];
+    for (int ii=0;ii<KaiserTaps;ii++)
+    {
+        // Distance from the center in source pixels, scaled down to the destination
+        double dist = ii - (KaiserTaps-1)/2.0;
+        double x = dist / 2.0;
+        double sinc = x == 0.0 ? 1.0 : sin(M_PI*x) / (M_PI*x);
+        double ratio = dist / halfWidth;
+        double window = fabs(ratio) >= 1.0 ? 0.0 : KaiserBessel0(alpha * sqrt(1.0 - ratio*ratio)) / KaiserBessel0(alpha);
+        weights[ii] = sinc * window;
+        total += weights[ii];
+    }
+
+    std::vector<float> ret(KaiserTaps);
+    for (int ii=0;ii<KaiserTaps;ii++)
+        ret[ii] = (float)(weights[ii] / total);
+    return ret;
+}
+
+// Built once, safely, on whichever loader thread gets here first
+static const float *KaiserGetWeights()
+{
+    static const std::vector<float> weights = KaiserMakeWeights();
+    return &weights[0];
+}
+
+static void ImageDownsampleKaiser(const uint8_t *src,int srcWidth,int srcHeight,uint8_t *dest,int destWidth,int destHeight)
+{
+    const float *KaiserWeights = KaiserGetWeights();
+
+    // Horizontal pass into floats, then vertical
+    std::vector<float> horiz(destWidth*srcHeight*4);
+    for (int y=0;y<srcHeight;y++)
+    {
+        const uint8_t *row = src + 4*y*srcWidth;
+        float *out = &horiz[4*y*destWidth];
+        for (int x=0;x<destWidth;x++)
+        {
+            float sum[4] = {0.0,0.0,0.0,0.0};
+            for (int tt=0;tt<KaiserTaps;tt++)
+            {
+                int sx = ResampleClamp(2*x - (KaiserTaps/2-1) + tt,0,srcWidth-1);
+                for (int c=0;c<4;c++)
+                    sum[c] += KaiserWeights[tt] * row[4*sx+c];
+            }
+            memcpy(&out[4*x],sum,sizeof(sum));
+        }
+    }
+
+    for (int y=0;y<destHeight;y++)
+    {
+        uint8_t *out = dest + 4*y*destWidth;
+        int rows[KaiserTaps];
+        for (int tt=0;tt<KaiserTaps;tt++)
+            rows[tt] = ResampleClamp(2*y - (KaiserTaps/2-1) + tt,0,srcHeight-1);
+        for (int x=0;x<destWidth;x++)
+        {
+            float sum[4] = {0.0,0.0,0.0,0.0};
+            for (int tt=0;tt<KaiserTaps;tt++)
+            {
+                const float *in = &horiz[4*(rows[tt]*destWidth+x)];
+                for (int c=0;c<4;c++)
+                    sum[c] += KaiserWeights[tt] * in[c];
+            }
+            // The negative lobes can overshoot.  Colors are premultiplied, so keep them under alpha too.
+            int alpha = ResampleClamp((int)(sum[3] + 0.5f),0,255);
+            for (int c=0;c<3;c++)
+                out[4*x+c] = (uint8_t)ResampleClamp((int)(sum[c] + 0.5f),0,alpha);
+            out[4*x+3] = (uint8_t)alpha;
+        }
+    }
+}
+
+void ImageDownsample(const uint8_t *srcPixels,int srcWidth,int srcHeight,uint8_t *destPixels,WKMipFilter filter)
+{
+    int destWidth = std::max(srcWidth/2,1), destHeight = std::max(srcHeight/2,1);
+    switch (filter)
+    {
+        case WKMipFilterBox:
+            ImageDownsampleBox(srcPixels,srcWidth,srcHeight,destPixels,destWidth,destHeight);
+            break;
+        case WKMipFilterKaiser:
+            ImageDownsampleKaiser(srcPixels,srcWidth,srcHeight,destPixels,destWidth,destHeight);
+            break;
+    }
+}
+
+void ImageBuildMipChain(NSData *pixels,int width,int height,WKMipFilter filter,std::vector<NSData *> &levels)
+{
+    if ([pixels length] < (size_t)width*height*4)
+        return;
+
+    const uint8_t *src = (const uint8_t *)[pixels bytes];
+    while (width > 1 || height > 1)
+    {
+        int destWidth = std::max(width/2,1), destHeight = std::max(height/2,1);
+        NSMutableData *level = [[NSMutableData alloc] initWithLength:destWidth*destHeight*4];
+        ImageDownsample(src,width,height,(uint8_t *)[level mutableBytes],filter);
+        levels.push_back(level);
+
+        src = (const uint8_t *)[level bytes];
+        width = destWidth;  height = destHeight;
+    }
+}
+
+NSData *ImageResampleWithBorder(const uint8_t *srcPixels,int srcWidth,int srcHeight,int destWidth,int destHeight,int border)
+{
+    if (!srcPixels || srcWidth <= 0 || srcHeight <= 0 || destWidth <= 0 || destHeight <= 0)
+        return nil;
+    int innerWidth = destWidth-2*border, innerHeight = destHeight-2*border;
+    if (border < 0 || innerWidth <= 0 || innerHeight <= 0)
+    {
+        border = 0;
+        innerWidth = destWidth;  innerHeight = destHeight;
+    }
+
+    // Bilinear gets blocky past 2:1, so box filter down until we're within range
+    NSMutableData *reduced = nil;
+    while (srcWidth >= 2*innerWidth && srcHeight >= 2*innerHeight)
+    {
+        int halfWidth = srcWidth/2, halfHeight = srcHeight/2;
+        NSMutableData *half = [[NSMutableData alloc] initWithLength:halfWidth*halfHeight*4];
+        ImageDownsampleBox(srcPixels,srcWidth,srcHeight,(uint8_t *)[half mutableBytes],halfWidth,halfHeight);
+        reduced = half;
+        srcPixels = (const uint8_t *)[reduced bytes];
+        srcWidth = halfWidth;  srcHeight = halfHeight;
+    }
+
+    // Where each column lands in the source, with 8 bits of fraction.
+    // Columns in the border clamp to the edge, which repeats the edge pixels.
+    std::vector<int> srcX0(destWidth),srcX1(destWidth),fracX(destWidth);
+    float scaleX = srcWidth / (float)innerWidth, scaleY = srcHeight / (float)innerHeight;
+    for (int x=0;x<destWidth;x++)
+    {
+        int ix = ResampleClamp(x-border,0,innerWidth-1);
+        float sx = std::max((ix + 0.5f) * scaleX - 0.5f,0.f);
+        srcX0[x] = std::min((int)sx,srcWidth-1);
+        srcX1[x] = std::min(srcX0[x]+1,srcWidth-1);
+        fracX[x] = (int)((sx - srcX0[x]) * 256.f);
+    }
+
+    NSMutableData *retData = [[NSMutableData alloc] initWithLength:destWidth*destHeight*4];
+    uint8_t *dest = (uint8_t *)[retData mutableBytes];
+    for (int y=border;y<destHeight-border;y++)
+    {
+        float sy = std::max((y - border + 0.5f) * scaleY - 0.5f,0.f);
+        int y0 = std::min((int)sy,srcHeight-1), y1 = std::min(y0+1,srcHeight-1);
+        int fracY = (int)((sy - y0) * 256.f);
+        const uint8_t *row0 = srcPixels + 4*y0*srcWidth, *row1 = srcPixels + 4*y1*srcWidth;
+        uint8_t *out = dest + 4*y*destWidth;
+        for (int x=0;x<destWidth;x++)
+        {
+            const uint8_t *p00 = row0 + 4*srcX0[x], *p01 = row0 + 4*srcX1[x];
+            const uint8_t *p10 = row1 + 4*srcX0[x], *p11 = row1 + 4*srcX1[x];
+            int fx = fracX[x];
+            for (int c=0;c<4;c++)
+            {
+                int top = p00[c] * (256-fx) + p01[c] * fx;
+                int bot = p10[c] * (256-fx) + p11[c] * fx;
+                out[4*x+c] = (uint8_t)((top * (256-fracY) + bot * fracY + 32768) >> 16);
+            }
+        }
+    }
+
+    // Rows in the top and bottom borders are copies of the first and last real rows
+    for (int y=0;y<border;y++)
+    {
+        memcpy(dest + 4*y*destWidth,dest + 4*border*destWidth,4*destWidth);
+        memcpy(dest + 4*(destHeight-1-y)*destWidth,dest + 4*(destHeight-1-border)*destWidth,4*destWidth);
+    }
+
+    return retData;
+}
+
+}
@@ -26,6 +26,7 @@
 #import "NSDictionary+Stuff.h"
 #import "UIColor+Stuff.h"
 #import "ScreenSpaceBuilder.h"
+#import "DefaultShaderPrograms.h"
 
 using namespace Eigen;
 using namespace WhirlyKit;
@@ -61,6 +62,7 @@ namespace WhirlyKit
     _shadowSize = [desc floatForKey:@"shadowSize" default:0.0];
     _outlineSize = [desc floatForKey:@"outlineSize" default:0.0];
     _outlineColor = [desc objectForKey:@"outlineColor" checkType:[UIColor class] default:[UIColor blackColor]];
+    _sdf = [desc boolForKey:@"sdf" default:false];
     if (![labelJustify compare:@"middle"])
         _labelJustify = WhirlyKitLabelMiddle;
     else {
@@ -161,6 +163,16 @@ typedef std::map<SimpleIdentity,BasicDrawable *> DrawableIDMap;
         // We set this if the color is embedded in the "font"
         bool embeddedColor = false;
         
+        // Distance field glyphs need their own shader
+        bool sdf = _labelInfo.sdf && _labelInfo.screenObject;
+        SimpleIdentity sdfProgID = EmptyIdentity;
+        if (sdf)
+        {
+            sdfProgID = _scene->getProgramIDBySceneName(label.hasMotion ? kToolkitDefaultScreenSpaceSDFMotionProgram : kToolkitDefaultScreenSpaceSDFProgram);
+            if (sdfProgID == EmptyIdentity)
+                sdf = false;
+        }
+        
         // Break the string into lines and convert the lines to DrawableStrings
         std::vector<DrawableString *> drawStrs;
         NSArray *strings = [label.text componentsSeparatedByString:@"\n"];
@@ -174,14 +186,14 @@ typedef std::map<SimpleIdentity,BasicDrawable *> DrawableIDMap;
             NSMutableAttributedString *attrStr = [[NSMutableAttributedString alloc] initWithString:text];
             NSInteger strLen = [attrStr length];
             [attrStr addAttribute:NSFontAttributeName value:theFont range:NSMakeRange(0, strLen)];
-            if (theOutlineSize > 0.0)
+            if (theOutlineSize > 0.0 && !sdf)
             {
                 embeddedColor = true;
                 [attrStr addAttribute:kOutlineAttributeSize value:[NSNumber numberWithFloat:theOutlineSize] range:NSMakeRange(0, strLen)];
                 [attrStr addAttribute:kOutlineAttributeColor value:theOutlineColor range:NSMakeRange(0, strLen)];
                 [attrStr addAttribute:NSForegroundColorAttributeName value:theTextColor range:NSMakeRange(0, strLen)];
             }
-            DrawableString *drawStr = [_fontTexManager addString:attrStr changes:_changeRequests];
+            DrawableString *drawStr = [_fontTexManager addString:attrStr sdf:sdf changes:_changeRequests];
             if (!drawStr)
                 continue;
             Mbr thisMbr = drawStr->mbr;
@@ -416,16 +428,26 @@ typedef std::map<SimpleIdentity,BasicDrawable *> DrawableIDMap;
                         break;
                 }
 
+                // Distance field edge and smoothing, where half a point is 0.25/sdfSpread
+                bool sdfStr = sdf && drawStr->sdfSpread > 0.0;
+                float sdfSmooth = sdfStr ? 0.25 / drawStr->sdfSpread : 0.0;
+
                 // Turn the glyph polys into simple geometry
-                // We do this in a weird order to stick the shadow underneath
-                for (int ss=((theShadowSize > 0.0) ? 0: 1);ss<2;ss++)
+                // We do this in a weird order to stick the shadow and outline underneath
+                for (int ss=((theShadowSize > 0.0) ? 0: 1);ss<3;ss++)
                 {
-                    Point2d soff;
+                    Point2d soff(0,0);
                     RGBAColor color;
-                    if (ss == 1)
+                    float sdfEdge = 0.5;
+                    if (ss == 2)
                     {
-                        soff = Point2d(0,0);
                         color = embeddedColor ? [[UIColor whiteColor] asRGBAColor] : [theTextColor asRGBAColor];
+                    } else if (ss == 1) {
+                        // Distance field outlines are just a lower edge, drawn under the text
+                        if (!sdfStr || theOutlineSize <= 0.0)
+                            continue;
+                        color = [theOutlineColor asRGBAColor];
+                        sdfEdge = std::max(0.5 - theOutlineSize / (2.0 * drawStr->sdfSpread), 0.05);
                     } else {
                         soff = Point2d(theShadowSize,theShadowSize);
                         color = [theShadowColor asRGBAColor];
@@ -435,7 +457,9 @@ typedef std::map<SimpleIdentity,BasicDrawable *> DrawableIDMap;
                         DrawableString::Rect &poly = drawStr->glyphPolys[ii];
                         // Note: Ignoring the desired size in favor of the font size
                         ScreenSpaceObject::ConvexGeometry smGeom;
-                        smGeom.progID = _labelInfo.programID;
+                        smGeom.progID = sdfStr ? sdfProgID : _labelInfo.programID;
+                        if (sdfStr)
+                            smGeom.vertexAttrs.insert(SingleVertexAttribute(a_sdfParamsNameID,sdfEdge,sdfSmooth));
                         smGeom.coords.push_back(Point2d(poly.pts[1].x()+label.screenOffset.width,poly.pts[0].y()+label.screenOffset.height+ offsetY) + soff + iconOff + justifyOff + lineOff);
                         smGeom.texCoords.push_back(TexCoord(poly.texCoords[1].u(),poly.texCoords[0].v()));
 
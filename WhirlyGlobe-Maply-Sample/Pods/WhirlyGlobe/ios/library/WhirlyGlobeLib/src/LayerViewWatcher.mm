@@ -322,6 +322,8 @@ public:
     _fullMatrices.resize(offMatrices.size());
     _invFullMatrices.resize(offMatrices.size());
     _fullNormalMatrices.resize(offMatrices.size());
+    _fullProjMatrices.resize(offMatrices.size());
+    _invFullProjMatrices.resize(offMatrices.size());
     _projMatrix = [view calcProjectionMatrix:Point2f(renderer.framebufferWidth,renderer.framebufferHeight) margin:0.0];
     _invProjMatrix = _projMatrix.inverse();
     Eigen::Matrix4d baseViewMatrix = [view calcViewMatrix];
@@ -332,6 +334,8 @@ public:
         _fullMatrices[ii] = _viewMatrices[ii] * _modelMatrix;
         _invFullMatrices[ii] = _fullMatrices[ii].inverse();
         _fullNormalMatrices[ii] = _fullMatrices[ii].inverse().transpose();
+        _fullProjMatrices[ii] = _projMatrix * _fullMatrices[ii];
+        _invFullProjMatrices[ii] = _invFullMatrices[ii] * _invProjMatrix;
     }
     
     _fieldOfView = view.fieldOfView;
@@ -807,6 +807,7 @@ bool TileBuilder::buildTile(Quadtree::NodeInfo *nodeInfo,BasicDrawable **draw,Ba
                 {
                     newTex->setFormat(glFormat);
                     newTex->setSingleByteSource(singleByteSource);
+                    newTex->compressETC2();
                     (*texs)[ii] = newTex;
                 } else {
                     texturesClean = false;
@@ -892,6 +893,8 @@ Texture *TileBuilder::buildTexture(WhirlyKitLoadedImage *loadImage)
     {
         newTex->setFormat(glFormat);
         newTex->setSingleByteSource(singleByteSource);
+        // Raw images headed for an ETC2 atlas get encoded here on the layer thread
+        newTex->compressETC2();
     }
     
     return newTex;
@@ -19,6 +19,8 @@
  */
 
 #import "LoadedTileNew.h"
+#import "SphericalMercator.h"
+#import "FlatMath.h"
 
 using namespace Eigen;
 
@@ -35,6 +37,43 @@ TileGeomSettings::TileGeomSettings()
 {
 }
     
+TileGeomGrid::TileGeomGrid(int sampleX,int sampleY)
+    : sampleX(sampleX), sampleY(sampleY)
+{
+    texCoords.resize((sampleX+1)*(sampleY+1));
+    for (unsigned int iy=0;iy<sampleY+1;iy++)
+        for (unsigned int ix=0;ix<sampleX+1;ix++)
+            texCoords[iy*(sampleX+1)+ix] = TexCoord(ix/(float)sampleX,1.0-(iy/(float)sampleY));
+    
+    // Two triangles per cell
+    tris.reserve(2*sampleX*sampleY);
+    for (unsigned int iy=0;iy<sampleY;iy++)
+    {
+        for (unsigned int ix=0;ix<sampleX;ix++)
+        {
+            BasicDrawable::Triangle triA,triB;
+            triA.verts[0] = (iy+1)*(sampleX+1)+ix;
+            triA.verts[1] = iy*(sampleX+1)+ix;
+            triA.verts[2] = (iy+1)*(sampleX+1)+(ix+1);
+            triB.verts[0] = triA.verts[2];
+            triB.verts[1] = triA.verts[1];
+            triB.verts[2] = iy*(sampleX+1)+(ix+1);
+            tris.push_back(triA);
+            tris.push_back(triB);
+        }
+    }
+    
+    // Bottom, top, left and right edges for the skirts
+    for (int ix=0;ix<=sampleX;ix++)
+        skirtEdges[0].push_back(ix);
+    for (int ix=sampleX;ix>=0;ix--)
+        skirtEdges[1].push_back(sampleY*(sampleX+1)+ix);
+    for (int iy=sampleY;iy>=0;iy--)
+        skirtEdges[2].push_back((sampleX+1)*iy+0);
+    for (int iy=0;iy<=sampleY;iy++)
+        skirtEdges[3].push_back((sampleX+1)*iy+sampleX);
+}
+    
 LoadedTileNew::LoadedTileNew(QuadTreeNew::ImportantNode &ident)
     : ident(ident), enabled(false)
 {
@@ -56,19 +95,24 @@ void LoadedTileNew::makeDrawables(TileGeomManager *geomManage,TileGeomSettings &
     Point2d texOffset(0.0,0.0);   // Note: Not using this
     
     // Snap to the designated area
+    bool clipped = false;
     if (theMbr.ll().x() < geomManage->mbr.ll().x()) {
         theMbr.ll().x() = geomManage->mbr.ll().x();
+        clipped = true;
     }
     if (theMbr.ur().x() > geomManage->mbr.ur().x()) {
         texScale.x() = (geomManage->mbr.ur().x()-theMbr.ll().x())/(theMbr.ur().x()-theMbr.ll().x());
         theMbr.ur().x() = geomManage->mbr.ur().x();
+        clipped = true;
     }
     if (theMbr.ll().y() < geomManage->mbr.ll().y()) {
         theMbr.ll().y() = geomManage->mbr.ll().y();
+        clipped = true;
     }
     if (theMbr.ur().y() > geomManage->mbr.ur().y()) {
         texScale.y() = (geomManage->mbr.ur().y()-theMbr.ll().y())/(theMbr.ur().y()-theMbr.ll().y());
         theMbr.ur().y() = geomManage->mbr.ur().y();
+        clipped = true;
     }
     
     // Calculate a center for the tile
@@ -185,71 +229,42 @@ void LoadedTileNew::makeDrawables(TileGeomManager *geomManage,TileGeomSettings &
             }
     } else {
         chunk->setType(GL_TRIANGLES);
-        // Generate point, texture coords, and normals
-        std::vector<Point3d> locs((sphereTessX+1)*(sphereTessY+1));
-        std::vector<float> elevs;
-        if (geomSettings.includeElev)
-            elevs.resize((sphereTessX+1)*(sphereTessY+1));
-        std::vector<TexCoord> texCoords((sphereTessX+1)*(sphereTessY+1));
-        for (unsigned int iy=0;iy<sphereTessY+1;iy++)
+        // The triangles and texture coordinates are shared with every other tile with this sampling
+        TileGeomGridRef grid = geomManage->getGrid(sphereTessX,sphereTessY);
+        
+        // Generate points, texture coords, and normals
+        std::vector<Point3d> locs;
+        geomManage->buildTileLocs(ident,theMbr,clipped,sphereTessX,sphereTessY,locs);
+        std::vector<TexCoord> scaledTexCoords;
+        if (texScale.x() != 1.0 || texScale.y() != 1.0)
         {
-            for (unsigned int ix=0;ix<sphereTessX+1;ix++)
-            {
-                float locZ = 0.0;
-                Point3d loc3D = geomManage->coordAdapter->localToDisplay(CoordSystemConvert3d(geomManage->coordSys,sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),locZ)));
-                if (geomManage->coordAdapter->isFlat())
-                    loc3D.z() = locZ;
-                
-                // Use Z priority to sort the levels
-                //                    if (singleLevel != -1)
-                //                        loc3D.z() = (drawPriority + nodeInfo->ident.level * 0.01)/10000;
-                
-                locs[iy*(sphereTessX+1)+ix] = loc3D;
-                
-                // Do the texture coordinate seperately
-                TexCoord texCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
-                texCoords[iy*(sphereTessX+1)+ix] = texCoord;
-            }
+            scaledTexCoords.resize((sphereTessX+1)*(sphereTessY+1));
+            for (unsigned int iy=0;iy<sphereTessY+1;iy++)
+                for (unsigned int ix=0;ix<sphereTessX+1;ix++)
+                    scaledTexCoords[iy*(sphereTessX+1)+ix] = TexCoord(ix*texIncr.x(),1.0-(iy*texIncr.y()));
         }
+        const std::vector<TexCoord> &texCoords = scaledTexCoords.empty() ? grid->texCoords : scaledTexCoords;
         
         // Without elevation data we can share the vertices
-        for (unsigned int iy=0;iy<sphereTessY+1;iy++)
+        bool isFlat = geomManage->coordAdapter->isFlat();
+        for (unsigned int ii=0;ii<locs.size();ii++)
         {
-            for (unsigned int ix=0;ix<sphereTessX+1;ix++)
-            {
-                Point3d &loc3D = locs[iy*(sphereTessX+1)+ix];
-                
-                // And the normal
-                Point3d norm3D;
-                if (geomManage->coordAdapter->isFlat())
-                    norm3D = geomManage->coordAdapter->normalForLocal(loc3D);
-                else
-                    norm3D = loc3D;
-                
-                TexCoord &texCoord = texCoords[iy*(sphereTessX+1)+ix];
-                
-                chunk->addPoint(Point3d(loc3D-chunkMidDisp));
-                chunk->addNormal(norm3D);
-                chunk->addTexCoord(-1,texCoord);
-            }
+            const Point3d &loc3D = locs[ii];
+            
+            // And the normal
+            Point3d norm3D;
+            if (isFlat)
+                norm3D = geomManage->coordAdapter->normalForLocal(loc3D);
+            else
+                norm3D = loc3D;
+            
+            chunk->addPoint(Point3d(loc3D-chunkMidDisp));
+            chunk->addNormal(norm3D);
+            chunk->addTexCoord(-1,texCoords[ii]);
         }
         
-        // Two triangles per cell
-        for (unsigned int iy=0;iy<sphereTessY;iy++)
-        {
-            for (unsigned int ix=0;ix<sphereTessX;ix++)
-            {
-                BasicDrawable::Triangle triA,triB;
-                triA.verts[0] = (iy+1)*(sphereTessX+1)+ix;
-                triA.verts[1] = iy*(sphereTessX+1)+ix;
-                triA.verts[2] = (iy+1)*(sphereTessX+1)+(ix+1);
-                triB.verts[0] = triA.verts[2];
-                triB.verts[1] = triA.verts[1];
-                triB.verts[2] = iy*(sphereTessX+1)+(ix+1);
-                chunk->addTriangle(triA);
-                chunk->addTriangle(triB);
-            }
-        }
+        for (const BasicDrawable::Triangle &tri : grid->tris)
+            chunk->addTriangle(tri);
         
         if (geomManage->buildSkirts && !geomManage->coordAdapter->isFlat())
         {
@@ -277,42 +292,20 @@ void LoadedTileNew::makeDrawables(TileGeomManager *geomManage,TileGeomSettings &
             //  disparity
             float skirtFactor = 1.0 - 0.2 / (1<<ident.level);
             
-            // Bottom skirt
+            // Bottom, top, left and right skirts
             std::vector<Point3d> skirtLocs;
             std::vector<TexCoord> skirtTexCoords;
-            for (unsigned int ix=0;ix<=sphereTessX;ix++)
-            {
-                skirtLocs.push_back(locs[ix]);
-                skirtTexCoords.push_back(texCoords[ix]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // Top skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int ix=sphereTessX;ix>=0;ix--)
+            for (unsigned int ii=0;ii<4;ii++)
             {
-                skirtLocs.push_back(locs[(sphereTessY)*(sphereTessX+1)+ix]);
-                skirtTexCoords.push_back(texCoords[(sphereTessY)*(sphereTessX+1)+ix]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // Left skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int iy=sphereTessY;iy>=0;iy--)
-            {
-                skirtLocs.push_back(locs[(sphereTessX+1)*iy+0]);
-                skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+0]);
-            }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
-            // right skirt
-            skirtLocs.clear();
-            skirtTexCoords.clear();
-            for (int iy=0;iy<=sphereTessY;iy++)
-            {
-                skirtLocs.push_back(locs[(sphereTessX+1)*iy+(sphereTessX)]);
-                skirtTexCoords.push_back(texCoords[(sphereTessX+1)*iy+(sphereTessX)]);
+                skirtLocs.clear();
+                skirtTexCoords.clear();
+                for (int which : grid->skirtEdges[ii])
+                {
+                    skirtLocs.push_back(locs[which]);
+                    skirtTexCoords.push_back(texCoords[which]);
+                }
+                buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
             }
-            buildSkirt(skirtChunk,skirtLocs,skirtTexCoords,skirtFactor,false,chunkMidDisp);
         }
         
         if (geomManage->coverPoles && !geomManage->coordAdapter->isFlat())
@@ -519,6 +512,91 @@ void TileGeomManager::cleanup(ChangeSet &changes)
     }
     
     tileMap.clear();
+    rowTemplates.clear();
+}
+    
+TileGeomGridRef TileGeomManager::getGrid(int sampleX,int sampleY)
+{
+    auto key = std::make_pair(sampleX,sampleY);
+    auto it = grids.find(key);
+    if (it != grids.end())
+        return it->second;
+    
+    TileGeomGridRef grid(new TileGeomGrid(sampleX,sampleY));
+    grids[key] = grid;
+    
+    return grid;
+}
+    
+// Once we've seen this many rows we start over, rather than grow forever
+static const int MaxRowTemplates = 512;
+
+void TileGeomManager::buildTileLocs(const QuadTreeNew::Node &ident,const MbrD &theMbr,bool clipped,int sampleX,int sampleY,std::vector<Point3d> &locs)
+{
+    CoordSystem *sceneCoordSys = coordAdapter->getCoordSystem();
+    Point2d chunkLL(theMbr.ll().x(),theMbr.ll().y());
+    Point2d incr((theMbr.ur().x()-theMbr.ll().x())/sampleX,(theMbr.ur().y()-theMbr.ll().y())/sampleY);
+    locs.resize((sampleX+1)*(sampleY+1));
+    
+    if (coordAdapter->isFlat())
+    {
+        // Flat display adapters are just an offset and scale, so we only need to project the corner
+        if (coordSys->isSameAs(sceneCoordSys))
+        {
+            Point3d org = coordAdapter->localToDisplay(Point3d(chunkLL.x(),chunkLL.y(),0.0));
+            Point3d dx = coordAdapter->localToDisplay(Point3d(chunkLL.x()+incr.x(),chunkLL.y(),0.0)) - org;
+            Point3d dy = coordAdapter->localToDisplay(Point3d(chunkLL.x(),chunkLL.y()+incr.y(),0.0)) - org;
+            for (unsigned int iy=0;iy<sampleY+1;iy++)
+                for (unsigned int ix=0;ix<sampleX+1;ix++)
+                {
+                    Point3d loc3D = org + (double)ix*dx + (double)iy*dy;
+                    loc3D.z() = 0.0;
+                    locs[iy*(sampleX+1)+ix] = loc3D;
+                }
+            return;
+        }
+    } else if (!clipped &&
+               (dynamic_cast<SphericalMercatorCoordSystem *>(coordSys) || dynamic_cast<PlateCarreeCoordSystem *>(coordSys) ||
+                dynamic_cast<GeoCoordSystem *>(coordSys)))
+    {
+        // X is longitude in these systems, so a tile is a copy of its neighbor rotated around the pole
+        double lon = coordSys->localToGeographic(Point3d(chunkLL.x(),chunkLL.y(),0.0)).x();
+        auto key = std::make_tuple(ident.level,ident.y,sampleX,sampleY);
+        auto it = rowTemplates.find(key);
+        if (it != rowTemplates.end() && it->second.locs.size() == locs.size())
+        {
+            double ang = lon - it->second.lon;
+            double sinAng = sin(ang), cosAng = cos(ang);
+            const std::vector<Point3d> &srcLocs = it->second.locs;
+            for (unsigned int ii=0;ii<srcLocs.size();ii++)
+            {
+                const Point3d &pt = srcLocs[ii];
+                locs[ii] = Point3d(pt.x()*cosAng - pt.y()*sinAng,pt.x()*sinAng + pt.y()*cosAng,pt.z());
+            }
+            return;
+        }
+        
+        for (unsigned int iy=0;iy<sampleY+1;iy++)
+            for (unsigned int ix=0;ix<sampleX+1;ix++)
+                locs[iy*(sampleX+1)+ix] = coordAdapter->localToDisplay(CoordSystemConvert3d(coordSys,sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),0.0)));
+        
+        if (rowTemplates.size() >= MaxRowTemplates)
+            rowTemplates.clear();
+        RowTemplate &rowTemplate = rowTemplates[key];
+        rowTemplate.lon = lon;
+        rowTemplate.locs = locs;
+        return;
+    }
+    
+    // Run the whole coordinate chain for each vertex
+    for (unsigned int iy=0;iy<sampleY+1;iy++)
+        for (unsigned int ix=0;ix<sampleX+1;ix++)
+        {
+            Point3d loc3D = coordAdapter->localToDisplay(CoordSystemConvert3d(coordSys,sceneCoordSys,Point3d(chunkLL.x()+ix*incr.x(),chunkLL.y()+iy*incr.y(),0.0)));
+            if (coordAdapter->isFlat())
+                loc3D.z() = 0.0;
+            locs[iy*(sampleX+1)+ix] = loc3D;
+        }
 }
     
 std::vector<LoadedTileNewRef> TileGeomManager::getTiles(const QuadTreeNew::NodeSet &tiles)
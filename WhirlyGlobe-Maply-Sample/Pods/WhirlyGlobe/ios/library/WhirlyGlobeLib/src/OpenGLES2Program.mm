@@ -19,6 +19,8 @@
  */
 
 #import <string>
+#import <mutex>
+#import <set>
 #import "OpenGLES2Program.h"
 #import "Lighting.h"
 #import "GLUtils.h"
@@ -29,6 +31,16 @@ using namespace Eigen;
 namespace WhirlyKit
 {
     
+// Programs that declare u_octNormals.  Drawables are set up on other threads, so this is locked.
+static std::mutex octProgramsLock;
+static std::set<SimpleIdentity> octPrograms;
+    
+bool ProgramDecodesOctNormals(SimpleIdentity progID)
+{
+    std::lock_guard<std::mutex> guardLock(octProgramsLock);
+    return octPrograms.find(progID) != octPrograms.end();
+}
+    
 OpenGLES2Program::OpenGLES2Program()
     : lightsLastUpdated(0.0)
 {
@@ -374,6 +386,12 @@ OpenGLES2Program::OpenGLES2Program(const std::string &inName,const std::string &
         uniforms[uni->nameID] = uni;
     }
     CheckGLError("OpenGLES2Program: glGetActiveUniform");
+    
+    if (uniforms.find(u_OctNormalsNameID) != uniforms.end())
+    {
+        std::lock_guard<std::mutex> guardLock(octProgramsLock);
+        octPrograms.insert(getId());
+    }
 
     // Convert the attributes into a more useful form
     GLint numAttr;
@@ -394,6 +412,11 @@ OpenGLES2Program::OpenGLES2Program(const std::string &inName,const std::string &
 // Clean up oustanding OpenGL resources
 void OpenGLES2Program::cleanUp()
 {
+    {
+        std::lock_guard<std::mutex> guardLock(octProgramsLock);
+        octPrograms.erase(getId());
+    }
+    
     if (program)
     {
         glDeleteProgram(program);
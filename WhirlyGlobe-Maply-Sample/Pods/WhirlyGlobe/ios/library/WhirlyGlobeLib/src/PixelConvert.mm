@@ -0,0 +1,507 @@
+/*
+ *  PixelConvert.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <pthread.h>
+#import <stdlib.h>
+#import <vector>
+#import <map>
+#import "PixelConvert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#import <arm_neon.h>
+#define WK_PIXEL_NEON 1
+#elif defined(__SSE2__)
+#import <emmintrin.h>
+#define WK_PIXEL_SSE2 1
+#endif
+
+namespace WhirlyKit
+{
+
+// Plain versions.  These do the tail end of every run and are the reference for the benchmark.
+
+static void PixelConvertRGBATo565Scalar(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        uint32_t r = ((pix >> 0)  & 0xFF) >> 3;
+        uint32_t g = ((pix >> 8)  & 0xFF) >> 2;
+        uint32_t b = ((pix >> 16) & 0xFF) >> 3;
+        outPixels[ii] = (r << 11) | (g << 5) | (b << 0);
+    }
+}
+
+static void PixelConvertRGBATo4444Scalar(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        uint32_t r = ((pix >> 0)  & 0xFF) >> 4;
+        uint32_t g = ((pix >> 8)  & 0xFF) >> 4;
+        uint32_t b = ((pix >> 16) & 0xFF) >> 4;
+        uint32_t a = ((pix >> 24) & 0xFF) >> 4;
+        outPixels[ii] = (r << 12) | (g << 8) | (b << 4) | (a << 0);
+    }
+}
+
+static void PixelConvertRGBATo5551Scalar(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        uint32_t r = ((pix >> 0)  & 0xFF) >> 3;
+        uint32_t g = ((pix >> 8)  & 0xFF) >> 3;
+        uint32_t b = ((pix >> 16) & 0xFF) >> 3;
+        uint32_t a = ((pix >> 24) & 0xFF) >> 7;
+        outPixels[ii] = (r << 11) | (g << 6) | (b << 1) | (a << 0);
+    }
+}
+
+static void PixelExtractChannelScalar(const uint32_t *inPixels,uint8_t *outPixels,size_t count,int channel)
+{
+    int shift = 8*channel;
+    for (size_t ii=0;ii<count;ii++)
+        outPixels[ii] = (inPixels[ii] >> shift) & 0xFF;
+}
+
+static void PixelAverageRGBScalar(const uint32_t *inPixels,uint8_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        int sum = (int)((pix >> 0) & 0xFF) + (int)((pix >> 8) & 0xFF) + (int)((pix >> 16) & 0xFF);
+        outPixels[ii] = (uint8_t)(sum / 3);
+    }
+}
+
+static void PixelExtractRGScalar(const uint32_t *inPixels,uint8_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        outPixels[2*ii] = (pix >> 0) & 0xFF;
+        outPixels[2*ii+1] = (pix >> 8) & 0xFF;
+    }
+}
+
+// c*a/255, rounded
+static inline uint32_t PremultiplyChannel(uint32_t c,uint32_t a)
+{
+    uint32_t t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static void PixelPremultiplyScalar(const uint32_t *inPixels,uint32_t *outPixels,size_t count)
+{
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        uint32_t a = (pix >> 24) & 0xFF;
+        uint32_t r = PremultiplyChannel((pix >> 0) & 0xFF,a);
+        uint32_t g = PremultiplyChannel((pix >> 8) & 0xFF,a);
+        uint32_t b = PremultiplyChannel((pix >> 16) & 0xFF,a);
+        outPixels[ii] = r | (g << 8) | (b << 16) | (a << 24);
+    }
+}
+
+static void PixelSwizzleScalar(const uint32_t *inPixels,uint32_t *outPixels,size_t count,const int order[4])
+{
+    int shift0 = 8*order[0], shift1 = 8*order[1], shift2 = 8*order[2], shift3 = 8*order[3];
+    for (size_t ii=0;ii<count;ii++)
+    {
+        uint32_t pix = inPixels[ii];
+        outPixels[ii] = ((pix >> shift0) & 0xFF) | (((pix >> shift1) & 0xFF) << 8) |
+                        (((pix >> shift2) & 0xFF) << 16) | (((pix >> shift3) & 0xFF) << 24);
+    }
+}
+
+#if WK_PIXEL_SSE2
+// Pack the low 16 bits of each 32 bit lane from two registers into one.
+// packs saturates, so sign extend the low half first to get the bits through unchanged.
+static inline __m128i PackLow16(__m128i a,__m128i b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a,16),16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b,16),16);
+    return _mm_packs_epi32(a,b);
+}
+#endif
+
+void PixelConvertRGBATo565(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    const uint8x16_t maskF8 = vdupq_n_u8(0xF8), mask1C = vdupq_n_u8(0x1C);
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint8x16x2_t out;
+        out.val[1] = vorrq_u8(vandq_u8(pix.val[0],maskF8),vshrq_n_u8(pix.val[1],5));
+        out.val[0] = vorrq_u8(vshlq_n_u8(vandq_u8(pix.val[1],mask1C),3),vshrq_n_u8(pix.val[2],3));
+        vst2q_u8((uint8_t *)(outPixels+ii),out);
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i maskR = _mm_set1_epi32(0xF8), maskG = _mm_set1_epi32(0x7E0), maskB = _mm_set1_epi32(0x1F);
+    for (;ii+8<=count;ii+=8)
+    {
+        __m128i pix[2] = {_mm_loadu_si128((const __m128i *)(inPixels+ii)),_mm_loadu_si128((const __m128i *)(inPixels+ii+4))};
+        __m128i out[2];
+        for (int jj=0;jj<2;jj++)
+            out[jj] = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(pix[jj],maskR),8),
+                                                _mm_and_si128(_mm_srli_epi32(pix[jj],5),maskG)),
+                                   _mm_and_si128(_mm_srli_epi32(pix[jj],19),maskB));
+        _mm_storeu_si128((__m128i *)(outPixels+ii),PackLow16(out[0],out[1]));
+    }
+#endif
+    PixelConvertRGBATo565Scalar(inPixels+ii,outPixels+ii,count-ii);
+}
+
+void PixelConvertRGBATo4444(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    const uint8x16_t maskF0 = vdupq_n_u8(0xF0);
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint8x16x2_t out;
+        out.val[1] = vorrq_u8(vandq_u8(pix.val[0],maskF0),vshrq_n_u8(pix.val[1],4));
+        out.val[0] = vorrq_u8(vandq_u8(pix.val[2],maskF0),vshrq_n_u8(pix.val[3],4));
+        vst2q_u8((uint8_t *)(outPixels+ii),out);
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i maskR = _mm_set1_epi32(0xF0), maskG = _mm_set1_epi32(0xF00), maskB = _mm_set1_epi32(0xF0);
+    for (;ii+8<=count;ii+=8)
+    {
+        __m128i pix[2] = {_mm_loadu_si128((const __m128i *)(inPixels+ii)),_mm_loadu_si128((const __m128i *)(inPixels+ii+4))};
+        __m128i out[2];
+        for (int jj=0;jj<2;jj++)
+            out[jj] = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(pix[jj],maskR),8),
+                                                _mm_and_si128(_mm_srli_epi32(pix[jj],4),maskG)),
+                                   _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pix[jj],16),maskB),
+                                                _mm_srli_epi32(pix[jj],28)));
+        _mm_storeu_si128((__m128i *)(outPixels+ii),PackLow16(out[0],out[1]));
+    }
+#endif
+    PixelConvertRGBATo4444Scalar(inPixels+ii,outPixels+ii,count-ii);
+}
+
+void PixelConvertRGBATo5551(const uint32_t *inPixels,uint16_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    const uint8x16_t maskF8 = vdupq_n_u8(0xF8), mask18 = vdupq_n_u8(0x18), mask3E = vdupq_n_u8(0x3E);
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint8x16x2_t out;
+        out.val[1] = vorrq_u8(vandq_u8(pix.val[0],maskF8),vshrq_n_u8(pix.val[1],5));
+        out.val[0] = vorrq_u8(vorrq_u8(vshlq_n_u8(vandq_u8(pix.val[1],mask18),3),
+                                       vandq_u8(vshrq_n_u8(pix.val[2],2),mask3E)),
+                              vshrq_n_u8(pix.val[3],7));
+        vst2q_u8((uint8_t *)(outPixels+ii),out);
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i maskR = _mm_set1_epi32(0xF8), maskG = _mm_set1_epi32(0x7C0), maskB = _mm_set1_epi32(0x3E);
+    for (;ii+8<=count;ii+=8)
+    {
+        __m128i pix[2] = {_mm_loadu_si128((const __m128i *)(inPixels+ii)),_mm_loadu_si128((const __m128i *)(inPixels+ii+4))};
+        __m128i out[2];
+        for (int jj=0;jj<2;jj++)
+            out[jj] = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(pix[jj],maskR),8),
+                                                _mm_and_si128(_mm_srli_epi32(pix[jj],5),maskG)),
+                                   _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pix[jj],18),maskB),
+                                                _mm_srli_epi32(pix[jj],31)));
+        _mm_storeu_si128((__m128i *)(outPixels+ii),PackLow16(out[0],out[1]));
+    }
+#endif
+    PixelConvertRGBATo5551Scalar(inPixels+ii,outPixels+ii,count-ii);
+}
+
+void PixelExtractChannel(const uint32_t *inPixels,uint8_t *outPixels,size_t count,int channel)
+{
+    if (channel < 0 || channel > 3)
+        return;
+
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        vst1q_u8(outPixels+ii,pix.val[channel]);
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i shift = _mm_cvtsi32_si128(8*channel);
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    for (;ii+16<=count;ii+=16)
+    {
+        __m128i vals[4];
+        for (int jj=0;jj<4;jj++)
+            vals[jj] = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i *)(inPixels+ii+4*jj)),shift),mask);
+        __m128i out = _mm_packus_epi16(_mm_packs_epi32(vals[0],vals[1]),_mm_packs_epi32(vals[2],vals[3]));
+        _mm_storeu_si128((__m128i *)(outPixels+ii),out);
+    }
+#endif
+    PixelExtractChannelScalar(inPixels+ii,outPixels+ii,count-ii,channel);
+}
+
+// Note: sum/3 is (sum*21846)>>16 for everything up to 3*255, which the vector versions rely on
+void PixelAverageRGB(const uint32_t *inPixels,uint8_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint16x8_t sumLo = vaddw_u8(vaddl_u8(vget_low_u8(pix.val[0]),vget_low_u8(pix.val[1])),vget_low_u8(pix.val[2]));
+        uint16x8_t sumHi = vaddw_u8(vaddl_u8(vget_high_u8(pix.val[0]),vget_high_u8(pix.val[1])),vget_high_u8(pix.val[2]));
+        // (2*sum*10923)>>16 is the same as (sum*21846)>>16
+        int16x8_t avgLo = vqdmulhq_n_s16(vreinterpretq_s16_u16(sumLo),10923);
+        int16x8_t avgHi = vqdmulhq_n_s16(vreinterpretq_s16_u16(sumHi),10923);
+        vst1q_u8(outPixels+ii,vcombine_u8(vmovn_u16(vreinterpretq_u16_s16(avgLo)),vmovn_u16(vreinterpretq_u16_s16(avgHi))));
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i third = _mm_set1_epi16(21846);
+    for (;ii+16<=count;ii+=16)
+    {
+        __m128i sums[4];
+        for (int jj=0;jj<4;jj++)
+        {
+            __m128i pix = _mm_loadu_si128((const __m128i *)(inPixels+ii+4*jj));
+            sums[jj] = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(pix,mask),
+                                                   _mm_and_si128(_mm_srli_epi32(pix,8),mask)),
+                                     _mm_and_si128(_mm_srli_epi32(pix,16),mask));
+        }
+        __m128i avg0 = _mm_mulhi_epu16(_mm_packs_epi32(sums[0],sums[1]),third);
+        __m128i avg1 = _mm_mulhi_epu16(_mm_packs_epi32(sums[2],sums[3]),third);
+        _mm_storeu_si128((__m128i *)(outPixels+ii),_mm_packus_epi16(avg0,avg1));
+    }
+#endif
+    PixelAverageRGBScalar(inPixels+ii,outPixels+ii,count-ii);
+}
+
+void PixelExtractRG(const uint32_t *inPixels,uint8_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint8x16x2_t out;
+        out.val[0] = pix.val[0];
+        out.val[1] = pix.val[1];
+        vst2q_u8(outPixels+2*ii,out);
+    }
+#elif WK_PIXEL_SSE2
+    for (;ii+8<=count;ii+=8)
+    {
+        __m128i out = PackLow16(_mm_loadu_si128((const __m128i *)(inPixels+ii)),_mm_loadu_si128((const __m128i *)(inPixels+ii+4)));
+        _mm_storeu_si128((__m128i *)(outPixels+2*ii),out);
+    }
+#endif
+    PixelExtractRGScalar(inPixels+ii,outPixels+2*ii,count-ii);
+}
+
+void PixelPremultiply(const uint32_t *inPixels,uint32_t *outPixels,size_t count)
+{
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    const uint16x8_t round = vdupq_n_u16(128);
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        for (int jj=0;jj<3;jj++)
+        {
+            uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(pix.val[jj]),vget_low_u8(pix.val[3])),round);
+            uint16x8_t hi = vaddq_u16(vmull_u8(vget_high_u8(pix.val[jj]),vget_high_u8(pix.val[3])),round);
+            pix.val[jj] = vcombine_u8(vaddhn_u16(lo,vshrq_n_u16(lo,8)),vaddhn_u16(hi,vshrq_n_u16(hi,8)));
+        }
+        vst4q_u8((uint8_t *)(outPixels+ii),pix);
+    }
+#elif WK_PIXEL_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    // Alpha gets multiplied by 255 and comes out the same
+    const __m128i colorMask = _mm_set_epi16(0,-1,-1,-1,0,-1,-1,-1);
+    const __m128i alphaMult = _mm_set_epi16(255,0,0,0,255,0,0,0);
+    for (;ii+4<=count;ii+=4)
+    {
+        __m128i pix = _mm_loadu_si128((const __m128i *)(inPixels+ii));
+        __m128i halves[2] = {_mm_unpacklo_epi8(pix,zero),_mm_unpackhi_epi8(pix,zero)};
+        for (int jj=0;jj<2;jj++)
+        {
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[jj],_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+            alpha = _mm_or_si128(_mm_and_si128(alpha,colorMask),alphaMult);
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[jj],alpha),round);
+            halves[jj] = _mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+        }
+        _mm_storeu_si128((__m128i *)(outPixels+ii),_mm_packus_epi16(halves[0],halves[1]));
+    }
+#endif
+    PixelPremultiplyScalar(inPixels+ii,outPixels+ii,count-ii);
+}
+
+void PixelSwizzle(const uint32_t *inPixels,uint32_t *outPixels,size_t count,const int order[4])
+{
+    for (int jj=0;jj<4;jj++)
+        if (order[jj] < 0 || order[jj] > 3)
+            return;
+
+    size_t ii = 0;
+#if WK_PIXEL_NEON
+    for (;ii+16<=count;ii+=16)
+    {
+        uint8x16x4_t pix = vld4q_u8((const uint8_t *)(inPixels+ii));
+        uint8x16x4_t out;
+        out.val[0] = pix.val[order[0]];
+        out.val[1] = pix.val[order[1]];
+        out.val[2] = pix.val[order[2]];
+        out.val[3] = pix.val[order[3]];
+        vst4q_u8((uint8_t *)(outPixels+ii),out);
+    }
+#elif WK_PIXEL_SSE2
+    // Swapping red and blue is the one that actually comes up
+    if (order[0] == 2 && order[1] == 1 && order[2] == 0 && order[3] == 3)
+    {
+        const __m128i maskGA = _mm_set1_epi32((int)0xFF00FF00), maskLow = _mm_set1_epi32(0xFF);
+        for (;ii+4<=count;ii+=4)
+        {
+            __m128i pix = _mm_loadu_si128((const __m128i *)(inPixels+ii));
+            __m128i out = _mm_or_si128(_mm_and_si128(pix,maskGA),
+                                       _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pix,16),maskLow),
+                                                    _mm_slli_epi32(_mm_and_si128(pix,maskLow),16)));
+            _mm_storeu_si128((__m128i *)(outPixels+ii),out);
+        }
+    }
+#endif
+    PixelSwizzleScalar(inPixels+ii,outPixels+ii,count-ii,order);
+}
+
+// Buffers we've got sitting around, sorted by size
+static pthread_mutex_t pixelPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static std::map<size_t,std::vector<void *> > pixelPool;
+static size_t pixelPoolBytes = 0;
+// Most we'll keep around, which is a handful of 1k tiles
+static const size_t PixelPoolMaxBytes = 16*1024*1024;
+
+static void PixelBufferPoolRelease(void *bytes,size_t length)
+{
+    pthread_mutex_lock(&pixelPoolLock);
+    if (pixelPoolBytes + length <= PixelPoolMaxBytes)
+    {
+        pixelPool[length].push_back(bytes);
+        pixelPoolBytes += length;
+        bytes = NULL;
+    }
+    pthread_mutex_unlock(&pixelPoolLock);
+
+    if (bytes)
+        free(bytes);
+}
+
+NSData *PixelBufferPoolData(size_t length,void **retBytes)
+{
+    void *bytes = NULL;
+    pthread_mutex_lock(&pixelPoolLock);
+    auto it = pixelPool.find(length);
+    if (it != pixelPool.end() && !it->second.empty())
+    {
+        bytes = it->second.back();
+        it->second.pop_back();
+        pixelPoolBytes -= length;
+    }
+    pthread_mutex_unlock(&pixelPoolLock);
+
+    if (!bytes)
+        bytes = malloc(length > 0 ? length : 1);
+    if (!bytes)
+    {
+        *retBytes = NULL;
+        return nil;
+    }
+    *retBytes = bytes;
+
+    return [[NSData alloc] initWithBytesNoCopy:bytes length:length deallocator:^(void *theBytes, NSUInteger theLength) {
+        PixelBufferPoolRelease(theBytes,theLength);
+    }];
+}
+
+// Time a kernel a few times and return the best run in milliseconds
+template<typename Kernel>
+static double PixelBenchmarkRun(Kernel kernel)
+{
+    double best = 0.0;
+    for (int ii=0;ii<10;ii++)
+    {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        kernel();
+        double ms = (CFAbsoluteTimeGetCurrent() - start) * 1000.0;
+        if (ii == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+void PixelConvertBenchmark()
+{
+    const int sizes[3] = {256,512,1024};
+    const int bgra[4] = {2,1,0,3};
+    for (int size : sizes)
+    {
+        size_t count = size*size;
+        std::vector<uint32_t> inPixels(count),outPixels32(count);
+        std::vector<uint16_t> outPixels16(count);
+        std::vector<uint8_t> outPixels8(2*count);
+        srand(size);
+        for (size_t ii=0;ii<count;ii++)
+            inPixels[ii] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        const uint32_t *in = &inPixels[0];
+
+        NSLog(@"PixelConvert: %dx%d tile, scalar ms / vector ms",size,size);
+        NSLog(@"  565:        %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo565Scalar(in,&outPixels16[0],count); }),
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo565(in,&outPixels16[0],count); }));
+        NSLog(@"  4444:       %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo4444Scalar(in,&outPixels16[0],count); }),
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo4444(in,&outPixels16[0],count); }));
+        NSLog(@"  5551:       %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo5551Scalar(in,&outPixels16[0],count); }),
+              PixelBenchmarkRun([&]{ PixelConvertRGBATo5551(in,&outPixels16[0],count); }));
+        NSLog(@"  alpha:      %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelExtractChannelScalar(in,&outPixels8[0],count,3); }),
+              PixelBenchmarkRun([&]{ PixelExtractChannel(in,&outPixels8[0],count,3); }));
+        NSLog(@"  rgb avg:    %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelAverageRGBScalar(in,&outPixels8[0],count); }),
+              PixelBenchmarkRun([&]{ PixelAverageRGB(in,&outPixels8[0],count); }));
+        NSLog(@"  rg:         %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelExtractRGScalar(in,&outPixels8[0],count); }),
+              PixelBenchmarkRun([&]{ PixelExtractRG(in,&outPixels8[0],count); }));
+        NSLog(@"  premult:    %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelPremultiplyScalar(in,&outPixels32[0],count); }),
+              PixelBenchmarkRun([&]{ PixelPremultiply(in,&outPixels32[0],count); }));
+        NSLog(@"  swizzle:    %.3f / %.3f",
+              PixelBenchmarkRun([&]{ PixelSwizzleScalar(in,&outPixels32[0],count,bgra); }),
+              PixelBenchmarkRun([&]{ PixelSwizzle(in,&outPixels32[0],count,bgra); }));
+        NSLog(@"  pooled buffer: %.3f",
+              PixelBenchmarkRun([&]{ void *bytes; @autoreleasepool { NSData *data = PixelBufferPoolData(count*2,&bytes); (void)data; } }));
+    }
+}
+
+}
@@ -18,6 +18,7 @@
  *
  */
 
+#import <typeinfo>
 #import "Scene.h"
 #import "GlobeView.h"
 #import "GlobeMath.h"
@@ -131,13 +132,11 @@ Scene::~Scene()
     pthread_mutex_destroy(&generatorLock);
     pthread_mutex_destroy(&programLock);
     
-    auto theChangeRequests = changeRequests;
-    changeRequests.clear();
-    for (unsigned int ii=0;ii<theChangeRequests.size();ii++)
-    {
-        // Note: Tear down change requests?
-        delete theChangeRequests[ii];
-    }
+    // Note: Tear down change requests?
+    ChangeRequest::deleteBatch(changeRequests);
+    ChangeSet timedChanges(timedChangeRequests.begin(),timedChangeRequests.end());
+    timedChangeRequests.clear();
+    ChangeRequest::deleteBatch(timedChanges);
     
     activeModels = nil;
     
@@ -191,6 +190,8 @@ void Scene::addChangeRequests(const ChangeSet &newChanges)
     
     for (ChangeRequest *change : newChanges)
     {
+        if (change)
+            ChangeRequestPool::recordRequest(typeid(*change).name());
         if (change && change->when > 0.0)
             timedChangeRequests.insert(change);
         else
@@ -203,6 +204,9 @@ void Scene::addChangeRequests(const ChangeSet &newChanges)
 // Add a single change request
 void Scene::addChangeRequest(ChangeRequest *newChange)
 {
+    if (newChange)
+        ChangeRequestPool::recordRequest(typeid(*newChange).name());
+
     pthread_mutex_lock(&changeRequestLock);
     
     if (newChange && newChange->when > 0.0)
@@ -389,12 +393,12 @@ int Scene::preProcessChanges(WhirlyKitView *view,WhirlyKitSceneRendererES *rende
     pthread_mutex_unlock(&changeRequestLock);
 
     // Run these outside of the lock, since they might use the lock
-    for (auto req : preRequests) {
+    for (auto req : preRequests)
         req->execute(this,renderer,view);
-        delete req;
-    }
+    int numPreRequests = (int)preRequests.size();
+    ChangeRequest::deleteBatch(preRequests);
     
-    return preRequests.size();
+    return numPreRequests;
 }
 
 // Process outstanding changes.
@@ -420,12 +424,11 @@ void Scene::processChanges(WhirlyKitView *view,WhirlyKitSceneRendererES *rendere
     for (unsigned int ii=0;ii<changeRequests.size();ii++)
     {
         ChangeRequest *req = changeRequests[ii];
-        if (req) {
+        if (req)
             req->execute(this,renderer,view);
-            delete req;
-        }
     }
-    changeRequests.clear();
+    // Hand the whole batch back to the pool at once
+    ChangeRequest::deleteBatch(changeRequests);
         
     pthread_mutex_unlock(&changeRequestLock);
 }
@@ -514,6 +517,7 @@ void Scene::dumpStats()
     NSLog(@"Scene: %ld sub textures",subTextureMap.size());
     cullTree->dumpStats();
     memManager.dumpStats();
+    ChangeRequestPool::dumpStats();
     for (GeneratorSet::iterator it = generators.begin();
          it != generators.end(); ++it)
         (*it)->dumpStats();
@@ -30,13 +30,17 @@
 using namespace Eigen;
 using namespace WhirlyKit;
 
-@implementation WhirlyKitDisplaySolid
+namespace WhirlyKit
+{
 
 // Let's not support tiles less than 10m on a side
 //static float const BoundsEps = 10.0 / EarthRadius;
 
+// Enough to cover several layers' worth of tiles at a high screen resolution
+static const int MaxDisplaySolids = 4096;
+
 // Calculate the number of samples required to represent the given line to a tolerance
-int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter,int level)
+static int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter,int level)
 {
     switch (level) {
     case 0:
@@ -58,10 +62,8 @@ int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,Co
     }
 }
 
-+ (WhirlyKitDisplaySolid *)displaySolidWithNodeIdent:(WhirlyKit::Quadtree::Identifier &)nodeIdent mbr:(WhirlyKit::Mbr)nodeMbr minZ:(float)inMinZ maxZ:(float)inMaxZ srcSystem:(WhirlyKit::CoordSystem *)srcSystem adapter:(WhirlyKit::CoordSystemDisplayAdapter *)coordAdapter;
+DisplaySolid::DisplaySolid(const Quadtree::Identifier &nodeIdent,const Mbr &nodeMbr,float inMinZ,float inMaxZ,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter)
 {
-    WhirlyKitDisplaySolid *dispSolid = [[WhirlyKitDisplaySolid alloc] init];
-
     // Start with the corner points in the source
     WhirlyKit::CoordSystem *displaySystem = coordAdapter->getCoordSystem();
     std::vector<Point3d> srcBounds;
@@ -93,7 +95,9 @@ int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,Co
     }
     
     // Build polygons out of those samples (in display space)
-    dispSolid.polys.reserve(numSamplesX*numSamplesY);
+    polys.reserve(numSamplesX*numSamplesY);
+    normals.reserve(numSamplesX*numSamplesY);
+    areas.reserve(numSamplesX*numSamplesY);
     for (int ix=0;ix<numSamplesX-1;ix++) {
         for (int iy=0;iy<numSamplesY-1;iy++) {
             // Surface polygon
@@ -103,67 +107,74 @@ int calcNumSamples(const Point3d &p0,const Point3d &p1,CoordSystem *srcSystem,Co
             poly.push_back(dispPoints[(iy+1)*numSamplesX+ix]);
             poly.push_back(dispPoints[(iy+1)*numSamplesX+(ix+1)]);
             poly.push_back(dispPoints[iy*numSamplesX+(ix+1)]);
-            dispSolid.polys.push_back(poly);
             
             // And a normal
-            if (coordAdapter->isFlat())
-                dispSolid.normals.push_back(Vector3d(0,0,1));
-            else {
+            Vector3d norm(0,0,1);
+            if (!coordAdapter->isFlat())
+            {
                 Point3d &p0 = poly[0];
                 Point3d &p1 = poly[1];
                 Point3d &p2 = poly[poly.size()-1];
-                Vector3d norm = (p1-p0).cross(p2-p0);
+                norm = (p1-p0).cross(p2-p0);
                 norm.normalize();
-                dispSolid.normals.push_back(norm);
             }
+            
+            // The area doesn't change with the view, so work it out once
+            areas.push_back(std::abs(PolygonArea(poly,norm)));
+            normals.push_back(norm);
+            polys.push_back(poly);
         }
     }
-    
-    return dispSolid;
 }
 
-double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize)
+// Scratch space for the projection and clipping.
+// Importance is evaluated constantly from the layer threads, so we keep these around.
+class PolyScratch
+{
+public:
+    std::vector<Eigen::Vector4d> pts,clipSpacePts;
+    std::vector<Point2d> screenPts;
+    std::vector<Point3d> backPts;
+};
+static thread_local PolyScratch polyScratch;
+
+static double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,double origArea,WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize)
 {
     double import = 0.0;
+    PolyScratch &scratch = polyScratch;
+    const std::vector<Eigen::Matrix4d> &fullProjMatrices = viewState.fullProjMatrices;
+    const std::vector<Eigen::Matrix4d> &invFullProjMatrices = viewState.invFullProjMatrices;
+    Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
     
-    for (unsigned int offi=0;offi<viewState.viewMatrices.size();offi++)
+    for (unsigned int offi=0;offi<fullProjMatrices.size();offi++)
     {
-        double origArea = PolygonArea(poly,norm);
-        origArea = std::abs(origArea);
-        
-        std::vector<Eigen::Vector4d> pts;
-        pts.reserve(poly.size());
+        // Straight to clip space
+        const Eigen::Matrix4d &fullProjMat = fullProjMatrices[offi];
+        scratch.pts.clear();
         for (unsigned int ii=0;ii<poly.size();ii++)
         {
             const Point3d &pt = poly[ii];
-            // Run through the model transform
-            Vector4d modPt = viewState.fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-            // And then the projection matrix.  Now we're in clip space
-            Vector4d projPt = viewState.projMatrix * modPt;
-            pts.push_back(projPt);
+            scratch.pts.push_back(fullProjMat * Vector4d(pt.x(),pt.y(),pt.z(),1.0));
         }
         
         // The points are in clip space, so clip!
-        std::vector<Eigen::Vector4d> clipSpacePts;
-        clipSpacePts.reserve(2*pts.size());
-        ClipHomogeneousPolygon(pts,clipSpacePts);
+        scratch.clipSpacePts.clear();
+        ClipHomogeneousPolygon(scratch.pts,scratch.clipSpacePts);
         
         // Outside the viewing frustum, so ignore it
-        if (clipSpacePts.empty())
+        if (scratch.clipSpacePts.empty())
             continue;
         
         // Project to the screen
-        std::vector<Point2d> screenPts;
-        screenPts.reserve(clipSpacePts.size());
-        Point2d halfFrameSize(frameSize.x()/2.0,frameSize.y()/2.0);
-        for (unsigned int ii=0;ii<clipSpacePts.size();ii++)
+        scratch.screenPts.clear();
+        for (unsigned int ii=0;ii<scratch.clipSpacePts.size();ii++)
         {
-            Vector4d &outPt = clipSpacePts[ii];
+            Vector4d &outPt = scratch.clipSpacePts[ii];
             Point2d screenPt(outPt.x()/outPt.w() * halfFrameSize.x()+halfFrameSize.x(),outPt.y()/outPt.w() * halfFrameSize.y()+halfFrameSize.y());
-            screenPts.push_back(screenPt);
+            scratch.screenPts.push_back(screenPt);
         }
         
-        double screenArea = CalcLoopArea(screenPts);
+        double screenArea = CalcLoopArea(scratch.screenPts);
         if (std::isnan(screenArea))
             screenArea = 0.0;
         // The polygon came out backwards, so toss it
@@ -171,16 +182,15 @@ double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,Whirl
             continue;
         
         // Now project the screen points back into model space
-        std::vector<Point3d> backPts;
-        backPts.reserve(screenPts.size());
-        for (unsigned int ii=0;ii<screenPts.size();ii++)
+        const Eigen::Matrix4d &invFullProjMat = invFullProjMatrices[offi];
+        scratch.backPts.clear();
+        for (unsigned int ii=0;ii<scratch.clipSpacePts.size();ii++)
         {
-            Vector4d modelPt = viewState.invProjMatrix * clipSpacePts[ii];
-            Vector4d backPt = viewState.invFullMatrices[offi] * modelPt;
-            backPts.push_back(Point3d(backPt.x(),backPt.y(),backPt.z()));
+            Vector4d backPt = invFullProjMat * scratch.clipSpacePts[ii];
+            scratch.backPts.push_back(Point3d(backPt.x(),backPt.y(),backPt.z()));
         }
         // Then calculate the area
-        double backArea = PolygonArea(backPts,norm);
+        double backArea = PolygonArea(scratch.backPts,norm);
         backArea = std::abs(backArea);
         
         // Now we know how much of the original polygon made it out to the screen
@@ -196,13 +206,13 @@ double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,Whirl
     return import;
 }
 
-- (bool)isInside:(WhirlyKit::Point3d)pt
+bool DisplaySolid::isInside(const Point3d &pt)
 {
     // Note: Fix this.  This will do weird things when we're very close.
     return false;
 }
 
-- (double)importanceForViewState:(WhirlyKitViewState *)viewState frameSize:(WhirlyKit::Point2f)frameSize;
+double DisplaySolid::importanceForViewState(WhirlyKitViewState *viewState,const Point2f &frameSize)
 {
     Point3d eyePos = viewState.eyePos;
 //    eyePos.normalize();
@@ -210,62 +220,58 @@ double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,Whirl
     if (!viewState.coordAdapter->isFlat())
     {
         // If the viewer is inside the bounds, the node is maximimally important (duh)
-        if ([self isInside:eyePos])
+        if (isInside(eyePos))
             return MAXFLOAT;
     }
     
     // Now work through the polygons and project each to the screen
     double totalImport = 0.0;
-    for (unsigned int ii=0;ii<_polys.size();ii++)
+    for (unsigned int ii=0;ii<polys.size();ii++)
     {
-        if (_normals[ii].dot(eyePos) >= 0.0) {
-            double import = PolyImportance(_polys[ii], _normals[ii], viewState, frameSize);
+        if (normals[ii].dot(eyePos) >= 0.0) {
+            double import = PolyImportance(polys[ii], normals[ii], areas[ii], viewState, frameSize);
             totalImport += import;
         }
     }
     
     // The flat map case is optimized to only evaluate one poly, since there's no curvature
-    double scaleFactor = (_polys.size() > 1 ? 0.5 : 1.0);
+    double scaleFactor = (polys.size() > 1 ? 0.5 : 1.0);
     
     return totalImport*scaleFactor;
 }
 
-- (bool)isOnScreenForViewState:(WhirlyKitViewState *)viewState frameSize:(WhirlyKit::Point2f)frameSize
+bool DisplaySolid::isOnScreenForViewState(WhirlyKitViewState *viewState,const Point2f &frameSize)
 {
     if (!viewState.coordAdapter->isFlat())
     {
         // If the viewer is inside the bounds, the node is maximimally important (duh)
-        if ([self isInside:viewState.eyePos])
-            return MAXFLOAT;
+        if (isInside(viewState.eyePos))
+            return true;
     }
     
-    for (unsigned int offi=0;offi<viewState.viewMatrices.size();offi++)
+    PolyScratch &scratch = polyScratch;
+    const std::vector<Eigen::Matrix4d> &fullProjMatrices = viewState.fullProjMatrices;
+    for (unsigned int offi=0;offi<fullProjMatrices.size();offi++)
     {
-        for (unsigned int ii=0;ii<_polys.size();ii++)
+        const Eigen::Matrix4d &fullProjMat = fullProjMatrices[offi];
+        for (unsigned int ii=0;ii<polys.size();ii++)
         {
-            const std::vector<Point3d> &poly = _polys[ii];
-            double origArea = PolygonArea(poly,_normals[ii]);
-            origArea = std::abs(origArea);
+            const std::vector<Point3d> &poly = polys[ii];
             
-            std::vector<Eigen::Vector4d> pts;
-            pts.reserve(poly.size());
-            for (unsigned int ii=0;ii<poly.size();ii++)
+            // Straight to clip space
+            scratch.pts.clear();
+            for (unsigned int jj=0;jj<poly.size();jj++)
             {
-                const Point3d &pt = poly[ii];
-                // Run through the model transform
-                Vector4d modPt = viewState.fullMatrices[offi] * Vector4d(pt.x(),pt.y(),pt.z(),1.0);
-                // And then the projection matrix.  Now we're in clip space
-                Vector4d projPt = viewState.projMatrix * modPt;
-                pts.push_back(projPt);
+                const Point3d &pt = poly[jj];
+                scratch.pts.push_back(fullProjMat * Vector4d(pt.x(),pt.y(),pt.z(),1.0));
             }
             
             // The points are in clip space, so clip!
-            std::vector<Eigen::Vector4d> clipSpacePts;
-            clipSpacePts.reserve(2*pts.size());
-            ClipHomogeneousPolygon(pts,clipSpacePts);
+            scratch.clipSpacePts.clear();
+            ClipHomogeneousPolygon(scratch.pts,scratch.clipSpacePts);
 
             // Got something inside the viewing frustum.  Good enough.
-            if (!clipSpacePts.empty())
+            if (!scratch.clipSpacePts.empty())
                 return true;
         }
     }
@@ -273,48 +279,113 @@ double PolyImportance(const std::vector<Point3d> &poly,const Point3d &norm,Whirl
     return false;
 }
 
-@end
+bool DisplaySolidCache::Key::operator == (const Key &that) const
+{
+    return coordAdapter == that.coordAdapter && x == that.x && y == that.y && level == that.level &&
+           llx == that.llx && lly == that.lly && urx == that.urx && ury == that.ury &&
+           minZ == that.minZ && maxZ == that.maxZ && dispOrigin == that.dispOrigin;
+}
 
-namespace WhirlyKit
+size_t DisplaySolidCache::KeyHash::operator () (const Key &key) const
 {
+    size_t hash = std::hash<void *>()(key.coordAdapter);
+    hash = hash * 31 + std::hash<int>()(key.x);
+    hash = hash * 31 + std::hash<int>()(key.y);
+    hash = hash * 31 + std::hash<int>()(key.level);
+    hash = hash * 31 + std::hash<double>()(key.dispOrigin.x());
+    hash = hash * 31 + std::hash<double>()(key.dispOrigin.y());
+    hash = hash * 31 + std::hash<double>()(key.dispOrigin.z());
     
-bool TileIsOnScreen(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,WhirlyKit::Mbr nodeMbr,WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs)
+    return hash;
+}
+
+DisplaySolidCache::DisplaySolidCache(int maxSolids)
+    : maxSolids(maxSolids)
 {
-    WhirlyKitDisplaySolid *dispSolid = attrs[@"DisplaySolid"];
-    if (!dispSolid)
+}
+
+DisplaySolidCache *DisplaySolidCache::sharedCache()
+{
+    static DisplaySolidCache *cache = new DisplaySolidCache(MaxDisplaySolids);
+    
+    return cache;
+}
+
+DisplaySolidRef DisplaySolidCache::getDisplaySolid(const Quadtree::Identifier &nodeIdent,const Mbr &nodeMbr,double minZ,double maxZ,CoordSystem *srcSystem,CoordSystemDisplayAdapter *coordAdapter)
+{
+    Key key;
+    key.coordAdapter = coordAdapter;
+    key.x = nodeIdent.x;  key.y = nodeIdent.y;  key.level = nodeIdent.level;
+    key.llx = nodeMbr.ll().x();  key.lly = nodeMbr.ll().y();
+    key.urx = nodeMbr.ur().x();  key.ury = nodeMbr.ur().y();
+    key.minZ = minZ;  key.maxZ = maxZ;
+    // Where the tile lands tells us whether the source system matches
+    key.dispOrigin = coordAdapter->localToDisplay(CoordSystemConvert3d(srcSystem, coordAdapter->getCoordSystem(), Point3d(key.llx,key.lly,(float)minZ)));
+    
     {
-        dispSolid = [WhirlyKitDisplaySolid displaySolidWithNodeIdent:nodeIdent mbr:nodeMbr minZ:0.0 maxZ:0.0 srcSystem:srcSystem adapter:coordAdapter];
-        if (dispSolid)
-        attrs[@"DisplaySolid"] = dispSolid;
-        else
-        attrs[@"DisplaySolid"] = [NSNull null];
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = solidMap.find(key);
+        if (it != solidMap.end())
+        {
+            solids.splice(solids.begin(),solids,it->second);
+            return it->second->second;
+        }
     }
     
+    // Build it outside the lock, since other layers may be looking at other tiles
+    DisplaySolidRef dispSolid(new DisplaySolid(nodeIdent,nodeMbr,minZ,maxZ,srcSystem,coordAdapter));
     // This means the tile is degenerate (as far as we're concerned)
-    if ([dispSolid isKindOfClass:[NSNull null]])
+    if (dispSolid->polys.empty())
+        dispSolid = DisplaySolidRef();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = solidMap.find(key);
+    if (it != solidMap.end())
+    {
+        // Someone else got there first
+        solids.splice(solids.begin(),solids,it->second);
+        return it->second->second;
+    }
+    solids.push_front(std::make_pair(key,dispSolid));
+    solidMap[key] = solids.begin();
+    while ((int)solids.size() > maxSolids)
+    {
+        solidMap.erase(solids.back().first);
+        solids.pop_back();
+    }
+    
+    return dispSolid;
+}
+
+void DisplaySolidCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    solidMap.clear();
+    solids.clear();
+}
+    
+bool TileIsOnScreen(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,WhirlyKit::Mbr nodeMbr,WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs)
+{
+    DisplaySolidRef dispSolid = DisplaySolidCache::sharedCache()->getDisplaySolid(nodeIdent, nodeMbr, 0.0, 0.0, srcSystem, coordAdapter);
+    
+    // This means the tile is degenerate (as far as we're concerned)
+    if (!dispSolid)
         return false;
 
-    return [dispSolid isOnScreenForViewState:viewState frameSize:frameSize];
+    return dispSolid->isOnScreenForViewState(viewState,frameSize);
 }
 
 
 // Calculate the max pixel size for a tile
 double ScreenImportance(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,const Point3d &notUsed,int pixelsSquare,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,Mbr nodeMbr,WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs)
 {
-    WhirlyKitDisplaySolid *dispSolid = attrs[@"DisplaySolid"];
-    if (!dispSolid)
-    {
-        dispSolid = [WhirlyKitDisplaySolid displaySolidWithNodeIdent:nodeIdent mbr:nodeMbr minZ:0.0 maxZ:0.0 srcSystem:srcSystem adapter:coordAdapter];
-        if (!dispSolid)
-            dispSolid = (WhirlyKitDisplaySolid *)[NSNull null];
-        attrs[@"DisplaySolid"] = dispSolid;
-    }
+    DisplaySolidRef dispSolid = DisplaySolidCache::sharedCache()->getDisplaySolid(nodeIdent, nodeMbr, 0.0, 0.0, srcSystem, coordAdapter);
     
     // This means the tile is degenerate (as far as we're concerned)
-    if ([dispSolid isKindOfClass:[NSNull class]])
+    if (!dispSolid)
         return 0.0;
     
-    double import = [dispSolid importanceForViewState:viewState frameSize:frameSize];
+    double import = dispSolid->importanceForViewState(viewState,frameSize);
     // The system is expecting an estimate of pixel size on screen
     import = import/(pixelsSquare * pixelsSquare);
     
@@ -326,21 +397,13 @@ double ScreenImportance(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSi
 // This version is for volumes with height
 double ScreenImportance(WhirlyKitViewState *viewState,WhirlyKit::Point2f frameSize,int pixelsSquare,WhirlyKit::CoordSystem *srcSystem,WhirlyKit::CoordSystemDisplayAdapter *coordAdapter,Mbr nodeMbr,double minZ,double maxZ,WhirlyKit::Quadtree::Identifier &nodeIdent,NSMutableDictionary *attrs)
 {
-    WhirlyKitDisplaySolid *dispSolid = attrs[@"DisplaySolid"];
-    if (!dispSolid)
-    {
-        dispSolid = [WhirlyKitDisplaySolid displaySolidWithNodeIdent:nodeIdent mbr:nodeMbr minZ:minZ maxZ:maxZ srcSystem:srcSystem adapter:coordAdapter];
-        if (dispSolid)
-            attrs[@"DisplaySolid"] = dispSolid;
-        else
-            attrs[@"DisplaySolid"] = [NSNull null];
-    }
+    DisplaySolidRef dispSolid = DisplaySolidCache::sharedCache()->getDisplaySolid(nodeIdent, nodeMbr, minZ, maxZ, srcSystem, coordAdapter);
     
     // This means the tile is degenerate (as far as we're concerned)
-    if ([dispSolid isKindOfClass:[NSNull class]])
+    if (!dispSolid)
         return 0.0;
     
-    double import = [dispSolid importanceForViewState:viewState frameSize:frameSize];
+    double import = dispSolid->importanceForViewState(viewState,frameSize);
     // The system is expecting an estimate of pixel size on screen
     import = import/(pixelsSquare * pixelsSquare);
     
@@ -203,6 +203,116 @@ static const char *fragmentShaderTri =
 "}\n"
 ;
 
+static const char *vertexShaderSDFTri =
+"uniform mat4  u_mvpMatrix;"
+"uniform mat4  u_mvMatrix;"
+"uniform mat4  u_mvNormalMatrix;"
+"uniform float u_fade;"
+"uniform vec2  u_scale;"
+"uniform bool  u_activerot;"
+""
+"attribute vec3 a_position;"
+"attribute vec3 a_normal;"
+"attribute vec2 a_texCoord0;"
+"attribute vec4 a_color;"
+"attribute vec2 a_offset;"
+"attribute vec3 a_rot;"
+"attribute vec2 a_sdfParams;"
+""
+"varying vec2 v_texCoord;"
+"varying vec4 v_color;"
+"varying vec2 v_sdfParams;"
+""
+"void main()"
+"{"
+"   v_texCoord = a_texCoord0;"
+"   v_color = a_color * u_fade;"
+"   v_sdfParams = a_sdfParams;"
+""
+// Convert from model space into display space
+"   vec4 pt = u_mvMatrix * vec4(a_position,1.0);"
+"   pt /= pt.w;"
+// Make sure the object is facing the user
+"   vec4 testNorm = u_mvNormalMatrix * vec4(a_normal,0.0);"
+"   float dot_res = dot(-pt.xyz,testNorm.xyz);"
+// Project the point all the way to screen space
+"   vec4 screenPt = (u_mvpMatrix * vec4(a_position,1.0));"
+"   screenPt /= screenPt.w;"
+// Project the rotation into display space and drop the Z
+"   vec4 projRot = u_mvNormalMatrix * vec4(a_rot,0.0);"
+"   vec2 rotY = normalize(projRot.xy);"
+"   vec2 rotX = vec2(rotY.y,-rotY.x);"
+"   vec2 screenOffset = (u_activerot ? a_offset.x*rotX + a_offset.y*rotY : a_offset);"
+"   gl_Position = (dot_res > 0.0 && pt.z <= 0.0) ? vec4(screenPt.xy + vec2(screenOffset.x*u_scale.x,screenOffset.y*u_scale.y),0.0,1.0) : vec4(0.0,0.0,0.0,0.0);"
+"}"
+;
+
+static const char *vertexShaderSDFMotionTri =
+"uniform mat4  u_mvpMatrix;"
+"uniform mat4  u_mvMatrix;"
+"uniform mat4  u_mvNormalMatrix;"
+"uniform float u_fade;"
+"uniform vec2  u_scale;"
+"uniform float u_time;"
+"uniform bool  u_activerot;"
+""
+"attribute vec3 a_position;"
+"attribute vec3 a_dir;"
+"attribute vec3 a_normal;"
+"attribute vec2 a_texCoord0;"
+"attribute vec4 a_color;"
+"attribute vec2 a_offset;"
+"attribute vec3 a_rot;"
+"attribute vec2 a_sdfParams;"
+""
+"varying vec2 v_texCoord;"
+"varying vec4 v_color;"
+"varying vec2 v_sdfParams;"
+""
+"void main()"
+"{"
+"   v_texCoord = a_texCoord0;"
+"   v_color = a_color * u_fade;"
+"   v_sdfParams = a_sdfParams;"
+""
+// Position can be modified over time
+"   vec3 thePos = a_position + u_time * a_dir;"
+// Convert from model space into display space
+"   vec4 pt = u_mvMatrix * vec4(thePos,1.0);"
+"   pt /= pt.w;"
+// Make sure the object is facing the user
+"   vec4 testNorm = u_mvNormalMatrix * vec4(a_normal,0.0);"
+"   float dot_res = dot(-pt.xyz,testNorm.xyz);"
+// Project the point all the way to screen space
+"   vec4 screenPt = (u_mvpMatrix * vec4(thePos,1.0));"
+"   screenPt /= screenPt.w;"
+// Project the rotation into display space and drop the Z
+"   vec4 projRot = u_mvNormalMatrix * vec4(a_rot,0.0);"
+"   vec2 rotY = normalize(projRot.xy);"
+"   vec2 rotX = vec2(rotY.y,-rotY.x);"
+"   vec2 screenOffset = (u_activerot ? a_offset.x*rotX + a_offset.y*rotY : a_offset);"
+"   gl_Position = (dot_res > 0.0 && pt.z <= 0.0) ? vec4(screenPt.xy + vec2(screenOffset.x*u_scale.x,screenOffset.y*u_scale.y),0.0,1.0) : vec4(0.0,0.0,0.0,0.0);"
+"}"
+;
+
+// Distance field glyphs.  a_sdfParams holds the edge value and the smoothing width.
+static const char *fragmentShaderSDFTri =
+"precision mediump float;\n"
+"\n"
+"uniform sampler2D s_baseMap0;\n"
+"\n"
+"varying vec2      v_texCoord;\n"
+"varying vec4      v_color;\n"
+"varying vec2      v_sdfParams;\n"
+"\n"
+"void main()\n"
+"{\n"
+"  float dist = texture2D(s_baseMap0, v_texCoord).a;\n"
+"  float alpha = smoothstep(v_sdfParams.x - v_sdfParams.y, v_sdfParams.x + v_sdfParams.y, dist);\n"
+"  gl_FragColor = v_color * alpha;\n"
+"}\n"
+;
+
 WhirlyKit::OpenGLES2Program *BuildScreenSpaceProgram()
 {
     OpenGLES2Program *shader = new OpenGLES2Program(kScreenSpaceShaderName,vertexShaderTri,fragmentShaderTri);
@@ -232,5 +342,35 @@ WhirlyKit::OpenGLES2Program *BuildScreenSpaceMotionProgram()
     
     return shader;
 }
+
+WhirlyKit::OpenGLES2Program *BuildScreenSpaceSDFProgram()
+{
+    OpenGLES2Program *shader = new OpenGLES2Program(kScreenSpaceShaderSDFName,vertexShaderSDFTri,fragmentShaderSDFTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = NULL;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
+
+WhirlyKit::OpenGLES2Program *BuildScreenSpaceSDFMotionProgram()
+{
+    OpenGLES2Program *shader = new OpenGLES2Program(kScreenSpaceShaderSDFMotionName,vertexShaderSDFMotionTri,fragmentShaderSDFTri);
+    if (!shader->isValid())
+    {
+        delete shader;
+        shader = NULL;
+    }
+    
+    if (shader)
+        glUseProgram(shader->getProgram());
+    
+    return shader;
+}
     
 }
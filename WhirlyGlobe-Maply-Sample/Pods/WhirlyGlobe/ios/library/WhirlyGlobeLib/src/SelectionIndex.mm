@@ -0,0 +1,204 @@
+/*
+ *  SelectionIndex.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <algorithm>
+#import "SelectionIndex.h"
+
+using namespace Eigen;
+
+namespace WhirlyKit
+{
+
+// Number of entries we'll tolerate in a leaf before splitting
+static const int MaxEntriesPerLeaf = 8;
+
+void SelectionVolume::addScreenRect(const Mbr &screenMbr,const Point2f &frameSize,const Eigen::Matrix4d &modelAndViewMat,const Eigen::Matrix4d &projMat)
+{
+    Matrix4d mat = projMat * modelAndViewMat;
+
+    // Screen rectangle in normalized device coordinates.  Screen Y is flipped.
+    double minX = screenMbr.ll().x() / (frameSize.x()/2.0) - 1.0;
+    double maxX = screenMbr.ur().x() / (frameSize.x()/2.0) - 1.0;
+    double minY = 1.0 - screenMbr.ur().y() / (frameSize.y()/2.0);
+    double maxY = 1.0 - screenMbr.ll().y() / (frameSize.y()/2.0);
+
+    // The planes fall right out of the combined matrix (Gribb & Hartmann)
+    Vector4d rowX = mat.row(0), rowY = mat.row(1), rowZ = mat.row(2), rowW = mat.row(3);
+    std::vector<Vector4d> planes(5);
+    planes[0] = rowX - minX * rowW;
+    planes[1] = maxX * rowW - rowX;
+    planes[2] = rowY - minY * rowW;
+    planes[3] = maxY * rowW - rowY;
+    // Near plane
+    planes[4] = rowZ + rowW;
+
+    hulls.push_back(planes);
+}
+
+void SelectionVolume::addBBox(const BBox &bbox)
+{
+    const Point3d &ll = bbox.ll(), &ur = bbox.ur();
+    std::vector<Vector4d> planes(6);
+    planes[0] = Vector4d(1,0,0,-ll.x());
+    planes[1] = Vector4d(-1,0,0,ur.x());
+    planes[2] = Vector4d(0,1,0,-ll.y());
+    planes[3] = Vector4d(0,-1,0,ur.y());
+    planes[4] = Vector4d(0,0,1,-ll.z());
+    planes[5] = Vector4d(0,0,-1,ur.z());
+
+    hulls.push_back(planes);
+}
+
+bool SelectionVolume::overlaps(const BBox &bbox) const
+{
+    const Point3d &ll = bbox.ll(), &ur = bbox.ur();
+    for (const std::vector<Vector4d> &planes : hulls)
+    {
+        bool outside = false;
+        for (const Vector4d &plane : planes)
+        {
+            // Check the corner furthest along the plane normal
+            double dist = plane.x() * (plane.x() > 0.0 ? ur.x() : ll.x()) +
+                          plane.y() * (plane.y() > 0.0 ? ur.y() : ll.y()) +
+                          plane.z() * (plane.z() > 0.0 ? ur.z() : ll.z()) + plane.w();
+            if (dist < 0.0)
+            {
+                outside = true;
+                break;
+            }
+        }
+        if (!outside)
+            return true;
+    }
+
+    return false;
+}
+
+SelectableIndex::SelectableIndex()
+{
+}
+
+void SelectableIndex::clear()
+{
+    entries.clear();
+    nodes.clear();
+}
+
+void SelectableIndex::addEntry(SimpleIdentity selectID,const BBox &bbox)
+{
+    Entry entry;
+    entry.selectID = selectID;
+    entry.bbox = bbox;
+    entry.center = (bbox.ll() + bbox.ur())/2.0;
+    entries.push_back(entry);
+}
+
+void SelectableIndex::build()
+{
+    nodes.clear();
+    if (entries.empty())
+        return;
+
+    nodes.reserve(2*entries.size()/MaxEntriesPerLeaf+1);
+    buildNode(0,(int)entries.size());
+}
+
+int SelectableIndex::buildNode(int start,int end)
+{
+    int nodeIdx = (int)nodes.size();
+    nodes.resize(nodes.size()+1);
+
+    // Bounds of everything below and of the centers, which we split on
+    BBox bbox,centerBox;
+    for (int ii=start;ii<end;ii++)
+    {
+        const Entry &entry = entries[ii];
+        bbox.addPoint(entry.bbox.ll());
+        bbox.addPoint(entry.bbox.ur());
+        centerBox.addPoint(entry.center);
+    }
+    nodes[nodeIdx].bbox = bbox;
+
+    if (end-start <= MaxEntriesPerLeaf)
+    {
+        nodes[nodeIdx].start = start;
+        nodes[nodeIdx].count = end-start;
+        return nodeIdx;
+    }
+
+    // Split at the median along the longest axis
+    Point3d span = centerBox.ur() - centerBox.ll();
+    int axis = 0;
+    if (span.y() > span.x())
+        axis = 1;
+    if (span.z() > span[axis])
+        axis = 2;
+    int mid = (start+end)/2;
+    std::nth_element(entries.begin()+start,entries.begin()+mid,entries.begin()+end,
+                     [axis](const Entry &a,const Entry &b) { return a.center[axis] < b.center[axis]; });
+
+    // Note: nodes may be reallocated in here, so don't hold a reference
+    int left = buildNode(start,mid);
+    int right = buildNode(mid,end);
+    nodes[nodeIdx].left = left;
+    nodes[nodeIdx].right = right;
+
+    return nodeIdx;
+}
+
+bool SelectableIndex::getBounds(BBox &bbox) const
+{
+    if (nodes.empty())
+        return false;
+
+    bbox = nodes[0].bbox;
+    return true;
+}
+
+void SelectableIndex::findInVolume(const SelectionVolume &vol,std::vector<SimpleIdentity> &selectIDs) const
+{
+    if (nodes.empty() || vol.empty())
+        return;
+
+    std::vector<int> toVisit;
+    toVisit.push_back(0);
+    while (!toVisit.empty())
+    {
+        const Node &node = nodes[toVisit.back()];
+        toVisit.pop_back();
+
+        if (!vol.overlaps(node.bbox))
+            continue;
+
+        if (node.left < 0)
+        {
+            for (int ii=node.start;ii<node.start+node.count;ii++)
+            {
+                const Entry &entry = entries[ii];
+                if (vol.overlaps(entry.bbox))
+                    selectIDs.push_back(entry.selectID);
+            }
+        } else {
+            toVisit.push_back(node.left);
+            toVisit.push_back(node.right);
+        }
+    }
+}
+
+}
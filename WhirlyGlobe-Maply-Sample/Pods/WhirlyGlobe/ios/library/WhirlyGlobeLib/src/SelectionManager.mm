@@ -70,7 +70,9 @@ bool BillboardSelectable::operator < (const BillboardSelectable &that) const
 }
 
 SelectionManager::SelectionManager(Scene *scene,float viewScale)
-    : scene(scene), scale(viewScale)
+    : scene(scene), scale(viewScale),
+    rect3DIndexDirty(false), rect2DIndexDirty(false), polytopeIndexDirty(false), linearIndexDirty(false), billboardIndexDirty(false),
+    rect2DMaxExtent(0.0)
 {
     pthread_mutex_init(&mutex,NULL);
 }
@@ -96,6 +98,7 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,Point3f *pts,bo
 
     pthread_mutex_lock(&mutex);
     rect3Dselectables.insert(newSelect);
+    rect3DIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -115,6 +118,7 @@ void SelectionManager::addSelectableRect(SimpleIdentity selectId,Point3f *pts,fl
     
     pthread_mutex_lock(&mutex);
     rect3Dselectables.insert(newSelect);
+    rect3DIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -135,6 +139,7 @@ void SelectionManager::addSelectableScreenRect(SimpleIdentity selectId,const Poi
     
     pthread_mutex_lock(&mutex);
     rect2Dselectables.insert(newSelect);
+    rect2DIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -194,6 +199,7 @@ void SelectionManager::addSelectableRectSolid(SimpleIdentity selectId,Point3f *p
     
     pthread_mutex_lock(&mutex);
     polytopeSelectables.insert(newSelect);
+    polytopeIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -239,6 +245,7 @@ void SelectionManager::addPolytope(SimpleIdentity selectId,const std::vector<std
     
     pthread_mutex_lock(&mutex);
     polytopeSelectables.insert(newSelect);
+    polytopeIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -371,6 +378,7 @@ void SelectionManager::addSelectableLinear(SimpleIdentity selectId,const std::ve
 
     pthread_mutex_lock(&mutex);
     linearSelectables.insert(newSelect);
+    linearIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -391,6 +399,7 @@ void SelectionManager::addSelectableBillboard(SimpleIdentity selectId,const Poin
     
     pthread_mutex_lock(&mutex);
     billboardSelectables.insert(newSelect);
+    billboardIndexDirty = true;
     pthread_mutex_unlock(&mutex);
 }
 
@@ -548,11 +557,17 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
     RectSelectable3DSet::iterator it = rect3Dselectables.find(RectSelectable3D(selectID));
     
     if (it != rect3Dselectables.end())
+    {
         rect3Dselectables.erase(it);
+        rect3DIndexDirty = true;
+    }
     
     RectSelectable2DSet::iterator it2 = rect2Dselectables.find(RectSelectable2D(selectID));
     if (it2 != rect2Dselectables.end())
+    {
         rect2Dselectables.erase(it2);
+        rect2DIndexDirty = true;
+    }
 
     MovingRectSelectable2DSet::iterator itM = movingRect2Dselectables.find(MovingRectSelectable2D(selectID));
     if (itM != movingRect2Dselectables.end())
@@ -560,7 +575,10 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
 
     PolytopeSelectableSet::iterator it3 = polytopeSelectables.find(PolytopeSelectable(selectID));
     if (it3 != polytopeSelectables.end())
+    {
         polytopeSelectables.erase(it3);
+        polytopeIndexDirty = true;
+    }
     
     MovingPolytopeSelectableSet::iterator it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
     if (it3a != movingPolytopeSelectables.end())
@@ -568,11 +586,17 @@ void SelectionManager::removeSelectable(SimpleIdentity selectID)
     
     LinearSelectableSet::iterator it5 = linearSelectables.find(LinearSelectable(selectID));
     if (it5 != linearSelectables.end())
+    {
         linearSelectables.erase(it5);
+        linearIndexDirty = true;
+    }
     
     BillboardSelectableSet::iterator it4 = billboardSelectables.find(BillboardSelectable(selectID));
     if (it4 != billboardSelectables.end())
+    {
         billboardSelectables.erase(it4);
+        billboardIndexDirty = true;
+    }
 
     pthread_mutex_unlock(&mutex);
 }
@@ -591,6 +615,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             found = true;
             rect3Dselectables.erase(it);
+            rect3DIndexDirty = true;
         }
         
         RectSelectable2DSet::iterator it2 = rect2Dselectables.find(RectSelectable2D(selectID));
@@ -598,6 +623,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             found = true;
             rect2Dselectables.erase(it2);
+            rect2DIndexDirty = true;
         }
         
         MovingRectSelectable2DSet::iterator itM = movingRect2Dselectables.find(MovingRectSelectable2D(selectID));
@@ -612,6 +638,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             found = true;
             polytopeSelectables.erase(it3);
+            polytopeIndexDirty = true;
         }
 
         MovingPolytopeSelectableSet::iterator it3a = movingPolytopeSelectables.find(MovingPolytopeSelectable(selectID));
@@ -626,6 +653,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             found = true;
             linearSelectables.erase(it5);
+            linearIndexDirty = true;
         }
 
         BillboardSelectableSet::iterator it4 = billboardSelectables.find(BillboardSelectable(selectID));
@@ -633,6 +661,7 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
         {
             found = true;
             billboardSelectables.erase(it4);
+            billboardIndexDirty = true;
         }
     }
     
@@ -642,11 +671,104 @@ void SelectionManager::removeSelectables(const SimpleIDSet &selectIDs)
     pthread_mutex_unlock(&mutex);
 }
 
-void SelectionManager::getScreenSpaceObjects(const PlacementInfo &pInfo,std::vector<ScreenSpaceObjectLocation> &screenPts,NSTimeInterval now)
+void SelectionManager::updateIndices()
 {
-    for (RectSelectable2DSet::iterator it = rect2Dselectables.begin();
-         it != rect2Dselectables.end(); ++it)
+    if (rect3DIndexDirty)
+    {
+        rect3DIndex.clear();
+        for (const RectSelectable3D &sel : rect3Dselectables)
+        {
+            BBox bbox;
+            for (unsigned int ii=0;ii<4;ii++)
+                bbox.addPoint(Vector3fToVector3d(sel.pts[ii]));
+            rect3DIndex.addEntry(sel.selectID, bbox);
+        }
+        rect3DIndex.build();
+        rect3DIndexDirty = false;
+    }
+    
+    // The 2D rectangles are indexed by their centers.  We expand the query by their size instead.
+    if (rect2DIndexDirty)
+    {
+        rect2DIndex.clear();
+        rect2DMaxExtent = 0.0;
+        for (const RectSelectable2D &sel : rect2Dselectables)
+        {
+            BBox bbox;
+            bbox.addPoint(sel.center);
+            rect2DIndex.addEntry(sel.selectID, bbox);
+            for (unsigned int ii=0;ii<4;ii++)
+                rect2DMaxExtent = std::max(rect2DMaxExtent,sel.pts[ii].norm());
+        }
+        rect2DIndex.build();
+        rect2DIndexDirty = false;
+    }
+    
+    if (polytopeIndexDirty)
+    {
+        polytopeIndex.clear();
+        for (const PolytopeSelectable &sel : polytopeSelectables)
+        {
+            BBox bbox;
+            for (const std::vector<Point3f> &poly : sel.polys)
+                for (const Point3f &pt : poly)
+                    bbox.addPoint(Vector3fToVector3d(pt) + sel.centerPt);
+            polytopeIndex.addEntry(sel.selectID, bbox);
+        }
+        polytopeIndex.build();
+        polytopeIndexDirty = false;
+    }
+    
+    if (linearIndexDirty)
     {
+        linearIndex.clear();
+        for (const LinearSelectable &sel : linearSelectables)
+        {
+            BBox bbox;
+            bbox.addPoints(sel.pts);
+            linearIndex.addEntry(sel.selectID, bbox);
+        }
+        linearIndex.build();
+        linearIndexDirty = false;
+    }
+    
+    // Billboards rotate toward the viewer, so use a box that covers any orientation
+    if (billboardIndexDirty)
+    {
+        billboardIndex.clear();
+        for (const BillboardSelectable &sel : billboardSelectables)
+        {
+            double rad = Point2d(sel.size.x()/2.0,sel.size.y()).norm();
+            BBox bbox;
+            bbox.addPoint(sel.center - Point3d(rad,rad,rad));
+            bbox.addPoint(sel.center + Point3d(rad,rad,rad));
+            billboardIndex.addEntry(sel.selectID, bbox);
+        }
+        billboardIndex.build();
+        billboardIndexDirty = false;
+    }
+}
+
+void SelectionManager::buildSelectionVolume(const PlacementInfo &pInfo,const Mbr &screenMbr,SelectionVolume &vol)
+{
+    // Some of the selectables are projected without the offset matrices
+    vol.addScreenRect(screenMbr, pInfo.frameSizeScale, pInfo.viewAndModelMat, pInfo.projMat);
+    for (const Eigen::Matrix4d &offMatrix : pInfo.offsetMatrices)
+    {
+        Eigen::Matrix4d modelAndViewMat = pInfo.viewMat * offMatrix * pInfo.modelMat;
+        vol.addScreenRect(screenMbr, pInfo.frameSizeScale, modelAndViewMat, pInfo.projMat);
+    }
+}
+
+void SelectionManager::getScreenSpaceObjects(const PlacementInfo &pInfo,const SelectionVolume &vol,std::vector<ScreenSpaceObjectLocation> &screenPts,NSTimeInterval now)
+{
+    std::vector<SimpleIdentity> candIDs;
+    rect2DIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        RectSelectable2DSet::iterator it = rect2Dselectables.find(RectSelectable2D(candID));
+        if (it == rect2Dselectables.end())
+            continue;
         const RectSelectable2D &sel = *it;
         if (sel.selectID != EmptyIdentity && sel.enable)
         {
@@ -838,6 +960,33 @@ Matrix2d SelectionManager::calcScreenRot(float &screenRot,WhirlyKitViewState *vi
     return screenRotMat;
 }
 
+void SelectionManager::screenSpaceObjectPoints(const PlacementInfo &pInfo,ScreenSpaceObjectLocation &screenObj,const Point2d &projPt,const Matrix4d &modelTrans,const Matrix4d &normalMat,const Point2f &frameBufferSize,std::vector<Point2f> &screenPts)
+{
+    Matrix2d screenRotMat;
+    float screenRot = 0.0;
+    CGPoint objPt;
+    objPt.x = projPt.x();  objPt.y = projPt.y();
+    if (screenObj.rotation != 0.0)
+        screenRotMat = calcScreenRot(screenRot,pInfo.viewState,pInfo.globeViewState,&screenObj,objPt,modelTrans,normalMat,frameBufferSize);
+    
+    if (screenRot == 0.0)
+    {
+        for (unsigned int kk=0;kk<screenObj.pts.size();kk++)
+        {
+            const Point2d &screenObjPt = screenObj.pts[kk];
+            Point2d theScreenPt = Point2d(screenObjPt.x(),-screenObjPt.y()) + projPt + Point2d(screenObj.offset.x(),-screenObj.offset.y());
+            screenPts.push_back(Point2f(theScreenPt.x(),theScreenPt.y()));
+        }
+    } else {
+        for (unsigned int kk=0;kk<screenObj.pts.size();kk++)
+        {
+            const Point2d screenObjPt = screenRotMat * (screenObj.pts[kk] + Point2d(screenObj.offset.x(),screenObj.offset.y()));
+            Point2d theScreenPt = Point2d(screenObjPt.x(),-screenObjPt.y()) + projPt;
+            screenPts.push_back(Point2f(theScreenPt.x(),theScreenPt.y()));
+        }
+    }
+}
+
 /// Pass in the screen point where the user touched.  This returns the closest hit within the given distance
 // Note: Should switch to a view state, rather than a view
 void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *theView,bool multi,std::vector<SelectedObject> &selObjs)
@@ -867,10 +1016,22 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
     
     pthread_mutex_lock(&mutex);
 
+    updateIndices();
+    
+    // Only the selectables whose bounds project near the touch are considered
+    Mbr touchMbr(Point2f(touchPt.x()-maxDist,touchPt.y()-maxDist),Point2f(touchPt.x()+maxDist,touchPt.y()+maxDist));
+    SelectionVolume touchVol;
+    buildSelectionVolume(pInfo, touchMbr, touchVol);
+    // The 2D rectangles are indexed by center, so look further out for them
+    float rectDist = maxDist + rect2DMaxExtent;
+    Mbr rectMbr(Point2f(touchPt.x()-rectDist,touchPt.y()-rectDist),Point2f(touchPt.x()+rectDist,touchPt.y()+rectDist));
+    SelectionVolume rectVol;
+    buildSelectionVolume(pInfo, rectMbr, rectVol);
+
     // Figure out where the screen space objects are, both layout manager
     //  controlled and other
     std::vector<ScreenSpaceObjectLocation> ssObjs;
-    getScreenSpaceObjects(pInfo,ssObjs,now);
+    getScreenSpaceObjects(pInfo,rectVol,ssObjs,now);
     if (layoutManager)
         layoutManager->getScreenSpaceObjects(pInfo,ssObjs);
     
@@ -897,31 +1058,8 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
             
             if (!screenObj.shapeIDs.empty())
             {
-                Matrix2d screenRotMat;
-                float screenRot = 0.0;
-                CGPoint objPt;
-                objPt.x = projPt.x();  objPt.y = projPt.y();
-                if (screenObj.rotation != 0.0)
-                    screenRotMat = calcScreenRot(screenRot,pInfo.viewState,pInfo.globeViewState,&screenObj,objPt,modelTrans,normalMat,frameBufferSize);
-
                 std::vector<Point2f> screenPts;
-                if (screenRot == 0.0)
-                {
-                    for (unsigned int kk=0;kk<screenObj.pts.size();kk++)
-                    {
-                        const Point2d &screenObjPt = screenObj.pts[kk];
-                        Point2d theScreenPt = Point2d(screenObjPt.x(),-screenObjPt.y()) + projPt + Point2d(screenObj.offset.x(),-screenObj.offset.y());
-                        screenPts.push_back(Point2f(theScreenPt.x(),theScreenPt.y()));
-                    }
-                } else {
-                    Point2d center(objPt.x,objPt.y);
-                    for (unsigned int kk=0;kk<screenObj.pts.size();kk++)
-                    {
-                        const Point2d screenObjPt = screenRotMat * (screenObj.pts[kk] + Point2d(screenObj.offset.x(),screenObj.offset.y()));
-                        Point2d theScreenPt = Point2d(screenObjPt.x(),-screenObjPt.y()) + projPt;
-                        screenPts.push_back(Point2f(theScreenPt.x(),theScreenPt.y()));
-                    }
-                }
+                screenSpaceObjectPoints(pInfo,screenObj,projPt,modelTrans,normalMat,frameBufferSize,screenPts);
                 
                 // Note: Debugging
 //                {
@@ -981,10 +1119,14 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
 
     if (!polytopeSelectables.empty())
     {
+        std::vector<SimpleIdentity> candIDs;
+        polytopeIndex.findInVolume(touchVol, candIDs);
         // Work through the axis aligned rectangular solids
-        for (PolytopeSelectableSet::iterator it = polytopeSelectables.begin();
-             it != polytopeSelectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
+            PolytopeSelectableSet::iterator it = polytopeSelectables.find(PolytopeSelectable(candID));
+            if (it == polytopeSelectables.end())
+                continue;
             PolytopeSelectable sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
@@ -1099,9 +1241,13 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
     
     if (!linearSelectables.empty())
     {
-        for (LinearSelectableSet::iterator it = linearSelectables.begin();
-             it != linearSelectables.end(); ++it)
+        std::vector<SimpleIdentity> candIDs;
+        linearIndex.findInVolume(touchVol, candIDs);
+        for (SimpleIdentity candID : candIDs)
         {
+            LinearSelectableSet::iterator it = linearSelectables.find(LinearSelectable(candID));
+            if (it == linearSelectables.end())
+                continue;
             LinearSelectable sel = *it;
             
             if (sel.selectID != EmptyIdentity && sel.enable)
@@ -1151,10 +1297,14 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
     
     if (!rect3Dselectables.empty())
     {
+        std::vector<SimpleIdentity> candIDs;
+        rect3DIndex.findInVolume(touchVol, candIDs);
         // Work through the 3D rectangles
-        for (RectSelectable3DSet::iterator it = rect3Dselectables.begin();
-             it != rect3Dselectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
+            RectSelectable3DSet::iterator it = rect3Dselectables.find(RectSelectable3D(candID));
+            if (it == rect3Dselectables.end())
+                continue;
             RectSelectable3D sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
@@ -1216,10 +1366,14 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
     
     if (!billboardSelectables.empty())
     {
+        std::vector<SimpleIdentity> candIDs;
+        billboardIndex.findInVolume(touchVol, candIDs);
         // Work through the billboards
-        for (BillboardSelectableSet::iterator it = billboardSelectables.begin();
-             it != billboardSelectables.end(); ++it)
+        for (SimpleIdentity candID : candIDs)
         {
+            BillboardSelectableSet::iterator it = billboardSelectables.find(BillboardSelectable(candID));
+            if (it == billboardSelectables.end())
+                continue;
             BillboardSelectable sel = *it;
             if (sel.selectID != EmptyIdentity && sel.enable)
             {
@@ -1277,3 +1431,393 @@ void SelectionManager::pickObjects(Point2f touchPt,float maxDist,WhirlyKitView *
     
     pthread_mutex_unlock(&mutex);
 }
+
+// Check if two line segments cross
+static bool SegmentsIntersect(const Point2f &a0,const Point2f &a1,const Point2f &b0,const Point2f &b1)
+{
+    Point2f da = a1-a0, db = b1-b0;
+    float denom = da.x()*db.y() - da.y()*db.x();
+    if (denom == 0.0)
+        return false;
+    Point2f diff = b0-a0;
+    float s = (diff.x()*db.y() - diff.y()*db.x())/denom;
+    float t = (diff.x()*da.y() - diff.y()*da.x())/denom;
+    return (s >= 0.0 && s <= 1.0 && t >= 0.0 && t <= 1.0);
+}
+
+// Check if a projected outline (closed polygon or open line) touches the given polygon
+static bool OutlineOverlapsPolygon(const std::vector<Point2f> &outline,bool closed,const std::vector<Point2f> &poly)
+{
+    if (outline.empty())
+        return false;
+    
+    for (const Point2f &pt : outline)
+        if (PointInPolygon(pt, poly))
+            return true;
+    
+    // Polygon might be entirely inside the outline
+    if (closed && outline.size() > 2 && PointInPolygon(poly[0], outline))
+        return true;
+    
+    unsigned int numSegs = closed ? outline.size() : outline.size()-1;
+    for (unsigned int ii=0;ii<numSegs;ii++)
+    {
+        const Point2f &p0 = outline[ii], &p1 = outline[(ii+1)%outline.size()];
+        for (unsigned int jj=0;jj<poly.size();jj++)
+            if (SegmentsIntersect(p0, p1, poly[jj], poly[(jj+1)%poly.size()]))
+                return true;
+    }
+    
+    return false;
+}
+
+// Check a selectable against the current visibility range
+static bool SelectableVisibleAt(const Selectable &sel,double heightAboveSurface)
+{
+    return sel.minVis == DrawVisibleInvalid ||
+        (sel.minVis < heightAboveSurface && heightAboveSurface < sel.maxVis);
+}
+
+void SelectionManager::findObjectsInScreenPolygon(const std::vector<Point2f> &screenPoly,const PlacementInfo &pInfo,SimpleIDSet &selectIDs)
+{
+    if (screenPoly.size() < 3 || (!pInfo.globeView && !pInfo.mapView))
+        return;
+    
+    NSTimeInterval now = CFAbsoluteTimeGetCurrent();
+    
+    Vector4d eyeVec4 = pInfo.viewAndModelInvMat * Vector4d(0,0,1,0);
+    Vector3d eyeVec(eyeVec4.x(),eyeVec4.y(),eyeVec4.z());
+    Matrix4d modelTrans = pInfo.viewState.fullMatrices[0];
+    Matrix4d normalMat = pInfo.viewState.fullMatrices[0].inverse().transpose();
+    Point2f frameBufferSize = pInfo.frameSize;
+    
+    LayoutManager *layoutManager = (LayoutManager *)scene->getManager(kWKLayoutManager);
+    
+    pthread_mutex_lock(&mutex);
+    
+    updateIndices();
+    
+    // Volumes for the region on the screen and for the 2D rectangles indexed by center
+    Mbr polyMbr(screenPoly);
+    SelectionVolume polyVol;
+    buildSelectionVolume(pInfo, polyMbr, polyVol);
+    Mbr rectMbr(polyMbr.ll() - Point2f(rect2DMaxExtent,rect2DMaxExtent),polyMbr.ur() + Point2f(rect2DMaxExtent,rect2DMaxExtent));
+    SelectionVolume rectVol;
+    buildSelectionVolume(pInfo, rectMbr, rectVol);
+    
+    // Screen space objects, both layout manager controlled and other
+    std::vector<ScreenSpaceObjectLocation> ssObjs;
+    getScreenSpaceObjects(pInfo,rectVol,ssObjs,now);
+    if (layoutManager)
+        layoutManager->getScreenSpaceObjects(pInfo,ssObjs);
+    for (ScreenSpaceObjectLocation &screenObj : ssObjs)
+    {
+        if (screenObj.shapeIDs.empty())
+            continue;
+        
+        std::vector<Point2d> projPts;
+        projectWorldPointToScreen(screenObj.dispLoc, pInfo, projPts, scale);
+        for (const Point2d &projPt : projPts)
+        {
+            std::vector<Point2f> screenPts;
+            screenSpaceObjectPoints(pInfo,screenObj,projPt,modelTrans,normalMat,frameBufferSize,screenPts);
+            if (OutlineOverlapsPolygon(screenPts, true, screenPoly))
+            {
+                selectIDs.insert(screenObj.shapeIDs.begin(),screenObj.shapeIDs.end());
+                break;
+            }
+        }
+    }
+    
+    // Polytopes, both the indexed ones and the moving ones
+    std::vector<const PolytopeSelectable *> polytopes;
+    std::vector<Point3d> polytopeCenters;
+    {
+        std::vector<SimpleIdentity> candIDs;
+        polytopeIndex.findInVolume(polyVol, candIDs);
+        for (SimpleIdentity candID : candIDs)
+        {
+            PolytopeSelectableSet::iterator it = polytopeSelectables.find(PolytopeSelectable(candID));
+            if (it != polytopeSelectables.end())
+            {
+                polytopes.push_back(&(*it));
+                polytopeCenters.push_back(it->centerPt);
+            }
+        }
+    }
+    for (const MovingPolytopeSelectable &sel : movingPolytopeSelectables)
+    {
+        double t = (now-sel.startTime)/sel.duration;
+        polytopes.push_back(&sel);
+        polytopeCenters.push_back((sel.endCenterPt - sel.centerPt)*t + sel.centerPt);
+    }
+    for (unsigned int pi=0;pi<polytopes.size();pi++)
+    {
+        const PolytopeSelectable &sel = *polytopes[pi];
+        const Point3d &centerPt = polytopeCenters[pi];
+        if (sel.selectID == EmptyIdentity || !sel.enable || !SelectableVisibleAt(sel, pInfo.heightAboveSurface))
+            continue;
+        
+        for (const std::vector<Point3f> &poly3f : sel.polys)
+        {
+            std::vector<Point3d> poly;
+            poly.reserve(poly3f.size());
+            for (const Point3f &pt : poly3f)
+                poly.push_back(Vector3fToVector3d(pt) + centerPt);
+            
+            std::vector<Point2f> screenPts;
+            ClipAndProjectPolygon(pInfo.viewAndModelMat,pInfo.projMat,pInfo.frameSizeScale,poly,screenPts);
+            if (OutlineOverlapsPolygon(screenPts, true, screenPoly))
+            {
+                selectIDs.insert(sel.selectID);
+                break;
+            }
+        }
+    }
+    
+    // Linears are checked segment by segment
+    {
+        std::vector<SimpleIdentity> candIDs;
+        linearIndex.findInVolume(polyVol, candIDs);
+        for (SimpleIdentity candID : candIDs)
+        {
+            LinearSelectableSet::iterator it = linearSelectables.find(LinearSelectable(candID));
+            if (it == linearSelectables.end())
+                continue;
+            const LinearSelectable &sel = *it;
+            if (sel.selectID == EmptyIdentity || !sel.enable || sel.pts.empty() || !SelectableVisibleAt(sel, pInfo.heightAboveSurface))
+                continue;
+            
+            std::vector<Point2d> p0Pts;
+            projectWorldPointToScreen(sel.pts[0],pInfo,p0Pts,scale);
+            bool found = false;
+            for (unsigned int ip=1;ip<sel.pts.size() && !found;ip++)
+            {
+                std::vector<Point2d> p1Pts;
+                projectWorldPointToScreen(sel.pts[ip],pInfo,p1Pts,scale);
+                
+                if (p0Pts.size() == p1Pts.size())
+                {
+                    for (unsigned int iw=0;iw<p0Pts.size();iw++)
+                    {
+                        std::vector<Point2f> seg(2);
+                        seg[0] = Point2f(p0Pts[iw].x(),p0Pts[iw].y());
+                        seg[1] = Point2f(p1Pts[iw].x(),p1Pts[iw].y());
+                        if (OutlineOverlapsPolygon(seg, false, screenPoly))
+                        {
+                            found = true;
+                            break;
+                        }
+                    }
+                }
+                
+                p0Pts = p1Pts;
+            }
+            if (found)
+                selectIDs.insert(sel.selectID);
+        }
+    }
+    
+    // 3D rectangles
+    {
+        std::vector<SimpleIdentity> candIDs;
+        rect3DIndex.findInVolume(polyVol, candIDs);
+        for (SimpleIdentity candID : candIDs)
+        {
+            RectSelectable3DSet::iterator it = rect3Dselectables.find(RectSelectable3D(candID));
+            if (it == rect3Dselectables.end())
+                continue;
+            const RectSelectable3D &sel = *it;
+            if (sel.selectID == EmptyIdentity || !sel.enable || !SelectableVisibleAt(sel, pInfo.heightAboveSurface))
+                continue;
+            
+            std::vector<Point2f> screenPts;
+            for (unsigned int ii=0;ii<4;ii++)
+            {
+                CGPoint screenPt;
+                Point3d pt3d = Vector3fToVector3d(sel.pts[ii]);
+                if (pInfo.globeView)
+                    screenPt = [pInfo.globeView pointOnScreenFromSphere:pt3d transform:&pInfo.viewAndModelMat frameSize:pInfo.frameSizeScale];
+                else
+                    screenPt = [pInfo.mapView pointOnScreenFromPlane:pt3d transform:&pInfo.viewAndModelMat frameSize:pInfo.frameSizeScale];
+                screenPts.push_back(Point2f(screenPt.x,screenPt.y));
+            }
+            if (OutlineOverlapsPolygon(screenPts, true, screenPoly))
+                selectIDs.insert(sel.selectID);
+        }
+    }
+    
+    // Billboards
+    {
+        std::vector<SimpleIdentity> candIDs;
+        billboardIndex.findInVolume(polyVol, candIDs);
+        for (SimpleIdentity candID : candIDs)
+        {
+            BillboardSelectableSet::iterator it = billboardSelectables.find(BillboardSelectable(candID));
+            if (it == billboardSelectables.end())
+                continue;
+            const BillboardSelectable &sel = *it;
+            if (sel.selectID == EmptyIdentity || !sel.enable)
+                continue;
+            
+            // Same rectangle in display space we use for picking
+            std::vector<Point3d> poly(4);
+            Point3d axisX = eyeVec.cross(sel.normal);
+            poly[0] = -sel.size.x()/2.0 * axisX + sel.center;
+            poly[3] = sel.size.x()/2.0 * axisX + sel.center;
+            poly[2] = -sel.size.x()/2.0 * axisX + sel.size.y() * sel.normal + sel.center;
+            poly[1] = sel.size.x()/2.0 * axisX + sel.size.y() * sel.normal + sel.center;
+            
+            std::vector<Point2f> screenPts;
+            ClipAndProjectPolygon(pInfo.viewAndModelMat,pInfo.projMat,pInfo.frameSizeScale,poly,screenPts);
+            if (OutlineOverlapsPolygon(screenPts, true, screenPoly))
+                selectIDs.insert(sel.selectID);
+        }
+    }
+    
+    pthread_mutex_unlock(&mutex);
+}
+
+void SelectionManager::findObjectsInGeoMbr(const GeoMbr &geoMbr,SimpleIDSet &selectIDs)
+{
+    CoordSystemDisplayAdapter *coordAdapter = scene->getCoordAdapter();
+    if (!coordAdapter)
+        return;
+    CoordSystem *coordSys = coordAdapter->getCoordSystem();
+    NSTimeInterval now = CFAbsoluteTimeGetCurrent();
+    
+    pthread_mutex_lock(&mutex);
+    
+    updateIndices();
+    
+    // Everything indexed, which tells us how far off the surface things go
+    BBox allBounds;
+    SelectableIndex *indices[5] = {&rect3DIndex,&rect2DIndex,&polytopeIndex,&linearIndex,&billboardIndex};
+    for (SelectableIndex *index : indices)
+    {
+        BBox bounds;
+        if (index->getBounds(bounds))
+        {
+            allBounds.addPoint(bounds.ll());
+            allBounds.addPoint(bounds.ur());
+        }
+    }
+    
+    bool haveBounds = allBounds.isValid();
+    double maxRad = haveBounds ? std::max(std::max(allBounds.ll().norm(),allBounds.ur().norm()),1.0) : 1.0;
+    
+    // Sample the geographic bounds to get a box in display space for each side of the date line
+    static const int NumSamples = 16;
+    SelectionVolume vol;
+    std::vector<Mbr> mbrs;
+    geoMbr.splitIntoMbrs(mbrs);
+    for (const Mbr &mbr : mbrs)
+    {
+        Point2f span = mbr.ur() - mbr.ll();
+        BBox bbox;
+        for (int ix=0;ix<=NumSamples;ix++)
+            for (int iy=0;iy<=NumSamples;iy++)
+            {
+                Point2d geoPt(mbr.ll().x() + ix*span.x()/NumSamples,mbr.ll().y() + iy*span.y()/NumSamples);
+                Point3d dispPt = coordAdapter->localToDisplay(coordSys->geographicToLocal(geoPt));
+                bbox.addPoint(dispPt);
+                if (coordAdapter->isFlat())
+                {
+                    // Cover anything above or below the plane
+                    if (haveBounds)
+                    {
+                        bbox.addPoint(Point3d(dispPt.x(),dispPt.y(),allBounds.ll().z()));
+                        bbox.addPoint(Point3d(dispPt.x(),dispPt.y(),allBounds.ur().z()));
+                    }
+                } else {
+                    // Cover anything sticking up off the globe
+                    bbox.addPoint(dispPt * maxRad);
+                }
+            }
+        
+        // The globe surface bulges out between samples
+        double pad = 0.0;
+        if (!coordAdapter->isFlat())
+            pad = maxRad * (1.0 - cos(std::max(span.x(),span.y())/NumSamples/2.0));
+        BBox padBox;
+        padBox.addPoint(bbox.ll() - Point3d(pad,pad,pad));
+        padBox.addPoint(bbox.ur() + Point3d(pad,pad,pad));
+        vol.addBBox(padBox);
+    }
+    
+    // Gather up the display points that represent each candidate
+    std::map<SimpleIdentity,std::vector<Point3d> > candPts;
+    std::vector<SimpleIdentity> candIDs;
+    rect2DIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        RectSelectable2DSet::iterator it = rect2Dselectables.find(RectSelectable2D(candID));
+        if (it != rect2Dselectables.end() && it->enable)
+            candPts[candID].push_back(it->center);
+    }
+    for (const MovingRectSelectable2D &sel : movingRect2Dselectables)
+        if (sel.enable)
+            candPts[sel.selectID].push_back(sel.centerForTime(now));
+    candIDs.clear();
+    rect3DIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        RectSelectable3DSet::iterator it = rect3Dselectables.find(RectSelectable3D(candID));
+        if (it != rect3Dselectables.end() && it->enable)
+            for (unsigned int ii=0;ii<4;ii++)
+                candPts[candID].push_back(Vector3fToVector3d(it->pts[ii]));
+    }
+    candIDs.clear();
+    polytopeIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        PolytopeSelectableSet::iterator it = polytopeSelectables.find(PolytopeSelectable(candID));
+        if (it != polytopeSelectables.end() && it->enable)
+        {
+            std::vector<Point3d> &pts = candPts[candID];
+            for (const std::vector<Point3f> &poly : it->polys)
+                for (const Point3f &pt : poly)
+                    pts.push_back(Vector3fToVector3d(pt) + it->centerPt);
+        }
+    }
+    for (const MovingPolytopeSelectable &sel : movingPolytopeSelectables)
+        if (sel.enable)
+        {
+            double t = (now-sel.startTime)/sel.duration;
+            Point3d centerPt = (sel.endCenterPt - sel.centerPt)*t + sel.centerPt;
+            std::vector<Point3d> &pts = candPts[sel.selectID];
+            for (const std::vector<Point3f> &poly : sel.polys)
+                for (const Point3f &pt : poly)
+                    pts.push_back(Vector3fToVector3d(pt) + centerPt);
+        }
+    candIDs.clear();
+    linearIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        LinearSelectableSet::iterator it = linearSelectables.find(LinearSelectable(candID));
+        if (it != linearSelectables.end() && it->enable)
+            candPts[candID].insert(candPts[candID].end(),it->pts.begin(),it->pts.end());
+    }
+    candIDs.clear();
+    billboardIndex.findInVolume(vol, candIDs);
+    for (SimpleIdentity candID : candIDs)
+    {
+        BillboardSelectableSet::iterator it = billboardSelectables.find(BillboardSelectable(candID));
+        if (it != billboardSelectables.end() && it->enable)
+            candPts[candID].push_back(it->center);
+    }
+    
+    pthread_mutex_unlock(&mutex);
+    
+    // Now for the real geographic check
+    for (const auto &it : candPts)
+    {
+        if (it.first == EmptyIdentity)
+            continue;
+        GeoMbr candMbr;
+        for (const Point3d &pt : it.second)
+            candMbr.addGeoCoord(coordSys->localToGeographic(coordAdapter->displayToLocal(pt)));
+        if (candMbr.valid() && candMbr.overlaps(geoMbr))
+            selectIDs.insert(it.first);
+    }
+}
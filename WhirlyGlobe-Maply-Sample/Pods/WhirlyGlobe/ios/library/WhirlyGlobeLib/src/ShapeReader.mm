@@ -26,12 +26,21 @@ namespace WhirlyKit
 {
 
 ShapeReader::ShapeReader(NSString *fileName)
+    : fileName(fileName), shp(NULL), attrReader(NULL), where(0), numEntity(0)
 {
 	const char *cFile =  [fileName cStringUsingEncoding:NSASCIIStringEncoding];
 	shp = SHPOpen(cFile, "rb");
 	if (!shp)
 		return;
-	dbf = DBFOpen(cFile, "rb");
+	attrReader = new DBFColumnReader(fileName);
+    if (!attrReader->isValid())
+    {
+        delete attrReader;
+        attrReader = NULL;
+    } else {
+        for (int ii=0;ii<attrReader->getNumFields();ii++)
+            allFields.push_back(ii);
+    }
 	where = 0;	
 	SHPGetInfo((SHPInfo *)shp, &numEntity, &shapeType, minBound, maxBound);
 }
@@ -40,8 +49,8 @@ ShapeReader::~ShapeReader()
 {
 	if (shp)
 		SHPClose((SHPHandle)shp);
-	if (dbf)
-		DBFClose((DBFHandle)dbf);
+	if (attrReader)
+		delete attrReader;
 }
 	
 bool ShapeReader::isValid()
@@ -53,6 +62,24 @@ unsigned int ShapeReader::getNumObjects()
 {
     return numEntity;
 }
+    
+// Shapelib handles aren't thread safe, so each thread gets its own
+VectorReader *ShapeReader::clone()
+{
+    ShapeReader *newReader = new ShapeReader(fileName);
+    if (!newReader->isValid())
+    {
+        delete newReader;
+        return NULL;
+    }
+    
+    return newReader;
+}
+    
+const DBFColumnReader *ShapeReader::getAttrReader()
+{
+    return attrReader;
+}
 
 /* Shapefiles support a lot of types.  Here are the ones we recognize:
     SHPT_ARC            yes
@@ -147,54 +174,25 @@ VectorShapeRef ShapeReader::getObjectByIndex(unsigned int vecIndex,const StringS
 	SHPDestroyObject(thisShape);
 	
 	// Attributes
-    // Note: Probably not complete
-	char attrTitle[12];
-	int attrWidth, numDecimals;
+    // Only the fields in the filter get decoded, if there is one
 	NSMutableDictionary *attrDict = [[NSMutableDictionary alloc] init];
 	theShape->setAttrDict(attrDict);
-	DBFHandle dbfHandle = (DBFHandle)dbf;
-	int numDbfRecord = DBFGetRecordCount(dbfHandle);
-	if (vecIndex < numDbfRecord)
-	{
-		for (unsigned int ii = 0; ii < DBFGetFieldCount(dbfHandle); ii++)
-		{
-			DBFFieldType attrType = DBFGetFieldInfo(dbfHandle, ii, attrTitle, &attrWidth, &numDecimals);
-            // If we have a set of filter attrs, skip this one if it's not there
-            if (filterAttrs && (filterAttrs->find(attrTitle) == filterAttrs->end()))
-                continue;
-			NSString *attrTitleStr = [NSString stringWithFormat:@"%s",attrTitle];
-			
-			if (!DBFIsAttributeNULL(dbfHandle, vecIndex, ii))
-			{
-				switch (attrType)
-				{
-					case FTString:
-					{
-						const char *str = DBFReadStringAttribute(dbfHandle, vecIndex, ii);
-                        NSString *newStr = [NSString stringWithCString:str encoding:NSASCIIStringEncoding];
-                        if (newStr)
-                            [attrDict setObject:newStr forKey:attrTitleStr];
-                        //						[attrDict setObject:[NSString stringWithFormat:@"%s",str] forKey:attrTitleStr];
-					}
-						break;
-					case FTInteger:
-					{
-						NSNumber *num = [NSNumber numberWithInt:DBFReadIntegerAttribute(dbfHandle, vecIndex, ii)];
-						[attrDict setObject:num forKey:attrTitleStr];
-					}
-						break;
-					case FTDouble:
-					{
-						NSNumber *num = [NSNumber numberWithDouble:DBFReadDoubleAttribute(dbfHandle, vecIndex, ii)];
-						[attrDict setObject:num forKey:attrTitleStr];
-					}
-						break;
-                    default:
-                        break;
-				}
-			}
-		}
-	}
+    if (attrReader)
+    {
+        if (filterAttrs)
+        {
+            std::vector<int> fields;
+            fields.reserve(filterAttrs->size());
+            for (const std::string &attrName : *filterAttrs)
+            {
+                int field = attrReader->getFieldIndex(attrName);
+                if (field >= 0)
+                    fields.push_back(field);
+            }
+            attrReader->readAttributes(vecIndex, fields, attrDict);
+        } else
+            attrReader->readAttributes(vecIndex, allFields, attrDict);
+    }
     
     // Let the user know what index this is
     [attrDict setObject:[NSNumber numberWithInt:vecIndex] forKey:@"wgshapefileidx"];
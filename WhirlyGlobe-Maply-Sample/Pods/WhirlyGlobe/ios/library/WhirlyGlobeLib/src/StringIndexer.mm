@@ -85,6 +85,7 @@ StringIdentity u_FadeNameID;
 StringIdentity u_pMatrixNameID;
 StringIdentity u_ScaleNameID;
 StringIdentity u_HasTextureNameID;
+StringIdentity u_OctNormalsNameID;
 StringIdentity a_SingleMatrixNameID;
 StringIdentity a_PositionNameID;
 StringIdentity u_EyeVecNameID;
@@ -95,6 +96,7 @@ StringIdentity u_lifetimeNameID;
 StringIdentity u_pixDispSizeNameID;
 StringIdentity u_frameLenID;
 StringIdentity a_offsetNameID;
+StringIdentity a_sdfParamsNameID;
 StringIdentity u_uprightNameID;
 StringIdentity u_activerotNameID;
 StringIdentity a_rotNameID;
@@ -162,6 +164,7 @@ void SetupDrawableStrings()
     u_pMatrixNameID = StringIndexer::getStringID("u_pMatrix");
     u_ScaleNameID = StringIndexer::getStringID("u_scale");
     u_HasTextureNameID = StringIndexer::getStringID("u_hasTexture");
+    u_OctNormalsNameID = StringIndexer::getStringID("u_octNormals");
     a_SingleMatrixNameID = StringIndexer::getStringID("a_singleMatrix");
     a_PositionNameID = StringIndexer::getStringID("a_position");
     u_EyeVecNameID = StringIndexer::getStringID("u_eyeVec");
@@ -172,6 +175,7 @@ void SetupDrawableStrings()
     u_pixDispSizeNameID = StringIndexer::getStringID("u_pixDispSize");
     u_frameLenID = StringIndexer::getStringID("u_frameLen");
     a_offsetNameID = StringIndexer::getStringID("a_offset");
+    a_sdfParamsNameID = StringIndexer::getStringID("a_sdfParams");
     u_uprightNameID = StringIndexer::getStringID("u_upright");
     u_activerotNameID = StringIndexer::getStringID("u_activerot");
     a_rotNameID = StringIndexer::getStringID("a_rot");
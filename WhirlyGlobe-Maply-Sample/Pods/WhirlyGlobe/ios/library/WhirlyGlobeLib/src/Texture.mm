@@ -21,6 +21,7 @@
 #import "GLUtils.h"
 #import "Texture.h"
 #import "UIImage+Stuff.h"
+#import "PixelConvert.h"
 
 using namespace WhirlyKit;
 
@@ -29,20 +30,13 @@ using namespace WhirlyKit;
 NSData *ConvertRGBATo565(NSData *inData)
 {
     uint32_t pixelCount = (uint32_t)[inData length]/4;
-    void *temp = malloc(pixelCount * 2);
-    uint32_t *inPixel32  = (uint32_t *)[inData bytes];
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 3);
-        uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 2);
-        uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 3);
-        
-        *outPixel16++ = (r << 11) | (g << 5) | (b << 0);
-    }
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(pixelCount * 2,&temp);
+    if (!outData)
+        return nil;
+    PixelConvertRGBATo565((const uint32_t *)[inData bytes],(uint16_t *)temp,pixelCount);
     
-    return [NSData dataWithBytesNoCopy:temp length:pixelCount*2 freeWhenDone:YES];
+    return outData;
 }
 
 
@@ -50,42 +44,26 @@ NSData *ConvertRGBATo565(NSData *inData)
 NSData *ConvertRGBATo4444(NSData *inData)
 {
     uint32_t pixelCount = (uint32_t)[inData length]/4;
-    void *temp = malloc(pixelCount * 2);
-    uint32_t *inPixel32  = (uint32_t *)[inData bytes];
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 4);
-        uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 4);
-        uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 4);
-        uint32_t a = (((*inPixel32 >> 24) & 0xFF) >> 4);
-        
-        *outPixel16++ = (r << 12) | (g << 8) | (b << 4) | (a<< 0);
-    }
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(pixelCount * 2,&temp);
+    if (!outData)
+        return nil;
+    PixelConvertRGBATo4444((const uint32_t *)[inData bytes],(uint16_t *)temp,pixelCount);
     
-    return [NSData dataWithBytesNoCopy:temp length:pixelCount*2 freeWhenDone:YES];
+    return outData;
 }
 
 // Convert a buffer in RGBA to 2-byte 5551
 NSData *ConvertRGBATo5551(NSData *inData)
 {
     uint32_t pixelCount = (uint32_t)[inData length]/4;
-    void *temp = malloc(pixelCount * 2);
-    uint32_t *inPixel32  = (uint32_t *)[inData bytes];
-    uint16_t *outPixel16 = (uint16_t *)temp;
-    
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
-    {
-        uint32_t r = (((*inPixel32 >> 0)  & 0xFF) >> 3);
-        uint32_t g = (((*inPixel32 >> 8)  & 0xFF) >> 3);
-        uint32_t b = (((*inPixel32 >> 16) & 0xFF) >> 3);
-        uint32_t a = (((*inPixel32 >> 24) & 0xFF) >> 7);
-        
-        *outPixel16++ = (r << 11) | (g << 6) | (b << 1) | (a << 0);
-    }
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(pixelCount * 2,&temp);
+    if (!outData)
+        return nil;
+    PixelConvertRGBATo5551((const uint32_t *)[inData bytes],(uint16_t *)temp,pixelCount);
     
-    return [NSData dataWithBytesNoCopy:temp length:pixelCount*2 freeWhenDone:YES];
+    return outData;
 }
 
 // Convert a buffer in A to 1-byte alpha but align it to 32 bits
@@ -98,7 +76,10 @@ NSData *ConvertAToA(NSData *inData,int width,int height)
     if (extra == 4) extra = 0;
     int outWidth = width + extra;
     
-    unsigned char *temp = (unsigned char *)malloc(outWidth*height);
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(outWidth*height,&temp);
+    if (!outData)
+        return nil;
     
     const unsigned char *inBytes = (const unsigned char *)[inData bytes];
     unsigned char *outBytes = (unsigned char *)temp;
@@ -109,7 +90,7 @@ NSData *ConvertAToA(NSData *inData,int width,int height)
         outBytes += outWidth;
     }
 
-    return [NSData dataWithBytesNoCopy:temp length:outWidth*height freeWhenDone:YES];
+    return outData;
 }
 
 // Convert a buffer in RG to a 2-byte RG but align it to 32 bits
@@ -122,18 +103,21 @@ NSData *ConvertRGToRG(NSData *inData,int width,int height)
     if (extra == 2) extra = 0;
     int outWidth = width + extra;
     
-    unsigned char *temp = (unsigned char *)malloc(outWidth*height*2);
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(outWidth*height*2,&temp);
+    if (!outData)
+        return nil;
     
     const unsigned char *inBytes = (const unsigned char *)[inData bytes];
     unsigned char *outBytes = (unsigned char *)temp;
     for (int32_t h=0;h<height;h++) {
-        bzero(&outBytes[width], 2*extra);
+        bzero(&outBytes[2*width], 2*extra);
         bcopy(inBytes, outBytes, 2*width);
         inBytes += 2*width;
         outBytes += 2*outWidth;
     }
     
-    return [NSData dataWithBytesNoCopy:temp length:outWidth*height*2 freeWhenDone:YES];
+    return outData;
 }
 
 NSData *ConvertRGBATo16(NSData *inData,int width,int height)
@@ -142,87 +126,76 @@ NSData *ConvertRGBATo16(NSData *inData,int width,int height)
     if (extra == 2) extra = 0;
     int outWidth = width + extra;
 
-    unsigned char *temp = (unsigned char *)malloc(outWidth*height*2);
-    bzero(temp,outWidth*height*2);
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(outWidth*height*2,&temp);
+    if (!outData)
+        return nil;
     
-    uint32_t *inPixel32row  = (uint32_t *)[inData bytes];
+    const uint32_t *inPixel32row  = (const uint32_t *)[inData bytes];
     uint8_t *outPixel8row = (uint8_t *)temp;
     for (int32_t h=0;h<height;h++) {
-        uint32_t *inPixel32 = inPixel32row;
-        uint8_t *outPixel8 = outPixel8row;
-        for (int32_t w=0;w<width;w++) {
-            uint32_t r = ((*inPixel32 >> 0)  & 0xFF);
-            uint32_t g = ((*inPixel32 >> 8)  & 0xFF);
-            outPixel8[0] = r;
-            outPixel8[1] = g;
-            
-            inPixel32++;
-            outPixel8+=2;
-        }
+        PixelExtractRG(inPixel32row,outPixel8row,width);
+        // Pooled buffers aren't clean, so zero the padding
+        if (extra)
+            bzero(&outPixel8row[2*width],2*extra);
         
         inPixel32row += width;
         outPixel8row += 2*outWidth;
     }
     
-    return [NSData dataWithBytesNoCopy:temp length:outWidth*height*2 freeWhenDone:YES];
+    return outData;
 }
 
 // Convert a buffer in RGBA to 1-byte alpha
 NSData *ConvertRGBATo8(NSData *inData,WKSingleByteSource source)
 {
     uint32_t pixelCount = (uint32_t)[inData length]/4;
-    void *temp = malloc(pixelCount);
-    uint32_t *inPixel32  = (uint32_t *)[inData bytes];
+    void *temp = NULL;
+    NSData *outData = PixelBufferPoolData(pixelCount,&temp);
+    if (!outData)
+        return nil;
+    const uint32_t *inPixel32  = (const uint32_t *)[inData bytes];
     uint8_t *outPixel8 = (uint8_t *)temp;
     
-    for(uint32_t i=0; i<pixelCount; i++, inPixel32++)
+    switch (source)
     {
-        uint32_t r = ((*inPixel32 >> 0)  & 0xFF);
-        uint32_t g = ((*inPixel32 >> 8)  & 0xFF);
-        uint32_t b = ((*inPixel32 >> 16) & 0xFF);
-        uint32_t a = ((*inPixel32 >> 24) & 0xFF);
-        int sum = 0;
-        switch (source)
-        {
-            case WKSingleRed:
-                sum = r;
-                break;
-            case WKSingleGreen:
-                sum = g;
-                break;
-            case WKSingleBlue:
-                sum = b;
-                break;
-            case WKSingleRGB:
-                sum = ((int)r + (int)g + (int)b)/3;
-                break;
-            case WKSingleAlpha:
-                sum = a;
-                break;
-        }
-        *outPixel8++ = (uint8_t)sum;
+        case WKSingleRed:
+            PixelExtractChannel(inPixel32,outPixel8,pixelCount,0);
+            break;
+        case WKSingleGreen:
+            PixelExtractChannel(inPixel32,outPixel8,pixelCount,1);
+            break;
+        case WKSingleBlue:
+            PixelExtractChannel(inPixel32,outPixel8,pixelCount,2);
+            break;
+        case WKSingleRGB:
+            PixelAverageRGB(inPixel32,outPixel8,pixelCount);
+            break;
+        case WKSingleAlpha:
+            PixelExtractChannel(inPixel32,outPixel8,pixelCount,3);
+            break;
     }
     
-    return [NSData dataWithBytesNoCopy:temp length:pixelCount freeWhenDone:YES];
+    return outData;
 }
 
 namespace WhirlyKit
 {
 	
 Texture::Texture(const std::string &name)
-	: TextureBase(name), texData(NULL), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false)
+	: TextureBase(name), texData(NULL), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false), etc2Quality(WKETC2Fast)
 {
 }
 	
 // Construct with raw texture data
 Texture::Texture(const std::string &name,NSData *texData,bool isPVRTC)
-	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false)
+	: TextureBase(name), texData(texData), isPVRTC(isPVRTC), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false), etc2Quality(WKETC2Fast)
 { 
 }
 
 // Set up the texture from a filename
 Texture::Texture(const std::string &name,NSString *baseName,NSString *ext)
-    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false)
+    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false), etc2Quality(WKETC2Fast)
 {	
 	if (![ext compare:@"pvrtc"])
 	{
@@ -255,13 +228,13 @@ Texture::Texture(const std::string &name,NSString *baseName,NSString *ext)
 
 // Construct with a UIImage
 Texture::Texture(const std::string &name,UIImage *inImage,bool roundUp)
-    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false)
+    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false), etc2Quality(WKETC2Fast)
 {
 	texData = [inImage rawDataRetWidth:&width height:&height roundUp:roundUp];
 }
 
 Texture::Texture(const std::string &name,UIImage *inImage,int inWidth,int inHeight)
-    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false)
+    : TextureBase(name), texData(nil), isPVRTC(false), isPKM(false), usesMipmaps(false), wrapU(false), wrapV(false), format(GL_UNSIGNED_BYTE), byteSource(WKSingleRGB), interpType(GL_LINEAR), isEmptyTexture(false), etc2Quality(WKETC2Fast)
 {
     texData = [inImage rawDataScaleWidth:inWidth height:inHeight border:0];
     width = inWidth;  height = inHeight;
@@ -281,44 +254,109 @@ NSData *Texture::processData()
 	{
         return texData;
 	} else {
-        // Depending on the format, we may need to mess around with the bytes
         switch (format)
         {
-            case GL_UNSIGNED_BYTE:
-            default:
-                return texData;
-                break;
-            case GL_UNSIGNED_SHORT_5_6_5:
-                return ConvertRGBATo565(texData);
-                break;
-            case GL_UNSIGNED_SHORT_4_4_4_4:
-                return ConvertRGBATo4444(texData);
-                break;
-            case GL_UNSIGNED_SHORT_5_5_5_1:
-                return ConvertRGBATo5551(texData);
-                break;
-            case GL_ALPHA:
-                if ([texData length] == width * height)
-                    return ConvertAToA(texData,width,height);
-                return ConvertRGBATo8(texData,byteSource);
-                break;
-            case GL_RG:
-                if ([texData length] == width * height * 2)
-                    return ConvertRGToRG(texData,width,height);
-                else if ([texData length] == width * height * 4)
-                    return ConvertRGBATo16(texData,width,height);
-                NSLog(@"Texture: Not handling RG conversion case.");
-                break;
             case GL_COMPRESSED_RGB8_ETC2:
-                // Can't convert this (for now)
-                return texData;
+            case GL_COMPRESSED_RGBA8_ETC2_EAC:
+                // Raw data should have been encoded on the loader thread, but we'll do it here if not
+                if (compressETC2())
+                    return texData;
+                return processData();
+                break;
+            default:
+                return convertData(texData,width,height);
                 break;
         }
 	}
     
     return nil;
 }
+
+NSData *Texture::convertData(NSData *data,int dataWidth,int dataHeight)
+{
+    // Depending on the format, we may need to mess around with the bytes
+    switch (format)
+    {
+        case GL_UNSIGNED_BYTE:
+        default:
+            return data;
+            break;
+        case GL_UNSIGNED_SHORT_5_6_5:
+            return ConvertRGBATo565(data);
+            break;
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+            return ConvertRGBATo4444(data);
+            break;
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            return ConvertRGBATo5551(data);
+            break;
+        case GL_ALPHA:
+            if ([data length] == dataWidth * dataHeight)
+                return ConvertAToA(data,dataWidth,dataHeight);
+            return ConvertRGBATo8(data,byteSource);
+            break;
+        case GL_RG:
+            if ([data length] == dataWidth * dataHeight * 2)
+                return ConvertRGToRG(data,dataWidth,dataHeight);
+            else if ([data length] == dataWidth * dataHeight * 4)
+                return ConvertRGBATo16(data,dataWidth,dataHeight);
+            NSLog(@"Texture: Not handling RG conversion case.");
+            break;
+    }
+    
+    return nil;
+}
+
+bool Texture::compressETC2()
+{
+    if (isPVRTC || isPKM || !texData)
+        return false;
+    if (format != GL_COMPRESSED_RGB8_ETC2 && format != GL_COMPRESSED_RGBA8_ETC2_EAC)
+        return false;
+    
+    // Has to be raw RGBA and whole blocks, or the atlases won't take it
+    NSData *pkmData = nil;
+    if ([texData length] == width * height * 4 && width % 4 == 0 && height % 4 == 0)
+        pkmData = ETC2EncodeRGBA((const uint8_t *)[texData bytes],width,height,format == GL_COMPRESSED_RGBA8_ETC2_EAC,etc2Quality);
+    if (!pkmData)
+    {
+        NSLog(@"Texture: Can't encode %dx%d texture as ETC2.  Falling back to RGBA.",width,height);
+        format = GL_UNSIGNED_BYTE;
+        return false;
+    }
+    
+    setPKMData(pkmData);
+    
+    return true;
+}
     
+bool Texture::buildMipmaps(WKMipFilter filter)
+{
+    if (isPVRTC || isPKM || !texData)
+        return false;
+    
+    // Only for the formats we convert from RGBA
+    switch (format)
+    {
+        case GL_UNSIGNED_BYTE:
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+        case GL_ALPHA:
+        case GL_RG:
+            break;
+        default:
+            return false;
+    }
+    if ([texData length] != width * height * 4)
+        return false;
+    
+    mipData.clear();
+    ImageBuildMipChain(texData,width,height,filter,mipData);
+    
+    return !mipData.empty();
+}
+
 void Texture::setPKMData(NSData *inData)
 {
     texData = inData;
@@ -439,40 +477,23 @@ bool Texture::createInGL(OpenGLMemManager *memManager)
         glCompressedTexImage2D(GL_TEXTURE_2D, 0, compressedType, width, height, 0, size, rawData);
         CheckGLError("Texture::createInGL() glCompressedTexImage2D()");
     } else {
-        // Depending on the format, we may need to mess around with the bytes
-        switch (format)
+        uploadLevel(0,width,height,convertedData);
+        
+        // We may have already built the levels on the loader thread
+        if (usesMipmaps && !mipData.empty())
         {
-            case GL_UNSIGNED_BYTE:
-            default:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, [convertedData bytes]);
-                break;
-            case GL_UNSIGNED_SHORT_5_6_5:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, [convertedData bytes]);
-                break;
-            case GL_UNSIGNED_SHORT_4_4_4_4:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, [convertedData bytes]);
-                break;
-            case GL_UNSIGNED_SHORT_5_5_5_1:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, [convertedData bytes]);
-                break;
-            case GL_ALPHA:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, [convertedData bytes]);
-                break;
-            case GL_RG:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, width, height, 0, GL_RG, GL_UNSIGNED_BYTE, [convertedData bytes]);
-                break;
-            case GL_COMPRESSED_RGB8_ETC2:
-                glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB8_ETC2, width, height, 0, (GLsizei)[convertedData length], [convertedData bytes]);
-                break;
-            case GL_DEPTH_COMPONENT16:
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, [convertedData bytes]);
-                break;
+            for (unsigned int ii=0;ii<mipData.size();ii++)
+            {
+                int levelWidth = std::max((int)width >> (ii+1),1);
+                int levelHeight = std::max((int)height >> (ii+1),1);
+                uploadLevel(ii+1,levelWidth,levelHeight,convertData(mipData[ii],levelWidth,levelHeight));
+            }
         }
-        CheckGLError("Texture::createInGL() glTexImage2D()");
-	}	
+	}
     
-    if (usesMipmaps)
+    if (usesMipmaps && mipData.empty())
         glGenerateMipmap(GL_TEXTURE_2D);
+    mipData.clear();
 	
     // Once we've moved it over to OpenGL, let's get rid of this copy
     texData = nil;
@@ -480,6 +501,40 @@ bool Texture::createInGL(OpenGLMemManager *memManager)
 	return true;
 }
 
+// Pass one level of the texture to OpenGL in its final format
+void Texture::uploadLevel(int level,int levelWidth,int levelHeight,NSData *convertedData)
+{
+    switch (format)
+    {
+        case GL_UNSIGNED_BYTE:
+        default:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, [convertedData bytes]);
+            break;
+        case GL_UNSIGNED_SHORT_5_6_5:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, levelWidth, levelHeight, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, [convertedData bytes]);
+            break;
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, [convertedData bytes]);
+            break;
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, [convertedData bytes]);
+            break;
+        case GL_ALPHA:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_ALPHA, levelWidth, levelHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, [convertedData bytes]);
+            break;
+        case GL_RG:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RG8, levelWidth, levelHeight, 0, GL_RG, GL_UNSIGNED_BYTE, [convertedData bytes]);
+            break;
+        case GL_COMPRESSED_RGB8_ETC2:
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB8_ETC2, levelWidth, levelHeight, 0, (GLsizei)[convertedData length], [convertedData bytes]);
+            break;
+        case GL_DEPTH_COMPONENT16:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT16, levelWidth, levelHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, [convertedData bytes]);
+            break;
+    }
+    CheckGLError("Texture::createInGL() glTexImage2D()");
+}
+
 // Release the OpenGL texture
 void Texture::destroyInGL(OpenGLMemManager *memManager)
 {
@@ -0,0 +1,147 @@
+/*
+ *  TileBuildQueue.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import "TileBuildQueue.h"
+#import <algorithm>
+
+namespace WhirlyKit
+{
+    
+bool TileBuildQueue::Job::operator < (const Job &that) const
+{
+    if (importance == that.importance)
+        return seq > that.seq;
+    return importance < that.importance;
+}
+
+TileBuildQueue::TileBuildQueue(int inMaxWorkers,int inMaxQueued)
+    : seq(0), maxWorkers(inMaxWorkers), activeWorkers(0), maxQueued(inMaxQueued),
+    numRun(0), numStale(0), numDropped(0)
+{
+    // Leave a core for the main and layer threads
+    if (maxWorkers <= 0)
+        maxWorkers = std::max((int)[[NSProcessInfo processInfo] activeProcessorCount] - 1,1);
+    if (maxQueued <= 0)
+        maxQueued = 1;
+    queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+}
+
+TileBuildQueue::~TileBuildQueue()
+{
+}
+
+void TileBuildQueue::addJob(double importance,TileGenerationRef gen,int genValue,dispatch_block_t work,dispatch_block_t dropped)
+{
+    std::vector<dispatch_block_t> toDrop;
+    bool startWorker = false;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        Job job;
+        job.importance = importance;
+        job.seq = seq++;
+        job.gen = gen;
+        job.genValue = genValue;
+        job.work = work;
+        job.dropped = dropped;
+        jobs.push_back(job);
+        std::push_heap(jobs.begin(),jobs.end());
+        
+        // Too many, so toss the least important
+        while (jobs.size() > (size_t)maxQueued)
+        {
+            auto minIt = std::min_element(jobs.begin(),jobs.end());
+            if (minIt->dropped)
+                toDrop.push_back(minIt->dropped);
+            jobs.erase(minIt);
+            std::make_heap(jobs.begin(),jobs.end());
+            numDropped++;
+        }
+        
+        if (activeWorkers < maxWorkers && !jobs.empty())
+        {
+            activeWorkers++;
+            startWorker = true;
+        }
+    }
+    
+    for (auto block : toDrop)
+        block();
+    
+    if (startWorker)
+    {
+        // Workers hold on to the queue until they run out of work
+        TileBuildQueueRef thisQueue = shared_from_this();
+        dispatch_async(queue, ^{
+            thisQueue->runJobs();
+        });
+    }
+}
+
+void TileBuildQueue::runJobs()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty())
+            {
+                activeWorkers--;
+                return;
+            }
+            std::pop_heap(jobs.begin(),jobs.end());
+            job = jobs.back();
+            jobs.pop_back();
+        }
+        
+        // The tile moved on while this was waiting
+        if (job.gen && job.gen->current() != job.genValue)
+        {
+            numStale++;
+            continue;
+        }
+        
+        @autoreleasepool
+        {
+            job.work();
+        }
+        numRun++;
+    }
+}
+
+void TileBuildQueue::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.clear();
+}
+
+int TileBuildQueue::numQueued()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)jobs.size();
+}
+
+void TileBuildQueue::dumpStats()
+{
+    NSLog(@"TileBuildQueue: %d run, %d stale, %d dropped, %d waiting, %d workers",(int)numRun,(int)numStale,(int)numDropped,numQueued(),maxWorkers);
+}
+
+}
@@ -20,6 +20,7 @@
 
 #import "UIImage+Stuff.h"
 #import "WhirlyGeometry.h"
+#import "ImageResample.h"
 
 using namespace WhirlyKit;
 
@@ -100,40 +101,30 @@ using namespace WhirlyKit;
 -(NSData *)rawDataScaleWidth:(unsigned int)destWidth height:(unsigned int)destHeight border:(int)border
 {
 	CGImageRef cgImage = self.CGImage;
+    unsigned int srcWidth = (unsigned int)CGImageGetWidth(cgImage);
+    unsigned int srcHeight = (unsigned int)CGImageGetHeight(cgImage);
     CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
-	
-    
-	NSMutableData *retData = [NSMutableData dataWithLength:destWidth*destHeight*4];
-	CGContextRef theContext = CGBitmapContextCreate((void *)[retData bytes], destWidth, destHeight, 8, destWidth * 4, colorSpace, kCGImageAlphaPremultipliedLast);
-	CGContextDrawImage(theContext, CGRectMake((float)border, (float)border, (CGFloat)(destWidth-2*border), (CGFloat)(destHeight-2*border)), cgImage);
-	CGContextRelease(theContext);
-    CGColorSpaceRelease(colorSpace);
-    
-    // Copy over the extra pixels
-    unsigned int *buf = (unsigned int *)[retData mutableBytes];
-    if (border > 0)
+
+    // Already the right size, so Core Graphics can just decode it
+    if (border == 0 && srcWidth == destWidth && srcHeight == destHeight)
     {
-        int ix,iy;
-        // Bottom
-        for (iy=border-1;iy>=0;iy--)
-            for (ix=0;ix<destWidth;ix++)
-            buf[iy*destWidth + ix] = buf[(iy+1)*destWidth + ix];
-        // Top
-        for (iy=destHeight-(1+border);iy<destHeight;iy++)
-            for (ix=0;ix<destWidth;ix++)
-                buf[iy*destWidth + ix] = buf[(iy-1)*destWidth + ix];
-        // Left
-        for (ix=border-1;ix>=0;ix--)
-            for (iy=0;iy<destHeight;iy++)
-            buf[iy*destWidth + ix] = buf[iy*destWidth + (ix+1)];
-        // Right
-        for (ix=destWidth-(1+border);ix<destWidth;ix++)
-            for (iy=0;iy<destHeight;iy++)
-            buf[iy*destWidth + ix] = buf[iy*destWidth + (ix-1)];
+        NSMutableData *retData = [NSMutableData dataWithLength:destWidth*destHeight*4];
+        CGContextRef theContext = CGBitmapContextCreate((void *)[retData bytes], destWidth, destHeight, 8, destWidth * 4, colorSpace, kCGImageAlphaPremultipliedLast);
+        CGContextDrawImage(theContext, CGRectMake(0.0, 0.0, (CGFloat)destWidth, (CGFloat)destHeight), cgImage);
+        CGContextRelease(theContext);
+        CGColorSpaceRelease(colorSpace);
+
+        return retData;
     }
+
+    // Decode at the native size and then do the scale and border in one pass ourselves
+	NSMutableData *srcData = [NSMutableData dataWithLength:srcWidth*srcHeight*4];
+	CGContextRef theContext = CGBitmapContextCreate((void *)[srcData bytes], srcWidth, srcHeight, 8, srcWidth * 4, colorSpace, kCGImageAlphaPremultipliedLast);
+	CGContextDrawImage(theContext, CGRectMake(0.0, 0.0, (CGFloat)srcWidth, (CGFloat)srcHeight), cgImage);
+	CGContextRelease(theContext);
+    CGColorSpaceRelease(colorSpace);
 	
-	return retData;
-    
+	return ImageResampleWithBorder((const uint8_t *)[srcData bytes], srcWidth, srcHeight, destWidth, destHeight, border);
 }
 
 
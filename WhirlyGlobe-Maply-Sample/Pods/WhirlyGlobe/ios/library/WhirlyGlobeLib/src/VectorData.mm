@@ -423,6 +423,166 @@ VectorArealRef VectorAreal::createAreal()
 {
     return VectorArealRef(new VectorAreal());
 }
+    
+PreparedPolygon::PreparedPolygon(const std::vector<VectorRing> &loops)
+    : minY(MAXFLOAT), maxY(-MAXFLOAT), bandScale(0.0), numBands(1)
+{
+    int numEdges = 0;
+    for (const VectorRing &ring : loops)
+    {
+        numEdges += ring.size();
+        for (const Point2f &pt : ring)
+        {
+            minY = std::min(minY,pt.y());
+            maxY = std::max(maxY,pt.y());
+        }
+    }
+    if (numEdges == 0)
+    {
+        bandStart.resize(2,0);
+        return;
+    }
+    
+    // A few edges per band is plenty
+    numBands = std::min(std::max(numEdges/4,1),4096);
+    bandScale = maxY > minY ? numBands / (maxY - minY) : 0.0;
+    
+    // Count the edges per band, then fill them in.  Loops go in order, so each band stays sorted by loop.
+    std::vector<int> counts(numBands+1,0);
+    for (int pass=0;pass<2;pass++)
+    {
+        for (unsigned int li=0;li<loops.size();li++)
+        {
+            const VectorRing &ring = loops[li];
+            for (size_t ii = 0, jj = ring.size()-1; ii < ring.size(); jj = ii++)
+            {
+                float y0 = std::min(ring[ii].y(),ring[jj].y()), y1 = std::max(ring[ii].y(),ring[jj].y());
+                int b0 = std::min((int)((y0 - minY) * bandScale),numBands-1);
+                int b1 = std::min((int)((y1 - minY) * bandScale),numBands-1);
+                for (int bi=b0;bi<=b1;bi++)
+                {
+                    if (pass == 0)
+                        counts[bi+1]++;
+                    else {
+                        Edge &edge = edges[counts[bi]++];
+                        edge.p0 = ring[ii];
+                        edge.p1 = ring[jj];
+                        edge.loop = li;
+                    }
+                }
+            }
+        }
+        
+        if (pass == 0)
+        {
+            for (int bi=0;bi<numBands;bi++)
+                counts[bi+1] += counts[bi];
+            bandStart = counts;
+            edges.resize(counts[numBands]);
+        }
+    }
+}
+    
+bool PreparedPolygon::pointInside(const Point2f &pt) const
+{
+    if (edges.empty() || pt.y() < minY || pt.y() > maxY)
+        return false;
+    int band = std::min((int)((pt.y() - minY) * bandScale),numBands-1);
+    
+    // Same test as PointInPolygon(), but one loop at a time out of the band
+    int curLoop = -1;
+    bool c = false;
+    for (int ei=bandStart[band];ei<bandStart[band+1];ei++)
+    {
+        const Edge &edge = edges[ei];
+        if (edge.loop != curLoop)
+        {
+            if (c)
+                return true;
+            curLoop = edge.loop;
+            c = false;
+        }
+        const Point2f &pi = edge.p0, &pj = edge.p1;
+        if ( ((pi.y()>pt.y()) != (pj.y()>pt.y())) &&
+            (pt.x() < (pj.x()-pi.x()) * (pt.y()-pi.y()) / (pj.y()-pi.y()) + pi.x()) )
+            c = !c;
+    }
+    
+    return c;
+}
+    
+LinearSegmentIndex::LinearSegmentIndex(const VectorRing &pts)
+{
+    build(pts);
+}
+
+LinearSegmentIndex::LinearSegmentIndex(const VectorRing3d &pts)
+{
+    build(pts);
+}
+
+template<typename T> void LinearSegmentIndex::build(const std::vector<T> &pts)
+{
+    if (pts.size() < 2)
+        return;
+    
+    // Runs share their end points so every segment lands in one of them
+    int numSegs = (int)pts.size()-1;
+    runMbrs.resize((numSegs + RunSize - 1) / RunSize);
+    for (unsigned int ri=0;ri<runMbrs.size();ri++)
+    {
+        Mbr &mbr = runMbrs[ri];
+        int end = std::min((int)(ri+1)*RunSize,numSegs);
+        for (int ii=ri*RunSize;ii<=end;ii++)
+            mbr.addPoint(Point2f(pts[ii].x(),pts[ii].y()));
+    }
+}
+
+void LinearSegmentIndex::findRuns(GeoCoord coord,const Point2f &dist,std::vector<int> &starts) const
+{
+    for (unsigned int ri=0;ri<runMbrs.size();ri++)
+    {
+        const Mbr &mbr = runMbrs[ri];
+        if (coord.x() >= mbr.ll().x() - dist.x() && coord.x() <= mbr.ur().x() + dist.x() &&
+            coord.y() >= mbr.ll().y() - dist.y() && coord.y() <= mbr.ur().y() + dist.y())
+            starts.push_back(ri*RunSize);
+    }
+}
+    
+void PointsInAreals(const std::vector<GeoCoord> &pts,const std::vector<VectorArealRef> &areals,std::vector<int> &which)
+{
+    which.resize(pts.size(),-1);
+    if (pts.empty() || areals.empty())
+        return;
+    
+    // Build the indices up front so the workers only read them
+    for (auto areal : areals)
+    {
+        areal->calcGeoMbr();
+        areal->prepare();
+    }
+    
+    const int ChunkSize = 1024;
+    size_t numChunks = (pts.size() + ChunkSize - 1) / ChunkSize;
+    int *whichPtr = &which[0];
+    const GeoCoord *ptsPtr = &pts[0];
+    size_t numPts = pts.size();
+    const VectorArealRef *arealsPtr = &areals[0];
+    size_t numAreals = areals.size();
+    dispatch_apply(numChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+        size_t end = std::min((chunk+1)*ChunkSize,numPts);
+        for (size_t pi=chunk*ChunkSize;pi<end;pi++)
+        {
+            whichPtr[pi] = -1;
+            for (unsigned int ai=0;ai<numAreals;ai++)
+                if (arealsPtr[ai]->pointInsidePrepared(ptsPtr[pi]))
+                {
+                    whichPtr[pi] = ai;
+                    break;
+                }
+        }
+    });
+}
 
     
 bool VectorAreal::pointInside(GeoCoord coord)
@@ -437,6 +597,37 @@ bool VectorAreal::pointInside(GeoCoord coord)
     return false;
 }
     
+bool VectorAreal::pointInsidePrepared(GeoCoord coord)
+{
+    if (geoMbr.inside(coord))
+    {
+        // Hang on to our own reference in case someone clears it out from under us
+        PreparedPolygonRef thePrepared = getPrepared();
+        return thePrepared->pointInside(coord);
+    }
+    
+    return false;
+}
+    
+void VectorAreal::prepare()
+{
+    getPrepared();
+}
+    
+PreparedPolygonRef VectorAreal::getPrepared()
+{
+    std::lock_guard<std::mutex> guardLock(preparedLock);
+    if (!prepared)
+        prepared = PreparedPolygonRef(new PreparedPolygon(loops));
+    return prepared;
+}
+    
+void VectorAreal::clearPrepared()
+{
+    std::lock_guard<std::mutex> guardLock(preparedLock);
+    prepared.reset();
+}
+    
 GeoMbr VectorAreal::calcGeoMbr() 
 { 
     if (!geoMbr.valid())
@@ -452,6 +643,7 @@ void VectorAreal::initGeoMbr()
     
 void VectorAreal::subdivide(float maxLen)
 {
+    clearPrepared();
     for (unsigned int ii=0;ii<loops.size();ii++)
     {
         VectorRing newPts;
@@ -490,6 +682,21 @@ void VectorLinear::subdivide(float maxLen)
     VectorRing newPts;
     SubdivideEdges(pts, newPts, false, maxLen);
     pts = newPts;
+    clearSegmentIndex();
+}
+
+LinearSegmentIndexRef VectorLinear::getSegmentIndex()
+{
+    std::lock_guard<std::mutex> guardLock(segIndexLock);
+    if (!segIndex)
+        segIndex = LinearSegmentIndexRef(new LinearSegmentIndex(pts));
+    return segIndex;
+}
+
+void VectorLinear::clearSegmentIndex()
+{
+    std::lock_guard<std::mutex> guardLock(segIndexLock);
+    segIndex.reset();
 }
 
 VectorLinear3d::VectorLinear3d()
@@ -500,6 +707,20 @@ VectorLinear3d::~VectorLinear3d()
 {
 }
 
+LinearSegmentIndexRef VectorLinear3d::getSegmentIndex()
+{
+    std::lock_guard<std::mutex> guardLock(segIndexLock);
+    if (!segIndex)
+        segIndex = LinearSegmentIndexRef(new LinearSegmentIndex(pts));
+    return segIndex;
+}
+
+void VectorLinear3d::clearSegmentIndex()
+{
+    std::lock_guard<std::mutex> guardLock(segIndexLock);
+    segIndex.reset();
+}
+
 VectorLinear3dRef VectorLinear3d::createLinear()
 {
     return VectorLinear3dRef(new VectorLinear3d());
@@ -59,7 +59,7 @@ VectorDatabase::VectorDatabase(NSString *bundleDir,NSString *cacheDir,NSString *
     // Now maybe build the cache (hopefully not)
     if (needToBuild)
     {
-        if (!buildCaches(mbrName1, dbName1))
+        if (!buildCaches(mbrName1, dbName1, indices))
             throw (std::string)"Failed to build vector cache.  Giving up.";
     }
     
@@ -167,8 +167,80 @@ sqlite3 *VectorDatabase::getSqliteDb()
 }
 
 
+// One attribute pulled out of a shape, ready to bind
+class VectorDbAttr
+{
+public:
+    std::string name;
+    const char *dataType;
+    NSObject *val;
+};
+
+// A run of shapes read and converted on one thread
+class VectorDbChunk
+{
+public:
+    std::vector<GeoMbr> mbrs;
+    std::vector<bool> valid;
+    std::vector<std::vector<VectorDbAttr> > rows;
+};
+    
+// Figure out the sqlite type for an attribute value.  NULL if we don't store it.
+static const char *VectorDbDataType(NSObject *obj)
+{
+    if ([obj isKindOfClass:[NSString class]])
+        return "VARCHAR(100)";  // Note: This may not be enough in all cases
+    if ([obj isKindOfClass:[NSNumber class]])
+    {
+        NSNumber *num = (NSNumber *)obj;
+        if (!strcmp([num objCType], @encode(BOOL)))
+            return "BOOLEAN";
+        if (!strcmp([num objCType], @encode(int)))
+            return "INTEGER";
+        if (!strcmp([num objCType], @encode(float)) ||
+            !strcmp([num objCType], @encode(double)))
+            return "REAL";
+    }
+    
+    return NULL;
+}
+    
+// Read a range of shapes, work out their MBRs and flatten their attributes
+static void VectorDbReadChunk(VectorReader *reader,unsigned int start,unsigned int end,VectorDbChunk &chunk)
+{
+    unsigned int num = end-start;
+    chunk.mbrs.resize(num);
+    chunk.valid.resize(num,false);
+    chunk.rows.resize(num);
+    for (unsigned int ii=0;ii<num;ii++)
+    {
+        @autoreleasepool
+        {
+            VectorShapeRef theShape = reader->getObjectByIndex(start+ii,NULL);
+            if (!theShape.get())
+                continue;
+            chunk.valid[ii] = true;
+            chunk.mbrs[ii] = theShape->calcGeoMbr();
+            
+            NSDictionary *attrDict = theShape->getAttrDict();
+            std::vector<VectorDbAttr> &row = chunk.rows[ii];
+            row.reserve([attrDict count]);
+            for (NSString *key in [attrDict allKeys])
+            {
+                VectorDbAttr attr;
+                attr.name = [key cStringUsingEncoding:NSASCIIStringEncoding];
+                attr.val = [attrDict objectForKey:key];
+                attr.dataType = VectorDbDataType(attr.val);
+                row.push_back(attr);
+            }
+        }
+    }
+}
+
 // Build the MBR cache and the sqlite database
-bool VectorDatabase::buildCaches(NSString *mbrCache,NSString *sqlDb)
+// Shapes are read and converted in parallel chunks, if the reader can be cloned,
+//  and the rows go in with cached prepared statements in a single transaction.
+bool VectorDatabase::buildCaches(NSString *mbrCache,NSString *sqlDb,const std::set<std::string> *indices)
 {
     // If we're rebuiling the caches, just nuke everything
     NSFileManager *fileManager = [NSFileManager defaultManager];
@@ -179,111 +251,157 @@ bool VectorDatabase::buildCaches(NSString *mbrCache,NSString *sqlDb)
     if (sqlite3_open([sqlDb cStringUsingEncoding:NSASCIIStringEncoding],&db) != SQLITE_OK)
         return false;
     
-    // Set up the one table we need table
-    sqlhelpers::OneShot(db,@"CREATE TABLE vectors (vecid INTEGER PRIMARY KEY);");
-    std::set<std::string> fields;
-    std::set<std::string> ignoreFields;
+    // Readers for the worker threads.  If we can't get any, we'll read on this one.
+    const unsigned int ChunkSize = 256;
+    unsigned int numObjects = reader->getNumObjects();
+    std::vector<VectorReader *> readers;
+    if (reader->canReadByIndex() && numObjects > ChunkSize)
+    {
+        int numReaders = std::max((int)[[NSProcessInfo processInfo] activeProcessorCount],1);
+        for (int ii=0;ii<numReaders;ii++)
+        {
+            VectorReader *newReader = reader->clone();
+            if (!newReader)
+                break;
+            readers.push_back(newReader);
+        }
+    }
     
-    mbrs.resize(reader->getNumObjects());
-    for (unsigned int ii=0;ii<mbrs.size();ii++)
+    // Insert statements, keyed by the columns they fill
+    std::map<std::string,sqlhelpers::StatementWrite *> insStmts;
+    bool success = true;
+    try
     {
-        VectorShapeRef theShape = getVector(ii,true);
-        if (theShape.get())
+        // The MBR file is written last, so a crash here just means a rebuild.  No need to journal.
+        //  (journal_mode hands back a row, which OneShot doesn't like)
+        sqlite3_exec(db,"PRAGMA synchronous = OFF; PRAGMA journal_mode = MEMORY;",NULL,NULL,NULL);
+        
+        // Set up the one table we need table
+        sqlhelpers::OneShot(db,@"CREATE TABLE vectors (vecid INTEGER PRIMARY KEY);");
+        sqlhelpers::OneShot(db,"BEGIN TRANSACTION;");
+        std::set<std::string> fields;
+        
+        // Work through a window of chunks at a time to keep the memory down
+        mbrs.resize(numObjects);
+        unsigned int numChunks = (numObjects + ChunkSize - 1) / ChunkSize;
+        unsigned int windowSize = readers.empty() ? 1 : 4*(unsigned int)readers.size();
+        for (unsigned int windowStart=0;windowStart<numChunks;windowStart+=windowSize)
         {
-            mbrs[ii] = theShape->calcGeoMbr();
-
-            std::vector<std::string> keys;
-            NSMutableArray *data = [NSMutableArray array];
-
-            // Build up a row to add
-            for (NSString *key in [theShape->getAttrDict() allKeys])
+            unsigned int windowEnd = std::min(windowStart+windowSize,numChunks);
+            std::vector<VectorDbChunk> chunks(windowEnd-windowStart);
+            if (readers.empty())
+                VectorDbReadChunk(reader, windowStart*ChunkSize, std::min((windowStart+1)*ChunkSize,numObjects), chunks[0]);
+            else {
+                // Each worker has its own reader and takes every Nth chunk
+                size_t numWorkers = std::min(readers.size(),chunks.size());
+                VectorReader **readersPtr = &readers[0];
+                VectorDbChunk *chunksPtr = &chunks[0];
+                size_t numWindowChunks = chunks.size();
+                dispatch_apply(numWorkers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker){
+                    for (size_t which=worker;which<numWindowChunks;which+=numWorkers)
+                    {
+                        unsigned int chunk = windowStart + (unsigned int)which;
+                        VectorDbReadChunk(readersPtr[worker], chunk*ChunkSize, std::min((chunk+1)*ChunkSize,numObjects), chunksPtr[which]);
+                    }
+                });
+            }
+            
+            // Add any new fields before we insert anything
+            for (const VectorDbChunk &chunk : chunks)
+                for (const std::vector<VectorDbAttr> &row : chunk.rows)
+                    for (const VectorDbAttr &attr : row)
+                        if (attr.dataType && fields.find(attr.name) == fields.end())
+                        {
+                            sqlhelpers::OneShot(db,[NSString stringWithFormat:@"ALTER TABLE vectors ADD \"%s\" %s;",attr.name.c_str(),attr.dataType]);
+                            fields.insert(attr.name);
+                        }
+            
+            // Then the rows go in, in order
+            for (unsigned int ci=0;ci<chunks.size();ci++)
             {
-                std::string fieldName = [key cStringUsingEncoding:NSASCIIStringEncoding];
-                std::string dataType = "";
-
-                // Figure out the data type
-                NSObject *obj = [theShape->getAttrDict() objectForKey:key];
-                if ([obj isKindOfClass:[NSString class]])
+                @autoreleasepool
                 {
-                    dataType = "VARCHAR(100)";  // Note: This may not be enough in all cases
-                } else {
-                    if ([obj isKindOfClass:[NSNumber class]])
+                    VectorDbChunk &chunk = chunks[ci];
+                    unsigned int chunkStart = (windowStart+ci)*ChunkSize;
+                    for (unsigned int ii=0;ii<chunk.rows.size();ii++)
                     {
-                        NSNumber *num = (NSNumber *)obj;
-                        if (!strcmp([num objCType], @encode(BOOL)))
+                        if (!chunk.valid[ii])
+                            continue;
+                        unsigned int vecId = chunkStart+ii;
+                        mbrs[vecId] = chunk.mbrs[ii];
+                        
+                        // Shapes from the same file usually fill the same columns, so the statement gets reused
+                        std::vector<VectorDbAttr> &row = chunk.rows[ii];
+                        std::string colKey;
+                        for (const VectorDbAttr &attr : row)
+                            if (attr.dataType)
+                                colKey += attr.name + ",";
+                        sqlhelpers::StatementWrite *insStmt = NULL;
+                        auto it = insStmts.find(colKey);
+                        if (it == insStmts.end())
                         {
-                            dataType = "BOOLEAN";
-                        } else {
-                            if (!strcmp([num objCType], @encode(int)))
-                            {
-                                dataType = "INTEGER";
-                            } else {
-                                if (!strcmp([num objCType], @encode(float)) ||
-                                    !strcmp([num objCType], @encode(double)))
+                            NSMutableString *keyStr = [NSMutableString stringWithString:@"vecid"];
+                            NSMutableString *valStr = [NSMutableString stringWithString:@"?"];
+                            for (const VectorDbAttr &attr : row)
+                                if (attr.dataType)
                                 {
-                                    dataType = "REAL";
+                                    [keyStr appendFormat:@", \"%s\"",attr.name.c_str()];
+                                    [valStr appendString:@", ?"];
                                 }
-                            }
+                            insStmt = new sqlhelpers::StatementWrite(db,[NSString stringWithFormat:@"INSERT INTO vectors (%@) values (%@);",keyStr,valStr]);
+                            insStmts[colKey] = insStmt;
+                        } else {
+                            insStmt = it->second;
+                            insStmt->reset();
                         }
-                    }
-                }
-
-                // Keep track of the field name/data
-                if (!dataType.empty())
-                {
-                    keys.push_back(fieldName);
-                    [data addObject:[theShape->getAttrDict() objectForKey:key]];
-                }
-
-                // Add the field if it isn't in the table
-                if (fields.find(fieldName) == fields.end() &&
-                    ignoreFields.find(fieldName) == ignoreFields.end())
-                {                    
-                    // Create the field
-                    if (!dataType.empty())
-                    {
-                        sqlhelpers::OneShot(db,[NSString stringWithFormat:@"ALTER TABLE vectors ADD \"%@\" %s;",key,dataType.c_str()]);                                                
-                        fields.insert(fieldName);
-                    } else
-                        ignoreFields.insert(fieldName);
-                }
-            }
-
-            // Build up the insert and kick it off
-            NSMutableString *keyStr = [NSMutableString stringWithString:@"vecid, "];
-            NSMutableString *valStr = [NSMutableString stringWithString:@"?, "];
-            for (unsigned int jj=0;jj<keys.size();jj++)
-            {
-                [keyStr appendFormat:@"\"%s\"%s",keys[jj].c_str(),(jj==keys.size()-1 ? "" : ", ")];
-                [valStr appendFormat:@"?%s",(jj==keys.size()-1 ? "" : ", ")];
-            }
-            sqlhelpers::StatementWrite insStmt(db,[NSString stringWithFormat:@"INSERT INTO vectors (%@) values (%@);",keyStr,valStr]);
-            insStmt.add((int)ii);
-            for (NSObject *obj in data)
-            {
-                if ([obj isKindOfClass:[NSString class]])
-                    insStmt.add((NSString *)obj);
-                else {
-                    if ([obj isKindOfClass:[NSNumber class]])
-                    {
-                        NSNumber *num = (NSNumber *)obj;
-                        if (!strcmp([num objCType], @encode(BOOL)))
-                            insStmt.add([num boolValue]);
-                        else {
-                            if (!strcmp([num objCType], @encode(int)))
-                                insStmt.add([num intValue]);
+                        
+                        insStmt->add((int)vecId);
+                        for (const VectorDbAttr &attr : row)
+                        {
+                            if (!attr.dataType)
+                                continue;
+                            if ([attr.val isKindOfClass:[NSString class]])
+                                insStmt->add((NSString *)attr.val);
                             else {
-                                if (!strcmp([num objCType], @encode(float)) ||
-                                    !strcmp([num objCType], @encode(double)))
-                                    insStmt.add([num floatValue]);
+                                NSNumber *num = (NSNumber *)attr.val;
+                                if (!strcmp(attr.dataType,"BOOLEAN"))
+                                    insStmt->add([num boolValue]);
+                                else if (!strcmp(attr.dataType,"INTEGER"))
+                                    insStmt->add([num intValue]);
+                                else
+                                    insStmt->add((double)[num floatValue]);
                             }
                         }
+                        insStmt->go();
                     }
                 }
             }
-            insStmt.go();
         }
+        
+        for (auto it : insStmts)
+            delete it.second;
+        insStmts.clear();
+        
+        // Indices are much cheaper to build once the data is in
+        if (indices)
+            for (const std::string &index : *indices)
+                if (fields.find(index) != fields.end())
+                    sqlhelpers::OneShot(db,[NSString stringWithFormat:@"CREATE INDEX \"vectors_%s_idx\" ON vectors (\"%s\");",index.c_str(),index.c_str()]);
+        
+        sqlhelpers::OneShot(db,"COMMIT;");
     }
+    catch (...)
+    {
+        NSLog(@"VectorDatabase: Failed to build %@",sqlDb);
+        success = false;
+    }
+    
+    for (auto it : insStmts)
+        delete it.second;
+    for (VectorReader *threadReader : readers)
+        delete threadReader;
+    if (!success)
+        return false;
     
     // Write the cache file
     //  Version
@@ -556,16 +556,34 @@ SimpleIdentity VectorManager::addVectors(ShapeSet *shapes, NSDictionary *desc, C
 //    VectorPointsRef thePoints = std::dynamic_pointer_cast<VectorPoints>(*first);
 //    bool linesOrPoints = (thePoints.get() ? false : true);
     
-    // Look for per vector colors
+    // Look for per vector colors and a draw order
     bool doColors = false;
+    bool doOrder = false;
     for (ShapeSet::iterator it = vecInfo->shapes.begin();
          it != vecInfo->shapes.end(); ++it)
     {
-        if (((*it)->getAttrDict())[@"color"])
-        {
+        NSDictionary *attrs = (*it)->getAttrDict();
+        if (attrs[@"color"])
             doColors = true;
+        if (attrs[@"batchorder"])
+            doOrder = true;
+        if (doColors && doOrder)
             break;
-        }
+    }
+    
+    // Shapes merged from several sources have to draw in the order they were given.
+    // The shape set is sorted by pointer, so we sort them ourselves.
+    std::vector<VectorShapeRef> orderedShapes(vecInfo->shapes.begin(),vecInfo->shapes.end());
+    if (doOrder)
+    {
+        std::vector<std::pair<int,VectorShapeRef> > sortShapes;
+        sortShapes.reserve(orderedShapes.size());
+        for (auto shape : orderedShapes)
+            sortShapes.push_back(std::make_pair([shape->getAttrDict()[@"batchorder"] intValue],shape));
+        std::stable_sort(sortShapes.begin(),sortShapes.end(),
+                         [](const std::pair<int,VectorShapeRef> &a,const std::pair<int,VectorShapeRef> &b) { return a.first < b.first; });
+        for (unsigned int ii=0;ii<sortShapes.size();ii++)
+            orderedShapes[ii] = sortShapes[ii].second;
     }
 
     // Look for a geometry center.  We'll offset everything if there is one
@@ -609,8 +627,8 @@ SimpleIdentity VectorManager::addVectors(ShapeSet *shapes, NSDictionary *desc, C
     if (centerValid)
         drawBuildTri.setCenter(center,geoCenter);
     
-    for (ShapeSet::iterator it = vecInfo->shapes.begin();
-         it != vecInfo->shapes.end(); ++it)
+    for (std::vector<VectorShapeRef>::iterator it = orderedShapes.begin();
+         it != orderedShapes.end(); ++it)
     {
         VectorArealRef theAreal = std::dynamic_pointer_cast<VectorAreal>(*it);
         if (theAreal.get())
@@ -182,6 +182,32 @@ using namespace Eigen;
 	return Point3d(mid.x(),mid.y(),-near);
 }
 
+- (void)pointsOnScreen:(const Point3d *)worldLocs numPoints:(int)numPts transform:(const Eigen::Matrix4d *)transform frameSize:(const Point2f &)frameSize screenPts:(CGPoint *)screenPts
+{
+    Point2d ll,ur;
+    double near,far;
+    [self calcFrustumWidth:frameSize.x() height:frameSize.y() ll:ll ur:ur near:near far:far];
+    const Eigen::Matrix4d &modelMat = *transform;
+    double scaleX = frameSize.x() / (ur.x() - ll.x());
+    double scaleY = frameSize.y() / (ur.y() - ll.y());
+    
+    for (int ii=0;ii<numPts;ii++)
+    {
+        const Point3d &worldLoc = worldLocs[ii];
+        Vector4d eyePt = modelMat * Vector4d(worldLoc.x(),worldLoc.y(),worldLoc.z(),1.0);
+        if (eyePt.z() == 0.0)
+        {
+            screenPts[ii] = CGPointMake(NAN, NAN);
+            continue;
+        }
+
+        // Intersection with near gives us the same plane as the screen
+        double t = -near/eyePt.z();
+        screenPts[ii].x = (eyePt.x() * t - ll.x()) * scaleX;
+        screenPts[ii].y = frameSize.y() - (eyePt.y() * t - ll.y()) * scaleY;
+    }
+}
+
 //- (WhirlyKit::Ray3f)displaySpaceRayFromScreenPt:(WhirlyKit::Point2f)screenPt width:(float)frameWidth height:(float)frameHeight
 //{
 //    // Here's where that screen point is in display space
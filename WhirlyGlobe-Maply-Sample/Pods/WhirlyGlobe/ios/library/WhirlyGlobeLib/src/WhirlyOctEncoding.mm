@@ -45,5 +45,24 @@ Point3f OctDecode(uint8_t enc_x, uint8_t enc_y)
 
 	return Point3f(x, y, z);
 }
+
+Point2f OctEncode(const Point3f &norm)
+{
+	float sum = fabs(norm.x()) + fabs(norm.y()) + fabs(norm.z());
+	if (sum == 0.0)
+		return Point2f(0.0, 0.0);
+
+	float x = norm.x() / sum;
+	float y = norm.y() / sum;
+
+	// Fold the lower hemisphere over the diagonals
+	if (norm.z() < 0.0) {
+		float oldX = x;
+		x = (1 - fabs(y)   ) * (oldX < 0.0 ? -1.0 : 1.0);
+		y = (1 - fabs(oldX)) * (y    < 0.0 ? -1.0 : 1.0);
+	}
+
+	return Point2f(x, y);
+}
 	
 }
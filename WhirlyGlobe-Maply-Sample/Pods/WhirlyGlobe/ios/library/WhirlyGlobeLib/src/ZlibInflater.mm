@@ -0,0 +1,277 @@
+/*
+ *  ZlibInflater.mm
+ *  WhirlyGlobeLib
+ *
+ *  Copyright 2011-2018 mousebird consulting. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#import <string.h>
+#import <stdlib.h>
+#import <algorithm>
+#import "ZlibInflater.h"
+
+#ifndef WK_INFLATE_LIBCOMPRESSION
+#define WK_INFLATE_LIBCOMPRESSION 0
+#endif
+
+#if WK_INFLATE_LIBCOMPRESSION
+#import <compression.h>
+#endif
+
+namespace WhirlyKit
+{
+    
+// Total size of the buffers we'll hang on to
+static const size_t MaxInflatePoolSize = 16*1024*1024;
+// Anything bigger than this isn't worth keeping
+static const size_t MaxInflatePoolBuffer = 4*1024*1024;
+// Smallest buffer we'll hand out
+static const size_t MinInflateBuffer = 4096;
+// Deflate can't do better than about this
+static const size_t MaxDeflateRatio = 1032;
+
+InflateBufferPool::InflateBufferPool()
+    : totalSize(0)
+{
+}
+    
+InflateBufferPool::~InflateBufferPool()
+{
+    for (auto it : buffers)
+        free(it.second);
+    buffers.clear();
+}
+    
+InflateBufferPool *InflateBufferPool::sharedPool()
+{
+    static InflateBufferPool pool;
+    return &pool;
+}
+
+unsigned char *InflateBufferPool::getBuffer(size_t &capacity)
+{
+    capacity = std::max(capacity,MinInflateBuffer);
+    
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        // Smallest buffer that fits, as long as it's not way too big
+        auto it = buffers.lower_bound(capacity);
+        if (it != buffers.end() && it->first <= 2*capacity)
+        {
+            capacity = it->first;
+            unsigned char *buf = it->second;
+            buffers.erase(it);
+            totalSize -= capacity;
+            return buf;
+        }
+    }
+    
+    return (unsigned char *)malloc(capacity);
+}
+
+void InflateBufferPool::releaseBuffer(unsigned char *buf,size_t capacity)
+{
+    if (!buf)
+        return;
+    
+    if (capacity <= MaxInflatePoolBuffer)
+    {
+        std::lock_guard<std::mutex> guardLock(lock);
+        if (totalSize + capacity <= MaxInflatePoolSize)
+        {
+            buffers.insert(std::make_pair(capacity,buf));
+            totalSize += capacity;
+            return;
+        }
+    }
+    
+    free(buf);
+}
+
+ZlibInflater::ZlibInflater()
+    : strmValid(false)
+{
+    memset(&strm,0,sizeof(strm));
+}
+    
+ZlibInflater::~ZlibInflater()
+{
+    if (strmValid)
+        inflateEnd(&strm);
+}
+    
+ZlibInflater *ZlibInflater::threadInflater()
+{
+    static thread_local ZlibInflater inflater;
+    return &inflater;
+}
+
+static inline uint32_t ReadLittleEndian32(const unsigned char *bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+size_t ZlibInflater::gzipSizeHint(const void *data,size_t len)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    if (len < 18 || bytes[0] != 0x1f || bytes[1] != 0x8b)
+        return 0;
+    
+    // The trailer has the size mod 2^32, so sanity check it
+    size_t size = ReadLittleEndian32(bytes+len-4);
+    if (size == 0 || size > len*MaxDeflateRatio)
+        return 0;
+    
+    return size;
+}
+
+bool ZlibInflater::inflate(const void *data,size_t len,size_t sizeHint,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity)
+{
+    size_t gzipSize = gzipSizeHint(data,len);
+    
+#if WK_INFLATE_LIBCOMPRESSION
+    if (gzipSize > 0 && inflateCompression(data,len,gzipSize,outBuf,outLen,outCapacity))
+        return true;
+#endif
+    
+    if (sizeHint == 0)
+        sizeHint = gzipSize;
+    
+    return inflateZlib(data,len,sizeHint,outBuf,outLen,outCapacity);
+}
+
+bool ZlibInflater::inflateZlib(const void *data,size_t len,size_t sizeHint,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity)
+{
+    // Set up the stream once and reset it after that
+    if (!strmValid)
+    {
+        memset(&strm,0,sizeof(strm));
+        // Detect zlib or gzip from the header
+        if (inflateInit2(&strm,15+32) != Z_OK)
+            return false;
+        strmValid = true;
+    } else if (inflateReset(&strm) != Z_OK)
+        return false;
+    
+    InflateBufferPool *pool = InflateBufferPool::sharedPool();
+    size_t capacity = sizeHint > 0 ? sizeHint : 4*len;
+    unsigned char *buf = pool->getBuffer(capacity);
+    if (!buf)
+        return false;
+    
+    strm.next_in = (Bytef *)data;
+    strm.avail_in = (uInt)len;
+    size_t total = 0;
+    while (true)
+    {
+        strm.next_out = buf + total;
+        strm.avail_out = (uInt)(capacity - total);
+        int status = ::inflate(&strm, Z_FINISH);
+        total = strm.next_out - buf;
+        if (status == Z_STREAM_END)
+            break;
+        
+        // Out of room, so go to a bigger buffer
+        if ((status == Z_OK || status == Z_BUF_ERROR) && strm.avail_out == 0)
+        {
+            size_t newCapacity = 2*capacity;
+            unsigned char *newBuf = pool->getBuffer(newCapacity);
+            if (!newBuf)
+            {
+                pool->releaseBuffer(buf,capacity);
+                return false;
+            }
+            memcpy(newBuf,buf,total);
+            pool->releaseBuffer(buf,capacity);
+            buf = newBuf;
+            capacity = newCapacity;
+            continue;
+        }
+        
+        // Corrupt or truncated
+        pool->releaseBuffer(buf,capacity);
+        return false;
+    }
+    
+    outBuf = buf;
+    outLen = total;
+    outCapacity = capacity;
+    
+    return true;
+}
+
+bool ZlibInflater::inflateCompression(const void *data,size_t len,size_t outSize,unsigned char *&outBuf,size_t &outLen,size_t &outCapacity)
+{
+#if WK_INFLATE_LIBCOMPRESSION
+    const unsigned char *bytes = (const unsigned char *)data;
+    if (len < 18 || bytes[0] != 0x1f || bytes[1] != 0x8b || bytes[2] != Z_DEFLATED)
+        return false;
+    
+    // Skip over the gzip header to the raw deflate data
+    int flags = bytes[3];
+    size_t pos = 10;
+    if (flags & 0x04)
+        pos += 2 + (bytes[pos] | (bytes[pos+1] << 8));
+    for (int strFlag : {0x08,0x10})
+        if (flags & strFlag)
+        {
+            while (pos < len && bytes[pos])
+                pos++;
+            pos++;
+        }
+    if (flags & 0x02)
+        pos += 2;
+    if (pos + 8 > len)
+        return false;
+    uint32_t crc = ReadLittleEndian32(bytes+len-8);
+    
+    // One extra byte tells us if the trailer lied about the size
+    InflateBufferPool *pool = InflateBufferPool::sharedPool();
+    size_t capacity = outSize+1;
+    unsigned char *buf = pool->getBuffer(capacity);
+    if (!buf)
+        return false;
+    size_t decoded = compression_decode_buffer(buf, outSize+1, bytes+pos, len-8-pos, NULL, COMPRESSION_ZLIB);
+    if (decoded != outSize || crc32(crc32(0L,Z_NULL,0),buf,(uInt)outSize) != crc)
+    {
+        pool->releaseBuffer(buf,capacity);
+        return false;
+    }
+    
+    outBuf = buf;
+    outLen = outSize;
+    outCapacity = capacity;
+    
+    return true;
+#else
+    return false;
+#endif
+}
+
+NSData *ZlibInflater::inflateToData(const void *data,size_t len,size_t sizeHint)
+{
+    unsigned char *buf = NULL;
+    size_t outLen = 0,capacity = 0;
+    if (!inflate(data,len,sizeHint,buf,outLen,capacity))
+        return nil;
+    
+    // The buffer goes back to the pool when the data is done with it
+    return [[NSData alloc] initWithBytesNoCopy:buf length:outLen deallocator:^(void *bytes, NSUInteger length)
+            {
+                InflateBufferPool::sharedPool()->releaseBuffer((unsigned char *)bytes,capacity);
+            }];
+}
+
+}
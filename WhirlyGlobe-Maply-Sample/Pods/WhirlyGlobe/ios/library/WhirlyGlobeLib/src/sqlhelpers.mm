@@ -214,6 +214,17 @@ void StatementWrite::go()
 	if (sqlite3_step(stmt) != SQLITE_DONE)
 		throw 1;
 }
+    
+// Reset for another round of binding
+void StatementWrite::reset()
+{
+	if (isFinalized)
+		throw 1;
+	
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+	curField = 1;
+}
 	
 // Finalize the statement
 void StatementWrite::finalize()